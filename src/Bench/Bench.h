@@ -0,0 +1,67 @@
+#pragma once
+
+// Timing helpers shared by the benchmark executables.
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+
+namespace bench
+{
+	inline volatile float g_Sink;
+
+	/// @brief Make a result observable so the loop producing it is not removed.
+	template <typename T>
+	void Consume(const T& value)
+	{
+		float f = 0;
+		memcpy(&f, &value, sizeof(T) < sizeof(f) ? sizeof(T) : sizeof(f));
+		g_Sink = g_Sink + f;
+	}
+
+	/// @brief Best time per operation of several samples.
+	/// @param body Runs `ops` operations per call
+	template <typename Body>
+	double Measure(size_t ops, Body&& body)
+	{
+		using Clock = std::chrono::steady_clock;
+		auto elapsed = [&](size_t reps) {
+			auto start = Clock::now();
+			for (size_t r = 0; r < reps; ++r)
+				body();
+			return std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+		};
+
+		// Grow repetitions until a sample takes about 2 ms
+		size_t reps = 1;
+		while (elapsed(reps) < 2e6 && reps < (size_t(1) << 24))
+			reps *= 2;
+
+		double best = std::numeric_limits<double>::max();
+		for (int sample = 0; sample < 7; ++sample)
+		{
+			double ns = elapsed(reps) / static_cast<double>(reps * ops);
+			if (ns < best)
+				best = ns;
+		}
+		return best;
+	}
+
+	/// @brief Runs cases matching filter and prints them as members of a JSON object.
+	struct Suite
+	{
+		const char* filter = nullptr;
+		bool first = true;
+
+		template <typename Body>
+		void Run(const char* name, size_t ops, Body&& body)
+		{
+			if (filter != nullptr && strstr(name, filter) == nullptr)
+				return;
+			double ns = Measure(ops, body);
+			printf("%s\n    \"%s\": %.3f", first ? "" : ",", name, ns);
+			first = false;
+		}
+	};
+}
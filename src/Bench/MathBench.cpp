@@ -0,0 +1,318 @@
+// Micro-benchmarks for the Math module. Links nothing but the C++ runtime.
+//
+// Usage: MathBench [filter]
+//   filter  Only run cases whose name contains this string
+//
+// Prints one JSON document to stdout, one case per line in a fixed order:
+//   { "format": "MathBench/1", "backend": "...", "batch": 1024, "unit": "ns/op",
+//     "results": { "<case>": <ns per operation>, ... } }
+// Each value is the best of several samples, so runs of two builds can be diffed directly.
+// Build MathBench and MathBenchScalar from the same tree to compare a SIMD backend with scalar code.
+
+#include "../Math/Affine3.h"
+#include "../Math/BatchCulling.h"
+#include "../Math/BatchQuaternion.h"
+#include "../Math/BatchTransform.h"
+#include "../Math/Random.h"
+#include "../Math/VectorStream.h"
+#include "../Utilities/Array.h"
+#include "Bench.h"
+
+namespace
+{
+	using bench::Consume;
+
+	constexpr size_t BatchSize = 1024;
+
+	struct Inputs
+	{
+		Array<vec2> v2;
+		Array<vec3> v3;
+		Array<vec4> v4;
+		Array<mat2> m2;
+		Array<mat3> m3;
+		Array<mat4> m4;
+		Array<Affine3> affine;
+		Array<Quaternion> qa;
+		Array<Quaternion> qb;
+		Array<float> t;
+		Array<float> angles;
+		/// @brief Bounds around the origin, a mix of inside, intersecting and outside the frustum
+		Array<float> bx, by, bz, be;
+	};
+
+	Inputs MakeInputs()
+	{
+		Random random(20240601);
+		auto r = [&]() { return random.range(-1.0f, 1.0f); };
+		Inputs in;
+		for (size_t i = 0; i < BatchSize; ++i)
+		{
+			in.v2.push_back(vec2(r(), r()));
+			in.v3.push_back(vec3(r(), r(), r()));
+			in.v4.push_back(vec4(r(), r(), r(), r()));
+			// Diagonally dominant, so every inverse is well defined
+			in.m2.push_back(mat2(r(), r(), r(), r()) + mat2::eye(3));
+			in.m3.push_back(mat3(vec3(r(), r(), r()), vec3(r(), r(), r()), vec3(r(), r(), r())) + mat3::eye(4));
+			mat4 m;
+			random.fill(&m.cols[0].x, 16, -1.0f, 1.0f);
+			in.m4.push_back(m + mat4::eye(5));
+			Quaternion qa(vec3(r(), r(), r()), 3 * r());
+			Quaternion qb(vec3(r(), r(), r()), 3 * r());
+			in.qa.push_back(qa);
+			in.qb.push_back(qb);
+			in.affine.push_back(Affine3(vec3(r(), r(), r()), vec3(1.5f + r(), 1.5f + r(), 1.5f + r()), qa));
+			in.t.push_back(random.next_float());
+			in.angles.push_back(10 * r());
+			in.bx.push_back(20 * r());
+			in.by.push_back(20 * r());
+			in.bz.push_back(20 * r());
+			in.be.push_back(1.5f + r());
+		}
+		return in;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	const Inputs in = MakeInputs();
+	Array<vec2> v2(BatchSize);
+	Array<vec3> v3(BatchSize);
+	Array<vec4> v4(BatchSize);
+	Array<mat2> m2(BatchSize);
+	Array<mat3> m3(BatchSize);
+	Array<mat4> m4(BatchSize);
+	Array<Affine3> affine(BatchSize);
+	Array<Quaternion> q(BatchSize);
+	Array<float> f(BatchSize);
+
+	bench::Suite suite;
+	suite.filter = argc > 1 ? argv[1] : nullptr;
+
+	printf("{\n  \"format\": \"MathBench/1\",\n  \"backend\": \"%s\",\n  \"batch\": %zu,\n  \"unit\": \"ns/op\",\n  \"results\": {",
+		simd::backend_name(), BatchSize);
+
+	// Vectors
+	suite.Run("vec2.normalize", BatchSize, [&] {
+		for (size_t i = 0; i < BatchSize; ++i)
+			v2[i] = in.v2[i].normalized();
+		Consume(v2[BatchSize - 1]);
+	});
+	suite.Run("vec3.normalize", BatchSize, [&] {
+		for (size_t i = 0; i < BatchSize; ++i)
+			v3[i] = in.v3[i].normalized();
+		Consume(v3[BatchSize - 1]);
+	});
+	suite.Run("vec3.normalize_fast", BatchSize, [&] {
+		for (size_t i = 0; i < BatchSize; ++i)
+			v3[i] = in.v3[i].normalized<MathPrecision::Fast>();
+		Consume(v3[BatchSize - 1]);
+	});
+	suite.Run("vec3.cross", BatchSize, [&] {
+		for (size_t i = 0; i < BatchSize; ++i)
+			v3[i] = in.v3[i].cross_product(in.v3[BatchSize - 1 - i]);
+		Consume(v3[BatchSize - 1]);
+	});
+	suite.Run("vec4.dot", BatchSize, [&] {
+		for (size_t i = 0; i < BatchSize; ++i)
+			f[i] = in.v4[i].dot_product(in.v4[BatchSize - 1 - i]);
+		Consume(f[BatchSize - 1]);
+	});
+	suite.Run("vec4.normalize", BatchSize, [&] {
+		for (size_t i = 0; i < BatchSize; ++i)
+			v4[i] = in.v4[i].normalized();
+		Consume(v4[BatchSize - 1]);
+	});
+
+	// Streams: the same vector work on SoA lanes
+	const Array<vec3> v3_reversed(in.v3.rbegin(), in.v3.rend());
+	const Array<vec4> v4_reversed(in.v4.rbegin(), in.v4.rend());
+	Vec3Stream s3(in.v3.data(), BatchSize), s3_reversed(v3_reversed.data(), BatchSize), s3_out(BatchSize);
+	Vec4Stream s4(in.v4.data(), BatchSize), s4_reversed(v4_reversed.data(), BatchSize), s4_out(BatchSize);
+	suite.Run("stream.vec3_load", BatchSize, [&] {
+		s3_out.load(in.v3.data());
+		Consume(s3_out[BatchSize - 1]);
+	});
+	suite.Run("stream.vec3_store", BatchSize, [&] {
+		s3.store(v3.data());
+		Consume(v3[BatchSize - 1]);
+	});
+	suite.Run("stream.vec3_normalize", BatchSize, [&] {
+		s3.view().normalized(s3_out.view());
+		Consume(s3_out[BatchSize - 1]);
+	});
+	suite.Run("stream.vec3_cross", BatchSize, [&] {
+		s3.view().cross_product(s3_reversed.view(), s3_out.view());
+		Consume(s3_out[BatchSize - 1]);
+	});
+	suite.Run("stream.vec4_dot", BatchSize, [&] {
+		s4.view().dot_product(s4_reversed.view(), f.data());
+		Consume(f[BatchSize - 1]);
+	});
+	suite.Run("stream.vec4_normalize", BatchSize, [&] {
+		s4.view().normalized(s4_out.view());
+		Consume(s4_out[BatchSize - 1]);
+	});
+
+	// Matrices
+	suite.Run("mat2.multiply", BatchSize, [&] {
+		for (size_t i = 0; i < BatchSize; ++i)
+			m2[i] = in.m2[i] * in.m2[BatchSize - 1 - i];
+		Consume(m2[BatchSize - 1]);
+	});
+	suite.Run("mat2.inverse", BatchSize, [&] {
+		for (size_t i = 0; i < BatchSize; ++i)
+			m2[i] = in.m2[i].inverse();
+		Consume(m2[BatchSize - 1]);
+	});
+	suite.Run("mat3.multiply", BatchSize, [&] {
+		for (size_t i = 0; i < BatchSize; ++i)
+			m3[i] = in.m3[i] * in.m3[BatchSize - 1 - i];
+		Consume(m3[BatchSize - 1]);
+	});
+	suite.Run("mat3.multiply_vec3", BatchSize, [&] {
+		for (size_t i = 0; i < BatchSize; ++i)
+			v3[i] = in.m3[i] * in.v3[i];
+		Consume(v3[BatchSize - 1]);
+	});
+	suite.Run("mat3.inverse", BatchSize, [&] {
+		for (size_t i = 0; i < BatchSize; ++i)
+			m3[i] = in.m3[i].inverse();
+		Consume(m3[BatchSize - 1]);
+	});
+	suite.Run("mat4.multiply", BatchSize, [&] {
+		for (size_t i = 0; i < BatchSize; ++i)
+			m4[i] = in.m4[i] * in.m4[BatchSize - 1 - i];
+		Consume(m4[BatchSize - 1]);
+	});
+	suite.Run("mat4.multiply_vec4", BatchSize, [&] {
+		for (size_t i = 0; i < BatchSize; ++i)
+			v4[i] = in.m4[i] * in.v4[i];
+		Consume(v4[BatchSize - 1]);
+	});
+	suite.Run("mat4.transpose", BatchSize, [&] {
+		for (size_t i = 0; i < BatchSize; ++i)
+			m4[i] = in.m4[i].transposed();
+		Consume(m4[BatchSize - 1]);
+	});
+	suite.Run("mat4.inverse", BatchSize, [&] {
+		for (size_t i = 0; i < BatchSize; ++i)
+			m4[i] = in.m4[i].inverse();
+		Consume(m4[BatchSize - 1]);
+	});
+	suite.Run("mat4.get_rotation", BatchSize, [&] {
+		for (size_t i = 0; i < BatchSize; ++i)
+			q[i] = mat4(in.qa[i]).get_rotation();
+		Consume(q[BatchSize - 1]);
+	});
+	suite.Run("affine3.multiply", BatchSize, [&] {
+		for (size_t i = 0; i < BatchSize; ++i)
+			affine[i] = in.affine[i] * in.affine[BatchSize - 1 - i];
+		Consume(affine[BatchSize - 1]);
+	});
+	suite.Run("affine3.inverse", BatchSize, [&] {
+		for (size_t i = 0; i < BatchSize; ++i)
+			affine[i] = in.affine[i].inverse();
+		Consume(affine[BatchSize - 1]);
+	});
+	suite.Run("batch.transform_points", BatchSize, [&] {
+		TransformPoints(in.m4[0], in.v3.data(), v3.data(), BatchSize);
+		Consume(v3[BatchSize - 1]);
+	});
+	suite.Run("batch.transform_normals", BatchSize, [&] {
+		TransformNormals(in.m4[0], in.v3.data(), v3.data(), BatchSize);
+		Consume(v3[BatchSize - 1]);
+	});
+
+	// Quaternions
+	suite.Run("quat.multiply", BatchSize, [&] {
+		for (size_t i = 0; i < BatchSize; ++i)
+			q[i] = in.qa[i] * in.qb[i];
+		Consume(q[BatchSize - 1]);
+	});
+	suite.Run("quat.to_mat3", BatchSize, [&] {
+		for (size_t i = 0; i < BatchSize; ++i)
+			m3[i] = mat3(in.qa[i]);
+		Consume(m3[BatchSize - 1]);
+	});
+	suite.Run("quat.nlerp", BatchSize, [&] {
+		for (size_t i = 0; i < BatchSize; ++i)
+			q[i] = Quaternion::nlerp(in.qa[i], in.qb[i], in.t[i]);
+		Consume(q[BatchSize - 1]);
+	});
+	suite.Run("quat.slerp", BatchSize, [&] {
+		for (size_t i = 0; i < BatchSize; ++i)
+			q[i] = Quaternion::slerp(in.qa[i], in.qb[i], in.t[i]);
+		Consume(q[BatchSize - 1]);
+	});
+	suite.Run("quat.slerp_fast", BatchSize, [&] {
+		for (size_t i = 0; i < BatchSize; ++i)
+			q[i] = Quaternion::slerp<MathPrecision::Fast>(in.qa[i], in.qb[i], in.t[i]);
+		Consume(q[BatchSize - 1]);
+	});
+	suite.Run("batch.quat_to_mat3", BatchSize, [&] {
+		QuaternionsToMat3(in.qa.data(), m3.data(), BatchSize);
+		Consume(m3[BatchSize - 1]);
+	});
+	suite.Run("batch.quat_nlerp", BatchSize, [&] {
+		NlerpQuaternions(in.qa.data(), in.qb.data(), in.t.data(), q.data(), BatchSize);
+		Consume(q[BatchSize - 1]);
+	});
+	suite.Run("batch.quat_slerp", BatchSize, [&] {
+		SlerpQuaternions(in.qa.data(), in.qb.data(), in.t.data(), q.data(), BatchSize);
+		Consume(q[BatchSize - 1]);
+	});
+
+	// Culling
+	// Same projection as the default CameraObject, looking at the origin from +z
+	const mat4 projection(
+		vec4(0.974f, 0, 0, 0),
+		vec4(0, 1.732f, 0, 0),
+		vec4(0, 0, -1.020f, -1),
+		vec4(0, 0, -2.020f, 0)
+	);
+	const Frustum frustum(projection * mat4(vec3(0, 0, 20), vec3(), vec3::up()));
+	Array<Containment> containment(BatchSize);
+	Array<uint32_t> visible(BatchSize);
+	const SphereSoA spheres = { in.bx.data(), in.by.data(), in.bz.data(), in.be.data() };
+	const AABBSoA boxes = { in.bx.data(), in.by.data(), in.bz.data(), in.be.data(), in.be.data(), in.be.data() };
+	suite.Run("frustum.classify_aabb", BatchSize, [&] {
+		for (size_t i = 0; i < BatchSize; ++i)
+			containment[i] = frustum.classify(AABB::from_center_extents(vec3(in.bx[i], in.by[i], in.bz[i]), vec3(in.be[i])));
+		Consume(containment[BatchSize - 1]);
+	});
+	suite.Run("batch.classify_aabbs", BatchSize, [&] {
+		ClassifyAABBs(frustum, boxes, containment.data(), BatchSize);
+		Consume(containment[BatchSize - 1]);
+	});
+	suite.Run("batch.cull_spheres", BatchSize, [&] {
+		Consume(CullSpheres(frustum, spheres, visible.data(), BatchSize));
+	});
+
+	// Scalar functions
+	suite.Run("mathf.sin", BatchSize, [&] {
+		for (size_t i = 0; i < BatchSize; ++i)
+			f[i] = Mathf::sin(in.angles[i]);
+		Consume(f[BatchSize - 1]);
+	});
+	suite.Run("mathf.sin_fast", BatchSize, [&] {
+		Mathf::sin<MathPrecision::Fast>(in.angles.data(), f.data(), BatchSize);
+		Consume(f[BatchSize - 1]);
+	});
+	suite.Run("mathf.acos_fast", BatchSize, [&] {
+		Mathf::acos<MathPrecision::Fast>(in.t.data(), f.data(), BatchSize);
+		Consume(f[BatchSize - 1]);
+	});
+	suite.Run("mathf.rsqrt_fast", BatchSize, [&] {
+		Mathf::rsqrt<MathPrecision::Fast>(in.t.data(), f.data(), BatchSize);
+		Consume(f[BatchSize - 1]);
+	});
+	Random random(1);
+	suite.Run("random.fill", BatchSize, [&] {
+		random.fill(f.data(), BatchSize);
+		Consume(f[BatchSize - 1]);
+	});
+
+	printf("\n  }\n}\n");
+	return 0;
+}
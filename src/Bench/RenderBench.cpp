@@ -0,0 +1,215 @@
+// Micro-benchmarks for draw submission. Runs on a NullRenderDevice: no GPU, display or GL loader.
+//
+// Usage: RenderBench [filter]
+//   filter  Only run cases whose name contains this string
+//
+// Prints one JSON document to stdout like MathBench, with format "RenderBench/1".
+// Each case draws a frame of N meshes, so ns/op is the CPU cost of one draw.
+// "direct" draws in submission order with Mesh::Draw, setting the material before each draw;
+// "queue" submits to a RenderQueue and executes it.
+// "instanced" draws one sphere at every model matrix with a single Mesh::DrawInstanced. The null
+// device does not copy buffer contents, so its times leave out the matrix upload.
+// The header reports the commands one frame of each records, and heap allocations of a warm
+// queue frame, which should be 0.
+
+#include "../Graphics/CameraObject.h"
+#include "../Graphics/Graphics.h"
+#include "../Graphics/LightObject.h"
+#include "../Graphics/Material.h"
+#include "../Graphics/Mesh.h"
+#include "../Graphics/NullRenderDevice.h"
+#include "../Graphics/PhongPipeline.h"
+#include "../Graphics/RenderQueue.h"
+#include "../Math/Random.h"
+#include "../Utilities/HeapStats.h"
+#include "Bench.h"
+
+namespace
+{
+	using bench::Consume;
+
+	constexpr size_t MeshCount = 16;
+	constexpr size_t MaterialCount = 8;
+
+	/// @brief Shared meshes and materials, drawn many times at random places
+	struct Scene
+	{
+		SharedPtr<PhongPipeline> pipeline;
+		Array<SharedPtr<Material>> materials;
+		Array<UniquePtr<Mesh>> meshes;
+		UniquePtr<CameraObject> camera;
+		UniquePtr<SunLightObject> sun;
+		UniquePtr<OmniLightObject> omni;
+		Array<Mesh*> draws;
+		Array<mat4> models;
+	};
+
+	NullRenderDevice* InstallDevice()
+	{
+		auto device = MakeUnique<NullRenderDevice>();
+		NullRenderDevice* raw = device.get();
+		device->AddUniform("MVP.Model", UniformType::Mat4);
+		device->AddUniform("Config.UseHalfLambert", UniformType::Bool);
+		device->AddUniform("Config.UseBlinnPhong", UniformType::Bool);
+		device->AddUniform("Material.Diffuse", UniformType::Vec4);
+		device->AddUniform("Material.DiffuseMap", UniformType::Sampler);
+		device->AddUniform("Material.UseDiffuseMap", UniformType::Bool);
+		device->AddUniform("Material.Specular", UniformType::Float);
+		device->AddUniform("Material.Glossiness", UniformType::Float);
+		device->AddUniformBlock("FrameBlock", sizeof(FrameUniforms));
+		device->AddUniformBlock("LightBlock", sizeof(LightUniforms));
+		Graphics::GetSingleton()->SetDevice(std::move(device));
+		return raw;
+	}
+
+	void MakeScene(Scene& scene, size_t drawCount)
+	{
+		scene.pipeline = MakeShared<PhongPipeline>();
+		Random random(20240701);
+		for (size_t i = 0; i < MaterialCount; ++i)
+		{
+			auto material = MakeShared<Material>();
+			material->diffuse = Color(random.range(0, 1), random.range(0, 1), random.range(0, 1));
+			scene.materials.push_back(material);
+		}
+		for (size_t i = 0; i < MeshCount; ++i)
+		{
+			const SharedPtr<Material>& material = scene.materials[i % MaterialCount];
+			Mesh* mesh = (i % 2) ? Mesh::NewSphere(scene.pipeline, 1.0f, 16, VertexAttributes(), material)
+				: Mesh::NewCube(scene.pipeline, 1.0f, VertexAttributes(), material);
+			mesh->BindGPUResources();
+			scene.meshes.emplace_back(mesh);
+		}
+		scene.camera = MakeUnique<CameraObject>();
+		scene.camera->lookAt = mat4(vec3(0, 20, 60), vec3(0), vec3::up());
+		scene.camera->farClip = 200.0f;
+		scene.sun = MakeUnique<SunLightObject>();
+		scene.omni = MakeUnique<OmniLightObject>();
+		for (size_t i = 0; i < drawCount; ++i)
+		{
+			scene.draws.push_back(scene.meshes[random.next_u32() % MeshCount].get());
+			mat4 model;
+			model.cols[3] = vec4(random.range(-50, 50), random.range(-50, 50), random.range(-50, 50), 1);
+			scene.models.push_back(model);
+		}
+	}
+
+	void SetFrameParams(Scene& scene)
+	{
+		Graphics::GetSingleton()->UsePipeline(scene.pipeline);
+		scene.pipeline->SetCameraParams(scene.camera.get());
+		scene.pipeline->SetLightParams(scene.sun.get());
+		scene.pipeline->SetLightParams(0, scene.omni.get());
+	}
+
+	void DrawDirect(Scene& scene)
+	{
+		SetFrameParams(scene);
+		for (size_t i = 0; i < scene.draws.size(); ++i)
+		{
+			scene.pipeline->SetMaterialParams(scene.draws[i]->GetMaterial().get());
+			scene.draws[i]->Draw(scene.models[i]);
+		}
+	}
+
+	void DrawQueued(Scene& scene, RenderQueue& queue)
+	{
+		SetFrameParams(scene);
+		queue.Begin(*scene.camera);
+		for (size_t i = 0; i < scene.draws.size(); ++i)
+			queue.Submit(scene.draws[i], scene.models[i]);
+		queue.Execute();
+	}
+
+	void DrawInstanced(Scene& scene, Mesh& mesh, size_t count)
+	{
+		const SharedPtr<Pipeline>& pipeline = mesh.GetPipeline();
+		Graphics::GetSingleton()->UsePipeline(pipeline);
+		pipeline->SetCameraParams(scene.camera.get());
+		pipeline->SetLightParams(scene.sun.get());
+		pipeline->SetLightParams(0, scene.omni.get());
+		pipeline->SetMaterialParams(mesh.GetMaterial().get());
+		mesh.DrawInstanced({ scene.models.data(), count });
+	}
+
+	/// @brief Commands and bytes recorded by one frame of draw
+	template <typename Draw>
+	std::pair<size_t, size_t> RecordFrame(NullRenderDevice* device, Draw&& draw)
+	{
+		device->ClearCommands();
+		draw();
+		return { device->GetCommandCount(), device->GetCommands().size() };
+	}
+}
+
+int main(int argc, char** argv)
+{
+	bench::Suite suite;
+	suite.filter = argc > 1 ? argv[1] : nullptr;
+
+	NullRenderDevice* device = InstallDevice();
+	constexpr size_t DrawCount = 100000;
+	Scene scene;
+	MakeScene(scene, DrawCount);
+	RenderQueue queue;
+	UniquePtr<Mesh> instanced(Mesh::NewSphere(MakeShared<PhongPipeline>(true), 1.0f, 16, VertexAttributes(),
+		scene.materials[0]));
+	instanced->BindGPUResources();
+
+	const auto direct = RecordFrame(device, [&] { DrawDirect(scene); });
+	const auto queued = RecordFrame(device, [&] { DrawQueued(scene, queue); });
+	const RenderQueueStats stats = queue.GetStats();
+	// The first frame creates and attaches the instance buffer, report a warm one
+	RecordFrame(device, [&] { DrawInstanced(scene, *instanced, DrawCount); });
+	const auto instancedFrame = RecordFrame(device, [&] { DrawInstanced(scene, *instanced, DrawCount); });
+	const size_t instancedDraws = device->GetCommandCount(NullRenderDevice::Command::DrawIndexedInstanced);
+	const size_t before = GetHeapAllocationCount();
+	RecordFrame(device, [&] { DrawQueued(scene, queue); });
+	const size_t queueAllocations = GetHeapAllocationCount() - before;
+
+	printf("{\n  \"format\": \"RenderBench/1\",\n  \"draws\": %zu,\n"
+		"  \"direct_commands\": %zu,\n  \"direct_command_bytes\": %zu,\n"
+		"  \"queue_commands\": %zu,\n  \"queue_command_bytes\": %zu,\n  \"queue_state_changes\": %zu,\n"
+		"  \"queue_heap_allocations\": %zu,\n"
+		"  \"instanced_commands\": %zu,\n  \"instanced_command_bytes\": %zu,\n  \"instanced_draw_calls\": %zu,\n"
+		"  \"unit\": \"ns/op\",\n  \"results\": {",
+		DrawCount, direct.first, direct.second, queued.first, queued.second, stats.StateChanges(), queueAllocations,
+		instancedFrame.first, instancedFrame.second, instancedDraws);
+
+	for (size_t count : { 1000, 10000, 100000 })
+	{
+		const AnsiString suffix = "/" + std::to_string(count);
+		Scene frame;
+		frame.pipeline = scene.pipeline;
+		frame.camera = MakeUnique<CameraObject>(*scene.camera);
+		frame.sun = MakeUnique<SunLightObject>();
+		frame.omni = MakeUnique<OmniLightObject>();
+		frame.draws.assign(scene.draws.begin(), scene.draws.begin() + count);
+		frame.models.assign(scene.models.begin(), scene.models.begin() + count);
+
+		suite.Run(("render.direct" + suffix).c_str(), count, [&] {
+			device->ClearCommands();
+			DrawDirect(frame);
+			Consume(device->GetCommandCount());
+		});
+		suite.Run(("render.queue_submit" + suffix).c_str(), count, [&] {
+			queue.Begin(*frame.camera);
+			for (size_t i = 0; i < count; ++i)
+				queue.Submit(frame.draws[i], frame.models[i]);
+			Consume(queue.GetSubmissionCount());
+		});
+		suite.Run(("render.queue" + suffix).c_str(), count, [&] {
+			device->ClearCommands();
+			DrawQueued(frame, queue);
+			Consume(device->GetCommandCount());
+		});
+		suite.Run(("render.instanced" + suffix).c_str(), count, [&] {
+			device->ClearCommands();
+			DrawInstanced(frame, *instanced, count);
+			Consume(device->GetCommandCount());
+		});
+	}
+
+	printf("\n  }\n}\n");
+	return 0;
+}
@@ -0,0 +1,401 @@
+// Micro-benchmarks for the Scene module. Links nothing but the C++ runtime.
+//
+// Usage: SceneBench [filter]
+//   filter  Only run cases whose name contains this string
+//
+// Prints one JSON document to stdout like MathBench, with format "SceneBench/1".
+// Case names end with the child or node count, so scaling is visible in one run:
+// a flat ns/op across counts means constant time per operation.
+// "spawn_heap_allocations" counts general heap allocations over warm rounds of destroying and
+// creating children and updating transforms; it should be 0.
+
+#include "../Scene/BVH.h"
+#include "../Scene/Node.h"
+#include "../Scene/SceneFile.h"
+#include "../Scene/SpatialHash.h"
+#include "../Scene/Transform.h"
+#include "../Scene/TransformSystem.h"
+#include "../Math/Random.h"
+#include "../Utilities/HeapStats.h"
+#include "../Utilities/ThreadPool.h"
+#include "Bench.h"
+
+namespace
+{
+	using bench::Consume;
+
+	constexpr size_t LookupCount = 1024;
+
+	Array<AnsiString> MakeNames(size_t count)
+	{
+		Array<AnsiString> names;
+		for (size_t i = 0; i < count; ++i)
+			names.push_back("child_" + std::to_string(i));
+		return names;
+	}
+
+	/// @brief Random hierarchy of count nodes below root, each node a child of an earlier one
+	Array<Node*> MakeTree(Node* root, size_t count, const Array<AnsiString>& names)
+	{
+		Random random(20240601);
+		Array<Node*> nodes = { root };
+		for (size_t i = 1; i < count; ++i)
+		{
+			Node* parent = nodes[random.next_u32() % nodes.size()];
+			Node* node = parent->CreateChild(names[i]);
+			Transform* t = node->GetTransform();
+			t->SetPosition(vec3(random.range(-1, 1), random.range(-1, 1), random.range(-1, 1)));
+			t->SetRotation(Quaternion(vec3(random.range(-1, 1), 1, random.range(-1, 1)), random.range(-3, 3)));
+			nodes.push_back(node);
+		}
+		return nodes;
+	}
+
+	/// @brief Replace every child of parent by a new one of the same name, then update transforms
+	void Respawn(Node& parent, Array<Node*>& children, const Array<AnsiString>& names)
+	{
+		for (size_t i = 0; i < children.size(); ++i)
+		{
+			delete parent.ReleaseChild(children[i]);
+			children[i] = parent.CreateChild(names[i]);
+		}
+		TransformSystem::GetSingleton()->Update();
+	}
+
+	/// @brief Heap allocations of Respawn() once warm
+	size_t SpawnHeapAllocations(const Array<AnsiString>& names)
+	{
+		Node parent("parent");
+		Array<Node*> children;
+		for (size_t i = 0; i < 1000; ++i)
+			children.push_back(parent.CreateChild(names[i]));
+		for (int round = 0; round < 4; ++round)
+			Respawn(parent, children, names);
+		const size_t before = GetHeapAllocationCount();
+		for (int round = 0; round < 4; ++round)
+			Respawn(parent, children, names);
+		return GetHeapAllocationCount() - before;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	bench::Suite suite;
+	suite.filter = argc > 1 ? argv[1] : nullptr;
+	const Array<AnsiString> names = MakeNames(100000);
+
+	ThreadPool pool;
+	const size_t spawnAllocations = SpawnHeapAllocations(names);
+
+	printf("{\n  \"format\": \"SceneBench/1\",\n  \"backend\": \"%s\",\n  \"threads\": %zu,\n"
+		"  \"spawn_heap_allocations\": %zu,\n"
+		"  \"unit\": \"ns/op\",\n  \"results\": {",
+		simd::backend_name(), pool.GetThreadCount(), spawnAllocations);
+
+	// Children by name
+	for (size_t count : { 16, 1000, 10000, 100000 })
+	{
+		const AnsiString suffix = "/" + std::to_string(count);
+		suite.Run(("node.create_children" + suffix).c_str(), count, [&] {
+			Node parent("parent");
+			for (size_t i = 0; i < count; ++i)
+				parent.CreateChild(names[i]);
+			Consume(parent.GetChild(names[count - 1]));
+		});
+
+		Node parent("parent");
+		for (size_t i = 0; i < count; ++i)
+			parent.CreateChild(names[i]);
+		Array<AnsiStringView> queries;
+		Random random(7);
+		for (size_t i = 0; i < LookupCount; ++i)
+			queries.push_back(names[random.next_u32() % count]);
+		suite.Run(("node.get_child" + suffix).c_str(), LookupCount, [&] {
+			Node* found = nullptr;
+			for (AnsiStringView name : queries)
+				found = parent.GetChild(name);
+			Consume(found);
+		});
+	}
+
+	// Spawn and despawn below one parent
+	for (size_t count : { 16, 1000 })
+	{
+		Node parent("parent");
+		Array<Node*> children;
+		for (size_t i = 0; i < count; ++i)
+			children.push_back(parent.CreateChild(names[i]));
+		suite.Run(("node.respawn/" + std::to_string(count)).c_str(), count, [&] {
+			Respawn(parent, children, names);
+			Consume(children.back());
+		});
+	}
+
+	// Paths
+	{
+		Node root("root");
+		Node* node = &root;
+		AnsiString path;
+		for (size_t i = 0; i < 8; ++i)
+		{
+			for (size_t k = 0; k < 100; ++k)
+				node->CreateChild(names[k]);
+			node = node->GetChild(names[i * 7]);
+			path += (i == 0 ? "" : "/") + names[i * 7];
+		}
+		suite.Run("node.get_child_chain/8", 1, [&] {
+			Node* cur = &root;
+			for (size_t i = 0; i < 8 && cur; ++i)
+				cur = cur->GetChild(names[i * 7]);
+			Consume(cur);
+		});
+		suite.Run("node.find_by_path/8", 1, [&] {
+			Consume(root.FindByPath(path));
+		});
+	}
+
+	// Components by type
+	{
+		Node root("root");
+		const Array<Node*> nodes = MakeTree(&root, 10000, names);
+		suite.Run("component.get/10000", nodes.size(), [&] {
+			uint32_t sum = 0;
+			for (Node* node : nodes)
+				sum += node->GetComponent<Transform>()->GetWorldGeneration();
+			Consume(sum);
+		});
+		suite.Run("component.for_each/10000", nodes.size(), [&] {
+			uint32_t sum = 0;
+			ForEachComponent<Transform>([&](Transform& t) { sum += t.GetWorldGeneration(); });
+			Consume(sum);
+		});
+	}
+
+	// World transform updates
+	for (size_t count : { 1000, 100000 })
+	{
+		const AnsiString suffix = "/" + std::to_string(count);
+		TransformSystem* system = TransformSystem::GetSingleton();
+		Node root("root");
+		const Array<Node*> nodes = MakeTree(&root, count, names);
+		system->Update();
+		system->Update();
+		suite.Run(("transform.update_all" + suffix).c_str(), count, [&] {
+			root.GetTransform()->Rotate(Quaternion(vec3::up(), 0.01f));
+			system->Update();
+			Consume(system->GetChangedEntries().size());
+		});
+		suite.Run(("transform.update_all_parallel" + suffix).c_str(), count, [&] {
+			root.GetTransform()->Rotate(Quaternion(vec3::up(), 0.01f));
+			system->Update(&pool);
+			Consume(system->GetChangedEntries().size());
+		});
+		suite.Run(("transform.update_one" + suffix).c_str(), 1, [&] {
+			nodes.back()->GetTransform()->Translate(vec3(0.01f, 0, 0));
+			system->Update();
+			Consume(system->GetChangedEntries().size());
+		});
+		Array<mat4> matrices(system->GetCount());
+		suite.Run(("transform.export_world_matrices" + suffix).c_str(), count, [&] {
+			system->ExportWorldMatrices(matrices);
+			Consume(matrices.back());
+		});
+		suite.Run(("transform.update_export_all" + suffix).c_str(), count, [&] {
+			root.GetTransform()->Rotate(Quaternion(vec3::up(), 0.01f));
+			system->Update();
+			system->ExportWorldMatrices(matrices);
+			Consume(matrices.back());
+		});
+		suite.Run(("transform.local_to_world" + suffix).c_str(), count, [&] {
+			vec3 sum;
+			for (Node* node : nodes)
+				sum += node->GetTransform()->LocalToWorld(vec3(1, 2, 3));
+			Consume(sum);
+		});
+	}
+
+	// Scene files
+	{
+		const char* path = "SceneBench.scene";
+		Node root("root");
+		MakeTree(&root, 100000, names);
+		const SceneWriter writer(root);
+		suite.Run("scene.serialize/100000", 100000, [&] {
+			Consume(writer.Serialize().size());
+		});
+		writer.Write(path);
+		suite.Run("scene.open/100000", 100000, [&] {
+			SceneFile file(path);
+			Consume(file.GetNodeCount());
+		});
+		const SceneFile file(path);
+		suite.Run("scene.instantiate/100000", 100000, [&] {
+			UniquePtr<Node> loaded(file.Instantiate(nullptr));
+			Consume(loaded.get());
+		});
+		std::remove(path);
+	}
+
+	// Bounding volume hierarchy over unit-ish boxes scattered in a 200 unit cube
+	{
+		constexpr size_t Count = 100000;
+		constexpr size_t QueryCount = 256;
+		TransformSystem* system = TransformSystem::GetSingleton();
+		Node root("root");
+		Random random(5);
+		Array<Node*> nodes;
+		for (size_t i = 0; i < Count; ++i)
+		{
+			Node* node = root.CreateChild(names[i]);
+			node->GetTransform()->SetPosition(vec3(random.range(-100, 100), random.range(-100, 100), random.range(-100, 100)));
+			nodes.push_back(node);
+		}
+		system->Update();
+		BVH bvh;
+		for (Node* node : nodes)
+			bvh.Insert(node, AABB(vec3(-0.5f), vec3(0.5f)));
+		suite.Run("bvh.build/100000", Count, [&] {
+			bvh.Build();
+			Consume(bvh.GetHeight());
+		});
+		suite.Run("bvh.refit_moved/100000", 1000, [&] {
+			for (size_t i = 0; i < 1000; ++i)
+				nodes[random.next_u32() % Count]->GetTransform()->Translate(vec3(random.range(-1, 1), 0, 0));
+			system->Update();
+			bvh.Refit();
+			Consume(bvh.GetHeight());
+		});
+
+		Array<Frustum> frusta;
+		Array<Sphere> spheres;
+		Array<Ray> rays;
+		const mat4 projection(
+			vec4(0.974f, 0, 0, 0),
+			vec4(0, 1.732f, 0, 0),
+			vec4(0, 0, -1.020f, -1),
+			vec4(0, 0, -2.020f, 0)
+		);
+		for (size_t i = 0; i < QueryCount; ++i)
+		{
+			const vec3 eye(random.range(-100, 100), random.range(-100, 100), random.range(-100, 100));
+			const vec3 target(random.range(-100, 100), random.range(-100, 100), random.range(-100, 100));
+			frusta.emplace_back(projection * mat4(eye, target, vec3::up()));
+			spheres.emplace_back(target, 10.0f);
+			rays.emplace_back(eye, (target - eye).normalized());
+		}
+		Array<Node*> found;
+		suite.Run("bvh.query_frustum/100000", QueryCount, [&] {
+			found.clear();
+			for (const Frustum& frustum : frusta)
+				bvh.Query(frustum, found);
+			Consume(found.size());
+		});
+		suite.Run("bvh.query_sphere/100000", QueryCount, [&] {
+			found.clear();
+			for (const Sphere& sphere : spheres)
+				bvh.Query(sphere, found);
+			Consume(found.size());
+		});
+		Array<BVH::RayHit> hits(QueryCount);
+		suite.Run("bvh.raycast/100000", QueryCount, [&] {
+			bvh.Raycast(rays.data(), hits.data(), QueryCount);
+			Consume(hits.back().node);
+		});
+		// Every node moving every frame, against the same objects in a spatial hash
+		SpatialHash hash(2.0f);
+		for (Node* node : nodes)
+			hash.Insert(node, 0.87f);
+		auto moveAll = [&] {
+			for (Node* node : nodes)
+				node->GetTransform()->Translate(vec3(random.range(-0.5f, 0.5f), random.range(-0.5f, 0.5f), 0));
+			system->Update();
+		};
+		suite.Run("bvh.refit_all_moving/100000", Count, [&] {
+			moveAll();
+			bvh.Refit();
+			Consume(bvh.GetHeight());
+		});
+		suite.Run("spatial_hash.refit_all_moving/100000", Count, [&] {
+			moveAll();
+			hash.Refit();
+			Consume(hash.GetCellCount());
+		});
+		for (Node* node : nodes)
+			hash.Remove(hash.GetProxy(node));
+
+		// The same sphere queries without the tree, for scale
+		Array<AABB> bounds;
+		for (Node* node : nodes)
+			bounds.push_back(bvh.GetWorldBounds(bvh.GetProxy(node)));
+		suite.Run("bvh.query_sphere_linear/100000", QueryCount, [&] {
+			size_t hit = 0;
+			for (const Sphere& sphere : spheres)
+			{
+				for (const AABB& box : bounds)
+					hit += sphere.intersects(box);
+			}
+			Consume(hit);
+		});
+	}
+
+	// Particles without nodes: every one moves every frame, then some look for neighbors
+	{
+		constexpr size_t Count = 100000;
+		constexpr size_t QueryCount = 1024;
+		Random random(11);
+		Array<float> x(Count), y(Count), z(Count), radius(Count);
+		Array<vec3> velocity(Count);
+		for (size_t i = 0; i < Count; ++i)
+		{
+			x[i] = random.range(-100, 100);
+			y[i] = random.range(-100, 100);
+			z[i] = random.range(-100, 100);
+			radius[i] = random.range(0.1f, 0.5f);
+			velocity[i] = vec3(random.range(-1, 1), random.range(-1, 1), random.range(-1, 1));
+		}
+		const SphereSoA spheres = { x.data(), y.data(), z.data(), radius.data() };
+		SpatialHash hash(2.0f);
+		suite.Run("spatial_hash.build/100000", Count, [&] {
+			hash.Build(spheres, Count);
+			Consume(hash.GetCellCount());
+		});
+		hash.Build(spheres, Count);
+		auto step = [&] {
+			for (uint32_t i = 0; i < Count; ++i)
+			{
+				vec3 p = hash.GetBounds(i).center + velocity[i];
+				// Bounce off the walls of the 200 unit cube
+				if (Mathf::abs(p.x) > 100)
+					velocity[i].x = -velocity[i].x;
+				if (Mathf::abs(p.y) > 100)
+					velocity[i].y = -velocity[i].y;
+				if (Mathf::abs(p.z) > 100)
+					velocity[i].z = -velocity[i].z;
+				hash.Move(i, p);
+			}
+		};
+		Array<uint32_t> found;
+		auto queryNeighbors = [&] {
+			found.clear();
+			for (uint32_t i = 0; i < QueryCount; ++i)
+				hash.QueryNeighbors(i * (Count / QueryCount), 2.0f, found);
+		};
+		suite.Run("spatial_hash.move_all/100000", Count, [&] {
+			step();
+			Consume(hash.GetCellCount());
+		});
+		suite.Run("spatial_hash.query_neighbors/100000", QueryCount, [&] {
+			queryNeighbors();
+			Consume(found.size());
+		});
+		// One frame: move everything, then query; per particle
+		suite.Run("spatial_hash.frame/100000", Count, [&] {
+			step();
+			queryNeighbors();
+			Consume(found.size());
+		});
+	}
+
+	printf("\n  }\n}\n");
+	return 0;
+}
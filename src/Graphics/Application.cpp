@@ -2,6 +2,7 @@
 
 #include "Graphics.h"
 #include "GfxConfigs.h"
+#include "GLRenderDevice.h"
 #include "../Math/Mathf.h"
 #include "../Control/GamePlay.h"
 
@@ -69,7 +70,7 @@ int Application::Exec()
 		return result;
 	}
 
-	result = gfx->Initialize();
+	result = gfx->Initialize(MakeUnique<GLRenderDevice>(), m_pConfig->ScreenWidth, m_pConfig->ScreenHeight);
 	if (result)
 	{
 		Graphics::GetSingleton()->Finalize();
@@ -1,6 +1,6 @@
 #pragma once
 
-#include "..\Math\mat4.h"
+#include "..\Math\Frustum.h"
 
 enum class CameraType
 {
@@ -34,6 +34,18 @@ public:
 		}
 	}
 
+	/// @brief World space eye position. lookAt is affine, so this skips the full 4x4 inverse.
+	vec3 GetPosition() const noexcept
+	{
+		return Affine3(lookAt).inverse().get_translation();
+	}
+
+	/// @brief World space view frustum, for culling bounds before they are drawn.
+	Frustum GetFrustum() const noexcept
+	{
+		return Frustum(GetProjectionMatrix() * lookAt);
+	}
+
 	mat4 lookAt = mat4(vec3(2, 1, 0), vec3(0, 1, 0), vec3::up());
 	CameraType type = CameraType::Perspective;
 	float farClip = 100.0f;
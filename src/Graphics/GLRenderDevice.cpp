@@ -0,0 +1,555 @@
+#include "GLRenderDevice.h"
+
+#include "Texture.h"
+
+#include "../Math/mat4.h"
+#include "../Resources/Image.h"
+
+#include <glad/glad.h>
+
+#include <cassert>
+#include <cstdio>
+
+enum class ShaderType
+{
+	VertexShader = 'vert',
+	PixelShader = 'frag'
+};
+
+static void APIENTRY glDebugOutput(GLenum source, GLenum type, unsigned int id,
+	GLenum severity, GLsizei length,
+	const char* message, const void* userParam);
+
+static GLenum GetGLPrimitive(PrimitiveType type);
+
+static UniformType GetUniformType(GLenum type) noexcept
+{
+	switch (type)
+	{
+	case GL_BOOL:
+		return UniformType::Bool;
+	case GL_INT:
+		return UniformType::Int;
+	case GL_FLOAT:
+		return UniformType::Float;
+	case GL_FLOAT_VEC2:
+		return UniformType::Vec2;
+	case GL_FLOAT_VEC3:
+		return UniformType::Vec3;
+	case GL_FLOAT_VEC4:
+		return UniformType::Vec4;
+	case GL_FLOAT_MAT3:
+		return UniformType::Mat3;
+	case GL_FLOAT_MAT4:
+		return UniformType::Mat4;
+	case GL_SAMPLER_1D:
+	case GL_SAMPLER_2D:
+	case GL_SAMPLER_3D:
+	case GL_SAMPLER_CUBE:
+	case GL_SAMPLER_1D_SHADOW:
+	case GL_SAMPLER_2D_SHADOW:
+	case GL_SAMPLER_1D_ARRAY:
+	case GL_SAMPLER_2D_ARRAY:
+	case GL_SAMPLER_2D_ARRAY_SHADOW:
+	case GL_SAMPLER_CUBE_SHADOW:
+	case GL_SAMPLER_2D_MULTISAMPLE:
+	case GL_SAMPLER_BUFFER:
+		return UniformType::Sampler;
+	default:
+		return UniformType::Other;
+	}
+}
+
+static GLenum GetGLTextureWrapMode(TextureWrapMode mode) noexcept
+{
+	switch (mode)
+	{
+	case TextureWrapMode::Repeat:
+		return GL_REPEAT;
+	case TextureWrapMode::MirroredRepeat:
+		return GL_MIRRORED_REPEAT;
+	case TextureWrapMode::ClampToEdge:
+		return GL_CLAMP_TO_EDGE;
+	case TextureWrapMode::ClampToBorder:
+		return GL_CLAMP_TO_BORDER;
+	default:
+		return GL_REPEAT;
+	}
+}
+
+static GLenum GetGLTextureInternalFormat(ImageFormat format)
+{
+	switch (format)
+	{
+	case ImageFormat::RGBA8:
+		return GL_RGBA8;
+	case ImageFormat::RGB8:
+		return GL_RGB8;
+	case ImageFormat::R8:
+		return GL_R8;
+	case ImageFormat::RGBA16:
+		return GL_RGBA16;
+	case ImageFormat::RGB16:
+		return GL_RGB16;
+	case ImageFormat::R16:
+		return GL_R16;
+	default:
+		return GL_RGBA8;
+	}
+}
+
+static GLenum GetGLTextureFormat(ImageFormat format)
+{
+	switch (format)
+	{
+	case ImageFormat::RGBA8:
+	case ImageFormat::RGB16:
+		return GL_RGBA;
+	case ImageFormat::RGB8:
+	case ImageFormat::RGBA16:
+		return GL_RGB;
+	case ImageFormat::R8:
+	case ImageFormat::R16:
+		return GL_R;
+	default:
+		return GL_RGBA;
+	}
+}
+
+static uint32_t CompileShader(AnsiStringView src, ShaderType type)
+{
+	uint32_t shader = glCreateShader(type == ShaderType::VertexShader ? GL_VERTEX_SHADER : GL_FRAGMENT_SHADER);
+	const char* str = src.data();
+	GLint len = static_cast<GLint>(src.length());
+	glShaderSource(shader, 1, &str, &len);
+	glCompileShader(shader);
+
+	GLint flag;
+	glGetShaderiv(shader, GL_COMPILE_STATUS, &flag);
+	if (flag == GL_FALSE)
+	{
+		char* info = new char[1024];
+		glGetShaderInfoLog(shader, 1024, nullptr, info);
+		glDeleteShader(shader);
+		printf("Error compiling shader: %s\n", info);
+		delete[] info;
+		return 0;
+	}
+	return shader;
+}
+
+static bool LinkProgram(uint32_t pipeline)
+{
+	if (pipeline == 0)
+		return false;
+	glLinkProgram(pipeline);
+	GLint flag;
+	glGetProgramiv(pipeline, GL_LINK_STATUS, &flag);
+	if (flag == GL_FALSE)
+	{
+		char* info = new char[1024];
+		glGetProgramInfoLog(pipeline, 1024, nullptr, info);
+		printf("Error linking pipeline: %s\n", info);
+		delete[] info;
+		return false;
+	}
+	return true;
+}
+
+int GLRenderDevice::Initialize(int width, int height)
+{
+	int32_t result = gladLoadGL();
+	if (result == GL_FALSE)
+	{
+		printf("Error: OpenGL load failed!\n");
+		return 10;
+	}
+	else
+	{
+		printf("Info: OpenGL Version %d.%d loaded\n", GLVersion.major, GLVersion.minor);
+		// Set the depth buffer to be entirely cleared to 1.0 values.
+		glClearDepth(1.0f);
+
+		glDisable(GL_DITHER);
+		// Enable depth testing.
+		glEnable(GL_DEPTH_TEST);
+		// Enable MSAA
+		glEnable(GL_MULTISAMPLE);
+
+		// Set the polygon winding to front facing for the right handed system.
+		glFrontFace(GL_CCW);
+
+		// Enable back face culling.
+		glEnable(GL_CULL_FACE);
+		glCullFace(GL_BACK);
+
+		glViewport(0, 0, width, height);
+
+		if (GLAD_GL_VERSION_4_3)
+		{
+			int flags;
+			glGetIntegerv(GL_CONTEXT_FLAGS, &flags);
+			if (flags & GL_CONTEXT_FLAG_DEBUG_BIT)
+			{
+				printf("Info: OpenGL Debug context enabled.\n");
+				glEnable(GL_DEBUG_OUTPUT);
+				glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+				glDebugMessageCallback(glDebugOutput, nullptr);
+				glDebugMessageControl(GL_DONT_CARE, GL_DONT_CARE, GL_DONT_CARE, 0, nullptr, GL_TRUE);
+			}
+		}
+	}
+
+	return 0;
+}
+
+void GLRenderDevice::SetViewport(int width, int height)
+{
+	glViewport(0, 0, width, height);
+}
+
+void GLRenderDevice::Clear(const Color& color)
+{
+	// Set the color to clear the screen to.
+	glClearColor(color.r, color.g, color.b, color.a);
+	// Clear the screen and depth buffer.
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+}
+
+uint32_t GLRenderDevice::CreateProgram(AnsiStringView vsSrc, AnsiStringView psSrc)
+{
+	uint32_t vs = CompileShader(vsSrc, ShaderType::VertexShader);
+	if (vs == 0)
+		return 0;
+	uint32_t ps = CompileShader(psSrc, ShaderType::PixelShader);
+	if (ps == 0)
+	{
+		glDeleteShader(vs);
+		return 0;
+	}
+	uint32_t program = glCreateProgram();
+	glAttachShader(program, vs);
+	glAttachShader(program, ps);
+	if (LinkProgram(program) == false)
+	{
+		glDeleteProgram(program);
+		program = 0;
+	}
+	glDeleteShader(ps);
+	glDeleteShader(vs);
+	return program;
+}
+
+void GLRenderDevice::DeleteProgram(uint32_t program)
+{
+	glDeleteProgram(program);
+}
+
+void GLRenderDevice::UseProgram(uint32_t program)
+{
+	glUseProgram(program);
+}
+
+int32_t GLRenderDevice::GetAttribLocation(uint32_t program, const char* name)
+{
+	return glGetAttribLocation(program, name);
+}
+
+void GLRenderDevice::GetActiveUniforms(uint32_t program, Array<UniformInfo>& out)
+{
+	GLint count = 0, maxLength = 0;
+	glGetProgramiv(program, GL_ACTIVE_UNIFORMS, &count);
+	glGetProgramiv(program, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+	Array<char> buffer(static_cast<size_t>(maxLength) + 1);
+	for (GLint i = 0; i < count; ++i)
+	{
+		GLsizei length = 0;
+		GLint size = 0;
+		GLenum type = GL_NONE;
+		glGetActiveUniform(program, static_cast<GLuint>(i), maxLength, &length, &size, &type, buffer.data());
+		AnsiString name(buffer.data(), static_cast<size_t>(length));
+		const GLint location = glGetUniformLocation(program, name.c_str());
+		out.push_back({ std::move(name), location, GetUniformType(type), size });
+	}
+}
+
+int32_t GLRenderDevice::BindUniformBlock(uint32_t program, const char* name, uint32_t binding)
+{
+	const GLuint index = glGetUniformBlockIndex(program, name);
+	if (index == GL_INVALID_INDEX)
+		return -1;
+	GLint size = 0;
+	glGetActiveUniformBlockiv(program, index, GL_UNIFORM_BLOCK_DATA_SIZE, &size);
+	glUniformBlockBinding(program, index, binding);
+	return size;
+}
+
+void GLRenderDevice::SetUniform(int32_t location, int v)
+{
+	glUniform1i(location, v);
+}
+
+void GLRenderDevice::SetUniform(int32_t location, float v)
+{
+	glUniform1f(location, v);
+}
+
+void GLRenderDevice::SetUniform(int32_t location, const vec3& v)
+{
+	glUniform3fv(location, 1, v);
+}
+
+void GLRenderDevice::SetUniform(int32_t location, const vec4& v)
+{
+	glUniform4fv(location, 1, v);
+}
+
+void GLRenderDevice::SetUniform(int32_t location, const mat4& m)
+{
+	glUniformMatrix4fv(location, 1, GL_FALSE, m.cols[0]);
+}
+
+void GLRenderDevice::SetVertexAttribDefault(int32_t location, const vec4& v)
+{
+	glVertexAttrib4fv(location, v);
+}
+
+uint32_t GLRenderDevice::CreateBuffer(size_t size, const void* data, BufferUsage usage)
+{
+	// Through the copy target, which no draw state depends on, so the bound vertex array keeps its buffers
+	GLuint buffer = 0;
+	glGenBuffers(1, &buffer);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+	glBufferData(GL_COPY_WRITE_BUFFER, static_cast<GLsizeiptr>(size), data,
+		usage == BufferUsage::Static ? GL_STATIC_DRAW : GL_DYNAMIC_DRAW);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+	return buffer;
+}
+
+void GLRenderDevice::DeleteBuffer(uint32_t buffer)
+{
+	glDeleteBuffers(1, &buffer);
+}
+
+void GLRenderDevice::UpdateBuffer(uint32_t buffer, size_t offset, size_t size, const void* data)
+{
+	glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+	glBufferSubData(GL_COPY_WRITE_BUFFER, static_cast<GLintptr>(offset), static_cast<GLsizeiptr>(size), data);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+}
+
+void GLRenderDevice::BindUniformBuffer(uint32_t binding, uint32_t buffer)
+{
+	glBindBufferBase(GL_UNIFORM_BUFFER, binding, buffer);
+}
+
+uint32_t GLRenderDevice::CreateVertexArray()
+{
+	GLuint vertexArray = 0;
+	glGenVertexArrays(1, &vertexArray);
+	return vertexArray;
+}
+
+void GLRenderDevice::DeleteVertexArray(uint32_t vertexArray)
+{
+	glDeleteVertexArrays(1, &vertexArray);
+}
+
+void GLRenderDevice::BindVertexArray(uint32_t vertexArray)
+{
+	glBindVertexArray(vertexArray);
+}
+
+void GLRenderDevice::SetVertexAttribute(int32_t location, uint32_t buffer, int components, bool normalized, size_t offset)
+{
+	glBindBuffer(GL_ARRAY_BUFFER, buffer);
+	glEnableVertexAttribArray(location);
+	glVertexAttribPointer(location, components, GL_FLOAT, normalized ? GL_TRUE : GL_FALSE, 0, reinterpret_cast<const void*>(offset));
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void GLRenderDevice::SetInstanceAttribute(int32_t location, uint32_t buffer, int components, size_t stride, size_t offset)
+{
+	glBindBuffer(GL_ARRAY_BUFFER, buffer);
+	glEnableVertexAttribArray(location);
+	glVertexAttribPointer(location, components, GL_FLOAT, GL_FALSE, static_cast<GLsizei>(stride), reinterpret_cast<const void*>(offset));
+	glVertexAttribDivisor(location, 1);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void GLRenderDevice::SetIndexBuffer(uint32_t buffer)
+{
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffer);
+}
+
+uint32_t GLRenderDevice::CreateTexture2D(const Image& image, TextureWrapMode wrapX, TextureWrapMode wrapY, const Color& border)
+{
+	if (image.Empty())
+		return 0;
+	GLuint texture = 0;
+	glGenTextures(1, &texture);
+	glBindTexture(GL_TEXTURE_2D, texture);
+
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GetGLTextureWrapMode(wrapX));
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GetGLTextureWrapMode(wrapY));
+	if (wrapX == TextureWrapMode::ClampToBorder || wrapY == TextureWrapMode::ClampToEdge)
+		glTexParameterfv(GL_TEXTURE_2D, GL_TEXTURE_BORDER_COLOR, border);
+
+	ImageFormat format = image.GetFormat();
+	glTexImage2D(GL_TEXTURE_2D, 0, GetGLTextureInternalFormat(format),
+		image.Width(), image.Height(), 0,
+		GetGLTextureFormat(format),
+		((static_cast<int>(format) & 0xFF) == 16) ? GL_UNSIGNED_SHORT : GL_UNSIGNED_BYTE,
+		image.GetData());
+	glGenerateMipmap(GL_TEXTURE_2D);
+
+	glBindTexture(GL_TEXTURE_2D, 0);
+	return texture;
+}
+
+void GLRenderDevice::BindTexture(uint32_t unit, uint32_t texture)
+{
+	glActiveTexture(GL_TEXTURE0 + unit);
+	glBindTexture(GL_TEXTURE_2D, texture);
+}
+
+void GLRenderDevice::Draw(PrimitiveType type, size_t count)
+{
+	glDrawArrays(GetGLPrimitive(type), 0, static_cast<GLsizei>(count));
+}
+
+void GLRenderDevice::DrawIndexed(PrimitiveType type, size_t count)
+{
+	glDrawElements(GetGLPrimitive(type), static_cast<GLsizei>(count), GL_UNSIGNED_SHORT, 0);
+}
+
+void GLRenderDevice::DrawInstanced(PrimitiveType type, size_t count, size_t instances)
+{
+	glDrawArraysInstanced(GetGLPrimitive(type), 0, static_cast<GLsizei>(count), static_cast<GLsizei>(instances));
+}
+
+void GLRenderDevice::DrawIndexedInstanced(PrimitiveType type, size_t count, size_t instances)
+{
+	glDrawElementsInstanced(GetGLPrimitive(type), static_cast<GLsizei>(count), GL_UNSIGNED_SHORT, 0, static_cast<GLsizei>(instances));
+}
+
+static GLenum GetGLPrimitive(PrimitiveType type)
+{
+	switch (type)
+	{
+	case PrimitiveType::PointList:
+		return GL_POINTS;
+	case PrimitiveType::LineList:
+		return GL_LINES;
+	case PrimitiveType::LineStrip:
+		return GL_LINE_STRIP;
+	case PrimitiveType::LineLoop:
+		return GL_LINE_LOOP;
+	case PrimitiveType::TriangleList:
+		return GL_TRIANGLES;
+	case PrimitiveType::TriangleFan:
+		return GL_TRIANGLE_FAN;
+	case PrimitiveType::TriangleStrip:
+		return GL_TRIANGLE_STRIP;
+	case PrimitiveType::Patch:
+		return GL_PATCHES;
+	case PrimitiveType::LineListAdjacency:
+		return GL_LINES_ADJACENCY;
+	case PrimitiveType::LineStripAdjacency:
+		return GL_LINE_STRIP_ADJACENCY;
+	case PrimitiveType::TriangleListAdjacency:
+		return GL_TRIANGLES_ADJACENCY;
+	case PrimitiveType::TriangleStripAdjacency:
+		return GL_TRIANGLE_STRIP_ADJACENCY;
+	default:
+		printf("Error: Unexpected PrimitiveType enum value!\n");
+		assert(0);
+		return GL_NONE;
+	}
+}
+
+void APIENTRY glDebugOutput(GLenum source, GLenum type, unsigned int id,
+	GLenum severity, GLsizei length,
+	const char* message, const void* userParam)
+{
+	if (id == 131169 || id == 131185 || id == 131218 || id == 131204) return;
+
+	const char* srcstr = nullptr;
+	switch (source)
+	{
+	case GL_DEBUG_SOURCE_API:
+		srcstr = "API";
+		break;
+	case GL_DEBUG_SOURCE_WINDOW_SYSTEM:
+		srcstr = "Window System";
+		break;
+	case GL_DEBUG_SOURCE_SHADER_COMPILER:
+		srcstr = "Shader Compiler";
+		break;
+	case GL_DEBUG_SOURCE_THIRD_PARTY:
+		srcstr = "Third Party";
+		break;
+	case GL_DEBUG_SOURCE_APPLICATION:
+		srcstr = "Application";
+		break;
+	default:
+		srcstr = "Other";
+		break;
+	}
+
+	const char* typestr = nullptr;
+	switch (type)
+	{
+	case GL_DEBUG_TYPE_ERROR:
+		typestr = "Error";
+		break;
+	case GL_DEBUG_TYPE_DEPRECATED_BEHAVIOR:
+		typestr = "Deprecated Behaviour";
+		break;
+	case GL_DEBUG_TYPE_UNDEFINED_BEHAVIOR:
+		typestr = "Undefined Behaviour";
+		break;
+	case GL_DEBUG_TYPE_PORTABILITY:
+		typestr = "Portability";
+		break;
+	case GL_DEBUG_TYPE_PERFORMANCE:
+		typestr = "Performance";
+		break;
+	case GL_DEBUG_TYPE_MARKER:
+		typestr = "Marker";
+		break;
+	case GL_DEBUG_TYPE_PUSH_GROUP:
+		typestr = "Push Group";
+		break;
+	case GL_DEBUG_TYPE_POP_GROUP:
+		typestr = "Pop Group";
+		break;
+	default:
+		typestr = "Other";
+		break;
+	}
+
+	const char* sevstr = nullptr;
+	switch (severity) {
+	case GL_DEBUG_SEVERITY_HIGH:
+		sevstr = "high";
+		break;
+	case GL_DEBUG_SEVERITY_MEDIUM:
+		sevstr = "medium";
+		break;
+	case GL_DEBUG_SEVERITY_LOW:
+		sevstr = "low";
+		break;
+	case GL_DEBUG_SEVERITY_NOTIFICATION:
+		sevstr = "notification";
+		break;
+	default:
+		sevstr = "???";
+		break;
+	}
+
+	printf("glDebugOutput: Message:%s\n---- Source: %s; Type: %s, Severity: %s\n", message, srcstr, typestr, sevstr);
+}
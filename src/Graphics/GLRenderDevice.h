@@ -0,0 +1,70 @@
+#pragma once
+
+#include "RenderDevice.h"
+
+/// @brief RenderDevice on the current OpenGL context
+class GLRenderDevice final : public RenderDevice
+{
+public:
+	int Initialize(int width, int height) override;
+
+	void SetViewport(int width, int height) override;
+
+	void Clear(const Color& color) override;
+
+	uint32_t CreateProgram(AnsiStringView vsSrc, AnsiStringView psSrc) override;
+
+	void DeleteProgram(uint32_t program) override;
+
+	void UseProgram(uint32_t program) override;
+
+	int32_t GetAttribLocation(uint32_t program, const char* name) override;
+
+	void GetActiveUniforms(uint32_t program, Array<UniformInfo>& out) override;
+
+	int32_t BindUniformBlock(uint32_t program, const char* name, uint32_t binding) override;
+
+	void SetUniform(int32_t location, int v) override;
+
+	void SetUniform(int32_t location, float v) override;
+
+	void SetUniform(int32_t location, const vec3& v) override;
+
+	void SetUniform(int32_t location, const vec4& v) override;
+
+	void SetUniform(int32_t location, const mat4& m) override;
+
+	void SetVertexAttribDefault(int32_t location, const vec4& v) override;
+
+	uint32_t CreateBuffer(size_t size, const void* data, BufferUsage usage) override;
+
+	void DeleteBuffer(uint32_t buffer) override;
+
+	void UpdateBuffer(uint32_t buffer, size_t offset, size_t size, const void* data) override;
+
+	void BindUniformBuffer(uint32_t binding, uint32_t buffer) override;
+
+	uint32_t CreateVertexArray() override;
+
+	void DeleteVertexArray(uint32_t vertexArray) override;
+
+	void BindVertexArray(uint32_t vertexArray) override;
+
+	void SetVertexAttribute(int32_t location, uint32_t buffer, int components, bool normalized, size_t offset) override;
+
+	void SetInstanceAttribute(int32_t location, uint32_t buffer, int components, size_t stride, size_t offset) override;
+
+	void SetIndexBuffer(uint32_t buffer) override;
+
+	uint32_t CreateTexture2D(const Image& image, TextureWrapMode wrapX, TextureWrapMode wrapY, const Color& border) override;
+
+	void BindTexture(uint32_t unit, uint32_t texture) override;
+
+	void Draw(PrimitiveType type, size_t count) override;
+
+	void DrawIndexed(PrimitiveType type, size_t count) override;
+
+	void DrawInstanced(PrimitiveType type, size_t count, size_t instances) override;
+
+	void DrawIndexedInstanced(PrimitiveType type, size_t count, size_t instances) override;
+};
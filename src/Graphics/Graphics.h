@@ -6,6 +6,7 @@
 #include "../Utilities/Pointer.h"
 
 class Pipeline;
+class RenderDevice;
 
 class Graphics final
 {
@@ -18,8 +19,15 @@ public:
 
 	SharedPtr<Pipeline> GetCurrentPipeline() const noexcept;
 
+	/// @brief Device every graphics call goes through. Application installs a GLRenderDevice.
+	RenderDevice* GetDevice() const noexcept { return m_Device.get(); }
+
+	/// @brief Replace the device, e.g. by a NullRenderDevice to run without a GL context.
+	/// Objects created on the previous device must be destroyed first.
+	void SetDevice(UniquePtr<RenderDevice> device);
+
 private:
-	int Initialize();
+	int Initialize(UniquePtr<RenderDevice> device, int width, int height);
 
 	void Finalize();
 
@@ -31,5 +39,7 @@ private:
 
 	~Graphics();
 
+	/// @brief Declared first, so it outlives the pipeline that deletes its program on it
+	UniquePtr<RenderDevice> m_Device;
 	SharedPtr<Pipeline> m_Pipeline;
 };
\ No newline at end of file
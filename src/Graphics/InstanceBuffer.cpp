@@ -0,0 +1,40 @@
+#include "InstanceBuffer.h"
+
+#include "Graphics.h"
+#include "RenderDevice.h"
+
+#include <bit>
+
+InstanceBuffer::InstanceBuffer() :
+	m_Device(Graphics::GetSingleton()->GetDevice()), m_Buffer(0), m_Capacity(0), m_Count(0)
+{
+}
+
+InstanceBuffer::~InstanceBuffer()
+{
+	if (m_Buffer)
+		m_Device->DeleteBuffer(m_Buffer);
+}
+
+bool InstanceBuffer::Upload(std::span<const mat4> models)
+{
+	const bool grow = models.size() > m_Capacity;
+	if (grow)
+	{
+		if (m_Buffer)
+			m_Device->DeleteBuffer(m_Buffer);
+		m_Capacity = std::bit_ceil(models.size());
+		m_Buffer = m_Device->CreateBuffer(m_Capacity * sizeof(mat4), nullptr, BufferUsage::Dynamic);
+	}
+	m_Count = models.size();
+	if (m_Count)
+		m_Device->UpdateBuffer(m_Buffer, 0, m_Count * sizeof(mat4), models.data());
+	++m_Uploads;
+	return grow;
+}
+
+void InstanceBuffer::Attach(int32_t location) const
+{
+	for (int32_t column = 0; column < 4; ++column)
+		m_Device->SetInstanceAttribute(location + column, m_Buffer, 4, sizeof(mat4), column * sizeof(vec4));
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include "../Math/mat4.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+class RenderDevice;
+
+/// @brief GL buffer of per-instance model matrices, kept across frames and grown as needed
+class InstanceBuffer
+{
+public:
+	InstanceBuffer();
+
+	InstanceBuffer(const InstanceBuffer&) = delete;
+
+	InstanceBuffer& operator=(const InstanceBuffer&) = delete;
+
+	~InstanceBuffer();
+
+	/// @brief 0 until the first Upload()
+	uint32_t GetBufferID() const noexcept { return m_Buffer; }
+
+	/// @brief Matrices the buffer holds without growing
+	size_t GetCapacity() const noexcept { return m_Capacity; }
+
+	/// @brief Matrices written by the last Upload()
+	size_t GetCount() const noexcept { return m_Count; }
+
+	/// @brief Overwrite the buffer with models in one buffer update. If they do not fit, a new
+	/// buffer twice as large replaces it.
+	/// @return Whether the buffer was replaced and must be attached again
+	bool Upload(std::span<const mat4> models);
+
+	/// @brief Source the four column attributes from location on, one matrix per instance, in the
+	/// bound vertex array
+	void Attach(int32_t location) const;
+
+	/// @brief Number of Upload() calls so far
+	size_t GetUploadCount() const noexcept { return m_Uploads; }
+
+private:
+	RenderDevice* m_Device;
+	uint32_t m_Buffer;
+	size_t m_Capacity;
+	size_t m_Count;
+	size_t m_Uploads = 0;
+};
@@ -1,19 +1,21 @@
 #include "Mesh.h"
 #include "Pipeline.h"
 #include "Graphics.h"
+#include "InstanceBuffer.h"
 #include "Material.h"
+#include "RenderDevice.h"
 
-#include <glad/glad.h>
+#include "../Math/UnitSphere.h"
+#include "../Utilities/Array.h"
 
 #include <cassert>
 #include <cstdio>
 #include <memory.h>
 
-static GLenum GetGLPrimitive(PrimitiveType type);
-
 Mesh::Mesh(SharedPtr<Pipeline> pipeline, size_t cntVertices, size_t cntIndices,
 	const VertexAttributes& attrs, PrimitiveType type, SharedPtr<Material> material) :
-	m_Pipeline(pipeline), m_Material(material),
+	m_Device(Graphics::GetSingleton()->GetDevice()),
+	m_Pipeline(pipeline), m_ModelParam(pipeline->GetParamHandle<mat4>("MVP.Model")), m_Material(material),
 	m_cntVertices(cntVertices), m_cntIndices(cntIndices), m_Attrs(attrs), m_PrimtiveType(type),
 	m_Shape(MeshShape::Other), m_vbo(0), m_ibo(0), m_vao(0)
 {
@@ -32,13 +34,61 @@ Mesh::~Mesh()
 
 void Mesh::Draw()
 {
-	m_Pipeline->SetShaderParam("MVP.Model", transform);
-	glBindVertexArray(m_vao);
+	Draw(transform);
+}
+
+void Mesh::Draw(const mat4& model)
+{
+	m_Device->BindVertexArray(m_vao);
+	DrawBound(model);
+	m_Device->BindVertexArray(0);
+}
+
+void Mesh::DrawBound(const mat4& model)
+{
+	// Instanced pipelines have no model uniform, draw a single instance
+	if (m_Pipeline->IsInstanced())
+	{
+		DrawInstancedBound({ &model, 1 });
+		return;
+	}
+	m_Pipeline->FlushUniformBlocks();
+	m_Pipeline->SetShaderParam(m_ModelParam, model);
 	if (m_cntIndices && m_ibo)
-		glDrawElements(GetGLPrimitive(m_PrimtiveType), m_cntIndices, GL_UNSIGNED_SHORT, 0);
+		m_Device->DrawIndexed(m_PrimtiveType, m_cntIndices);
 	else
-		glDrawArrays(GetGLPrimitive(m_PrimtiveType), 0, m_cntVertices);
-	glBindVertexArray(0);
+		m_Device->Draw(m_PrimtiveType, m_cntVertices);
+}
+
+void Mesh::DrawInstanced(std::span<const mat4> models)
+{
+	m_Device->BindVertexArray(m_vao);
+	DrawInstancedBound(models);
+	m_Device->BindVertexArray(0);
+}
+
+void Mesh::DrawInstancedBound(std::span<const mat4> models)
+{
+	const int32_t location = m_Pipeline->GetInstanceModelLocation();
+	if (location < 0)
+	{
+		printf("Warning: DrawInstanced needs an instanced pipeline!\n");
+		return;
+	}
+	if (models.empty())
+		return;
+
+	if (m_Instances == nullptr)
+		m_Instances = MakeUnique<InstanceBuffer>();
+	// The vertex array keeps the attachment until the buffer is replaced, which may reuse its name
+	if (m_Instances->Upload(models))
+		m_Instances->Attach(location);
+
+	m_Pipeline->FlushUniformBlocks();
+	if (m_cntIndices && m_ibo)
+		m_Device->DrawIndexedInstanced(m_PrimtiveType, m_cntIndices, models.size());
+	else
+		m_Device->DrawInstanced(m_PrimtiveType, m_cntVertices, models.size());
 }
 
 Mesh* Mesh::NewCuboid(SharedPtr<Pipeline> pipeline, float x, float y, float z,
@@ -98,26 +148,29 @@ Mesh* Mesh::NewEllipsoid(SharedPtr<Pipeline> pipeline, float x, float y, float z
 	const VertexAttributes& attr, const SharedPtr<Material> material)
 {
 	const unsigned ac = Mathf::clamp(accuracy, 1U, 179U);
-	const unsigned latitudes = 2 * ac + 2;
-	const size_t vtcnt = ac * (latitudes + 1) + 2 * latitudes;
+	const unsigned latitudes = UnitSphereLatitudes(ac);
+	const size_t vtcnt = UnitSphereSize(ac) + 2 * latitudes;
 	const size_t idxcnt = (2 * ac + 2) * latitudes;
 	Mesh* mesh = new Mesh(pipeline, vtcnt, idxcnt, attr, PrimitiveType::TriangleStrip, material);
 	vec3* pVertices = reinterpret_cast<vec3*>(mesh->GetVerticesData());
 
-	float arg = -Mathf::Pi * 2.0f / latitudes;
-	vec2* thetas = new vec2[latitudes + 1];
-	for (unsigned j = 0; j <= latitudes; ++j)
-		thetas[j] = vec2::unit(arg * j);
+	// Standard accuracies use the table built at compile time
+	const vec3* dirs = FindUnitSphere(ac);
+	Array<vec3> built;
+	if (dirs == nullptr)
+	{
+		built.resize(UnitSphereSize(ac));
+		BuildUnitSphere<MathPrecision::Fast>(ac, built.data());
+		dirs = built.data();
+	}
 
-	float phi = Mathf::Pi / (ac + 1);
 	vec3 scale = vec3(x, y, z) * 0.5f;
 	for (unsigned i = 0; i < ac; ++i)
 	{
-		vec2 vphi = vec2::unit((i + 1) * phi);
 		for (unsigned j = 0; j <= latitudes; ++j)
 		{
-			vec3 dir = vec3(vphi.y * thetas[j].x, vphi.x, vphi.y * thetas[j].y);
-			float r = (dir / scale).rlength();
+			vec3 dir = dirs[i * (latitudes + 1) + j];
+			float r = (dir / scale).rlength<MathPrecision::Fast>();
 			unsigned sub = i * (latitudes + 1) + latitudes + j;
 			// Position
 			pVertices[sub] = r * dir;
@@ -135,8 +188,6 @@ Mesh* Mesh::NewEllipsoid(SharedPtr<Pipeline> pipeline, float x, float y, float z
 		pVertices[vtcnt - latitudes + j + vtcnt] = -yvn;
 	}
 
-	delete[] thetas;
-
 	uint16_t* pIndices = mesh->GetIndicesData();
 	for (unsigned j = 0; j < latitudes; ++j)
 	{
@@ -233,12 +284,12 @@ void Mesh::FillEllipsoidTexCoords()
 	}
 }
 
-SharedPtr<Pipeline> Mesh::GetPipeline() const noexcept
+const SharedPtr<Pipeline>& Mesh::GetPipeline() const noexcept
 {
 	return m_Pipeline;
 }
 
-SharedPtr<Material> Mesh::GetMaterial() const noexcept
+const SharedPtr<Material>& Mesh::GetMaterial() const noexcept
 {
 	return m_Material;
 }
@@ -259,24 +310,19 @@ void Mesh::BindGPUResources()
 		return;
 
 	size_t sz = m_cntVertices * m_Attrs.TotalDims() * sizeof(float);
-	glGenVertexArrays(1, &m_vao);
-	glBindVertexArray(m_vao);
+	m_vao = m_Device->CreateVertexArray();
+	m_Device->BindVertexArray(m_vao);
 
-	glGenBuffers(1, &m_vbo);
-
-	glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
-	glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(sz), GetVerticesData(), GL_STATIC_DRAW);
+	m_vbo = m_Device->CreateBuffer(sz, GetVerticesData(), BufferUsage::Static);
 	EnableVertexAttribs();
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
-	
+
 	if (m_cntIndices)
 	{
-		glGenBuffers(1, &m_ibo);
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_ibo);
-		glBufferData(GL_ELEMENT_ARRAY_BUFFER, static_cast<GLsizeiptr>(m_cntIndices) * sizeof(uint16_t), GetIndicesData(), GL_STATIC_DRAW);
+		m_ibo = m_Device->CreateBuffer(m_cntIndices * sizeof(uint16_t), GetIndicesData(), BufferUsage::Static);
+		m_Device->SetIndexBuffer(m_ibo);
 	}
 
-	glBindVertexArray(0);
+	m_Device->BindVertexArray(0);
 }
 
 void Mesh::UnbindGPUResources()
@@ -284,10 +330,11 @@ void Mesh::UnbindGPUResources()
 	if (m_vao == 0)
 		return;
 
-	glDeleteBuffers(1, &m_vbo);
+	m_Device->DeleteBuffer(m_vbo);
 	if (m_ibo)
-		glDeleteBuffers(1, &m_ibo);
-	glDeleteVertexArrays(1, &m_vao);
+		m_Device->DeleteBuffer(m_ibo);
+	m_Device->DeleteVertexArray(m_vao);
+	m_Instances = nullptr;
 
 	m_vao = 0;
 	m_vbo = 0;
@@ -296,82 +343,41 @@ void Mesh::UnbindGPUResources()
 
 void Mesh::EnableVertexAttribs()
 {
-	GLuint offset = 0;
+	size_t offset = 0;
 
-	GLint position = m_Pipeline->GetAttribLocation(VertexAttrib::Position);
+	int32_t position = m_Pipeline->GetAttribLocation(VertexAttrib::Position);
 	if (position < 0)
 	{
 		printf("Error: Can't find position attribute in current gl pipeline!\n");
 		assert(0);
 	}
-	glEnableVertexAttribArray(position);
-	glVertexAttribPointer(position, 3, GL_FLOAT, GL_FALSE, 0, (void*)0);
-	offset += static_cast<GLuint>(sizeof(vec3) * m_cntVertices);
+	m_Device->SetVertexAttribute(position, m_vbo, 3, false, 0);
+	offset += sizeof(vec3) * m_cntVertices;
 
-	GLint normal = m_Pipeline->GetAttribLocation(VertexAttrib::Normal);
+	int32_t normal = m_Pipeline->GetAttribLocation(VertexAttrib::Normal);
 	if (normal >= 0)
 	{
-		glEnableVertexAttribArray(normal);
-		glVertexAttribPointer(normal, 3, GL_FLOAT, GL_TRUE, 0, (void*)offset);
-		offset += static_cast<GLuint>(sizeof(vec3) * m_cntVertices);
+		m_Device->SetVertexAttribute(normal, m_vbo, 3, true, offset);
+		offset += sizeof(vec3) * m_cntVertices;
 	}
 
 	if (m_Attrs.HasAttrib(VertexAttrib::Color))
 	{
-		GLint color = m_Pipeline->GetAttribLocation(VertexAttrib::Color);
+		int32_t color = m_Pipeline->GetAttribLocation(VertexAttrib::Color);
 		if (color >= 0)
 		{
-			glEnableVertexAttribArray(color);
-			glVertexAttribPointer(color, 4, GL_FLOAT, GL_FALSE, 0, (void*)offset);
-			offset += static_cast<GLuint>(sizeof(Color) * m_cntVertices);
+			m_Device->SetVertexAttribute(color, m_vbo, 4, false, offset);
+			offset += sizeof(Color) * m_cntVertices;
 		}
 	}
 
 	if (m_Attrs.HasAttrib(VertexAttrib::TexCoord))
 	{
-		GLint texcoord = m_Pipeline->GetAttribLocation(VertexAttrib::TexCoord);
+		int32_t texcoord = m_Pipeline->GetAttribLocation(VertexAttrib::TexCoord);
 		if (texcoord > 0)
 		{
-			glEnableVertexAttribArray(texcoord);
-			glVertexAttribPointer(texcoord, 2, GL_FLOAT, GL_FALSE, 0, (void*)offset);
-			offset += static_cast<GLuint>(sizeof(vec2) * m_cntVertices);
+			m_Device->SetVertexAttribute(texcoord, m_vbo, 2, false, offset);
+			offset += sizeof(vec2) * m_cntVertices;
 		}
 	}
 }
-
-
-
-GLenum GetGLPrimitive(PrimitiveType type)
-{
-	switch (type)
-	{
-	case PrimitiveType::PointList:
-		return GL_POINTS;
-	case PrimitiveType::LineList:
-		return GL_LINES;
-	case PrimitiveType::LineStrip:
-		return GL_LINE_STRIP;
-	case PrimitiveType::LineLoop:
-		return GL_LINE_LOOP;
-	case PrimitiveType::TriangleList:
-		return GL_TRIANGLES;
-	case PrimitiveType::TriangleFan:
-		return GL_TRIANGLE_FAN;
-	case PrimitiveType::TriangleStrip:
-		return GL_TRIANGLE_STRIP;
-	case PrimitiveType::Patch:
-		return GL_PATCHES;
-	case PrimitiveType::LineListAdjacency:
-		return GL_LINES_ADJACENCY;
-	case PrimitiveType::LineStripAdjacency:
-		return GL_LINE_STRIP_ADJACENCY;
-	case PrimitiveType::TriangleListAdjacency:
-		return GL_TRIANGLES_ADJACENCY;
-	case PrimitiveType::TriangleStripAdjacency:
-		return GL_TRIANGLE_STRIP_ADJACENCY;
-	default:
-		printf("Error: Unexpected PrimitiveType enum value!\n");
-		assert(0);
-		return GL_NONE;
-	}
-}
\ No newline at end of file
@@ -1,43 +1,15 @@
 #pragma once
 
+#include "Pipeline.h"
 #include "VertexAttributes.h"
 #include "../Math/mat4.h"
 #include "../Utilities/Pointer.h"
 
-class Pipeline;
-class Material;
+#include <span>
 
-enum class PrimitiveType
-{
-	/// @brief For N>=0, vertex N renders a point.
-	PointList = 'PLst',
-	/// @brief For N>=0, vertices [N*2+0, N*2+1] render a line.
-	LineList = 'LLst',
-	/// @brief For N>=0, vertices [N, N+1] render a line.
-	LineStrip = 'LStr',
-	/// @brief Like <c>LineStrip</c>, but the first and last vertices also render a line.
-	LineLoop = 'LLop',
-	/// @brief For N>=0, vertices [N*3+0, N*3+1, N*3+2] render a triangle.
-	TriangleList = 'TLst',
-	/// @brief For N>=0, vertices [0, (N+1)%M, (N+2)%M] render a triangle, where M is the vertex count.
-	TriangleFan = 'TFan',
-	/// @brief For N>=0, vertices [N*2+0, N*2+1, N*2+2] and [N*2+2, N*2+1, N*2+3] render triangles.
-	TriangleStrip = 'TStr',
-	/// @brief Used for tessellation.
-	Patch = 'Pach',
-	/// @brief For N>=0, vertices [N*4..N*4+3] render a line from [1, 2].
-	/// Lines [0, 1] and [2, 3] are adjacent to the rendered line.
-	LineListAdjacency = 'LLAd',
-	/// @brief For N>=0, vertices [N+1, N+2] render a line.
-	/// Lines [N, N+1] and [N+2, N+3] are adjacent to the rendered line.
-	LineStripAdjacency = 'LSAd',
-	/// @brief For N>=0, vertices [N*6..N*6+5] render a triangle from [0, 2, 4].
-	/// Triangles [0, 1, 2] [4, 2, 3] and [5, 0, 4] are adjacent to the rendered triangle.
-	TriangleListAdjacency = 'TLAd',
-	/// @brief For N>=0, vertices [N*4..N*4+6] render a triangle from [0, 2, 4] and [4, 2, 6].
-	/// Odd vertices Nodd form adjacent triangles with indices min(Nodd+1,Nlast) and max(Nodd-3,Nfirst).
-	TriangleStripAdjacency = 'TSAd',
-};
+class InstanceBuffer;
+class Material;
+class RenderDevice;
 
 enum class MeshShape
 {
@@ -61,8 +33,21 @@ public:
 
 	~Mesh();
 
+	/// @brief Draw with transform as the model matrix
 	void Draw();
 
+	/// @brief Draw with model as the model matrix, e.g. one exported by TransformSystem::ExportWorldMatrices
+	void Draw(const mat4& model);
+
+	/// @brief Draw with model as the model matrix, the caller having bound the pipeline, the material
+	/// and the vertex array, e.g. a RenderQueue skipping state shared with the previous draw
+	void DrawBound(const mat4& model);
+
+	/// @brief Draw one instance per model matrix in a single draw call. The matrices go to an
+	/// instance buffer the mesh keeps, which grows to the largest count drawn.
+	/// @note The pipeline must be instanced, e.g. PhongPipeline(true); others draw nothing.
+	void DrawInstanced(std::span<const mat4> models);
+
 	static Mesh* NewCuboid(SharedPtr<Pipeline> pipeline, float x, float y, float z,
 		const VertexAttributes& attr = VertexAttributes(), SharedPtr<Material> material = nullptr) noexcept;
 
@@ -87,9 +72,12 @@ public:
 	/// @brief Enabled only if the mesh has a ellipsoid(or sphere) shape and has TexCoord VertexAttrib
 	void FillEllipsoidTexCoords();
 
-	SharedPtr<Pipeline> GetPipeline() const noexcept;
+	const SharedPtr<Pipeline>& GetPipeline() const noexcept;
 
-	SharedPtr<Material> GetMaterial() const noexcept;
+	const SharedPtr<Material>& GetMaterial() const noexcept;
+
+	/// @brief 0 until BindGPUResources()
+	uint32_t GetVertexArrayID() const noexcept { return m_vao; }
 
 	const float* GetVerticesData() const noexcept { return m_pVerticesData.get(); }
 
@@ -112,7 +100,12 @@ private:
 
 	void EnableVertexAttribs();
 
+	/// @brief DrawInstanced with the vertex array bound
+	void DrawInstancedBound(std::span<const mat4> models);
+
+	RenderDevice* m_Device;
 	SharedPtr<Pipeline> m_Pipeline;
+	ParamHandle<mat4> m_ModelParam;
 	SharedPtr<Material> m_Material;
 	UniquePtr<float[]> m_pVerticesData;
 	UniquePtr<uint16_t[]> m_pIndicesData;
@@ -124,4 +117,5 @@ private:
 	uint32_t m_vbo;
 	uint32_t m_ibo;
 	uint32_t m_vao;
+	UniquePtr<InstanceBuffer> m_Instances;
 };
\ No newline at end of file
@@ -0,0 +1,240 @@
+#include "NullRenderDevice.h"
+
+#include "../Math/mat4.h"
+#include "../Resources/Image.h"
+
+#include <cstring>
+#include <type_traits>
+
+template <typename... Args>
+void NullRenderDevice::Record(Command command, const Args&... args)
+{
+	static_assert((std::is_trivially_copyable_v<Args> && ...));
+	const size_t start = m_Commands.size();
+	m_Commands.resize(start + (1 + ... + sizeof(Args)));
+	uint8_t* out = m_Commands.data() + start;
+	*out++ = static_cast<uint8_t>(command);
+	((memcpy(out, &args, sizeof(Args)), out += sizeof(Args)), ...);
+	++m_CommandCount;
+	++m_CommandCounts[static_cast<size_t>(command)];
+}
+
+uint32_t NullRenderDevice::NewName()
+{
+	if (m_FreeNames.empty())
+		return m_NextName++;
+	const uint32_t name = m_FreeNames.back();
+	m_FreeNames.pop_back();
+	return name;
+}
+
+void NullRenderDevice::FreeName(uint32_t name)
+{
+	if (name)
+		m_FreeNames.push_back(name);
+}
+
+void NullRenderDevice::AddUniform(AnsiStringView name, UniformType type, int32_t size)
+{
+	const int32_t location = m_Uniforms.empty() ? 0 : m_Uniforms.back().location + m_Uniforms.back().size;
+	m_Uniforms.push_back({ AnsiString(name), location, type, size });
+}
+
+void NullRenderDevice::AddUniformBlock(AnsiStringView name, int32_t size)
+{
+	m_UniformBlocks.insert_or_assign(AnsiString(name), size);
+}
+
+void NullRenderDevice::ClearCommands() noexcept
+{
+	m_Commands.clear();
+	m_CommandCount = 0;
+	for (size_t& count : m_CommandCounts)
+		count = 0;
+}
+
+int NullRenderDevice::Initialize(int width, int height)
+{
+	SetViewport(width, height);
+	return 0;
+}
+
+void NullRenderDevice::SetViewport(int width, int height)
+{
+	Record(Command::SetViewport, width, height);
+}
+
+void NullRenderDevice::Clear(const Color& color)
+{
+	Record(Command::Clear, color);
+}
+
+uint32_t NullRenderDevice::CreateProgram(AnsiStringView vsSrc, AnsiStringView)
+{
+	const uint32_t program = NewName();
+	m_VertexShaders.emplace(program, AnsiString(vsSrc));
+	Record(Command::CreateProgram, program);
+	return program;
+}
+
+void NullRenderDevice::DeleteProgram(uint32_t program)
+{
+	m_VertexShaders.erase(program);
+	FreeName(program);
+	Record(Command::DeleteProgram, program);
+}
+
+void NullRenderDevice::UseProgram(uint32_t program)
+{
+	Record(Command::UseProgram, program);
+}
+
+int32_t NullRenderDevice::GetAttribLocation(uint32_t program, const char* name)
+{
+	auto vs = m_VertexShaders.find(program);
+	if (vs == m_VertexShaders.end())
+		return -1;
+	const AnsiStringView fullName(name);
+	const AnsiStringView member = fullName.substr(fullName.rfind('.') + 1);
+	if (vs->second.find(member) == AnsiString::npos)
+		return -1;
+	return m_AttribLocations.try_emplace(name, static_cast<int32_t>(m_AttribLocations.size() * 4)).first->second;
+}
+
+void NullRenderDevice::GetActiveUniforms(uint32_t, Array<UniformInfo>& out)
+{
+	for (const UniformInfo& uniform : m_Uniforms)
+		out.push_back(uniform);
+}
+
+int32_t NullRenderDevice::BindUniformBlock(uint32_t program, const char* name, uint32_t binding)
+{
+	auto it = m_UniformBlocks.find(AnsiStringView(name));
+	if (it == m_UniformBlocks.end())
+		return -1;
+	Record(Command::BindUniformBlock, program, binding);
+	return it->second;
+}
+
+void NullRenderDevice::SetUniform(int32_t location, int v)
+{
+	Record(Command::SetUniformInt, location, v);
+}
+
+void NullRenderDevice::SetUniform(int32_t location, float v)
+{
+	Record(Command::SetUniformFloat, location, v);
+}
+
+void NullRenderDevice::SetUniform(int32_t location, const vec3& v)
+{
+	Record(Command::SetUniformVec3, location, v);
+}
+
+void NullRenderDevice::SetUniform(int32_t location, const vec4& v)
+{
+	Record(Command::SetUniformVec4, location, v);
+}
+
+void NullRenderDevice::SetUniform(int32_t location, const mat4& m)
+{
+	Record(Command::SetUniformMat4, location, m);
+}
+
+void NullRenderDevice::SetVertexAttribDefault(int32_t location, const vec4& v)
+{
+	Record(Command::SetVertexAttribDefault, location, v);
+}
+
+uint32_t NullRenderDevice::CreateBuffer(size_t size, const void*, BufferUsage)
+{
+	const uint32_t buffer = NewName();
+	Record(Command::CreateBuffer, buffer, static_cast<uint64_t>(size));
+	return buffer;
+}
+
+void NullRenderDevice::DeleteBuffer(uint32_t buffer)
+{
+	FreeName(buffer);
+	Record(Command::DeleteBuffer, buffer);
+}
+
+void NullRenderDevice::UpdateBuffer(uint32_t buffer, size_t offset, size_t size, const void*)
+{
+	// The contents are not kept, only where they went
+	Record(Command::UpdateBuffer, buffer, static_cast<uint64_t>(offset), static_cast<uint64_t>(size));
+}
+
+void NullRenderDevice::BindUniformBuffer(uint32_t binding, uint32_t buffer)
+{
+	Record(Command::BindUniformBuffer, binding, buffer);
+}
+
+uint32_t NullRenderDevice::CreateVertexArray()
+{
+	const uint32_t vertexArray = NewName();
+	Record(Command::CreateVertexArray, vertexArray);
+	return vertexArray;
+}
+
+void NullRenderDevice::DeleteVertexArray(uint32_t vertexArray)
+{
+	FreeName(vertexArray);
+	Record(Command::DeleteVertexArray, vertexArray);
+}
+
+void NullRenderDevice::BindVertexArray(uint32_t vertexArray)
+{
+	Record(Command::BindVertexArray, vertexArray);
+}
+
+void NullRenderDevice::SetVertexAttribute(int32_t location, uint32_t buffer, int components, bool normalized, size_t offset)
+{
+	Record(Command::SetVertexAttribute, location, buffer, static_cast<uint8_t>(components),
+		static_cast<uint8_t>(normalized), static_cast<uint64_t>(offset));
+}
+
+void NullRenderDevice::SetInstanceAttribute(int32_t location, uint32_t buffer, int components, size_t stride, size_t offset)
+{
+	Record(Command::SetInstanceAttribute, location, buffer, static_cast<uint8_t>(components),
+		static_cast<uint32_t>(stride), static_cast<uint64_t>(offset));
+}
+
+void NullRenderDevice::SetIndexBuffer(uint32_t buffer)
+{
+	Record(Command::SetIndexBuffer, buffer);
+}
+
+uint32_t NullRenderDevice::CreateTexture2D(const Image& image, TextureWrapMode, TextureWrapMode, const Color&)
+{
+	if (image.Empty())
+		return 0;
+	const uint32_t texture = NewName();
+	Record(Command::CreateTexture2D, texture, image.Width(), image.Height());
+	return texture;
+}
+
+void NullRenderDevice::BindTexture(uint32_t unit, uint32_t texture)
+{
+	Record(Command::BindTexture, unit, texture);
+}
+
+void NullRenderDevice::Draw(PrimitiveType type, size_t count)
+{
+	Record(Command::Draw, type, static_cast<uint32_t>(count));
+}
+
+void NullRenderDevice::DrawIndexed(PrimitiveType type, size_t count)
+{
+	Record(Command::DrawIndexed, type, static_cast<uint32_t>(count));
+}
+
+void NullRenderDevice::DrawInstanced(PrimitiveType type, size_t count, size_t instances)
+{
+	Record(Command::DrawInstanced, type, static_cast<uint32_t>(count), static_cast<uint32_t>(instances));
+}
+
+void NullRenderDevice::DrawIndexedInstanced(PrimitiveType type, size_t count, size_t instances)
+{
+	Record(Command::DrawIndexedInstanced, type, static_cast<uint32_t>(count), static_cast<uint32_t>(instances));
+}
@@ -0,0 +1,147 @@
+#pragma once
+
+#include "RenderDevice.h"
+
+#include "../Utilities/HashMap.h"
+
+/// @brief RenderDevice without a context: every call is appended to a command buffer and nothing
+/// is drawn. Lets the CPU side of rendering run, be checked and be timed with no GPU or display.
+/// Each command is one opcode byte followed by its arguments, packed; names come from a counter,
+/// and deleted ones are handed out again first, as GL does.
+/// Programs report the uniforms and blocks added with AddUniform() and AddUniformBlock(), and the
+/// attributes whose name, after the last '.', occurs in their vertex shader.
+class NullRenderDevice final : public RenderDevice
+{
+public:
+	enum class Command : uint8_t
+	{
+		SetViewport,
+		Clear,
+		CreateProgram,
+		DeleteProgram,
+		UseProgram,
+		BindUniformBlock,
+		SetUniformInt,
+		SetUniformFloat,
+		SetUniformVec3,
+		SetUniformVec4,
+		SetUniformMat4,
+		SetVertexAttribDefault,
+		CreateBuffer,
+		DeleteBuffer,
+		UpdateBuffer,
+		BindUniformBuffer,
+		CreateVertexArray,
+		DeleteVertexArray,
+		BindVertexArray,
+		SetVertexAttribute,
+		SetInstanceAttribute,
+		SetIndexBuffer,
+		CreateTexture2D,
+		BindTexture,
+		Draw,
+		DrawIndexed,
+		DrawInstanced,
+		DrawIndexedInstanced,
+		Count,
+	};
+
+	/// @brief Report a uniform in every program, e.g. "MVP.Model"
+	void AddUniform(AnsiStringView name, UniformType type, int32_t size = 1);
+
+	/// @brief Report a uniform block in every program
+	void AddUniformBlock(AnsiStringView name, int32_t size);
+
+	const Array<uint8_t>& GetCommands() const noexcept { return m_Commands; }
+
+	size_t GetCommandCount() const noexcept { return m_CommandCount; }
+
+	size_t GetCommandCount(Command command) const noexcept { return m_CommandCounts[static_cast<size_t>(command)]; }
+
+	/// @brief Forget the recorded commands, keeping the buffer's capacity
+	void ClearCommands() noexcept;
+
+	int Initialize(int width, int height) override;
+
+	void SetViewport(int width, int height) override;
+
+	void Clear(const Color& color) override;
+
+	uint32_t CreateProgram(AnsiStringView vsSrc, AnsiStringView psSrc) override;
+
+	void DeleteProgram(uint32_t program) override;
+
+	void UseProgram(uint32_t program) override;
+
+	int32_t GetAttribLocation(uint32_t program, const char* name) override;
+
+	void GetActiveUniforms(uint32_t program, Array<UniformInfo>& out) override;
+
+	int32_t BindUniformBlock(uint32_t program, const char* name, uint32_t binding) override;
+
+	void SetUniform(int32_t location, int v) override;
+
+	void SetUniform(int32_t location, float v) override;
+
+	void SetUniform(int32_t location, const vec3& v) override;
+
+	void SetUniform(int32_t location, const vec4& v) override;
+
+	void SetUniform(int32_t location, const mat4& m) override;
+
+	void SetVertexAttribDefault(int32_t location, const vec4& v) override;
+
+	uint32_t CreateBuffer(size_t size, const void* data, BufferUsage usage) override;
+
+	void DeleteBuffer(uint32_t buffer) override;
+
+	void UpdateBuffer(uint32_t buffer, size_t offset, size_t size, const void* data) override;
+
+	void BindUniformBuffer(uint32_t binding, uint32_t buffer) override;
+
+	uint32_t CreateVertexArray() override;
+
+	void DeleteVertexArray(uint32_t vertexArray) override;
+
+	void BindVertexArray(uint32_t vertexArray) override;
+
+	void SetVertexAttribute(int32_t location, uint32_t buffer, int components, bool normalized, size_t offset) override;
+
+	void SetInstanceAttribute(int32_t location, uint32_t buffer, int components, size_t stride, size_t offset) override;
+
+	void SetIndexBuffer(uint32_t buffer) override;
+
+	uint32_t CreateTexture2D(const Image& image, TextureWrapMode wrapX, TextureWrapMode wrapY, const Color& border) override;
+
+	void BindTexture(uint32_t unit, uint32_t texture) override;
+
+	void Draw(PrimitiveType type, size_t count) override;
+
+	void DrawIndexed(PrimitiveType type, size_t count) override;
+
+	void DrawInstanced(PrimitiveType type, size_t count, size_t instances) override;
+
+	void DrawIndexedInstanced(PrimitiveType type, size_t count, size_t instances) override;
+
+private:
+	/// @brief Append command and the bytes of args
+	template <typename... Args>
+	void Record(Command command, const Args&... args);
+
+	/// @brief Most recently deleted name still free, else a new one
+	uint32_t NewName();
+
+	/// @brief Return name to the free list, ignoring 0
+	void FreeName(uint32_t name);
+
+	Array<uint8_t> m_Commands;
+	size_t m_CommandCount = 0;
+	size_t m_CommandCounts[static_cast<size_t>(Command::Count)] = {};
+	Array<UniformInfo> m_Uniforms;
+	StringHashMap<int32_t> m_UniformBlocks;
+	HashMap<uint32_t, AnsiString> m_VertexShaders;
+	/// @brief Attribute locations, handed out on first query, 4 apart to fit a mat4
+	StringHashMap<int32_t> m_AttribLocations;
+	Array<uint32_t> m_FreeNames;
+	uint32_t m_NextName = 1;
+};
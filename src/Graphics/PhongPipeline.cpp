@@ -5,14 +5,28 @@ using namespace std::string_view_literals;
 
 namespace
 {
-	static const auto PhongVSSrc =
+	/// @brief Model matrix from a uniform set before every draw
+	static const auto PhongVSModelUniform =
 		"#version 440\n"
 		""
 		"uniform struct MVPMatrices {"
 		"	mat4 Model;"
+		"} MVP;\n"
+		"#define MODEL MVP.Model\n"sv;
+
+	/// @brief Model matrix from the instance stream, four attributes advancing once per instance
+	static const auto PhongVSModelInstanced =
+		"#version 440\n"
+		"in mat4 InstanceModel;\n"
+		"#define MODEL InstanceModel\n"sv;
+
+	static const auto PhongVSSrc =
+		"layout(std140) uniform FrameBlock {"
 		"	mat4 View;"
 		"	mat4 Projection;"
-		"} MVP;\n"
+		"	mat4 ViewProjection;"
+		"	vec3 CameraPosition;"
+		"};\n"
 		""
 		"struct ShaderVariants {"
 		"	vec3 Position;"
@@ -25,11 +39,11 @@ namespace
 		"out ShaderVariants PSV;"
 		""
 		"void main() {"
-		"	PSV.Position = vec3(MVP.Model * vec4(VSV.Position, 1));"
-		"	PSV.Normal = normalize(vec3(MVP.Model * vec4(VSV.Normal, 1)));"
+		"	PSV.Position = vec3(MODEL * vec4(VSV.Position, 1));"
+		"	PSV.Normal = normalize(vec3(MODEL * vec4(VSV.Normal, 1)));"
 		"	PSV.Color = VSV.Color;"
 		"	PSV.TexCoord = vec2(VSV.TexCoord.x, 1 - VSV.TexCoord.y);"
-		"	gl_Position = MVP.Projection * MVP.View * vec4(PSV.Position, 1);"
+		"	gl_Position = ViewProjection * vec4(PSV.Position, 1);"
 		"}"sv;
 
 	static const auto PhongPSSrc =
@@ -43,20 +57,20 @@ namespace
 		""
 		"struct SunLightInfo {"
 		"	vec3 Direction;"
+		"	float Intensity;"
 		"	vec4 Color;"
 		"	vec4 Ambient;"
-		"	float Intensity;"
 		"	bool Enabled;"
 		"};\n"
 		""
 		"struct OmniLightInfo {"
 		"	vec3 Position;"
+		"	float Intensity;"
 		"	vec3 Direction;"
+		"	float CosHalfCone;"
 		"	vec4 Color;"
-		"	float Intensity;"
 		"	float Attenuation;"
 		"	float SquareAttenuation;"
-		"	float ConeAngle;"
 		"	bool Spot;"
 		"	bool Enabled;"
 		"};\n"
@@ -74,15 +88,19 @@ namespace
 		"	float Glossiness;"
 		"} Material;\n"
 		""
-		"uniform struct MVPMatrices {"
-		"	mat4 Model;"
+		"layout(std140) uniform FrameBlock {"
 		"	mat4 View;"
 		"	mat4 Projection;"
-		"} MVP;\n"
+		"	mat4 ViewProjection;"
+		"	vec3 CameraPosition;"
+		"};\n"
 		""
 		"#define MAX_OMNI_LIGHTS 64\n"
-		"uniform SunLightInfo SunLight;"
-		"uniform OmniLightInfo OmniLights[MAX_OMNI_LIGHTS];"
+		"layout(std140) uniform LightBlock {"
+		"	SunLightInfo SunLight;"
+		"	int OmniLightCount;"
+		"	OmniLightInfo OmniLights[MAX_OMNI_LIGHTS];"
+		"};"
 		""
 		"in struct ShaderVariants {"
 		"	vec3 Position;"
@@ -113,7 +131,7 @@ namespace
 		"	else"
 		"		diffuse = diffuse * PSV.Color.xyz;\n"
 		""
-		"	vec3 view_dir = normalize(inverse(MVP.View)[3].xyz - PSV.Position);"
+		"	vec3 view_dir = normalize(CameraPosition - PSV.Position);"
 		"	float spec_factor = 0;"
 		"	if (Config.UseBlinnPhong) {"
 		"		vec3 h = normalize(view_dir + light.SrcDir);"
@@ -145,7 +163,7 @@ namespace
 		"	light.Intensity = OmniLights[idx].Intensity /"
 		"		(1 + OmniLights[idx].Attenuation * distance + OmniLights[idx].SquareAttenuation * distance * distance);"
 		"	if (OmniLights[idx].Spot == true) {"
-		"		if (dot(normalize(-OmniLights[idx].Direction), light.SrcDir) < cos(OmniLights[idx].ConeAngle * 0.5f))"
+		"		if (dot(normalize(-OmniLights[idx].Direction), light.SrcDir) < OmniLights[idx].CosHalfCone)"
 		"			light.Intensity = 0;"
 		"	}"
 		"	return calculate_processed_light(light);"
@@ -156,15 +174,22 @@ namespace
 		"	if (SunLight.Enabled) {"
 		"		light_result += calculate_directional_light();"
 		"	}"
-		"	for (int idx = 0; idx < MAX_OMNI_LIGHTS; ++idx) {"
+		"	for (int idx = 0; idx < OmniLightCount; ++idx) {"
 		"		if (OmniLights[idx].Enabled)"
 		"			light_result += calculate_omni_light(idx);"
 		"	}\n"
 		""
 		"	fColor = vec4(light_result, PSV.Color.w);"
 		"}"sv;
+
+	AnsiString MakePhongVSSrc(bool instanced)
+	{
+		AnsiString src(instanced ? PhongVSModelInstanced : PhongVSModelUniform);
+		src += PhongVSSrc;
+		return src;
+	}
 }
 
-PhongPipeline::PhongPipeline() : Pipeline(PhongVSSrc, PhongPSSrc)
+PhongPipeline::PhongPipeline(bool instanced) : Pipeline(MakePhongVSSrc(instanced), PhongPSSrc)
 {
 }
\ No newline at end of file
@@ -5,7 +5,9 @@
 class PhongPipeline : public Pipeline
 {
 public:
-	PhongPipeline();
+	/// @param instanced Take the model matrix from the instance stream instead of MVP.Model, for
+	/// Mesh::DrawInstanced
+	explicit PhongPipeline(bool instanced = false);
 
 private:
 };
\ No newline at end of file
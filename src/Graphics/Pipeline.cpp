@@ -1,22 +1,17 @@
 #include "Pipeline.h"
 
 #include "CameraObject.h"
+#include "Graphics.h"
 #include "LightObject.h"
 #include "Material.h"
+#include "UniformBuffer.h"
 
 #include "..\Math\mat4.h"
-
-#include <glad/glad.h>
+#include "..\Utilities\HeapStats.h"
 
 #include <cstdio>
 #include <cassert>
 
-enum class ShaderType
-{
-	VertexShader = 'vert',
-	PixelShader = 'frag'
-};
-
 static const char* GetAttribName(VertexAttrib attr) noexcept
 {
 	switch (attr)
@@ -36,76 +31,61 @@ static const char* GetAttribName(VertexAttrib attr) noexcept
 	}
 }
 
-static uint32_t CompileShader(AnsiStringView src, ShaderType type)
+namespace
 {
-	uint32_t shader = glCreateShader(type == ShaderType::VertexShader ? GL_VERTEX_SHADER : GL_FRAGMENT_SHADER);
-	const char* str = src.data();
-	GLint len = static_cast<GLint>(src.length());
-	glShaderSource(shader, 1, &str, &len);
-	glCompileShader(shader);
-
-	GLint flag;
-	glGetShaderiv(shader, GL_COMPILE_STATUS, &flag);
-	if (flag == GL_FALSE)
+	/// @brief Adds the heap allocations its thread made during its lifetime to a counter
+	class AllocationScope
 	{
-		char* info = new char[1024];
-		glGetShaderInfoLog(shader, 1024, nullptr, info);
-		glDeleteShader(shader);
-		printf("Error compiling shader: %s\n", info);
-		delete[] info;
-		return 0;
-	}
-	return shader;
-}
+	public:
+		explicit AllocationScope(size_t& counter) noexcept :
+			m_Counter(counter), m_Start(GetHeapAllocationCount()) {}
 
-static bool LinkProgram(uint32_t pipeline)
-{
-	if (pipeline == 0)
-		return false;
-	glLinkProgram(pipeline);
-	GLint flag;
-	glGetProgramiv(pipeline, GL_LINK_STATUS, &flag);
-	if (flag == GL_FALSE)
+		~AllocationScope() { m_Counter += GetHeapAllocationCount() - m_Start; }
+
+	private:
+		size_t& m_Counter;
+		const size_t m_Start;
+	};
+
+	/// @brief Whether a T can set a uniform of type
+	template <ShaderParamType T>
+	bool AcceptsType(UniformType type) noexcept
 	{
-		char* info = new char[1024];
-		glGetProgramInfoLog(pipeline, 1024, nullptr, info);
-		printf("Error linking pipeline: %s\n", info);
-		delete[] info;
-		return false;
+		if constexpr (SameAs<T, bool>)
+			return type == UniformType::Bool;
+		else if constexpr (SameAs<T, int>)
+			return type == UniformType::Int || type == UniformType::Bool || type == UniformType::Sampler;
+		else if constexpr (SameAs<T, float>)
+			return type == UniformType::Float;
+		else if constexpr (SameAs<T, vec3>)
+			return type == UniformType::Vec3;
+		else if constexpr (SameAs<T, vec4>)
+			return type == UniformType::Vec4;
+		else
+			return type == UniformType::Mat4;
 	}
-	return true;
 }
 
 Pipeline::Pipeline(AnsiStringView VSSrc, AnsiStringView PSSrc) :
-	m_Program(0)
+	m_Device(Graphics::GetSingleton()->GetDevice()), m_Program(0), m_InstanceModelLocation(-1)
 {
-	uint32_t vs = CompileShader(VSSrc, ShaderType::VertexShader);
-	if (vs == 0)
-		return;
-	uint32_t ps = CompileShader(PSSrc, ShaderType::PixelShader);
-	if (ps == 0)
-	{
-		glDeleteShader(vs);
-		return;
-	}
-	m_Program = glCreateProgram();
-	glAttachShader(m_Program, vs);
-	glAttachShader(m_Program, ps);
-	if (LinkProgram(m_Program) == false)
+	assert(m_Device);
+	m_Program = m_Device->CreateProgram(VSSrc, PSSrc);
+	if (m_Program)
 	{
-		glDeleteProgram(m_Program);
-		m_Program = 0;
+		ReflectUniforms();
+		m_InstanceModelLocation = m_Device->GetAttribLocation(m_Program, "InstanceModel");
+		m_FrameBuffer = ReflectUniformBlock("FrameBlock", UniformBlockBinding::Frame, sizeof(FrameUniforms));
+		m_LightBuffer = ReflectUniformBlock("LightBlock", UniformBlockBinding::Lights, sizeof(LightUniforms));
 	}
-	glDeleteShader(ps);
-	glDeleteShader(vs);
 
-	glVertexAttrib4fv(GetAttribLocation(VertexAttrib::Color), Color::white());
+	m_Device->SetVertexAttribDefault(GetAttribLocation(VertexAttrib::Color), Color::white());
 }
 
 Pipeline::~Pipeline()
 {
 	if (m_Program)
-		glDeleteProgram(m_Program);
+		m_Device->DeleteProgram(m_Program);
 }
 
 bool Pipeline::Valid() const noexcept
@@ -115,110 +95,261 @@ bool Pipeline::Valid() const noexcept
 
 int32_t Pipeline::GetAttribLocation(VertexAttrib attrib) const
 {
-	return glGetAttribLocation(m_Program, GetAttribName(attrib));
+	return m_Device->GetAttribLocation(m_Program, GetAttribName(attrib));
+}
+
+template <ShaderParamType T>
+ParamHandle<T> Pipeline::GetParamHandle(AnsiStringView name) const
+{
+	auto it = m_UniformIndices.find(name);
+	if (it == m_UniformIndices.end())
+		return ParamHandle<T>();
+	const UniformInfo& uniform = m_Uniforms[it->second];
+	if (!AcceptsType<T>(uniform.type))
+	{
+		printf("Warning: Shader param \"%s\" has a different type!\n", uniform.name.c_str());
+		return ParamHandle<T>();
+	}
+	return ParamHandle<T>(uniform.location);
+}
+
+template ParamHandle<bool> Pipeline::GetParamHandle(AnsiStringView name) const;
+template ParamHandle<int> Pipeline::GetParamHandle(AnsiStringView name) const;
+template ParamHandle<float> Pipeline::GetParamHandle(AnsiStringView name) const;
+template ParamHandle<vec3> Pipeline::GetParamHandle(AnsiStringView name) const;
+template ParamHandle<vec4> Pipeline::GetParamHandle(AnsiStringView name) const;
+template ParamHandle<mat4> Pipeline::GetParamHandle(AnsiStringView name) const;
+
+template <ShaderParamType T>
+ParamHandle<T> Pipeline::FindParam(AnsiStringView name)
+{
+	AllocationScope scope(m_ParamAllocations);
+	++m_NameLookups;
+	return GetParamHandle<T>(name);
+}
+
+void Pipeline::SetShaderParam(ParamHandle<bool> param, bool b)
+{
+	if (param.Valid())
+		m_Device->SetUniform(param.m_Location, b ? 1 : 0);
+}
+
+void Pipeline::SetShaderParam(ParamHandle<int> param, int v)
+{
+	if (param.Valid())
+		m_Device->SetUniform(param.m_Location, v);
+}
+
+void Pipeline::SetShaderParam(ParamHandle<float> param, float v)
+{
+	if (param.Valid())
+		m_Device->SetUniform(param.m_Location, v);
 }
 
-void Pipeline::SetShaderParam(const AnsiString& name, bool b)
+void Pipeline::SetShaderParam(ParamHandle<vec3> param, const vec3& v)
 {
-	if (GLint loc = GetParamLocation(name); loc >= 0)
-		glUniform1i(loc, b ? GL_TRUE : GL_FALSE);
+	if (param.Valid())
+		m_Device->SetUniform(param.m_Location, v);
 }
 
-void Pipeline::SetShaderParam(const AnsiString& name, int v)
+void Pipeline::SetShaderParam(ParamHandle<vec4> param, const vec4& v)
 {
-	if (GLint loc = GetParamLocation(name); loc >= 0)
-		glUniform1i(loc, v);
+	if (param.Valid())
+		m_Device->SetUniform(param.m_Location, v);
 }
 
-void Pipeline::SetShaderParam(const AnsiString& name, float v)
+void Pipeline::SetShaderParam(ParamHandle<mat4> param, const mat4& m)
 {
-	if (GLint loc = GetParamLocation(name); loc >= 0)
-		glUniform1f(loc, v);
+	if (param.Valid())
+		m_Device->SetUniform(param.m_Location, m);
 }
 
-void Pipeline::SetShaderParam(const AnsiString& name, const vec3& v)
+void Pipeline::SetShaderParam(AnsiStringView name, bool b)
 {
-	if (GLint loc = GetParamLocation(name); loc >= 0)
-		glUniform3fv(loc, 1, v);
+	SetShaderParam(FindParam<bool>(name), b);
 }
 
-void Pipeline::SetShaderParam(const AnsiString& name, const vec4& v)
+void Pipeline::SetShaderParam(AnsiStringView name, int v)
 {
-	if (GLint loc = GetParamLocation(name); loc >= 0)
-		glUniform4fv(loc, 1, v);
+	SetShaderParam(FindParam<int>(name), v);
 }
 
-void Pipeline::SetShaderParam(const AnsiString& name, const mat4& m)
+void Pipeline::SetShaderParam(AnsiStringView name, float v)
 {
-	if (GLint loc = GetParamLocation(name); loc >= 0)
-		glUniformMatrix4fv(loc, 1, GL_FALSE, m.cols[0]);
+	SetShaderParam(FindParam<float>(name), v);
+}
+
+void Pipeline::SetShaderParam(AnsiStringView name, const vec3& v)
+{
+	SetShaderParam(FindParam<vec3>(name), v);
+}
+
+void Pipeline::SetShaderParam(AnsiStringView name, const vec4& v)
+{
+	SetShaderParam(FindParam<vec4>(name), v);
+}
+
+void Pipeline::SetShaderParam(AnsiStringView name, const mat4& m)
+{
+	SetShaderParam(FindParam<mat4>(name), m);
 }
 
 void Pipeline::SetCameraParams(CameraObject* camera)
 {
+	AllocationScope scope(m_ParamAllocations);
 	if (camera == nullptr)
 		return;
-	SetShaderParam("MVP.Projection", camera->GetProjectionMatrix());
-	SetShaderParam("MVP.View", camera->lookAt);
+	FrameUniforms& frame = m_FrameUniforms;
+	frame.view = camera->lookAt;
+	frame.projection = camera->GetProjectionMatrix();
+	frame.viewProjection = frame.projection * frame.view;
+	frame.cameraPosition = camera->GetPosition();
+	m_DirtyBlocks |= FrameBlockDirty;
 }
 
 void Pipeline::SetLightParams(SunLightObject* light)
 {
-	AnsiString prefix = "SunLight.";
+	AllocationScope scope(m_ParamAllocations);
+	SunLightUniforms& sun = m_LightUniforms.sunLight;
+	m_DirtyBlocks |= LightBlockDirty;
 	if (light == nullptr)
 	{
-		SetShaderParam(prefix + "Enabled", false);
+		sun.enabled = 0;
 		return;
 	}
-	SetShaderParam(prefix + "Enabled", true);
-	SetShaderParam(prefix + "Direction", light->direction);
-	SetShaderParam(prefix + "Color", light->color);
-	SetShaderParam(prefix + "Ambient", light->ambient);
-	SetShaderParam(prefix + "Intensity", light->intensity);
+	sun.enabled = 1;
+	sun.direction = light->direction;
+	sun.color = light->color;
+	sun.ambient = light->ambient;
+	sun.intensity = light->intensity;
 }
 
 void Pipeline::SetLightParams(unsigned light_id, OmniLightObject* light)
 {
-	AnsiString prefix = "OmniLights[" + std::to_string(light_id & 0xFF) + "].";
+	AllocationScope scope(m_ParamAllocations);
+	if (light_id >= MaxOmniLights)
+		return;
+	OmniLightUniforms& omni = m_LightUniforms.omniLights[light_id];
+	int32_t& count = m_LightUniforms.omniLightCount;
+	m_DirtyBlocks |= LightBlockDirty;
 	if (light == nullptr)
 	{
-		SetShaderParam(prefix + "Enabled", false);
+		omni.enabled = 0;
+		// Keep the shaded range as short as the highest enabled light
+		while (count > 0 && m_LightUniforms.omniLights[count - 1].enabled == 0)
+			--count;
 		return;
 	}
-	SetShaderParam(prefix + "Enabled", true);
-	SetShaderParam(prefix + "Position", light->position);
-	SetShaderParam(prefix + "Direction", light->direction);
-	SetShaderParam(prefix + "Color", light->color);
-	SetShaderParam(prefix + "Intensity", light->intensity);
-	SetShaderParam(prefix + "Attenuation", light->attenuation);
-	SetShaderParam(prefix + "SquareAttenuation", light->squareAttenuation);
-	SetShaderParam(prefix + "ConeAngle", light->coneAngle);
-	SetShaderParam(prefix + "Spot", light->spot);
+	omni.enabled = 1;
+	omni.position = light->position;
+	omni.direction = light->direction;
+	omni.color = light->color;
+	omni.intensity = light->intensity;
+	omni.attenuation = light->attenuation;
+	omni.squareAttenuation = light->squareAttenuation;
+	omni.cosHalfCone = Mathf::cos(light->coneAngle * 0.5f);
+	omni.spot = light->spot ? 1 : 0;
+	count = Mathf::max(count, static_cast<int32_t>(light_id) + 1);
 }
 
 void Pipeline::SetMaterialParams(Material* material)
 {
+	AllocationScope scope(m_ParamAllocations);
 	int gl_tex_off = 0;
 	if (material == nullptr)
 		return;
+	const MaterialParams& params = m_MaterialParams;
 	if (material->diffuse.UseMap())
 	{
-		SetShaderParam("Material.UseDiffuseMap", true);
-		glActiveTexture(GL_TEXTURE0 + gl_tex_off);
-		glBindTexture(GL_TEXTURE_2D, material->diffuse.GetTexture()->GetTextureID());
-		SetShaderParam("Material.DiffuseMap", gl_tex_off);
+		SetShaderParam(params.useDiffuseMap, true);
+		// The sampler keeps its unit while the pipeline is in use, so the bind is all that changes
+		const uint32_t texture = material->diffuse.GetTexture()->GetTextureID();
+		if (texture != m_BoundDiffuseMap)
+		{
+			m_Device->BindTexture(gl_tex_off, texture);
+			SetShaderParam(params.diffuseMap, gl_tex_off);
+			m_BoundDiffuseMap = texture;
+		}
 		++gl_tex_off;
 	}
 	else
 	{
-		SetShaderParam("Material.UseDiffuseMap", false);
-		SetShaderParam("Material.Diffuse", material->diffuse.GetValue());
+		SetShaderParam(params.useDiffuseMap, false);
+		SetShaderParam(params.diffuse, material->diffuse.GetValue());
+	}
+	SetShaderParam(params.specular, material->specular);
+	SetShaderParam(params.glossiness, material->glosiness);
+}
+
+void Pipeline::FlushUniformBlocks()
+{
+	if (m_DirtyBlocks == 0)
+		return;
+	AllocationScope scope(m_ParamAllocations);
+	if ((m_DirtyBlocks & FrameBlockDirty) && m_FrameBuffer)
+		m_FrameBuffer->Upload(&m_FrameUniforms, sizeof(FrameUniforms));
+	if ((m_DirtyBlocks & LightBlockDirty) && m_LightBuffer)
+	{
+		const size_t count = static_cast<size_t>(m_LightUniforms.omniLightCount);
+		m_LightBuffer->Upload(&m_LightUniforms, offsetof(LightUniforms, omniLights) + count * sizeof(OmniLightUniforms));
 	}
-	SetShaderParam("Material.Specular", material->specular);
-	SetShaderParam("Material.Glossiness", material->glosiness);
+	m_DirtyBlocks = 0;
 }
 
-int32_t Pipeline::GetParamLocation(const AnsiString& name) const
+void Pipeline::BindUniformBlocks() const
 {
-	return glGetUniformLocation(m_Program, name.c_str());
-}
\ No newline at end of file
+	if (m_FrameBuffer)
+		m_FrameBuffer->Bind();
+	if (m_LightBuffer)
+		m_LightBuffer->Bind();
+}
+
+size_t Pipeline::GetUniformBlockUploadCount() const noexcept
+{
+	return (m_FrameBuffer ? m_FrameBuffer->GetUploadCount() : 0) + (m_LightBuffer ? m_LightBuffer->GetUploadCount() : 0);
+}
+
+void Pipeline::ReflectUniforms()
+{
+	Array<UniformInfo> active;
+	m_Device->GetActiveUniforms(m_Program, active);
+	for (UniformInfo& uniform : active)
+	{
+		// Members of uniform blocks have no location
+		if (uniform.location < 0)
+			continue;
+		// Arrays of basic types are reported once as "name[0]", their elements have consecutive locations
+		if (uniform.name.ends_with("[0]"))
+		{
+			uniform.name.resize(uniform.name.size() - 3);
+			for (int32_t k = 0; k < uniform.size; ++k)
+				AddUniform(uniform.name + "[" + std::to_string(k) + "]", uniform.location + k, uniform.type, 1);
+		}
+		AddUniform(std::move(uniform.name), uniform.location, uniform.type, uniform.size);
+	}
+
+	m_MaterialParams = {
+		GetParamHandle<bool>("Material.UseDiffuseMap"),
+		GetParamHandle<int>("Material.DiffuseMap"),
+		GetParamHandle<vec4>("Material.Diffuse"),
+		GetParamHandle<float>("Material.Specular"),
+		GetParamHandle<float>("Material.Glossiness"),
+	};
+}
+
+void Pipeline::AddUniform(AnsiString name, int32_t location, UniformType type, int32_t size)
+{
+	const uint32_t index = static_cast<uint32_t>(m_Uniforms.size());
+	if (m_UniformIndices.try_emplace(name, index).second)
+		m_Uniforms.push_back({ std::move(name), location, type, size });
+}
+
+UniquePtr<UniformBuffer> Pipeline::ReflectUniformBlock(const char* name, UniformBlockBinding binding, size_t size)
+{
+	const int32_t blockSize = m_Device->BindUniformBlock(m_Program, name, static_cast<uint32_t>(binding));
+	if (blockSize < 0)
+		return nullptr;
+	if (static_cast<size_t>(blockSize) != size)
+		printf("Warning: Uniform block \"%s\" is %d bytes, its std140 mirror is %zu!\n", name, blockSize, size);
+	return MakeUnique<UniformBuffer>(binding, Mathf::max(size, static_cast<size_t>(blockSize)));
+}
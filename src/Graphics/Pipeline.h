@@ -1,18 +1,45 @@
 #pragma once
 
+#include "RenderDevice.h"
+#include "UniformBlocks.h"
 #include "VertexAttributes.h"
 
+#include "../Utilities/Array.h"
+#include "../Utilities/HashMap.h"
+#include "../Utilities/Pointer.h"
 #include "../Utilities/String.h"
-#include "../Utilities/String.h"
+#include "../Utilities/Traits.h"
 #include <cstdint>
 
-class vec3;
-class vec4;
-class mat4;
 class CameraObject;
 class SunLightObject;
 class OmniLightObject;
 class Material;
+class UniformBuffer;
+
+/// @brief C++ types that SetShaderParam can upload
+template <typename T>
+concept ShaderParamType = SameAs<T, bool> || SameAs<T, int> || SameAs<T, float> ||
+	SameAs<T, vec3> || SameAs<T, vec4> || SameAs<T, mat4>;
+
+/// @brief Location of a uniform resolved once, typed by the value it takes.
+/// A default constructed handle, or one for a uniform the pipeline does not have, is invalid and
+/// setting it does nothing.
+template <ShaderParamType T>
+class ParamHandle
+{
+	friend class Pipeline;
+
+public:
+	constexpr ParamHandle() noexcept = default;
+
+	constexpr bool Valid() const noexcept { return m_Location >= 0; }
+
+private:
+	constexpr explicit ParamHandle(int32_t location) noexcept : m_Location(location) {}
+
+	int32_t m_Location = -1;
+};
 
 class Pipeline
 {
@@ -31,28 +58,126 @@ public:
 
 	int32_t GetAttribLocation(VertexAttrib attrib) const;
 
-	void SetShaderParam(const AnsiString& name, bool b);
+	/// @brief First of the four locations of the vertex shader's "in mat4 InstanceModel", which
+	/// takes the model matrix from the instance stream, e.g. in PhongPipeline(true)
+	/// @return -1 if the pipeline takes the model matrix from a uniform
+	int32_t GetInstanceModelLocation() const noexcept { return m_InstanceModelLocation; }
+
+	bool IsInstanced() const noexcept { return m_InstanceModelLocation >= 0; }
+
+	/// @brief Uniforms reflected at link time. Arrays of basic types are listed once as "name" and
+	/// once per element as "name[i]".
+	const Array<UniformInfo>& GetUniforms() const noexcept { return m_Uniforms; }
+
+	/// @brief Resolve a uniform once, e.g. at load time, for use every frame.
+	/// @return Invalid handle, with a warning, if the uniform's type does not take a T
+	template <ShaderParamType T>
+	ParamHandle<T> GetParamHandle(AnsiStringView name) const;
+
+	void SetShaderParam(ParamHandle<bool> param, bool b);
+
+	void SetShaderParam(ParamHandle<int> param, int v);
+
+	void SetShaderParam(ParamHandle<float> param, float v);
+
+	void SetShaderParam(ParamHandle<vec3> param, const vec3& v);
+
+	void SetShaderParam(ParamHandle<vec4> param, const vec4& v);
 
-	void SetShaderParam(const AnsiString& name, int v);
+	void SetShaderParam(ParamHandle<mat4> param, const mat4& m);
 
-	void SetShaderParam(const AnsiString& name, float v);
+	/// @brief By name, through the table reflected at link time. Unknown names are ignored, as are
+	/// uniforms of another type, with a warning. Prefer handles every frame.
+	void SetShaderParam(AnsiStringView name, bool b);
 
-	void SetShaderParam(const AnsiString& name, const vec3& v);
+	void SetShaderParam(AnsiStringView name, int v);
 
-	void SetShaderParam(const AnsiString& name, const vec4& v);
+	void SetShaderParam(AnsiStringView name, float v);
 
-	void SetShaderParam(const AnsiString& name, const mat4& m);
+	void SetShaderParam(AnsiStringView name, const vec3& v);
 
+	void SetShaderParam(AnsiStringView name, const vec4& v);
+
+	void SetShaderParam(AnsiStringView name, const mat4& m);
+
+	/// @brief Camera and light parameters are written to CPU copies of FrameBlock and LightBlock,
+	/// and reach the GPU at the next FlushUniformBlocks()
 	void SetCameraParams(CameraObject* camera);
 
 	void SetLightParams(SunLightObject* light);
 
+	/// @param light_id Below MaxOmniLights, others are ignored
 	void SetLightParams(unsigned light_id, OmniLightObject* light);
 
+	/// @brief Set the material's parameters. Its diffuse map is only bound if another texture
+	/// was bound for this pipeline since it was put in use. Does nothing for nullptr.
 	void SetMaterialParams(Material* material);
 
+	/// @brief Forget the textures SetMaterialParams() bound, e.g. after other code bound textures.
+	/// Graphics::UsePipeline() calls it, since other pipelines share the texture units.
+	void InvalidateBoundTextures() noexcept { m_BoundDiffuseMap = UINT32_MAX; }
+
+	/// @brief Upload the uniform blocks changed since the last flush, one buffer update each.
+	/// Called before every draw, so it costs nothing until parameters change.
+	void FlushUniformBlocks();
+
+	/// @brief Attach the pipeline's uniform buffers to their binding points, when it starts being used
+	void BindUniformBlocks() const;
+
+	const FrameUniforms& GetFrameUniforms() const noexcept { return m_FrameUniforms; }
+
+	const LightUniforms& GetLightUniforms() const noexcept { return m_LightUniforms; }
+
+	/// @brief Buffer updates made by FlushUniformBlocks() since link time
+	size_t GetUniformBlockUploadCount() const noexcept;
+
+	/// @brief Parameters set by name since link time
+	size_t GetNameLookupCount() const noexcept { return m_NameLookups; }
+
+	/// @brief Heap allocations made by the Set*Params and SetShaderParam calls since link time.
+	/// Stays 0 once setup is done; checked with GetHeapAllocationCount(), so always 0 without HEAP_STATS.
+	size_t GetParamAllocationCount() const noexcept { return m_ParamAllocations; }
+
 private:
-	int32_t GetParamLocation(const AnsiString& name) const;
+	struct MaterialParams
+	{
+		ParamHandle<bool> useDiffuseMap;
+		ParamHandle<int> diffuseMap;
+		ParamHandle<vec4> diffuse;
+		ParamHandle<float> specular;
+		ParamHandle<float> glossiness;
+	};
+
+	/// @brief Bits of m_DirtyBlocks
+	static constexpr uint32_t FrameBlockDirty = 1;
+	static constexpr uint32_t LightBlockDirty = 2;
+
+	/// @brief Fill the uniform table and the handles of the built-in parameter sets
+	void ReflectUniforms();
+
+	/// @brief Bind the named block to binding and create its buffer
+	/// @return nullptr if the pipeline does not declare the block
+	UniquePtr<UniformBuffer> ReflectUniformBlock(const char* name, UniformBlockBinding binding, size_t size);
+
+	void AddUniform(AnsiString name, int32_t location, UniformType type, int32_t size);
+
+	/// @brief GetParamHandle() for the setters by name, counting the lookup
+	template <ShaderParamType T>
+	ParamHandle<T> FindParam(AnsiStringView name);
 
+	RenderDevice* m_Device;
 	uint32_t m_Program;
-};
\ No newline at end of file
+	int32_t m_InstanceModelLocation;
+	Array<UniformInfo> m_Uniforms;
+	StringHashMap<uint32_t> m_UniformIndices;
+	MaterialParams m_MaterialParams;
+	FrameUniforms m_FrameUniforms{};
+	LightUniforms m_LightUniforms{};
+	UniquePtr<UniformBuffer> m_FrameBuffer;
+	UniquePtr<UniformBuffer> m_LightBuffer;
+	uint32_t m_DirtyBlocks = 0;
+	/// @brief Texture SetMaterialParams() bound to the diffuse map unit, UINT32_MAX if unknown
+	uint32_t m_BoundDiffuseMap = UINT32_MAX;
+	size_t m_NameLookups = 0;
+	size_t m_ParamAllocations = 0;
+};
@@ -0,0 +1,173 @@
+#pragma once
+
+#include "../Math/vec4.h"
+#include "../Utilities/Array.h"
+#include "../Utilities/String.h"
+
+#include <cstddef>
+#include <cstdint>
+
+class mat4;
+class Image;
+enum class TextureWrapMode;
+
+enum class PrimitiveType
+{
+	/// @brief For N>=0, vertex N renders a point.
+	PointList = 'PLst',
+	/// @brief For N>=0, vertices [N*2+0, N*2+1] render a line.
+	LineList = 'LLst',
+	/// @brief For N>=0, vertices [N, N+1] render a line.
+	LineStrip = 'LStr',
+	/// @brief Like <c>LineStrip</c>, but the first and last vertices also render a line.
+	LineLoop = 'LLop',
+	/// @brief For N>=0, vertices [N*3+0, N*3+1, N*3+2] render a triangle.
+	TriangleList = 'TLst',
+	/// @brief For N>=0, vertices [0, (N+1)%M, (N+2)%M] render a triangle, where M is the vertex count.
+	TriangleFan = 'TFan',
+	/// @brief For N>=0, vertices [N*2+0, N*2+1, N*2+2] and [N*2+2, N*2+1, N*2+3] render triangles.
+	TriangleStrip = 'TStr',
+	/// @brief Used for tessellation.
+	Patch = 'Pach',
+	/// @brief For N>=0, vertices [N*4..N*4+3] render a line from [1, 2].
+	/// Lines [0, 1] and [2, 3] are adjacent to the rendered line.
+	LineListAdjacency = 'LLAd',
+	/// @brief For N>=0, vertices [N+1, N+2] render a line.
+	/// Lines [N, N+1] and [N+2, N+3] are adjacent to the rendered line.
+	LineStripAdjacency = 'LSAd',
+	/// @brief For N>=0, vertices [N*6..N*6+5] render a triangle from [0, 2, 4].
+	/// Triangles [0, 1, 2] [4, 2, 3] and [5, 0, 4] are adjacent to the rendered triangle.
+	TriangleListAdjacency = 'TLAd',
+	/// @brief For N>=0, vertices [N*4..N*4+6] render a triangle from [0, 2, 4] and [4, 2, 6].
+	/// Odd vertices Nodd form adjacent triangles with indices min(Nodd+1,Nlast) and max(Nodd-3,Nfirst).
+	TriangleStripAdjacency = 'TSAd',
+};
+
+enum class BufferUsage
+{
+	/// @brief Written once, e.g. vertices and indices
+	Static,
+	/// @brief Rewritten every frame, e.g. uniform blocks
+	Dynamic,
+};
+
+/// @brief Shader side type of a uniform
+enum class UniformType : uint32_t
+{
+	Bool,
+	Int,
+	Float,
+	Vec2,
+	Vec3,
+	Vec4,
+	Mat3,
+	Mat4,
+	Sampler,
+	Other,
+};
+
+/// @brief Active uniform of a linked pipeline
+struct UniformInfo
+{
+	AnsiString name;
+	int32_t location;
+	UniformType type;
+	/// @brief Array length, 1 for non-arrays
+	int32_t size;
+};
+
+/// @brief Every call the renderer makes to the graphics API.
+/// Objects are plain 32 bit names, 0 meaning none. GLRenderDevice forwards to OpenGL;
+/// NullRenderDevice records the calls without a context, for headless tests and benchmarks.
+class RenderDevice
+{
+public:
+	virtual ~RenderDevice() = default;
+
+	/// @brief Load the API and set the default state
+	/// @return 0 on success
+	virtual int Initialize(int width, int height) = 0;
+
+	virtual void SetViewport(int width, int height) = 0;
+
+	/// @brief Clear color and depth
+	virtual void Clear(const Color& color) = 0;
+
+	/// @brief Compile and link a vertex and a pixel shader
+	/// @return 0, with the log printed, if either fails
+	virtual uint32_t CreateProgram(AnsiStringView vsSrc, AnsiStringView psSrc) = 0;
+
+	virtual void DeleteProgram(uint32_t program) = 0;
+
+	virtual void UseProgram(uint32_t program) = 0;
+
+	/// @return -1 if the program has no such attribute
+	virtual int32_t GetAttribLocation(uint32_t program, const char* name) = 0;
+
+	/// @brief Append the active uniforms as the API lists them: arrays of basic types once, named
+	/// "name[0]". Uniform block members have location -1.
+	virtual void GetActiveUniforms(uint32_t program, Array<UniformInfo>& out) = 0;
+
+	/// @brief Attach the named uniform block to a buffer binding point
+	/// @return Size of the block in bytes, -1 if the program has no such block
+	virtual int32_t BindUniformBlock(uint32_t program, const char* name, uint32_t binding) = 0;
+
+	/// @brief Set a uniform of the program in use. Bools are set as ints.
+	virtual void SetUniform(int32_t location, int v) = 0;
+
+	virtual void SetUniform(int32_t location, float v) = 0;
+
+	virtual void SetUniform(int32_t location, const vec3& v) = 0;
+
+	virtual void SetUniform(int32_t location, const vec4& v) = 0;
+
+	virtual void SetUniform(int32_t location, const mat4& m) = 0;
+
+	/// @brief Value of an attribute for vertex arrays that do not source it
+	virtual void SetVertexAttribDefault(int32_t location, const vec4& v) = 0;
+
+	/// @param data Initial contents, may be nullptr
+	virtual uint32_t CreateBuffer(size_t size, const void* data, BufferUsage usage) = 0;
+
+	virtual void DeleteBuffer(uint32_t buffer) = 0;
+
+	/// @brief Overwrite bytes [offset, offset + size) of buffer
+	virtual void UpdateBuffer(uint32_t buffer, size_t offset, size_t size, const void* data) = 0;
+
+	virtual void BindUniformBuffer(uint32_t binding, uint32_t buffer) = 0;
+
+	virtual uint32_t CreateVertexArray() = 0;
+
+	virtual void DeleteVertexArray(uint32_t vertexArray) = 0;
+
+	virtual void BindVertexArray(uint32_t vertexArray) = 0;
+
+	/// @brief Source an attribute of the bound vertex array from floats in buffer, one vertex after
+	/// another
+	virtual void SetVertexAttribute(int32_t location, uint32_t buffer, int components, bool normalized, size_t offset) = 0;
+
+	/// @brief Source an attribute of the bound vertex array from floats in buffer that advance once
+	/// per instance, stride bytes apart
+	virtual void SetInstanceAttribute(int32_t location, uint32_t buffer, int components, size_t stride, size_t offset) = 0;
+
+	/// @brief Source 16 bit indices of the bound vertex array from buffer
+	virtual void SetIndexBuffer(uint32_t buffer) = 0;
+
+	/// @brief Upload image with mipmaps
+	/// @return 0 if image is empty
+	virtual uint32_t CreateTexture2D(const Image& image, TextureWrapMode wrapX, TextureWrapMode wrapY, const Color& border) = 0;
+
+	virtual void BindTexture(uint32_t unit, uint32_t texture) = 0;
+
+	/// @brief Draw vertices [0, count) of the bound vertex array
+	virtual void Draw(PrimitiveType type, size_t count) = 0;
+
+	/// @brief Draw indices [0, count) of the bound vertex array
+	virtual void DrawIndexed(PrimitiveType type, size_t count) = 0;
+
+	/// @brief Draw vertices [0, count) of the bound vertex array instances times in one call
+	virtual void DrawInstanced(PrimitiveType type, size_t count, size_t instances) = 0;
+
+	/// @brief Draw indices [0, count) of the bound vertex array instances times in one call
+	virtual void DrawIndexedInstanced(PrimitiveType type, size_t count, size_t instances) = 0;
+};
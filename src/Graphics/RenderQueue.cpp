@@ -0,0 +1,156 @@
+#include "RenderQueue.h"
+
+#include "CameraObject.h"
+#include "Graphics.h"
+#include "Material.h"
+#include "Mesh.h"
+#include "Pipeline.h"
+#include "RenderDevice.h"
+
+#include <cassert>
+#include <utility>
+
+namespace
+{
+	constexpr uint64_t Field(uint64_t value, int bits) noexcept
+	{
+		return value & ((uint64_t(1) << bits) - 1);
+	}
+
+	/// @return 0 without a material or diffuse map
+	uint32_t GetDiffuseMapID(const Material* material) noexcept
+	{
+		return material != nullptr && material->diffuse.UseMap() ? material->diffuse.GetTexture()->GetTextureID() : 0;
+	}
+}
+
+void RenderQueue::Begin(const CameraObject& camera)
+{
+	m_Items.clear();
+	m_Models.clear();
+	m_Keys.clear();
+	m_View = camera.lookAt;
+	m_NearClip = camera.nearClip;
+	m_InvDepthRange = 1 / (camera.farClip - camera.nearClip);
+}
+
+void RenderQueue::Submit(Mesh* mesh)
+{
+	Submit(mesh, mesh->transform);
+}
+
+void RenderQueue::Submit(Mesh* mesh, const mat4& model)
+{
+	assert(mesh);
+	Material* material = mesh->GetMaterial().get();
+	const Item item = { mesh, mesh->GetPipeline().get(), material, GetDiffuseMapID(material), mesh->GetVertexArrayID() };
+	m_Keys.push_back(MakeKey(item, model));
+	m_Items.push_back(item);
+	m_Models.push_back(model);
+}
+
+void RenderQueue::Execute()
+{
+	Sort();
+	m_Stats = RenderQueueStats();
+	Graphics* graphics = Graphics::GetSingleton();
+	RenderDevice* device = graphics->GetDevice();
+	Pipeline* pipeline = nullptr;
+	Material* material = nullptr;
+	uint32_t texture = UINT32_MAX;
+	uint32_t vertexArray = UINT32_MAX;
+	for (uint32_t index : m_Order)
+	{
+		const Item& item = m_Items[index];
+		if (item.pipeline != pipeline)
+		{
+			graphics->UsePipeline(item.mesh->GetPipeline());
+			pipeline = item.pipeline;
+			// Material parameters live in the program, set them again for the new one
+			material = nullptr;
+			++m_Stats.pipelineChanges;
+		}
+		if (item.material != material)
+		{
+			pipeline->SetMaterialParams(item.material);
+			material = item.material;
+			++m_Stats.materialChanges;
+			if (item.texture != texture)
+			{
+				texture = item.texture;
+				++m_Stats.textureChanges;
+			}
+		}
+		if (item.vertexArray != vertexArray)
+		{
+			device->BindVertexArray(item.vertexArray);
+			vertexArray = item.vertexArray;
+			++m_Stats.vertexArrayChanges;
+		}
+		item.mesh->DrawBound(m_Models[index]);
+		++m_Stats.draws;
+	}
+	device->BindVertexArray(0);
+}
+
+uint64_t RenderQueue::MakeKey(const Item& item, const mat4& model)
+{
+	// Id 0 is no material
+	uint32_t material = 0;
+	if (item.material != nullptr)
+		material = m_MaterialIds.try_emplace(item.material, static_cast<uint32_t>(m_MaterialIds.size() + 1)).first->second;
+
+	// View space depth of the model's origin: third row of the view matrix
+	const vec4& origin = model.cols[3];
+	const float depth = -(m_View.cols[0].z * origin.x + m_View.cols[1].z * origin.y +
+		m_View.cols[2].z * origin.z + m_View.cols[3].z);
+	const float t = Mathf::clamp((depth - m_NearClip) * m_InvDepthRange, 0.0f, 1.0f);
+	const uint64_t depthBits = static_cast<uint64_t>(t * float((1 << DepthBits) - 1));
+
+	uint64_t key = Field(item.pipeline->GetProgramID(), PipelineBits);
+	key = (key << TextureBits) | Field(item.texture, TextureBits);
+	key = (key << MaterialBits) | Field(material, MaterialBits);
+	key = (key << VertexArrayBits) | Field(item.vertexArray, VertexArrayBits);
+	key = (key << DepthBits) | depthBits;
+	return key;
+}
+
+void RenderQueue::Sort()
+{
+	const size_t count = m_Keys.size();
+	m_Order.resize(count);
+	for (size_t i = 0; i < count; ++i)
+		m_Order[i] = static_cast<uint32_t>(i);
+	if (count < 2)
+		return;
+
+	// LSD radix sort on bytes. All histograms come from one pass over the keys, and bytes every
+	// key shares, e.g. the pipeline of a single pipeline scene, are skipped.
+	constexpr int Passes = 8;
+	uint32_t histograms[Passes][256] = {};
+	for (uint64_t key : m_Keys)
+		for (int pass = 0; pass < Passes; ++pass)
+			++histograms[pass][(key >> (pass * 8)) & 0xFF];
+
+	m_SortedKeys = m_Keys;
+	m_SortedKeysScratch.resize(count);
+	m_OrderScratch.resize(count);
+	for (int pass = 0; pass < Passes; ++pass)
+	{
+		uint32_t* histogram = histograms[pass];
+		const int shift = pass * 8;
+		if (histogram[(m_SortedKeys[0] >> shift) & 0xFF] == count)
+			continue;
+		uint32_t offset = 0;
+		for (int digit = 0; digit < 256; ++digit)
+			offset += std::exchange(histogram[digit], offset);
+		for (size_t i = 0; i < count; ++i)
+		{
+			const uint32_t slot = histogram[(m_SortedKeys[i] >> shift) & 0xFF]++;
+			m_SortedKeysScratch[slot] = m_SortedKeys[i];
+			m_OrderScratch[slot] = m_Order[i];
+		}
+		std::swap(m_SortedKeys, m_SortedKeysScratch);
+		std::swap(m_Order, m_OrderScratch);
+	}
+}
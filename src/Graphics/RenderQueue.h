@@ -0,0 +1,99 @@
+#pragma once
+
+#include "../Math/mat4.h"
+#include "../Utilities/Array.h"
+#include "../Utilities/HashMap.h"
+
+#include <cstdint>
+
+class CameraObject;
+class Material;
+class Mesh;
+class Pipeline;
+
+/// @brief State changes and draws made by the last RenderQueue::Execute()
+struct RenderQueueStats
+{
+	size_t draws = 0;
+	size_t pipelineChanges = 0;
+	size_t materialChanges = 0;
+	/// @brief Material changes that also bound another diffuse map
+	size_t textureChanges = 0;
+	size_t vertexArrayChanges = 0;
+
+	size_t StateChanges() const noexcept
+	{
+		return pipelineChanges + materialChanges + vertexArrayChanges;
+	}
+};
+
+/// @brief Collects the draws of a frame and executes them sorted by state.
+/// Each submission gets a 64 bit key, from the most significant bits down: pipeline (8 bits),
+/// diffuse map (12), material (12), vertex array (16) and view depth (16, front to back).
+/// Execute() radix sorts the keys, so draws sharing state run together, and sets only the state
+/// that differs from the previous draw. Keys only decide the order: ids wider than their field
+/// may interleave, but never skip a state change that is needed.
+class RenderQueue final
+{
+public:
+	RenderQueue() = default;
+
+	RenderQueue(const RenderQueue&) = delete;
+
+	RenderQueue& operator=(const RenderQueue&) = delete;
+
+	/// @brief Drop the previous frame's submissions, and measure depth from camera
+	void Begin(const CameraObject& camera);
+
+	/// @brief Draw mesh with its transform as the model matrix
+	void Submit(Mesh* mesh);
+
+	/// @brief Draw mesh with model as the model matrix
+	void Submit(Mesh* mesh, const mat4& model);
+
+	/// @brief Sort the submissions and draw them. The last pipeline executed stays in use.
+	void Execute();
+
+	size_t GetSubmissionCount() const noexcept { return m_Items.size(); }
+
+	const RenderQueueStats& GetStats() const noexcept { return m_Stats; }
+
+	/// @brief Sort keys in submission order
+	const Array<uint64_t>& GetKeys() const noexcept { return m_Keys; }
+
+private:
+	static constexpr int DepthBits = 16;
+	static constexpr int VertexArrayBits = 16;
+	static constexpr int MaterialBits = 12;
+	static constexpr int TextureBits = 12;
+	static constexpr int PipelineBits = 8;
+
+	struct Item
+	{
+		Mesh* mesh;
+		Pipeline* pipeline;
+		Material* material;
+		uint32_t texture;
+		uint32_t vertexArray;
+	};
+
+	uint64_t MakeKey(const Item& item, const mat4& model);
+
+	/// @brief Fill m_Order with item indices by ascending key
+	void Sort();
+
+	mat4 m_View;
+	float m_NearClip = 0.0f;
+	float m_InvDepthRange = 0.0f;
+	Array<Item> m_Items;
+	Array<mat4> m_Models;
+	Array<uint64_t> m_Keys;
+	/// @brief Sort scratch, ping-ponged between passes
+	Array<uint64_t> m_SortedKeys;
+	Array<uint64_t> m_SortedKeysScratch;
+	Array<uint32_t> m_Order;
+	Array<uint32_t> m_OrderScratch;
+	/// @brief Dense ids from 1 of the materials seen so far, stable across frames
+	HashMap<const Material*, uint32_t> m_MaterialIds;
+	RenderQueueStats m_Stats;
+};
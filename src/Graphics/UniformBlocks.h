@@ -0,0 +1,71 @@
+#pragma once
+
+#include "../Math/mat4.h"
+
+#include <cstddef>
+#include <cstdint>
+
+/// @brief Uniform buffer binding points shared by every pipeline
+enum class UniformBlockBinding : uint32_t
+{
+	/// @brief FrameBlock, FrameUniforms
+	Frame = 0,
+	/// @brief LightBlock, LightUniforms
+	Lights = 1,
+};
+
+/// @brief Length of the OmniLights array in LightBlock
+constexpr uint32_t MaxOmniLights = 64;
+
+// CPU mirrors of the std140 uniform blocks declared by the shaders. Members are ordered so that
+// every vec3 is followed by a scalar filling its fourth component, GLSL bools are int32_t, and
+// structs end on a 16 byte boundary.
+
+/// @brief FrameBlock: camera constants, written once per frame
+struct FrameUniforms
+{
+	mat4 view;
+	mat4 projection;
+	mat4 viewProjection;
+	vec3 cameraPosition;
+	float padding;
+};
+
+struct SunLightUniforms
+{
+	vec3 direction;
+	float intensity;
+	Color color;
+	Color ambient;
+	int32_t enabled;
+	int32_t padding[3];
+};
+
+struct OmniLightUniforms
+{
+	vec3 position;
+	float intensity;
+	vec3 direction;
+	/// @brief Cosine of half the cone angle, precomputed for the spot test
+	float cosHalfCone;
+	Color color;
+	float attenuation;
+	float squareAttenuation;
+	int32_t spot;
+	int32_t enabled;
+};
+
+/// @brief LightBlock: the sun and the omni lights. Only the first omniLightCount omni lights are
+/// shaded and uploaded.
+struct LightUniforms
+{
+	SunLightUniforms sunLight;
+	int32_t omniLightCount;
+	int32_t padding[3];
+	OmniLightUniforms omniLights[MaxOmniLights];
+};
+
+static_assert(sizeof(FrameUniforms) == 208 && offsetof(FrameUniforms, cameraPosition) == 192);
+static_assert(sizeof(SunLightUniforms) == 64 && offsetof(SunLightUniforms, enabled) == 48);
+static_assert(sizeof(OmniLightUniforms) == 64 && offsetof(OmniLightUniforms, color) == 32);
+static_assert(offsetof(LightUniforms, omniLights) == 80 && sizeof(LightUniforms) == 80 + 64 * MaxOmniLights);
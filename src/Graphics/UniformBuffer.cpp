@@ -0,0 +1,31 @@
+#include "UniformBuffer.h"
+
+#include "Graphics.h"
+#include "RenderDevice.h"
+
+#include <cassert>
+
+UniformBuffer::UniformBuffer(UniformBlockBinding binding, size_t size) :
+	m_Device(Graphics::GetSingleton()->GetDevice()), m_Binding(binding), m_Size(size), m_Buffer(0)
+{
+	m_Buffer = m_Device->CreateBuffer(size, nullptr, BufferUsage::Dynamic);
+	Bind();
+}
+
+UniformBuffer::~UniformBuffer()
+{
+	if (m_Buffer)
+		m_Device->DeleteBuffer(m_Buffer);
+}
+
+void UniformBuffer::Bind() const
+{
+	m_Device->BindUniformBuffer(static_cast<uint32_t>(m_Binding), m_Buffer);
+}
+
+void UniformBuffer::Upload(const void* data, size_t size)
+{
+	assert(size <= m_Size);
+	m_Device->UpdateBuffer(m_Buffer, 0, size, data);
+	++m_Uploads;
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "UniformBlocks.h"
+
+#include <cstddef>
+#include <cstdint>
+
+class RenderDevice;
+
+/// @brief GL buffer backing one uniform block at a fixed binding point
+class UniformBuffer
+{
+public:
+	UniformBuffer(UniformBlockBinding binding, size_t size);
+
+	UniformBuffer(const UniformBuffer&) = delete;
+
+	UniformBuffer& operator=(const UniformBuffer&) = delete;
+
+	~UniformBuffer();
+
+	bool Valid() const noexcept { return m_Buffer; }
+
+	uint32_t GetBufferID() const noexcept { return m_Buffer; }
+
+	UniformBlockBinding GetBinding() const noexcept { return m_Binding; }
+
+	size_t GetSize() const noexcept { return m_Size; }
+
+	/// @brief Attach the buffer to its binding point
+	void Bind() const;
+
+	/// @brief Overwrite bytes [0, size) in one buffer update
+	void Upload(const void* data, size_t size);
+
+	/// @brief Number of Upload() calls so far
+	size_t GetUploadCount() const noexcept { return m_Uploads; }
+
+private:
+	RenderDevice* m_Device;
+	UniformBlockBinding m_Binding;
+	size_t m_Size;
+	uint32_t m_Buffer;
+	size_t m_Uploads = 0;
+};
@@ -0,0 +1,118 @@
+#pragma once
+
+#include "Affine3.h"
+
+#include <cstddef>
+#include <limits>
+
+/// @brief Axis-aligned bounding box.
+/// A default constructed box is empty (min > max); merging anything into it yields that thing's bounds.
+class AABB
+{
+public:
+	constexpr AABB() noexcept :
+		min(std::numeric_limits<float>::infinity()), max(-std::numeric_limits<float>::infinity()) {}
+
+	constexpr AABB(const vec3& min, const vec3& max) noexcept : min(min), max(max) {}
+
+	constexpr AABB(const AABB&) noexcept = default;
+
+	constexpr static AABB from_center_extents(const vec3& center, const vec3& extents) noexcept
+	{
+		return AABB(center - extents, center + extents);
+	}
+
+	/// @brief Bounds of points[0, n). Empty if n is 0.
+	constexpr static AABB from_points(const vec3* points, size_t n) noexcept
+	{
+		AABB ret;
+		for (size_t i = 0; i < n; ++i)
+			ret.merge(points[i]);
+		return ret;
+	}
+
+	constexpr bool operator==(const AABB&) const noexcept = default;
+
+	constexpr bool empty() const noexcept
+	{
+		return min.x > max.x || min.y > max.y || min.z > max.z;
+	}
+
+	constexpr vec3 center() const noexcept { return (min + max) * 0.5f; }
+
+	/// @brief Half size
+	constexpr vec3 extents() const noexcept { return (max - min) * 0.5f; }
+
+	constexpr vec3 size() const noexcept { return max - min; }
+
+	constexpr float surface_area() const noexcept
+	{
+		vec3 d = size();
+		return 2 * (d.x * d.y + d.y * d.z + d.z * d.x);
+	}
+
+	constexpr bool contains(const vec3& p) const noexcept
+	{
+		return p.x >= min.x && p.x <= max.x && p.y >= min.y && p.y <= max.y && p.z >= min.z && p.z <= max.z;
+	}
+
+	constexpr bool contains(const AABB& rhs) const noexcept
+	{
+		return contains(rhs.min) && contains(rhs.max);
+	}
+
+	/// @brief Touching boxes intersect
+	constexpr bool intersects(const AABB& rhs) const noexcept
+	{
+		return min.x <= rhs.max.x && max.x >= rhs.min.x
+			&& min.y <= rhs.max.y && max.y >= rhs.min.y
+			&& min.z <= rhs.max.z && max.z >= rhs.min.z;
+	}
+
+	constexpr AABB& merge(const vec3& p) noexcept
+	{
+		min = vec3(Mathf::min(min.x, p.x), Mathf::min(min.y, p.y), Mathf::min(min.z, p.z));
+		max = vec3(Mathf::max(max.x, p.x), Mathf::max(max.y, p.y), Mathf::max(max.z, p.z));
+		return *this;
+	}
+
+	constexpr AABB& merge(const AABB& rhs) noexcept
+	{
+		min = vec3(Mathf::min(min.x, rhs.min.x), Mathf::min(min.y, rhs.min.y), Mathf::min(min.z, rhs.min.z));
+		max = vec3(Mathf::max(max.x, rhs.max.x), Mathf::max(max.y, rhs.max.y), Mathf::max(max.z, rhs.max.z));
+		return *this;
+	}
+
+	/// @brief Squared distance from p to the box, 0 inside
+	constexpr float distance_squared(const vec3& p) const noexcept
+	{
+		vec3 d(
+			Mathf::max(min.x - p.x, 0.0f, p.x - max.x),
+			Mathf::max(min.y - p.y, 0.0f, p.y - max.y),
+			Mathf::max(min.z - p.z, 0.0f, p.z - max.z)
+		);
+		return d.length_squared();
+	}
+
+	/// @brief Bounds of the transformed box, without visiting its 8 corners. An empty box stays empty.
+	constexpr AABB transformed(const Affine3& m) const noexcept
+	{
+		if (empty())
+			return *this;
+		const vec3 c = m.transform_point(center());
+		const vec3 e = extents();
+		auto radius = [&](const vec4& row) {
+			return Mathf::abs(row.x) * e.x + Mathf::abs(row.y) * e.y + Mathf::abs(row.z) * e.z;
+		};
+		return from_center_extents(c, vec3(radius(m.rows[0]), radius(m.rows[1]), radius(m.rows[2])));
+	}
+
+	/// @brief m must be affine
+	constexpr AABB transformed(const mat4& m) const noexcept
+	{
+		return transformed(Affine3(m));
+	}
+
+	vec3 min;
+	vec3 max;
+};
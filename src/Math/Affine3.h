@@ -0,0 +1,150 @@
+#pragma once
+
+#include "mat4.h"
+
+/// @brief Affine transform stored as a row-major 3x4 matrix.
+/// Each row is (linear row, translation component); the implicit last row is (0, 0, 0, 1).
+/// @note Composition and inverse skip the constant row, roughly halving the work of the mat4 versions.
+/// Storage is 16-byte aligned so the SIMD backend can use aligned loads.
+class alignas(16) Affine3
+{
+public:
+	constexpr Affine3() noexcept
+	{
+		rows[0] = vec4(1, 0, 0, 0);
+		rows[1] = vec4(0, 1, 0, 0);
+		rows[2] = vec4(0, 0, 1, 0);
+	}
+
+	constexpr Affine3(const vec4& row0, const vec4& row1, const vec4& row2) noexcept
+	{
+		rows[0] = row0;
+		rows[1] = row1;
+		rows[2] = row2;
+	}
+
+	constexpr Affine3(const mat3& linear, const vec3& translation) noexcept
+	{
+		rows[0] = vec4(linear.cols[0].x, linear.cols[1].x, linear.cols[2].x, translation.x);
+		rows[1] = vec4(linear.cols[0].y, linear.cols[1].y, linear.cols[2].y, translation.y);
+		rows[2] = vec4(linear.cols[0].z, linear.cols[1].z, linear.cols[2].z, translation.z);
+	}
+
+	/// @brief Same transform as mat4(position, scales, rotation)
+	constexpr Affine3(const vec3& position, const vec3& scales, const Quaternion& rotation) noexcept
+	{
+		mat3 rot = mat3(rotation);
+		*this = Affine3(mat3(rot.cols[0] * scales, rot.cols[1] * scales, rot.cols[2] * scales), position);
+	}
+
+	/// @brief Drop the last row of m. m must be affine.
+	constexpr explicit Affine3(const mat4& m) noexcept :
+		Affine3(mat3(m), m.get_translation()) {}
+
+	constexpr Affine3(const Affine3&) noexcept = default;
+
+	/// @brief For uniform upload
+	constexpr explicit operator mat4() const noexcept
+	{
+		return mat4(rows[0], rows[1], rows[2], vec4(0, 0, 0, 1)).transposed();
+	}
+
+	constexpr static Affine3 identity() noexcept { return Affine3(); }
+
+	/// @brief View transform, same as mat4(position, look_at, up)
+	static Affine3 look_at(const vec3& position, const vec3& look_at, const vec3& up) noexcept
+	{
+		vec3 const f((look_at - position).normalized());
+		vec3 const s(f.cross_product(up).normalized());
+		vec3 const u(s.cross_product(f));
+		return Affine3(
+			vec4(s, -s.dot_product(position)),
+			vec4(u, -u.dot_product(position)),
+			vec4(-f, f.dot_product(position))
+		);
+	}
+
+	constexpr bool operator==(const Affine3&) const noexcept = default;
+
+	/// @brief Composition, rhs is applied first
+	constexpr Affine3 operator*(const Affine3& rhs) const noexcept
+	{
+#if MATH_SIMD_LEVEL >= 1
+		if (!std::is_constant_evaluated())
+		{
+			Affine3 ret;
+			simd::affine3_mul(rows[0], rhs.rows[0], ret.rows[0]);
+			return ret;
+		}
+#endif
+		const vec4 b0 = rhs.rows[0];
+		const vec4 b1 = rhs.rows[1];
+		const vec4 b2 = rhs.rows[2];
+		Affine3 ret;
+		for (int i = 0; i < 3; ++i)
+		{
+			const vec4& a = rows[i];
+			ret.rows[i] = vec4(
+				a.x * b0.x + a.y * b1.x + a.z * b2.x,
+				a.x * b0.y + a.y * b1.y + a.z * b2.y,
+				a.x * b0.z + a.y * b1.z + a.z * b2.z,
+				a.x * b0.w + a.y * b1.w + a.z * b2.w + a.w
+			);
+		}
+		return ret;
+	}
+
+	constexpr Affine3& operator*=(const Affine3& rhs) noexcept
+	{
+		return *this = *this * rhs;
+	}
+
+	constexpr vec3 transform_point(const vec3& p) const noexcept
+	{
+		return vec3(
+			rows[0].x * p.x + rows[0].y * p.y + rows[0].z * p.z + rows[0].w,
+			rows[1].x * p.x + rows[1].y * p.y + rows[1].z * p.z + rows[1].w,
+			rows[2].x * p.x + rows[2].y * p.y + rows[2].z * p.z + rows[2].w
+		);
+	}
+
+	constexpr vec3 transform_direction(const vec3& d) const noexcept
+	{
+		return vec3(
+			rows[0].x * d.x + rows[0].y * d.y + rows[0].z * d.z,
+			rows[1].x * d.x + rows[1].y * d.y + rows[1].z * d.z,
+			rows[2].x * d.x + rows[2].y * d.y + rows[2].z * d.z
+		);
+	}
+
+	/// @brief 3x3 inverse plus one matrix-vector product
+	constexpr Affine3 inverse() const noexcept
+	{
+#if MATH_SIMD_LEVEL >= 1
+		if (!std::is_constant_evaluated())
+		{
+			Affine3 ret;
+			simd::affine3_inverse(rows[0], ret.rows[0]);
+			return ret;
+		}
+#endif
+		mat3 inv = get_linear().inverse();
+		return Affine3(inv, -(inv * get_translation()));
+	}
+
+	constexpr mat3 get_linear() const noexcept
+	{
+		return mat3(
+			vec3(rows[0].x, rows[1].x, rows[2].x),
+			vec3(rows[0].y, rows[1].y, rows[2].y),
+			vec3(rows[0].z, rows[1].z, rows[2].z)
+		);
+	}
+
+	constexpr vec3 get_translation() const noexcept
+	{
+		return vec3(rows[0].w, rows[1].w, rows[2].w);
+	}
+
+	vec4 rows[3];
+};
@@ -0,0 +1,153 @@
+#pragma once
+
+#include "Frustum.h"
+#include "Sphere.h"
+
+#include <cstddef>
+#include <cstdint>
+
+/// @file BatchCulling.h
+/// @brief Classify structure-of-arrays bounds against a frustum, or overlap boxes with a sphere.
+/// SIMD backends test 4 (SSE4.1) or 8 (AVX2) bounds per iteration against all 6 planes.
+/// Results match Frustum::classify for the same bound (up to FMA rounding on AVX2).
+/// Sphere radii must not be negative.
+
+/// @brief Structure-of-arrays view of n bounding spheres.
+struct SphereSoA
+{
+	const float* x;
+	const float* y;
+	const float* z;
+	const float* radius;
+};
+
+/// @brief Structure-of-arrays view of n boxes in center/extents form (see AABB::center, AABB::extents).
+struct AABBSoA
+{
+	const float* x;
+	const float* y;
+	const float* z;
+	const float* ex;
+	const float* ey;
+	const float* ez;
+};
+
+namespace simd
+{
+	/// @brief Shared kernel: emit(i, code) for every bound, code is the Containment value as a float.
+	/// @param planes 6 planes of 4 floats, see Frustum::planes
+	/// @param e Extents per axis. Spheres pass the radius for x, ignored if Box is false.
+	template <bool Box, typename Emit>
+	void classify_bounds(const float* planes, const float* const c[3], const float* const e[3], size_t n, Emit&& emit) noexcept
+	{
+		for_each_lanes(n, [&](auto lanes, size_t i) {
+			using L = decltype(lanes);
+			const auto x = L::load(c[0] + i), y = L::load(c[1] + i), z = L::load(c[2] + i);
+			typename L::type ex = L::load(e[0] + i), ey = ex, ez = ex;
+			if constexpr (Box)
+			{
+				ey = L::load(e[1] + i);
+				ez = L::load(e[2] + i);
+			}
+			auto nearest = L::set1(std::numeric_limits<float>::infinity());
+			auto farthest = nearest;
+			for (int k = 0; k < Frustum::PlaneCount; ++k)
+			{
+				const float* p = planes + 4 * k;
+				const auto d = L::madd(L::set1(p[2]), z, L::madd(L::set1(p[1]), y, L::madd(L::set1(p[0]), x, L::set1(p[3]))));
+				typename L::type r = ex;
+				if constexpr (Box)
+				{
+					r = L::madd(L::set1(Mathf::abs(p[2])), ez,
+						L::madd(L::set1(Mathf::abs(p[1])), ey, L::mul(L::set1(Mathf::abs(p[0])), ex)));
+				}
+				nearest = L::min(nearest, L::add(d, r));
+				farthest = L::min(farthest, L::sub(d, r));
+			}
+			const auto zero = L::set1(0.0f);
+			const auto code = L::select_gt(zero, nearest, zero,
+				L::select_gt(zero, farthest, L::set1(1.0f), L::set1(2.0f)));
+			float codes[L::width];
+			L::store(codes, code);
+			for (size_t k = 0; k < L::width; ++k)
+				emit(i + k, codes[k]);
+		});
+	}
+}
+
+/// @brief out[i] = frustum.classify(Sphere(center[i], radius[i]))
+inline void ClassifySpheres(const Frustum& frustum, const SphereSoA& spheres, Containment* out, size_t n) noexcept
+{
+	const float* c[3] = { spheres.x, spheres.y, spheres.z };
+	const float* e[3] = { spheres.radius, nullptr, nullptr };
+	simd::classify_bounds<false>(&frustum.planes[0].x, c, e, n, [=](size_t i, float code) {
+		out[i] = static_cast<Containment>(static_cast<uint8_t>(code));
+	});
+}
+
+/// @brief out[i] = frustum.classify(AABB::from_center_extents(center[i], extents[i]))
+inline void ClassifyAABBs(const Frustum& frustum, const AABBSoA& boxes, Containment* out, size_t n) noexcept
+{
+	const float* c[3] = { boxes.x, boxes.y, boxes.z };
+	const float* e[3] = { boxes.ex, boxes.ey, boxes.ez };
+	simd::classify_bounds<true>(&frustum.planes[0].x, c, e, n, [=](size_t i, float code) {
+		out[i] = static_cast<Containment>(static_cast<uint8_t>(code));
+	});
+}
+
+/// @brief Write the indices of spheres not outside frustum to visible, in increasing order.
+/// @return Number of indices written, at most n
+inline size_t CullSpheres(const Frustum& frustum, const SphereSoA& spheres, uint32_t* visible, size_t n) noexcept
+{
+	const float* c[3] = { spheres.x, spheres.y, spheres.z };
+	const float* e[3] = { spheres.radius, nullptr, nullptr };
+	size_t count = 0;
+	simd::classify_bounds<false>(&frustum.planes[0].x, c, e, n, [&](size_t i, float code) {
+		visible[count] = static_cast<uint32_t>(i);
+		count += code != 0;
+	});
+	return count;
+}
+
+/// @brief Write the indices of boxes not outside frustum to visible, in increasing order.
+/// @return Number of indices written, at most n
+inline size_t CullAABBs(const Frustum& frustum, const AABBSoA& boxes, uint32_t* visible, size_t n) noexcept
+{
+	const float* c[3] = { boxes.x, boxes.y, boxes.z };
+	const float* e[3] = { boxes.ex, boxes.ey, boxes.ez };
+	size_t count = 0;
+	simd::classify_bounds<true>(&frustum.planes[0].x, c, e, n, [&](size_t i, float code) {
+		visible[count] = static_cast<uint32_t>(i);
+		count += code != 0;
+	});
+	return count;
+}
+
+/// @brief Write the indices of boxes intersecting sphere to hits, in increasing order.
+/// @return Number of indices written, at most n
+inline size_t OverlapAABBs(const Sphere& sphere, const AABBSoA& boxes, uint32_t* hits, size_t n) noexcept
+{
+	if (sphere.empty())
+		return 0;
+	size_t count = 0;
+	simd::for_each_lanes(n, [&](auto lanes, size_t i) {
+		using L = decltype(lanes);
+		const auto zero = L::set1(0.0f);
+		// Per axis distance from the center to the box, 0 inside
+		auto gap = [&](float c, const float* x, const float* e) {
+			return L::max(L::sub(L::abs(L::sub(L::set1(c), L::load(x + i))), L::load(e + i)), zero);
+		};
+		const auto dx = gap(sphere.center.x, boxes.x, boxes.ex);
+		const auto dy = gap(sphere.center.y, boxes.y, boxes.ey);
+		const auto dz = gap(sphere.center.z, boxes.z, boxes.ez);
+		const auto d2 = L::madd(dz, dz, L::madd(dy, dy, L::mul(dx, dx)));
+		float outside[L::width];
+		L::store(outside, L::select_gt(d2, L::set1(sphere.radius * sphere.radius), L::set1(1.0f), zero));
+		for (size_t k = 0; k < L::width; ++k)
+		{
+			hits[count] = static_cast<uint32_t>(i + k);
+			count += outside[k] == 0;
+		}
+	});
+	return count;
+}
@@ -0,0 +1,245 @@
+#pragma once
+
+#include "mat4.h"
+#include "FastMath.h"
+
+#include <cstddef>
+
+/// @file BatchQuaternion.h
+/// @brief Interpolate and convert arrays of quaternions.
+/// SIMD backends process 4 (SSE4.1) or 8 (AVX2) quaternions per iteration.
+/// Output arrays may be the same as an input array.
+
+namespace simd
+{
+	/// @brief Deinterleave width packed (x, y, z, w) quadruples into lanes.
+	inline void quat_load(ScalarLanes, const float* p, float& x, float& y, float& z, float& w) noexcept
+	{
+		x = p[0];
+		y = p[1];
+		z = p[2];
+		w = p[3];
+	}
+
+	inline void quat_store(ScalarLanes, float* p, float x, float y, float z, float w) noexcept
+	{
+		p[0] = x;
+		p[1] = y;
+		p[2] = z;
+		p[3] = w;
+	}
+
+#if MATH_SIMD_LEVEL >= 1
+	inline void quat_load(WideLanes4, const float* p, __m128& x, __m128& y, __m128& z, __m128& w) noexcept
+	{
+		x = _mm_loadu_ps(p);
+		y = _mm_loadu_ps(p + 4);
+		z = _mm_loadu_ps(p + 8);
+		w = _mm_loadu_ps(p + 12);
+		_MM_TRANSPOSE4_PS(x, y, z, w);
+	}
+
+	inline void quat_store(WideLanes4, float* p, __m128 x, __m128 y, __m128 z, __m128 w) noexcept
+	{
+		_MM_TRANSPOSE4_PS(x, y, z, w);
+		_mm_storeu_ps(p, x);
+		_mm_storeu_ps(p + 4, y);
+		_mm_storeu_ps(p + 8, z);
+		_mm_storeu_ps(p + 12, w);
+	}
+#endif
+
+#if MATH_SIMD_LEVEL >= 2
+	inline void quat_load(WideLanes, const float* p, __m256& x, __m256& y, __m256& z, __m256& w) noexcept
+	{
+		__m128 x0, y0, z0, w0, x1, y1, z1, w1;
+		quat_load(WideLanes4{}, p, x0, y0, z0, w0);
+		quat_load(WideLanes4{}, p + 16, x1, y1, z1, w1);
+		x = _mm256_set_m128(x1, x0);
+		y = _mm256_set_m128(y1, y0);
+		z = _mm256_set_m128(z1, z0);
+		w = _mm256_set_m128(w1, w0);
+	}
+
+	inline void quat_store(WideLanes, float* p, __m256 x, __m256 y, __m256 z, __m256 w) noexcept
+	{
+		quat_store(WideLanes4{}, p, _mm256_castps256_ps128(x), _mm256_castps256_ps128(y),
+			_mm256_castps256_ps128(z), _mm256_castps256_ps128(w));
+		quat_store(WideLanes4{}, p + 16, _mm256_extractf128_ps(x, 1), _mm256_extractf128_ps(y, 1),
+			_mm256_extractf128_ps(z, 1), _mm256_extractf128_ps(w, 1));
+	}
+#endif
+
+	/// @brief Shared kernel: out[i] = interpolate(a[i], b[i], t[i]) along the shortest path.
+	/// Slerp uses the fast trig kernels and falls back to nlerp above Quaternion::SlerpNlerpThreshold.
+	/// @param t Per element weights, or a single weight if UniformT
+	template <bool Slerp, bool UniformT>
+	void quat_interpolate(const float* a, const float* b, const float* t, float* out, size_t n) noexcept
+	{
+		for_each_lanes(n, [=](auto lanes, size_t i) {
+			using L = decltype(lanes);
+			typename L::type ax, ay, az, aw, bx, by, bz, bw;
+			quat_load(lanes, a + 4 * i, ax, ay, az, aw);
+			quat_load(lanes, b + 4 * i, bx, by, bz, bw);
+			auto wt = UniformT ? L::set1(*t) : L::load(t + i);
+
+			auto d = L::madd(aw, bw, L::madd(az, bz, L::madd(ay, by, L::mul(ax, bx))));
+			// Flip b onto a's hemisphere
+			auto sign = L::select_gt(L::set1(0.0f), d, L::set1(-1.0f), L::set1(1.0f));
+			d = L::abs(d);
+			auto wa = L::sub(L::set1(1.0f), wt);
+			auto wb = L::mul(wt, sign);
+			if constexpr (Slerp)
+			{
+				auto theta = fast_acos<L>(d);
+				auto rs = fast_rsqrt<L>(L::max(L::sub(L::set1(1.0f), L::mul(d, d)), L::set1(1e-12f)));
+				auto sa = L::mul(fast_sin<L>(L::mul(wa, theta)), rs);
+				auto sb = L::mul(L::mul(fast_sin<L>(L::mul(wt, theta)), rs), sign);
+				wa = L::select_gt(d, L::set1(Quaternion::SlerpNlerpThreshold), wa, sa);
+				wb = L::select_gt(d, L::set1(Quaternion::SlerpNlerpThreshold), wb, sb);
+			}
+			auto rx = L::madd(bx, wb, L::mul(ax, wa));
+			auto ry = L::madd(by, wb, L::mul(ay, wa));
+			auto rz = L::madd(bz, wb, L::mul(az, wa));
+			auto rw = L::madd(bw, wb, L::mul(aw, wa));
+			auto ls = L::madd(rw, rw, L::madd(rz, rz, L::madd(ry, ry, L::mul(rx, rx))));
+			auto rl = L::div(L::set1(1.0f), L::sqrt(ls));
+			quat_store(lanes, out + 4 * i, L::mul(rx, rl), L::mul(ry, rl), L::mul(rz, rl), L::mul(rw, rl));
+		});
+	}
+
+	/// @brief Store rotation matrices given as 9 column-major lanes (c0.x, c0.y, ..., c2.z).
+	/// Mat4 writes a full mat4 with zero translation, otherwise a packed mat3.
+	template <bool Mat4>
+	void rotation_store(ScalarLanes, float* p, const float* m) noexcept
+	{
+		for (size_t c = 0; c < 3; ++c)
+		{
+			for (size_t r = 0; r < 3; ++r)
+				p[c * (Mat4 ? 4 : 3) + r] = m[c * 3 + r];
+			if constexpr (Mat4)
+				p[c * 4 + 3] = 0;
+		}
+		if constexpr (Mat4)
+		{
+			p[12] = p[13] = p[14] = 0;
+			p[15] = 1;
+		}
+	}
+
+#if MATH_SIMD_LEVEL >= 1
+	template <bool Mat4>
+	void rotation_store(WideLanes4, float* p, const __m128* m) noexcept
+	{
+		if constexpr (Mat4)
+		{
+			const __m128 col3 = _mm_setr_ps(0, 0, 0, 1);
+			for (size_t c = 0; c < 3; ++c)
+			{
+				__m128 x = m[c * 3], y = m[c * 3 + 1], z = m[c * 3 + 2], w = _mm_setzero_ps();
+				_MM_TRANSPOSE4_PS(x, y, z, w);
+				_mm_storeu_ps(p + 4 * c, x);
+				_mm_storeu_ps(p + 16 + 4 * c, y);
+				_mm_storeu_ps(p + 32 + 4 * c, z);
+				_mm_storeu_ps(p + 48 + 4 * c, w);
+			}
+			for (size_t k = 0; k < 4; ++k)
+				_mm_storeu_ps(p + 16 * k + 12, col3);
+		}
+		else
+		{
+			// Per matrix: a = m[0..3], b = m[4..7], then m[8]
+			__m128 a0 = m[0], a1 = m[1], a2 = m[2], a3 = m[3];
+			__m128 b0 = m[4], b1 = m[5], b2 = m[6], b3 = m[7];
+			_MM_TRANSPOSE4_PS(a0, a1, a2, a3);
+			_MM_TRANSPOSE4_PS(b0, b1, b2, b3);
+			alignas(16) float last[4];
+			_mm_store_ps(last, m[8]);
+			const __m128 a[4] = { a0, a1, a2, a3 }, b[4] = { b0, b1, b2, b3 };
+			for (size_t k = 0; k < 4; ++k)
+			{
+				_mm_storeu_ps(p + 9 * k, a[k]);
+				_mm_storeu_ps(p + 9 * k + 4, b[k]);
+				p[9 * k + 8] = last[k];
+			}
+		}
+	}
+#endif
+
+#if MATH_SIMD_LEVEL >= 2
+	template <bool Mat4>
+	void rotation_store(WideLanes, float* p, const __m256* m) noexcept
+	{
+		__m128 lo[9], hi[9];
+		for (size_t j = 0; j < 9; ++j)
+		{
+			lo[j] = _mm256_castps256_ps128(m[j]);
+			hi[j] = _mm256_extractf128_ps(m[j], 1);
+		}
+		rotation_store<Mat4>(WideLanes4{}, p, lo);
+		rotation_store<Mat4>(WideLanes4{}, p + 4 * (Mat4 ? 16 : 9), hi);
+	}
+#endif
+
+	/// @brief Shared kernel: rotation matrices of unit quaternions, same layout as mat3(const Quaternion&).
+	template <bool Mat4>
+	void quat_to_matrix(const float* q, float* out, size_t n) noexcept
+	{
+		for_each_lanes(n, [=](auto lanes, size_t i) {
+			using L = decltype(lanes);
+			typename L::type x, y, z, w;
+			quat_load(lanes, q + 4 * i, x, y, z, w);
+			auto x2 = L::add(x, x), y2 = L::add(y, y), z2 = L::add(z, z);
+			auto xx = L::mul(x, x2), yy = L::mul(y, y2), zz = L::mul(z, z2);
+			auto xy = L::mul(x, y2), xz = L::mul(x, z2), yz = L::mul(y, z2);
+			auto wx = L::mul(w, x2), wy = L::mul(w, y2), wz = L::mul(w, z2);
+			const auto one = L::set1(1.0f);
+			const typename L::type m[9] = {
+				L::sub(one, L::add(yy, zz)), L::add(xy, wz), L::sub(xz, wy),
+				L::sub(xy, wz), L::sub(one, L::add(xx, zz)), L::add(yz, wx),
+				L::add(xz, wy), L::sub(yz, wx), L::sub(one, L::add(xx, yy))
+			};
+			rotation_store<Mat4>(lanes, out + i * (Mat4 ? 16 : 9), m);
+		});
+	}
+}
+
+/// @brief out[i] = Quaternion::nlerp(a[i], b[i], t[i])
+inline void NlerpQuaternions(const Quaternion* a, const Quaternion* b, const float* t, Quaternion* out, size_t n) noexcept
+{
+	simd::quat_interpolate<false, false>(reinterpret_cast<const float*>(a), reinterpret_cast<const float*>(b), t,
+		reinterpret_cast<float*>(out), n);
+}
+
+/// @brief out[i] = Quaternion::nlerp(a[i], b[i], t)
+inline void NlerpQuaternions(const Quaternion* a, const Quaternion* b, float t, Quaternion* out, size_t n) noexcept
+{
+	simd::quat_interpolate<false, true>(reinterpret_cast<const float*>(a), reinterpret_cast<const float*>(b), &t,
+		reinterpret_cast<float*>(out), n);
+}
+
+/// @brief out[i] = Quaternion::slerp<MathPrecision::Fast>(a[i], b[i], t[i])
+inline void SlerpQuaternions(const Quaternion* a, const Quaternion* b, const float* t, Quaternion* out, size_t n) noexcept
+{
+	simd::quat_interpolate<true, false>(reinterpret_cast<const float*>(a), reinterpret_cast<const float*>(b), t,
+		reinterpret_cast<float*>(out), n);
+}
+
+/// @brief out[i] = Quaternion::slerp<MathPrecision::Fast>(a[i], b[i], t)
+inline void SlerpQuaternions(const Quaternion* a, const Quaternion* b, float t, Quaternion* out, size_t n) noexcept
+{
+	simd::quat_interpolate<true, true>(reinterpret_cast<const float*>(a), reinterpret_cast<const float*>(b), &t,
+		reinterpret_cast<float*>(out), n);
+}
+
+/// @brief out[i] = mat3(q[i]). Quaternions must be normalized.
+inline void QuaternionsToMat3(const Quaternion* q, mat3* out, size_t n) noexcept
+{
+	simd::quat_to_matrix<false>(reinterpret_cast<const float*>(q), reinterpret_cast<float*>(out), n);
+}
+
+/// @brief out[i] = mat4(q[i]). Quaternions must be normalized.
+inline void QuaternionsToMat4(const Quaternion* q, mat4* out, size_t n) noexcept
+{
+	simd::quat_to_matrix<true>(reinterpret_cast<const float*>(q), reinterpret_cast<float*>(out), n);
+}
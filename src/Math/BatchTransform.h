@@ -0,0 +1,262 @@
+#pragma once
+
+#include "Affine3.h"
+
+#include <cstddef>
+
+/// @file BatchTransform.h
+/// @brief Transform contiguous vec3 arrays by one matrix.
+/// The AVX2 backend processes 8 vectors per iteration. SSE4.1 builds normalize normals 4 at a time
+/// and leave the other transforms to the scalar loop, which the compiler vectorizes.
+/// `in` and `out` may be the same array.
+
+namespace simd
+{
+#if MATH_SIMD_LEVEL >= 1
+	/// @brief Deinterleave 4 packed vec3 (3 registers) into x, y, z lanes.
+	inline void vec3x4_load(const float* p, __m128& x, __m128& y, __m128& z) noexcept
+	{
+		__m128 a = _mm_loadu_ps(p);
+		__m128 b = _mm_loadu_ps(p + 4);
+		__m128 c = _mm_loadu_ps(p + 8);
+		// a = x0 y0 z0 x1, b = y1 z1 x2 y2, c = z2 x3 y3 z3
+		const __m128 a03 = swizzle<0, 3, 2, 3>(a), c1 = swizzle<0, 0, 0, 1>(c);
+		const __m128 a1 = swizzle<1, 1, 1, 1>(a), b03 = swizzle<0, 0, 3, 3>(b), c2 = swizzle<2, 2, 2, 2>(c);
+		const __m128 a2 = swizzle<2, 2, 2, 2>(a), c03 = swizzle<0, 0, 0, 3>(c);
+		x = _mm_blend_ps(_mm_blend_ps(a03, b, 0x4), c1, 0x8);
+		y = _mm_blend_ps(_mm_blend_ps(a1, b03, 0x6), c2, 0x8);
+		z = _mm_blend_ps(_mm_blend_ps(a2, b, 0x2), c03, 0xC);
+	}
+
+	/// @brief Interleave x, y, z lanes back into 4 packed vec3.
+	inline void vec3x4_store(float* p, __m128 x, __m128 y, __m128 z) noexcept
+	{
+		const __m128 x01 = swizzle<0, 0, 0, 1>(x), y0 = swizzle<0, 0, 0, 0>(y), z0 = swizzle<0, 0, 0, 0>(z);
+		const __m128 y12 = swizzle<1, 1, 1, 2>(y);
+		const __m128 z23 = swizzle<2, 2, 2, 3>(z), x3 = swizzle<3, 3, 3, 3>(x), y3 = swizzle<3, 3, 3, 3>(y);
+		// a = x0 y0 z0 x1, b = y1 z1 x2 y2, c = z2 x3 y3 z3
+		__m128 a = _mm_blend_ps(_mm_blend_ps(x01, y0, 0x2), z0, 0x4);
+		__m128 b = _mm_blend_ps(_mm_blend_ps(y12, z, 0x2), x, 0x4);
+		__m128 c = _mm_blend_ps(_mm_blend_ps(z23, x3, 0x2), y3, 0x4);
+		_mm_storeu_ps(p, a);
+		_mm_storeu_ps(p + 4, b);
+		_mm_storeu_ps(p + 8, c);
+	}
+#endif
+
+#if MATH_SIMD_LEVEL >= 2
+	/// @brief out[i] = M * in[i] (+ t) on packed vec3, 8 per iteration, without deinterleaving.
+	/// Each group of 4 output floats holds the components (x, y, z, x), (y, z, x, y) or (z, x, y, z)
+	/// of its vectors, so it is a sum of matrix columns rotated the same way, times inputs splat from
+	/// one unaligned load at the matching offset.
+	/// @return Number of vectors done, the caller finishes the rest
+	template <bool Translate>
+	size_t transform_vec3_packed(const float* m, const float* t, const float* in, float* out, size_t n) noexcept
+	{
+		// Column c of the matrix, rotated to start at component k, in both 128-bit lanes
+		auto column = [m](int c, int k) {
+			const __m128 v = _mm_setr_ps(m[3 * c + k], m[3 * c + (k + 1) % 3], m[3 * c + (k + 2) % 3], m[3 * c + k]);
+			return _mm256_set_m128(v, v);
+		};
+		auto translation = [t](int k) {
+			const __m128 v = Translate ? _mm_setr_ps(t[k], t[(k + 1) % 3], t[(k + 2) % 3], t[k]) : _mm_setzero_ps();
+			return _mm256_set_m128(v, v);
+		};
+		const __m256 ax = column(0, 0), ay = column(1, 0), az = column(2, 0), at = translation(0);
+		const __m256 bx = column(0, 1), by = column(1, 1), bz = column(2, 1), bt = translation(1);
+		const __m256 cx = column(0, 2), cy = column(1, 2), cz = column(2, 2), ct = translation(2);
+		size_t i = 0;
+		for (; i + 8 <= n; i += 8)
+		{
+			// Vectors 0..3 in the low lanes, 4..7 in the high lanes. Splats (0, 0, 0, 3), (0, 0, 3, 3)
+			// and (0, 3, 3, 3) of the loads at offsets 0..8 give each output lane the input it multiplies.
+			const float* p = in + 3 * i;
+			auto load = [p](int offset) { return _mm256_loadu2_m128(p + 12 + offset, p + offset); };
+			__m256 a = _mm256_fmadd_ps(az, _mm256_permute_ps(load(2), 0xC0),
+				_mm256_fmadd_ps(ay, _mm256_permute_ps(load(1), 0xC0), _mm256_mul_ps(ax, _mm256_permute_ps(load(0), 0xC0))));
+			__m256 b = _mm256_fmadd_ps(bz, _mm256_permute_ps(load(5), 0xF0),
+				_mm256_fmadd_ps(by, _mm256_permute_ps(load(4), 0xF0), _mm256_mul_ps(bx, _mm256_permute_ps(load(3), 0xF0))));
+			__m256 c = _mm256_fmadd_ps(cz, _mm256_permute_ps(load(8), 0xFC),
+				_mm256_fmadd_ps(cy, _mm256_permute_ps(load(7), 0xFC), _mm256_mul_ps(cx, _mm256_permute_ps(load(6), 0xFC))));
+			if constexpr (Translate)
+			{
+				a = _mm256_add_ps(a, at);
+				b = _mm256_add_ps(b, bt);
+				c = _mm256_add_ps(c, ct);
+			}
+			float* r = out + 3 * i;
+			_mm256_storeu2_m128(r + 12, r, a);
+			_mm256_storeu2_m128(r + 16, r + 4, b);
+			_mm256_storeu2_m128(r + 20, r + 8, c);
+		}
+		return i;
+	}
+#endif
+
+	/// @brief Shared kernel: out[i] = M * in[i] (+ t), optionally normalized.
+	/// @param m Column-major 3x3 matrix, 9 packed floats
+	/// @param t Translation, ignored if Translate is false
+	template <bool Translate, bool Normalize>
+	void transform_vec3(const float* m, const float* t, const float* in, float* out, size_t n) noexcept
+	{
+		size_t i = 0;
+#if MATH_SIMD_LEVEL >= 1
+		// Normalizing needs each vector's x, y and z in one lane, so normals are deinterleaved.
+		// A hand-written 4-wide packed kernel measured slower than the vectorized scalar loop.
+		if constexpr (!Normalize)
+		{
+#if MATH_SIMD_LEVEL >= 2
+			i = transform_vec3_packed<Translate>(m, t, in, out, n);
+#endif
+		}
+		else
+		{
+#if MATH_SIMD_LEVEL >= 2
+			const __m256 m00 = _mm256_set1_ps(m[0]), m01 = _mm256_set1_ps(m[1]), m02 = _mm256_set1_ps(m[2]);
+			const __m256 m10 = _mm256_set1_ps(m[3]), m11 = _mm256_set1_ps(m[4]), m12 = _mm256_set1_ps(m[5]);
+			const __m256 m20 = _mm256_set1_ps(m[6]), m21 = _mm256_set1_ps(m[7]), m22 = _mm256_set1_ps(m[8]);
+			const __m256 tx = _mm256_set1_ps(Translate ? t[0] : 0.0f);
+			const __m256 ty = _mm256_set1_ps(Translate ? t[1] : 0.0f);
+			const __m256 tz = _mm256_set1_ps(Translate ? t[2] : 0.0f);
+			for (; i + 8 <= n; i += 8)
+			{
+				__m128 x0, y0, z0, x1, y1, z1;
+				vec3x4_load(in + 3 * i, x0, y0, z0);
+				vec3x4_load(in + 3 * i + 12, x1, y1, z1);
+				__m256 x = _mm256_set_m128(x1, x0);
+				__m256 y = _mm256_set_m128(y1, y0);
+				__m256 z = _mm256_set_m128(z1, z0);
+				__m256 rx = _mm256_fmadd_ps(m20, z, _mm256_fmadd_ps(m10, y, _mm256_fmadd_ps(m00, x, tx)));
+				__m256 ry = _mm256_fmadd_ps(m21, z, _mm256_fmadd_ps(m11, y, _mm256_fmadd_ps(m01, x, ty)));
+				__m256 rz = _mm256_fmadd_ps(m22, z, _mm256_fmadd_ps(m12, y, _mm256_fmadd_ps(m02, x, tz)));
+				if constexpr (Normalize)
+				{
+					__m256 ls = _mm256_fmadd_ps(rz, rz, _mm256_fmadd_ps(ry, ry, _mm256_mul_ps(rx, rx)));
+					__m256 nz = _mm256_cmp_ps(ls, _mm256_setzero_ps(), _CMP_NEQ_OQ);
+					__m256 rl = _mm256_div_ps(_mm256_set1_ps(1.0f), _mm256_sqrt_ps(ls));
+					rl = _mm256_blendv_ps(_mm256_set1_ps(1.0f), rl, nz);
+					rx = _mm256_mul_ps(rx, rl);
+					ry = _mm256_mul_ps(ry, rl);
+					rz = _mm256_mul_ps(rz, rl);
+				}
+				vec3x4_store(out + 3 * i, _mm256_castps256_ps128(rx), _mm256_castps256_ps128(ry), _mm256_castps256_ps128(rz));
+				vec3x4_store(out + 3 * i + 12, _mm256_extractf128_ps(rx, 1), _mm256_extractf128_ps(ry, 1), _mm256_extractf128_ps(rz, 1));
+			}
+#endif
+			const __m128 n00 = _mm_set1_ps(m[0]), n01 = _mm_set1_ps(m[1]), n02 = _mm_set1_ps(m[2]);
+			const __m128 n10 = _mm_set1_ps(m[3]), n11 = _mm_set1_ps(m[4]), n12 = _mm_set1_ps(m[5]);
+			const __m128 n20 = _mm_set1_ps(m[6]), n21 = _mm_set1_ps(m[7]), n22 = _mm_set1_ps(m[8]);
+			for (; i + 4 <= n; i += 4)
+			{
+				__m128 x, y, z;
+				vec3x4_load(in + 3 * i, x, y, z);
+				__m128 rx = madd(n20, z, madd(n10, y, _mm_mul_ps(n00, x)));
+				__m128 ry = madd(n21, z, madd(n11, y, _mm_mul_ps(n01, x)));
+				__m128 rz = madd(n22, z, madd(n12, y, _mm_mul_ps(n02, x)));
+				if constexpr (Translate)
+				{
+					rx = _mm_add_ps(rx, _mm_set1_ps(t[0]));
+					ry = _mm_add_ps(ry, _mm_set1_ps(t[1]));
+					rz = _mm_add_ps(rz, _mm_set1_ps(t[2]));
+				}
+				if constexpr (Normalize)
+				{
+					__m128 ls = madd(rz, rz, madd(ry, ry, _mm_mul_ps(rx, rx)));
+					__m128 nz = _mm_cmpneq_ps(ls, _mm_setzero_ps());
+					__m128 rl = _mm_div_ps(_mm_set1_ps(1.0f), _mm_sqrt_ps(ls));
+					rl = _mm_blendv_ps(_mm_set1_ps(1.0f), rl, nz);
+					rx = _mm_mul_ps(rx, rl);
+					ry = _mm_mul_ps(ry, rl);
+					rz = _mm_mul_ps(rz, rl);
+				}
+				vec3x4_store(out + 3 * i, rx, ry, rz);
+			}
+		}
+#endif
+		// Walks pointers rather than recomputing in + 3 * i, from which GCC derives a bogus trip
+		// count after the SIMD loops (-Waggressive-loop-optimizations)
+		const float* v = in + 3 * i;
+		const float* const end = in + 3 * n;
+		float* r = out + 3 * i;
+		for (; v != end; v += 3, r += 3)
+		{
+			float x = m[0] * v[0] + m[3] * v[1] + m[6] * v[2];
+			float y = m[1] * v[0] + m[4] * v[1] + m[7] * v[2];
+			float z = m[2] * v[0] + m[5] * v[1] + m[8] * v[2];
+			if constexpr (Translate)
+			{
+				x += t[0];
+				y += t[1];
+				z += t[2];
+			}
+			if constexpr (Normalize)
+			{
+				float ls = x * x + y * y + z * z;
+				if (ls != 0)
+				{
+					float rl = 1 / Mathf::sqrt(ls);
+					x *= rl;
+					y *= rl;
+					z *= rl;
+				}
+			}
+			r[0] = x;
+			r[1] = y;
+			r[2] = z;
+		}
+	}
+}
+
+/// @brief Upper 3x3 of m, used by the batch kernels.
+inline mat3 LinearPart(const mat4& m) noexcept
+{
+	return mat3(m);
+}
+
+/// @brief Normal matrix: inverse transpose of the upper 3x3.
+inline mat3 NormalMatrix(const mat4& m) noexcept
+{
+	return mat3(m).inverse().transposed();
+}
+
+/// @brief out[i] = (m * vec4(in[i], 1)).xyz. No perspective divide.
+inline void TransformPoints(const mat4& m, const vec3* in, vec3* out, size_t n) noexcept
+{
+	mat3 linear = LinearPart(m);
+	vec3 translation = m.get_translation();
+	simd::transform_vec3<true, false>(&linear.cols[0].x, &translation.x, reinterpret_cast<const float*>(in), reinterpret_cast<float*>(out), n);
+}
+
+/// @brief out[i] = a.transform_point(in[i])
+inline void TransformPoints(const Affine3& a, const vec3* in, vec3* out, size_t n) noexcept
+{
+	mat3 linear = a.get_linear();
+	vec3 translation = a.get_translation();
+	simd::transform_vec3<true, false>(&linear.cols[0].x, &translation.x, reinterpret_cast<const float*>(in), reinterpret_cast<float*>(out), n);
+}
+
+/// @brief out[i] = (m * vec4(in[i], 0)).xyz
+inline void TransformDirections(const mat4& m, const vec3* in, vec3* out, size_t n) noexcept
+{
+	mat3 linear = LinearPart(m);
+	simd::transform_vec3<false, false>(&linear.cols[0].x, nullptr, reinterpret_cast<const float*>(in), reinterpret_cast<float*>(out), n);
+}
+
+/// @brief out[i] = m * in[i]
+inline void TransformDirections(const mat3& m, const vec3* in, vec3* out, size_t n) noexcept
+{
+	simd::transform_vec3<false, false>(&m.cols[0].x, nullptr, reinterpret_cast<const float*>(in), reinterpret_cast<float*>(out), n);
+}
+
+/// @brief out[i] = normalize(normal_matrix * in[i]). Zero vectors stay zero.
+/// @param normal_matrix Precomputed by NormalMatrix()
+inline void TransformNormals(const mat3& normal_matrix, const vec3* in, vec3* out, size_t n) noexcept
+{
+	simd::transform_vec3<false, true>(&normal_matrix.cols[0].x, nullptr, reinterpret_cast<const float*>(in), reinterpret_cast<float*>(out), n);
+}
+
+/// @brief out[i] = normalize(NormalMatrix(m) * in[i]). Zero vectors stay zero.
+inline void TransformNormals(const mat4& m, const vec3* in, vec3* out, size_t n) noexcept
+{
+	TransformNormals(NormalMatrix(m), in, out, n);
+}
@@ -0,0 +1,140 @@
+#pragma once
+
+#include "SIMD.h"
+
+#include <limits>
+
+/// @file FastMath.h
+/// @brief Approximate transcendental functions for the MathPrecision::Fast tier.
+///
+/// Every kernel is written once against a lanes type (simd::ScalarLanes or simd::WideLanes),
+/// so the same code runs on 1, 4 or 8 floats. Measured against double precision libm:
+///
+/// | Function   | Domain          | Max abs error | Max ulp          |
+/// |------------|-----------------|---------------|------------------|
+/// | fast_rsqrt | [2^-100, 2^100] | -             | 4 (2 scalar)     |
+/// | fast_sin   | [-100pi, 100pi] | 2.2e-7        | 4 where |y|>0.5  |
+/// | fast_cos   | [-100pi, 100pi] | 2.8e-7        | 5 where |y|>0.5  |
+/// | fast_acos  | [-1, 1]         | 4.4e-7        | 3 where |y|>0.5  |
+/// | fast_atan2 | all finite      | 3.1e-7        | -                |
+///
+/// Near the roots of sin/cos only the absolute bound is meaningful.
+/// fast_rsqrt returns +-inf at +-0 and 0 at inf, like 1 / sqrt(x).
+/// fast_atan2 ignores the sign of zero: (-0, x < 0) gives pi rather than -pi.
+
+namespace simd
+{
+	/// @brief 1 / sqrt(x): hardware estimate refined by one Newton-Raphson step.
+	template <typename L>
+	typename L::type fast_rsqrt(typename L::type x) noexcept
+	{
+		auto y = L::rsqrt_est(x);
+		auto half_xyy = L::mul(L::mul(L::set1(0.5f), x), L::mul(y, y));
+		auto refined = L::mul(y, L::sub(L::set1(1.5f), half_xyy));
+		// The step is 0 * inf at x = 0 and x = inf, where the estimate (inf, 0) is already exact
+		refined = L::select_nonzero(x, refined, y);
+		return L::select_gt(x, L::set1(std::numeric_limits<float>::max()), y, refined);
+	}
+
+	/// @brief Reduce x to [-pi, pi] with a two constant Cody-Waite reduction.
+	template <typename L>
+	typename L::type reduce_2pi(typename L::type x) noexcept
+	{
+		constexpr float inv_2pi = 0.159154943091895f;
+		constexpr float two_pi_hi = 6.28125f;
+		constexpr float two_pi_lo = 0.00193530717958647692f;
+		auto q = L::round(L::mul(x, L::set1(inv_2pi)));
+		auto y = L::sub(x, L::mul(q, L::set1(two_pi_hi)));
+		return L::sub(y, L::mul(q, L::set1(two_pi_lo)));
+	}
+
+	/// @brief sin(x), 11-degree minimax polynomial on [-pi/2, pi/2].
+	template <typename L>
+	typename L::type fast_sin(typename L::type x) noexcept
+	{
+		constexpr float pi = 3.14159265358979f;
+		constexpr float half_pi = 1.57079632679490f;
+		auto y = reduce_2pi<L>(x);
+		// sin(y) == sin(pi - y) == sin(-pi - y)
+		y = L::select_gt(y, L::set1(half_pi), L::sub(L::set1(pi), y), y);
+		y = L::select_gt(L::set1(-half_pi), y, L::sub(L::set1(-pi), y), y);
+		auto y2 = L::mul(y, y);
+		auto p = L::madd(L::set1(-2.3889859e-08f), y2, L::set1(2.7525562e-06f));
+		p = L::madd(p, y2, L::set1(-0.00019840874f));
+		p = L::madd(p, y2, L::set1(0.0083333310f));
+		p = L::madd(p, y2, L::set1(-0.16666667f));
+		p = L::madd(p, y2, L::set1(1.0f));
+		return L::mul(p, y);
+	}
+
+	/// @brief cos(x), 10-degree minimax polynomial on [-pi/2, pi/2].
+	template <typename L>
+	typename L::type fast_cos(typename L::type x) noexcept
+	{
+		constexpr float pi = 3.14159265358979f;
+		constexpr float half_pi = 1.57079632679490f;
+		auto y = reduce_2pi<L>(x);
+		// cos(y) == -cos(pi - y) == -cos(-pi - y)
+		auto sign = L::select_gt(L::abs(y), L::set1(half_pi), L::set1(-1.0f), L::set1(1.0f));
+		y = L::select_gt(y, L::set1(half_pi), L::sub(L::set1(pi), y), y);
+		y = L::select_gt(L::set1(-half_pi), y, L::sub(L::set1(-pi), y), y);
+		auto y2 = L::mul(y, y);
+		auto p = L::madd(L::set1(-2.6051615e-07f), y2, L::set1(2.4760495e-05f));
+		p = L::madd(p, y2, L::set1(-0.0013888378f));
+		p = L::madd(p, y2, L::set1(0.041666638f));
+		p = L::madd(p, y2, L::set1(-0.5f));
+		p = L::madd(p, y2, L::set1(1.0f));
+		return L::mul(p, sign);
+	}
+
+	/// @brief acos(x) = sqrt(1 - |x|) * P7(|x|), reflected for x < 0. Input is clamped to [-1, 1].
+	template <typename L>
+	typename L::type fast_acos(typename L::type x) noexcept
+	{
+		constexpr float pi = 3.14159265358979f;
+		auto ax = L::min(L::abs(x), L::set1(1.0f));
+		auto root = L::sqrt(L::sub(L::set1(1.0f), ax));
+		auto p = L::madd(L::set1(-0.0012624911f), ax, L::set1(0.0066700901f));
+		p = L::madd(p, ax, L::set1(-0.0170881256f));
+		p = L::madd(p, ax, L::set1(0.0308918810f));
+		p = L::madd(p, ax, L::set1(-0.0501743046f));
+		p = L::madd(p, ax, L::set1(0.0889789874f));
+		p = L::madd(p, ax, L::set1(-0.2145988016f));
+		p = L::madd(p, ax, L::set1(1.5707963050f));
+		auto r = L::mul(p, root);
+		return L::select_gt(L::set1(0.0f), x, L::sub(L::set1(pi), r), r);
+	}
+
+	/// @brief atan(t) for t in [0, 1], 15-degree odd minimax polynomial.
+	template <typename L>
+	typename L::type fast_atan01(typename L::type t) noexcept
+	{
+		auto t2 = L::mul(t, t);
+		auto p = L::madd(L::set1(0.0028662257f), t2, L::set1(-0.0161657367f));
+		p = L::madd(p, t2, L::set1(0.0429096138f));
+		p = L::madd(p, t2, L::set1(-0.0752896400f));
+		p = L::madd(p, t2, L::set1(0.1065626393f));
+		p = L::madd(p, t2, L::set1(-0.1420889944f));
+		p = L::madd(p, t2, L::set1(0.1999355085f));
+		p = L::madd(p, t2, L::set1(-0.3333314528f));
+		p = L::madd(p, t2, L::set1(1.0f));
+		return L::mul(p, t);
+	}
+
+	/// @brief atan2(y, x). Returns 0 for (0, 0).
+	template <typename L>
+	typename L::type fast_atan2(typename L::type y, typename L::type x) noexcept
+	{
+		constexpr float pi = 3.14159265358979f;
+		constexpr float half_pi = 1.57079632679490f;
+		auto ax = L::abs(x);
+		auto ay = L::abs(y);
+		auto hi = L::max(ax, ay);
+		auto lo = L::min(ax, ay);
+		auto t = L::select_nonzero(hi, L::div(lo, hi), L::set1(0.0f));
+		auto a = fast_atan01<L>(t);
+		a = L::select_gt(ay, ax, L::sub(L::set1(half_pi), a), a);
+		a = L::select_gt(L::set1(0.0f), x, L::sub(L::set1(pi), a), a);
+		return L::select_gt(L::set1(0.0f), y, L::sub(L::set1(0.0f), a), a);
+	}
+}
@@ -0,0 +1,118 @@
+#pragma once
+
+#include "Sphere.h"
+
+#include <cstdint>
+
+/// @brief Result of testing a bound against a volume.
+enum class Containment : uint8_t
+{
+	Outside,
+	Intersecting,
+	Inside
+};
+
+/// @brief Convex view volume bounded by 6 inward facing planes.
+/// @note Tests are conservative: a bound near a frustum edge can be reported Intersecting
+/// while it is actually outside, but a visible bound is never reported Outside.
+class Frustum
+{
+public:
+	enum Plane
+	{
+		Left,
+		Right,
+		Bottom,
+		Top,
+		Near,
+		Far,
+		PlaneCount
+	};
+
+	/// @brief Degenerate frustum, every bound intersects it
+	constexpr Frustum() noexcept = default;
+
+	/// @brief Planes of the OpenGL clip volume (-w <= x, y, z <= w) of view_projection.
+	/// Pass CameraObject::GetProjectionMatrix() * lookAt for a world space frustum,
+	/// or additionally multiplied by a model matrix for an object space one.
+	constexpr explicit Frustum(const mat4& view_projection) noexcept
+	{
+		const mat4 rows = view_projection.transposed();
+		const vec4 r0 = rows.cols[0], r1 = rows.cols[1], r2 = rows.cols[2], r3 = rows.cols[3];
+		planes[Left] = r3 + r0;
+		planes[Right] = r3 - r0;
+		planes[Bottom] = r3 + r1;
+		planes[Top] = r3 - r1;
+		planes[Near] = r3 + r2;
+		planes[Far] = r3 - r2;
+		// Unit normals so plane distances are metric, required by the sphere test
+		for (vec4& p : planes)
+			p *= 1 / Mathf::sqrt(p.x * p.x + p.y * p.y + p.z * p.z);
+	}
+
+	constexpr Frustum(const Frustum&) noexcept = default;
+
+	/// @brief Signed distance of p to a plane, positive inside
+	constexpr float distance(Plane plane, const vec3& p) const noexcept
+	{
+		const vec4& n = planes[plane];
+		return n.x * p.x + n.y * p.y + n.z * p.z + n.w;
+	}
+
+	constexpr bool contains(const vec3& p) const noexcept
+	{
+		for (int i = 0; i < PlaneCount; ++i)
+		{
+			if (distance(Plane(i), p) < 0)
+				return false;
+		}
+		return true;
+	}
+
+	/// @brief Same result as ClassifySpheres for one sphere. An empty sphere is outside.
+	constexpr Containment classify(const Sphere& sphere) const noexcept
+	{
+		if (sphere.empty())
+			return Containment::Outside;
+		return classify(sphere.center, vec3(sphere.radius), false);
+	}
+
+	/// @brief Same result as ClassifyAABBs for one box. An empty box is outside.
+	constexpr Containment classify(const AABB& box) const noexcept
+	{
+		if (box.empty())
+			return Containment::Outside;
+		return classify(box.center(), box.extents(), true);
+	}
+
+	constexpr bool intersects(const Sphere& sphere) const noexcept
+	{
+		return classify(sphere) != Containment::Outside;
+	}
+
+	constexpr bool intersects(const AABB& box) const noexcept
+	{
+		return classify(box) != Containment::Outside;
+	}
+
+	/// @brief (xyz: inward unit normal, w: offset). A point p is inside a plane if dot(xyz, p) + w >= 0.
+	vec4 planes[PlaneCount];
+
+private:
+	/// @brief Reference version of the batch kernel in BatchCulling.h, same operation order.
+	constexpr Containment classify(const vec3& c, const vec3& e, bool box) const noexcept
+	{
+		float nearest = std::numeric_limits<float>::infinity();
+		float farthest = std::numeric_limits<float>::infinity();
+		for (const vec4& p : planes)
+		{
+			const float d = p.z * c.z + (p.y * c.y + (p.x * c.x + p.w));
+			const float r = box ? Mathf::abs(p.z) * e.z + (Mathf::abs(p.y) * e.y + Mathf::abs(p.x) * e.x) : e.x;
+			nearest = Mathf::min(nearest, d + r);
+			farthest = Mathf::min(farthest, d - r);
+		}
+		if (nearest < 0)
+			return Containment::Outside;
+		return farthest < 0 ? Containment::Intersecting : Containment::Inside;
+	}
+};
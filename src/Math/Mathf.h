@@ -1,12 +1,24 @@
 #pragma once
 
 #include "..\Utilities\Traits.h"
+#include "FastMath.h"
+#include "Random.h"
 
 #include <utility>
-#include <random>
+#include <type_traits>
+#include <atomic>
 #include <limits>
 #include <cmath>
 
+/// @brief Precision tier for transcendental functions.
+/// Accurate forwards to the C runtime, Fast uses the polynomial kernels in FastMath.h
+/// (max absolute error ~4e-7, see the table there).
+enum class MathPrecision
+{
+	Accurate,
+	Fast
+};
+
 class Mathf
 {
 public:
@@ -76,50 +88,137 @@ public:
 		return val * val;
 	}
 
-	static float sqrt(float val) noexcept
+	static constexpr float sqrt(float val) noexcept
 	{
+		if (std::is_constant_evaluated())
+			return static_cast<float>(ce_sqrt(val));
 		return ::std::sqrtf(val);
 	}
 
-	static float rsqrt(float val) noexcept
+	template <MathPrecision P = MathPrecision::Accurate>
+	static constexpr float rsqrt(float val) noexcept
 	{
-		// TODO: intrin rsqrt
-		return 1 / sqrt(val);
+		if (std::is_constant_evaluated())
+			return static_cast<float>(1 / ce_sqrt(val));
+		if constexpr (P == MathPrecision::Fast)
+			return simd::fast_rsqrt<simd::ScalarLanes>(val);
+		else
+			return 1 / sqrt(val);
 	}
 
-	static float sin(float rad) noexcept
+	template <MathPrecision P = MathPrecision::Accurate>
+	static constexpr float sin(float rad) noexcept
 	{
-		return ::std::sinf(rad);
+		if (std::is_constant_evaluated())
+			return static_cast<float>(ce_sin(rad, false));
+		if constexpr (P == MathPrecision::Fast)
+			return simd::fast_sin<simd::ScalarLanes>(rad);
+		else
+			return ::std::sinf(rad);
 	}
 
-	static float cos(float rad) noexcept
+	template <MathPrecision P = MathPrecision::Accurate>
+	static constexpr float cos(float rad) noexcept
 	{
-		return ::std::cosf(rad);
+		if (std::is_constant_evaluated())
+			return static_cast<float>(ce_sin(rad, true));
+		if constexpr (P == MathPrecision::Fast)
+			return simd::fast_cos<simd::ScalarLanes>(rad);
+		else
+			return ::std::cosf(rad);
 	}
 
-	static float tan(float rad) noexcept
+	static constexpr float tan(float rad) noexcept
 	{
+		if (std::is_constant_evaluated())
+			return static_cast<float>(ce_sin(rad, false) / ce_sin(rad, true));
 		return ::std::tanf(rad);
 	}
 
-	static float asin(float val) noexcept
+	static constexpr float asin(float val) noexcept
 	{
+		if (std::is_constant_evaluated())
+			return static_cast<float>(ce_atan2(val, ce_sqrt(1.0 - static_cast<double>(val) * val)));
 		return ::std::asinf(val);
 	}
 
-	static float acos(float val) noexcept
+	template <MathPrecision P = MathPrecision::Accurate>
+	static constexpr float acos(float val) noexcept
 	{
-		return ::std::acosf(val);
+		if (std::is_constant_evaluated())
+			return static_cast<float>(ce_atan2(ce_sqrt(1.0 - static_cast<double>(val) * val), val));
+		if constexpr (P == MathPrecision::Fast)
+			return simd::fast_acos<simd::ScalarLanes>(val);
+		else
+			return ::std::acosf(val);
 	}
 
-	static float atan(float val) noexcept
+	static constexpr float atan(float val) noexcept
 	{
+		if (std::is_constant_evaluated())
+			return static_cast<float>(ce_atan(val));
 		return ::std::atanf(val);
 	}
 
-	static float atan2(float y, float x) noexcept
+	template <MathPrecision P = MathPrecision::Accurate>
+	static constexpr float atan2(float y, float x) noexcept
+	{
+		if (std::is_constant_evaluated())
+			return static_cast<float>(ce_atan2(y, x));
+		if constexpr (P == MathPrecision::Fast)
+			return simd::fast_atan2<simd::ScalarLanes>(y, x);
+		else
+			return ::std::atan2f(y, x);
+	}
+
+	/// @brief out[i] = rsqrt(in[i]). in and out may alias.
+	template <MathPrecision P = MathPrecision::Accurate>
+	static void rsqrt(const float* in, float* out, size_t n) noexcept
+	{
+		batch<P>(in, out, n, [](auto lanes, auto v) { return simd::fast_rsqrt<decltype(lanes)>(v); },
+			[](float v) { return rsqrt(v); });
+	}
+
+	/// @brief out[i] = sin(in[i]). in and out may alias.
+	template <MathPrecision P = MathPrecision::Accurate>
+	static void sin(const float* in, float* out, size_t n) noexcept
+	{
+		batch<P>(in, out, n, [](auto lanes, auto v) { return simd::fast_sin<decltype(lanes)>(v); },
+			[](float v) { return sin(v); });
+	}
+
+	/// @brief out[i] = cos(in[i]). in and out may alias.
+	template <MathPrecision P = MathPrecision::Accurate>
+	static void cos(const float* in, float* out, size_t n) noexcept
+	{
+		batch<P>(in, out, n, [](auto lanes, auto v) { return simd::fast_cos<decltype(lanes)>(v); },
+			[](float v) { return cos(v); });
+	}
+
+	/// @brief out[i] = acos(in[i]). in and out may alias.
+	template <MathPrecision P = MathPrecision::Accurate>
+	static void acos(const float* in, float* out, size_t n) noexcept
 	{
-		return ::std::atan2f(y, x);
+		batch<P>(in, out, n, [](auto lanes, auto v) { return simd::fast_acos<decltype(lanes)>(v); },
+			[](float v) { return acos(v); });
+	}
+
+	/// @brief out[i] = atan2(y[i], x[i]). out may alias y or x.
+	template <MathPrecision P = MathPrecision::Accurate>
+	static void atan2(const float* y, const float* x, float* out, size_t n) noexcept
+	{
+		if constexpr (P == MathPrecision::Fast)
+		{
+			simd::for_each_lanes(n, [=](auto lanes, size_t i) {
+				using L = decltype(lanes);
+				L::store(out + i, simd::fast_atan2<L>(L::load(y + i), L::load(x + i)));
+			});
+		}
+		else
+		{
+			for (size_t i = 0; i < n; ++i)
+				out[i] = atan2(y[i], x[i]);
+		}
 	}
 
 	static constexpr bool fuzzy_zero(float val) noexcept
@@ -141,28 +240,122 @@ public:
 		return ret;
 	}
 
+	/// @brief Seed the calling thread's generator.
 	static void srand(unsigned seed) noexcept
 	{
-		random_engine.seed(seed);
+		random_engine().seed(seed);
 	}
 
 	/// @brief Generate a random float value.
-	/// @return A random float value between (0.0f, 1.0f)
+	/// @return A random float value between [0.0f, 1.0f)
 	static float random() noexcept
 	{
-		return float_random_range(random_engine);
+		return random_engine().next_float();
 	}
 
 	/// @brief Generate a random float value
 	/// @param a Random range left
 	/// @param b Random range right
-	/// @return A random float value between (a, b)
+	/// @return A random float value between [a, b)
 	static float random(float a, float b) noexcept
 	{
-		return lerp(a, b, random());
+		return random_engine().range(a, b);
+	}
+
+	/// @brief The calling thread's generator.
+	/// Each thread starts on its own stream, numbered by first use.
+	static Random& random_engine() noexcept
+	{
+		thread_local Random engine = Random::stream(0, random_thread_count.fetch_add(1, std::memory_order_relaxed));
+		return engine;
 	}
 
 private:
-	inline static std::default_random_engine random_engine{};
-	inline static std::uniform_real_distribution<float> float_random_range{0.0f, 1.0f};
+	// Compile time implementations. They run in double and round once, so results
+	// agree with the C runtime to within 1 ulp of float.
+
+	static constexpr double ce_sqrt(double x) noexcept
+	{
+		if (!(x > 0))
+			return x == 0 ? 0 : std::numeric_limits<double>::quiet_NaN();
+		if (x == std::numeric_limits<double>::infinity())
+			return x;
+		// Newton from above decreases monotonically until it converges
+		double r = x > 1 ? x : 1;
+		while (true)
+		{
+			double next = 0.5 * (r + x / r);
+			if (next >= r)
+				return r;
+			r = next;
+		}
+	}
+
+	/// @return sin(x), or cos(x) if cosine is set
+	static constexpr double ce_sin(double x, bool cosine) noexcept
+	{
+		// Reduce to r in [-pi/4, pi/4] and a quadrant, cos(x) = sin(x + pi/2)
+		double k = x / (PiD / 2);
+		long long n = static_cast<long long>(k < 0 ? k - 0.5 : k + 0.5);
+		double r = x - static_cast<double>(n) * (PiD / 2);
+		int quadrant = static_cast<int>(((n + (cosine ? 1 : 0)) % 4 + 4) % 4);
+		double r2 = r * r;
+		double term = (quadrant & 1) ? 1 : r;
+		double sum = term;
+		for (int i = 1; i < 12; ++i)
+		{
+			// Taylor series of sin (odd quadrants: cos)
+			int a = (quadrant & 1) ? 2 * i - 1 : 2 * i;
+			term *= -r2 / (a * (a + 1));
+			sum += term;
+		}
+		return quadrant >= 2 ? -sum : sum;
+	}
+
+	static constexpr double ce_atan(double x) noexcept
+	{
+		if (x < 0)
+			return -ce_atan(-x);
+		if (x > 1)
+			return PiD / 2 - ce_atan(1 / x);
+		// atan(x) = 2 * atan(x / (1 + sqrt(1 + x^2))) brings x below tan(pi/8)
+		double y = x / (1 + ce_sqrt(1 + x * x));
+		double y2 = y * y;
+		double term = y;
+		double sum = y;
+		for (int i = 1; i < 40; ++i)
+		{
+			term *= -y2;
+			sum += term / (2 * i + 1);
+		}
+		return 2 * sum;
+	}
+
+	static constexpr double ce_atan2(double y, double x) noexcept
+	{
+		if (x > 0)
+			return ce_atan(y / x);
+		if (x < 0)
+			return y >= 0 ? ce_atan(y / x) + PiD : ce_atan(y / x) - PiD;
+		return y > 0 ? PiD / 2 : y < 0 ? -PiD / 2 : 0;
+	}
+
+	template <MathPrecision P, typename Kernel, typename Scalar>
+	static void batch(const float* in, float* out, size_t n, Kernel kernel, Scalar scalar) noexcept
+	{
+		if constexpr (P == MathPrecision::Fast)
+		{
+			simd::for_each_lanes(n, [=](auto lanes, size_t i) {
+				using L = decltype(lanes);
+				L::store(out + i, kernel(lanes, L::load(in + i)));
+			});
+		}
+		else
+		{
+			for (size_t i = 0; i < n; ++i)
+				out[i] = scalar(in[i]);
+		}
+	}
+
+	inline static std::atomic<uint32_t> random_thread_count{0};
 };
\ No newline at end of file
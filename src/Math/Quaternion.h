@@ -17,7 +17,7 @@ public:
 
 	constexpr bool operator==(const Quaternion& rhs) const noexcept { return v == rhs.v; }
 
-	/// @brief Quaternion product
+	/// @brief Hamilton product: rotating by *this * rhs rotates by rhs, then by *this
 	/// @param rhs Another Quatrenion(vec4)
 	/// @return Quaternion
 	constexpr Quaternion operator*(const Quaternion& _rhs) const noexcept
@@ -25,9 +25,9 @@ public:
 		auto [x, y, z, w] = v;
 		const auto& rhs = _rhs.v;
 		return Quaternion(
-			w * rhs.x + x * rhs.w + z * rhs.y - y * rhs.z,
-			w * rhs.y + y * rhs.w + x * rhs.z - z * rhs.x,
-			w * rhs.z + z * rhs.w + y * rhs.z - x * rhs.z,
+			w * rhs.x + x * rhs.w + y * rhs.z - z * rhs.y,
+			w * rhs.y + y * rhs.w + z * rhs.x - x * rhs.z,
+			w * rhs.z + z * rhs.w + x * rhs.y - y * rhs.x,
 			w * rhs.w - x * rhs.x - y * rhs.y - z * rhs.z
 		);
 	}
@@ -54,13 +54,39 @@ public:
 		return v.dot_product(rhs.v);
 	}
 
+	/// @brief Rotate a vector. Same as mat3(*this) * p for a unit quaternion.
+	constexpr vec3 rotate(const vec3& p) const noexcept
+	{
+		vec3 u(v.x, v.y, v.z);
+		vec3 t = 2.0f * u.cross_product(p);
+		return p + v.w * t + u.cross_product(t);
+	}
+
+	/// @brief Above this |dot| slerp falls back to nlerp, sin(theta) is too small to divide by.
+	static constexpr float SlerpNlerpThreshold = 0.9995f;
+
+	/// @brief Normalized linear interpolation along the shortest path.
+	static Quaternion nlerp(const Quaternion& lhs, const Quaternion& rhs, float t) noexcept
+	{
+		vec4 to = lhs.dot_product(rhs) < 0 ? -rhs.v : rhs.v;
+		return Quaternion((lhs.v * (1 - t) + to * t).normalized());
+	}
+
+	/// @brief Spherical linear interpolation along the shortest path.
+	/// Nearly parallel inputs fall back to nlerp.
+	template <MathPrecision P = MathPrecision::Accurate>
 	static Quaternion slerp(const Quaternion& lhs, const Quaternion& rhs, float t) noexcept
 	{
-		float theta = Mathf::acos(lhs.dot_product(rhs));
-		float rs = 1 / Mathf::sin(theta);
-		float snt = Mathf::sin((1 - t) * theta);
-		float st = Mathf::sin(t * theta);
-		return Quaternion((snt * lhs.v + st * rhs.v) * rs);
+		float d = lhs.dot_product(rhs);
+		vec4 to = d < 0 ? -rhs.v : rhs.v;
+		d = Mathf::abs(d);
+		if (d > SlerpNlerpThreshold)
+			return Quaternion((lhs.v * (1 - t) + to * t).normalized());
+		float theta = Mathf::acos<P>(d);
+		float rs = 1 / Mathf::sin<P>(theta);
+		float snt = Mathf::sin<P>((1 - t) * theta);
+		float st = Mathf::sin<P>(t * theta);
+		return Quaternion((snt * lhs.v + st * to) * rs);
 	}
 
 private:
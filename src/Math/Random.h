@@ -0,0 +1,224 @@
+#pragma once
+
+#include "SIMD.h"
+
+#include <cstdint>
+#include <cstddef>
+
+/// @brief xoshiro256++ pseudo random generator.
+/// @note An instance is not synchronized. Give every thread its own generator,
+/// e.g. Random::stream(seed, thread_index) or successive split() calls.
+class Random
+{
+public:
+	explicit Random(uint64_t seed = 0) noexcept
+	{
+		this->seed(seed);
+	}
+
+	void seed(uint64_t seed) noexcept
+	{
+		// splitmix64 spreads the seed over the whole state
+		for (uint64_t& s : m_State)
+		{
+			seed += 0x9E3779B97F4A7C15ull;
+			uint64_t z = seed;
+			z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+			z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+			s = z ^ (z >> 31);
+		}
+		m_bLanesReady = false;
+	}
+
+	uint64_t next_u64() noexcept
+	{
+		return step(m_State[0], m_State[1], m_State[2], m_State[3]);
+	}
+
+	uint32_t next_u32() noexcept
+	{
+		return static_cast<uint32_t>(next_u64() >> 32);
+	}
+
+	/// @return A random float value in [0.0f, 1.0f)
+	float next_float() noexcept
+	{
+		return to_float(next_u32());
+	}
+
+	/// @return A random float value in [a, b)
+	float range(float a, float b) noexcept
+	{
+		return a + (b - a) * next_float();
+	}
+
+	/// @brief Advance the scalar stream by 2^128 values.
+	void jump() noexcept
+	{
+		static constexpr uint64_t poly[] = {
+			0x180EC6D33CFD0ABAull, 0xD5A61266F0C9392Cull, 0xA9582618E03FC9AAull, 0x39ABDC4529B1661Cull
+		};
+		jump(m_State, poly);
+		m_bLanesReady = false;
+	}
+
+	/// @brief Generator for the next 2^128 values of this stream, which are then skipped here.
+	/// Successive calls hand out deterministic, non-overlapping streams.
+	Random split() noexcept
+	{
+		Random ret = *this;
+		ret.m_bLanesReady = false;
+		jump();
+		return ret;
+	}
+
+	/// @brief The index-th non-overlapping stream of seed: the generator the (index + 1)-th split() of Random(seed) returns.
+	static Random stream(uint64_t seed, uint32_t index) noexcept
+	{
+		Random ret(seed);
+		for (uint32_t i = 0; i < index; ++i)
+			ret.jump();
+		return ret;
+	}
+
+	/// @brief Fill out with uniform floats in [0.0f, 1.0f), 8 per step.
+	/// Batch values come from 4 interleaved lanes seeded off the scalar stream, so the output
+	/// only depends on the seed and the sequence of fill sizes, not on the SIMD backend.
+	/// A step is never split across calls: the unused part of a partial step is dropped.
+	void fill(float* out, size_t n) noexcept
+	{
+		fill(out, n, 0.0f, 1.0f);
+	}
+
+	/// @brief Fill out with uniform floats in [a, b), 8 per step.
+	void fill(float* out, size_t n, float a, float b) noexcept
+	{
+		if (!m_bLanesReady)
+			init_lanes();
+		const float scale = (b - a) * (1.0f / 16777216.0f);
+		size_t i = 0;
+#if MATH_SIMD_LEVEL >= 2
+		__m256i s0 = _mm256_load_si256(reinterpret_cast<const __m256i*>(m_Lanes[0]));
+		__m256i s1 = _mm256_load_si256(reinterpret_cast<const __m256i*>(m_Lanes[1]));
+		__m256i s2 = _mm256_load_si256(reinterpret_cast<const __m256i*>(m_Lanes[2]));
+		__m256i s3 = _mm256_load_si256(reinterpret_cast<const __m256i*>(m_Lanes[3]));
+		const __m256 vscale = _mm256_set1_ps(scale);
+		const __m256 va = _mm256_set1_ps(a);
+		for (; i < n; i += 8)
+		{
+			__m256i sum = _mm256_add_epi64(s0, s3);
+			__m256i r = _mm256_add_epi64(_mm256_or_si256(_mm256_slli_epi64(sum, 23), _mm256_srli_epi64(sum, 41)), s0);
+			__m256i t = _mm256_slli_epi64(s1, 17);
+			s2 = _mm256_xor_si256(s2, s0);
+			s3 = _mm256_xor_si256(s3, s1);
+			s1 = _mm256_xor_si256(s1, s2);
+			s0 = _mm256_xor_si256(s0, s3);
+			s2 = _mm256_xor_si256(s2, t);
+			s3 = _mm256_or_si256(_mm256_slli_epi64(s3, 45), _mm256_srli_epi64(s3, 19));
+			__m256 f = _mm256_add_ps(_mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_srli_epi32(r, 8)), vscale), va);
+			if (i + 8 <= n)
+				_mm256_storeu_ps(out + i, f);
+			else
+				store_partial(out + i, n - i, f);
+		}
+		_mm256_store_si256(reinterpret_cast<__m256i*>(m_Lanes[0]), s0);
+		_mm256_store_si256(reinterpret_cast<__m256i*>(m_Lanes[1]), s1);
+		_mm256_store_si256(reinterpret_cast<__m256i*>(m_Lanes[2]), s2);
+		_mm256_store_si256(reinterpret_cast<__m256i*>(m_Lanes[3]), s3);
+#else
+		// Four scalar lanes. With SSE4.1 only, 2-wide 64-bit shifts lose to native scalar rotates.
+		for (; i < n; i += 8)
+		{
+			float f[8];
+			for (int k = 0; k < 4; ++k)
+			{
+				uint64_t r = step(m_Lanes[0][k], m_Lanes[1][k], m_Lanes[2][k], m_Lanes[3][k]);
+				f[2 * k] = static_cast<float>(static_cast<uint32_t>(r) >> 8) * scale + a;
+				f[2 * k + 1] = static_cast<float>(static_cast<uint32_t>(r >> 32) >> 8) * scale + a;
+			}
+			copy_step(out + i, n - i, f);
+		}
+#endif
+	}
+
+private:
+	static constexpr uint64_t rotl(uint64_t x, int k) noexcept
+	{
+		return (x << k) | (x >> (64 - k));
+	}
+
+	static uint64_t step(uint64_t& s0, uint64_t& s1, uint64_t& s2, uint64_t& s3) noexcept
+	{
+		const uint64_t result = rotl(s0 + s3, 23) + s0;
+		const uint64_t t = s1 << 17;
+		s2 ^= s0;
+		s3 ^= s1;
+		s1 ^= s2;
+		s0 ^= s3;
+		s2 ^= t;
+		s3 = rotl(s3, 45);
+		return result;
+	}
+
+	static float to_float(uint32_t bits) noexcept
+	{
+		return static_cast<float>(bits >> 8) * (1.0f / 16777216.0f);
+	}
+
+	static void jump(uint64_t (&state)[4], const uint64_t (&poly)[4]) noexcept
+	{
+		uint64_t s[4] = {};
+		for (uint64_t p : poly)
+		{
+			for (int b = 0; b < 64; ++b)
+			{
+				if (p & (uint64_t(1) << b))
+				{
+					for (int i = 0; i < 4; ++i)
+						s[i] ^= state[i];
+				}
+				step(state[0], state[1], state[2], state[3]);
+			}
+		}
+		for (int i = 0; i < 4; ++i)
+			state[i] = s[i];
+	}
+
+	/// @brief Lane k starts k + 1 long jumps (2^192 values) ahead of the scalar stream,
+	/// far beyond the streams handed out by split().
+	void init_lanes() noexcept
+	{
+		static constexpr uint64_t poly[] = {
+			0x76E15D3EFEFDCBBFull, 0xC5004E441C522FB3ull, 0x77710069854EE241ull, 0x39109BB02ACBE635ull
+		};
+		uint64_t s[4] = { m_State[0], m_State[1], m_State[2], m_State[3] };
+		for (int k = 0; k < 4; ++k)
+		{
+			jump(s, poly);
+			for (int i = 0; i < 4; ++i)
+				m_Lanes[i][k] = s[i];
+		}
+		m_bLanesReady = true;
+	}
+
+	static void copy_step(float* out, size_t remain, const float* f) noexcept
+	{
+		const size_t cnt = remain < 8 ? remain : 8;
+		for (size_t j = 0; j < cnt; ++j)
+			out[j] = f[j];
+	}
+
+#if MATH_SIMD_LEVEL >= 2
+	static void store_partial(float* out, size_t remain, __m256 f) noexcept
+	{
+		alignas(32) float tmp[8];
+		_mm256_store_ps(tmp, f);
+		copy_step(out, remain, tmp);
+	}
+#endif
+
+	uint64_t m_State[4];
+	/// @brief Batch state, m_Lanes[word][lane]
+	alignas(32) uint64_t m_Lanes[4][4];
+	bool m_bLanesReady = false;
+};
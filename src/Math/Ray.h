@@ -0,0 +1,47 @@
+#pragma once
+
+#include "AABB.h"
+
+#include <limits>
+#include <utility>
+
+/// @brief Half line origin + t * direction for t >= 0.
+/// Distances are in units of the direction length, pass a normalized direction for world units.
+class Ray
+{
+public:
+	constexpr Ray() noexcept : Ray(vec3(), vec3(0, 0, -1)) {}
+
+	/// @param direction Must not be zero
+	constexpr Ray(const vec3& origin, const vec3& direction) noexcept :
+		origin(origin), direction(direction), inv_direction(1 / direction.x, 1 / direction.y, 1 / direction.z) {}
+
+	constexpr Ray(const Ray&) noexcept = default;
+
+	constexpr vec3 at(float t) const noexcept { return origin + direction * t; }
+
+	/// @brief Slab test against box.
+	/// @param t Receives the entry distance, 0 if origin is inside
+	/// @return Whether the ray enters box at a distance within [0, max_t]
+	constexpr bool intersects(const AABB& box, float& t, float max_t = std::numeric_limits<float>::infinity()) const noexcept
+	{
+		float near = 0, far = max_t;
+		auto slab = [&](float o, float inv, float lo, float hi) {
+			float t0 = (lo - o) * inv, t1 = (hi - o) * inv;
+			if (t0 > t1)
+				std::swap(t0, t1);
+			near = Mathf::max(near, t0);
+			far = Mathf::min(far, t1);
+		};
+		slab(origin.x, inv_direction.x, box.min.x, box.max.x);
+		slab(origin.y, inv_direction.y, box.min.y, box.max.y);
+		slab(origin.z, inv_direction.z, box.min.z, box.max.z);
+		t = near;
+		return near <= far;
+	}
+
+	vec3 origin;
+	vec3 direction;
+	/// @brief Per axis 1 / direction, infinite for axes the ray is parallel to
+	vec3 inv_direction;
+};
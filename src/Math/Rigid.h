@@ -0,0 +1,61 @@
+#pragma once
+
+#include "Affine3.h"
+
+/// @brief Rigid transform: a rotation followed by a translation, no scale.
+/// @note Inverse is a conjugate and one rotation, no matrix inversion.
+class Rigid
+{
+public:
+	constexpr Rigid() noexcept = default;
+
+	constexpr Rigid(const Quaternion& rotation, const vec3& translation) noexcept :
+		rotation(rotation), translation(translation) {}
+
+	constexpr Rigid(const Rigid&) noexcept = default;
+
+	constexpr explicit operator Affine3() const noexcept
+	{
+		return Affine3(mat3(rotation), translation);
+	}
+
+	/// @brief For uniform upload
+	constexpr explicit operator mat4() const noexcept
+	{
+		return mat4(mat3(rotation), vec4(translation, 1));
+	}
+
+	constexpr static Rigid identity() noexcept { return Rigid(); }
+
+	constexpr bool operator==(const Rigid&) const noexcept = default;
+
+	/// @brief Composition, rhs is applied first
+	constexpr Rigid operator*(const Rigid& rhs) const noexcept
+	{
+		return Rigid(rotation * rhs.rotation, rotation.rotate(rhs.translation) + translation);
+	}
+
+	constexpr Rigid& operator*=(const Rigid& rhs) noexcept
+	{
+		return *this = *this * rhs;
+	}
+
+	constexpr vec3 transform_point(const vec3& p) const noexcept
+	{
+		return rotation.rotate(p) + translation;
+	}
+
+	constexpr vec3 transform_direction(const vec3& d) const noexcept
+	{
+		return rotation.rotate(d);
+	}
+
+	constexpr Rigid inverse() const noexcept
+	{
+		Quaternion inv = rotation.inverse();
+		return Rigid(inv, -inv.rotate(translation));
+	}
+
+	Quaternion rotation;
+	vec3 translation;
+};
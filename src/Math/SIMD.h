@@ -0,0 +1,501 @@
+#pragma once
+
+/// @file SIMD.h
+/// @brief Compile-time selected SIMD kernels used by the Math module.
+///
+/// MATH_SIMD_LEVEL
+///   0 - Scalar fallback (or MATH_SIMD_FORCE_SCALAR defined)
+///   1 - SSE4.1
+///   2 - AVX2 + FMA
+///
+/// The level follows the target flags: __SSE4_1__ or __AVX__, and __AVX2__ with __FMA__. MSVC only
+/// sets __AVX__ and __AVX2__ (/arch), and x64 guarantees no more than SSE2, so SSE4.1 without /arch
+/// needs MATH_SIMD_ASSUME_SSE4 defined.
+///
+/// All kernels work on raw float pointers so they don't depend on the vector types.
+/// Pointers documented as "aligned" must be 16-byte aligned (mat4 storage is).
+///
+/// Agreement with the scalar code, checked by MathTests.cpp:
+///   mat4 * mat4, mat4 * vec4, mat3 * mat3, mat3 * vec3
+///     SSE4.1 bit-exact (same summation order). AVX2 fuses multiply-adds, so each element is
+///     within 4 * FLT_EPSILON * sum |a_k * b_k| of its products.
+///   mat4 transpose - bit-exact.
+///   vec4 dot - sums in another order, within 4 * FLT_EPSILON * sum |a_k * b_k|.
+///   mat4 inverse - adjugates instead of block elimination, within 1e-6 * max |element| for
+///     well conditioned matrices.
+
+#if defined(MATH_SIMD_FORCE_SCALAR)
+#define MATH_SIMD_LEVEL 0
+#elif defined(__AVX2__) && (defined(__FMA__) || defined(_MSC_VER))
+#define MATH_SIMD_LEVEL 2
+#elif defined(__SSE4_1__) || defined(__AVX__) || defined(MATH_SIMD_ASSUME_SSE4)
+#define MATH_SIMD_LEVEL 1
+#else
+#define MATH_SIMD_LEVEL 0
+#endif
+
+#if MATH_SIMD_LEVEL >= 2
+#include <immintrin.h>
+#elif MATH_SIMD_LEVEL >= 1
+#include <smmintrin.h>
+#endif
+
+#include <type_traits>
+#include <cstddef>
+#include <cmath>
+
+namespace simd
+{
+	/// @brief Name of the compiled backend.
+	constexpr const char* backend_name() noexcept
+	{
+#if MATH_SIMD_LEVEL >= 2
+		return "avx2";
+#elif MATH_SIMD_LEVEL >= 1
+		return "sse4.1";
+#else
+		return "scalar";
+#endif
+	}
+
+#if MATH_SIMD_LEVEL >= 1
+
+#define MATH_SIMD_SHUFFLE_MASK(x, y, z, w) ((x) | ((y) << 2) | ((z) << 4) | ((w) << 6))
+
+	template <int x, int y, int z, int w>
+	inline __m128 swizzle(__m128 v) noexcept
+	{
+		return _mm_shuffle_ps(v, v, MATH_SIMD_SHUFFLE_MASK(x, y, z, w));
+	}
+
+	template <int x, int y, int z, int w>
+	inline __m128 shuffle(__m128 a, __m128 b) noexcept
+	{
+		return _mm_shuffle_ps(a, b, MATH_SIMD_SHUFFLE_MASK(x, y, z, w));
+	}
+
+	inline __m128 madd(__m128 a, __m128 b, __m128 c) noexcept
+	{
+#if MATH_SIMD_LEVEL >= 2
+		return _mm_fmadd_ps(a, b, c);
+#else
+		return _mm_add_ps(_mm_mul_ps(a, b), c);
+#endif
+	}
+
+	/// @brief Store lanes 0..2 without touching memory past p[2].
+	inline void store3(float* p, __m128 v) noexcept
+	{
+		_mm_store_sd(reinterpret_cast<double*>(p), _mm_castps_pd(v));
+		_mm_store_ss(p + 2, _mm_movehl_ps(v, v));
+	}
+
+	/// @brief Column-major 4x4 * 4-vector. m aligned.
+	inline __m128 mat4_mul_vec4(const __m128 m[4], __m128 v) noexcept
+	{
+		__m128 r = _mm_mul_ps(m[0], swizzle<0, 0, 0, 0>(v));
+#if MATH_SIMD_LEVEL >= 2
+		r = _mm_fmadd_ps(m[1], swizzle<1, 1, 1, 1>(v), r);
+		r = _mm_fmadd_ps(m[2], swizzle<2, 2, 2, 2>(v), r);
+		r = _mm_fmadd_ps(m[3], swizzle<3, 3, 3, 3>(v), r);
+#else
+		// Same summation order as the scalar code, so SSE results are bit-exact.
+		r = _mm_add_ps(r, _mm_mul_ps(m[1], swizzle<1, 1, 1, 1>(v)));
+		r = _mm_add_ps(r, _mm_mul_ps(m[2], swizzle<2, 2, 2, 2>(v)));
+		r = _mm_add_ps(r, _mm_mul_ps(m[3], swizzle<3, 3, 3, 3>(v)));
+#endif
+		return r;
+	}
+
+	// 2x2 helpers for the block inverse. A 2x2 matrix is packed as (m00, m01, m10, m11).
+
+	/// @brief A * B
+	inline __m128 mat2_mul(__m128 a, __m128 b) noexcept
+	{
+		return _mm_add_ps(_mm_mul_ps(a, swizzle<0, 3, 0, 3>(b)),
+			_mm_mul_ps(swizzle<1, 0, 3, 2>(a), swizzle<2, 1, 2, 1>(b)));
+	}
+
+	/// @brief adj(A) * B
+	inline __m128 mat2_adj_mul(__m128 a, __m128 b) noexcept
+	{
+		return _mm_sub_ps(_mm_mul_ps(swizzle<3, 3, 0, 0>(a), b),
+			_mm_mul_ps(swizzle<1, 1, 2, 2>(a), swizzle<2, 3, 0, 1>(b)));
+	}
+
+	/// @brief A * adj(B)
+	inline __m128 mat2_mul_adj(__m128 a, __m128 b) noexcept
+	{
+		return _mm_sub_ps(_mm_mul_ps(a, swizzle<3, 0, 3, 0>(b)),
+			_mm_mul_ps(swizzle<1, 0, 3, 2>(a), swizzle<2, 1, 2, 1>(b)));
+	}
+
+#endif // MATH_SIMD_LEVEL >= 1
+
+	/// @brief out = lhs * rhs for column-major 4x4 matrices. All pointers aligned.
+	inline void mat4_mul(const float* lhs, const float* rhs, float* out) noexcept
+	{
+#if MATH_SIMD_LEVEL >= 2
+		const __m256 a0 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(lhs + 0));
+		const __m256 a1 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(lhs + 4));
+		const __m256 a2 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(lhs + 8));
+		const __m256 a3 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(lhs + 12));
+		for (int j = 0; j < 16; j += 8)
+		{
+			__m256 b = _mm256_loadu_ps(rhs + j);
+			__m256 r = _mm256_mul_ps(a0, _mm256_permute_ps(b, 0x00));
+			r = _mm256_fmadd_ps(a1, _mm256_permute_ps(b, 0x55), r);
+			r = _mm256_fmadd_ps(a2, _mm256_permute_ps(b, 0xAA), r);
+			r = _mm256_fmadd_ps(a3, _mm256_permute_ps(b, 0xFF), r);
+			_mm256_storeu_ps(out + j, r);
+		}
+#elif MATH_SIMD_LEVEL >= 1
+		const __m128 a[4] = {
+			_mm_load_ps(lhs), _mm_load_ps(lhs + 4), _mm_load_ps(lhs + 8), _mm_load_ps(lhs + 12)
+		};
+		for (int j = 0; j < 16; j += 4)
+			_mm_store_ps(out + j, mat4_mul_vec4(a, _mm_load_ps(rhs + j)));
+#else
+		for (int j = 0; j < 4; ++j)
+		{
+			const float* b = rhs + 4 * j;
+			for (int i = 0; i < 4; ++i)
+				out[4 * j + i] = lhs[i] * b[0] + lhs[4 + i] * b[1] + lhs[8 + i] * b[2] + lhs[12 + i] * b[3];
+		}
+#endif
+	}
+
+	/// @brief out = m * v. m aligned, v and out unaligned.
+	inline void mat4_mul_vec4(const float* m, const float* v, float* out) noexcept
+	{
+#if MATH_SIMD_LEVEL >= 1
+		const __m128 a[4] = {
+			_mm_load_ps(m), _mm_load_ps(m + 4), _mm_load_ps(m + 8), _mm_load_ps(m + 12)
+		};
+		_mm_storeu_ps(out, mat4_mul_vec4(a, _mm_loadu_ps(v)));
+#else
+		float r[4];
+		for (int i = 0; i < 4; ++i)
+			r[i] = m[i] * v[0] + m[4 + i] * v[1] + m[8 + i] * v[2] + m[12 + i] * v[3];
+		for (int i = 0; i < 4; ++i)
+			out[i] = r[i];
+#endif
+	}
+
+	/// @brief out = transpose(m). Both aligned.
+	inline void mat4_transpose(const float* m, float* out) noexcept
+	{
+#if MATH_SIMD_LEVEL >= 1
+		__m128 c0 = _mm_load_ps(m);
+		__m128 c1 = _mm_load_ps(m + 4);
+		__m128 c2 = _mm_load_ps(m + 8);
+		__m128 c3 = _mm_load_ps(m + 12);
+		_MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+		_mm_store_ps(out, c0);
+		_mm_store_ps(out + 4, c1);
+		_mm_store_ps(out + 8, c2);
+		_mm_store_ps(out + 12, c3);
+#else
+		float r[16];
+		for (int j = 0; j < 4; ++j)
+			for (int i = 0; i < 4; ++i)
+				r[4 * i + j] = m[4 * j + i];
+		for (int i = 0; i < 16; ++i)
+			out[i] = r[i];
+#endif
+	}
+
+#if MATH_SIMD_LEVEL >= 1
+	/// @brief out = inverse(m) using the 2x2 block method with adjugates. Both aligned.
+	/// @note Works on columns directly: inverse(transpose(M)) == transpose(inverse(M)).
+	inline void mat4_inverse(const float* m, float* out) noexcept
+	{
+		const __m128 c0 = _mm_load_ps(m);
+		const __m128 c1 = _mm_load_ps(m + 4);
+		const __m128 c2 = _mm_load_ps(m + 8);
+		const __m128 c3 = _mm_load_ps(m + 12);
+
+		// Sub matrices
+		__m128 A = _mm_movelh_ps(c0, c1);
+		__m128 B = _mm_movehl_ps(c1, c0);
+		__m128 C = _mm_movelh_ps(c2, c3);
+		__m128 D = _mm_movehl_ps(c3, c2);
+
+		// (|A|, |B|, |C|, |D|)
+		__m128 det_sub = _mm_sub_ps(
+			_mm_mul_ps(shuffle<0, 2, 0, 2>(c0, c2), shuffle<1, 3, 1, 3>(c1, c3)),
+			_mm_mul_ps(shuffle<1, 3, 1, 3>(c0, c2), shuffle<0, 2, 0, 2>(c1, c3))
+		);
+		__m128 det_a = swizzle<0, 0, 0, 0>(det_sub);
+		__m128 det_b = swizzle<1, 1, 1, 1>(det_sub);
+		__m128 det_c = swizzle<2, 2, 2, 2>(det_sub);
+		__m128 det_d = swizzle<3, 3, 3, 3>(det_sub);
+
+		__m128 dc = mat2_adj_mul(D, C);
+		__m128 ab = mat2_adj_mul(A, B);
+		__m128 X = _mm_sub_ps(_mm_mul_ps(det_d, A), mat2_mul(B, dc));
+		__m128 W = _mm_sub_ps(_mm_mul_ps(det_a, D), mat2_mul(C, ab));
+		__m128 Y = _mm_sub_ps(_mm_mul_ps(det_b, C), mat2_mul_adj(D, ab));
+		__m128 Z = _mm_sub_ps(_mm_mul_ps(det_c, B), mat2_mul_adj(A, dc));
+
+		// |M| = |A||D| + |B||C| - tr(adj(A)B adj(D)C)
+		__m128 det_m = _mm_add_ps(_mm_mul_ps(det_a, det_d), _mm_mul_ps(det_b, det_c));
+		__m128 tr = _mm_mul_ps(ab, swizzle<0, 2, 1, 3>(dc));
+		tr = _mm_hadd_ps(tr, tr);
+		tr = _mm_hadd_ps(tr, tr);
+		det_m = _mm_sub_ps(det_m, tr);
+
+		const __m128 rdet = _mm_div_ps(_mm_setr_ps(1.0f, -1.0f, -1.0f, 1.0f), det_m);
+		X = _mm_mul_ps(X, rdet);
+		Y = _mm_mul_ps(Y, rdet);
+		Z = _mm_mul_ps(Z, rdet);
+		W = _mm_mul_ps(W, rdet);
+
+		// Apply the adjugate shuffle while storing
+		_mm_store_ps(out, shuffle<3, 1, 3, 1>(X, Y));
+		_mm_store_ps(out + 4, shuffle<2, 0, 2, 0>(X, Y));
+		_mm_store_ps(out + 8, shuffle<3, 1, 3, 1>(Z, W));
+		_mm_store_ps(out + 12, shuffle<2, 0, 2, 0>(Z, W));
+	}
+
+	/// @brief Columns of a packed 3x3 matrix, w lanes unspecified.
+	/// Overlapping 4-wide loads that stay within the 9 floats.
+	inline void load_mat3(const float* m, __m128& c0, __m128& c1, __m128& c2) noexcept
+	{
+		c0 = _mm_loadu_ps(m);
+		c1 = _mm_loadu_ps(m + 3);
+		c2 = swizzle<1, 2, 3, 3>(_mm_loadu_ps(m + 5));
+	}
+
+	/// @brief out = lhs * rhs for column-major 3x3 matrices stored as 9 packed floats.
+	inline void mat3_mul(const float* lhs, const float* rhs, float* out) noexcept
+	{
+		__m128 a0, a1, a2;
+		load_mat3(lhs, a0, a1, a2);
+		__m128 c[3];
+		for (int j = 0; j < 3; ++j)
+		{
+			const float* b = rhs + 3 * j;
+			c[j] = madd(a2, _mm_set1_ps(b[2]), madd(a1, _mm_set1_ps(b[1]), _mm_mul_ps(a0, _mm_set1_ps(b[0]))));
+		}
+		// Repack the three xyz columns into 9 floats without a round trip through the stack.
+		// Without optimization _mm_blend_ps is a macro, so the template commas stay out of its arguments.
+		const __m128 x1 = swizzle<0, 0, 0, 0>(c[1]);
+		_mm_storeu_ps(out, _mm_blend_ps(c[0], x1, 0x8));
+		_mm_storeu_ps(out + 4, shuffle<1, 2, 0, 1>(c[1], c[2]));
+		_mm_store_ss(out + 8, _mm_movehl_ps(c[2], c[2]));
+	}
+
+	/// @brief out = m * v for a packed 3x3 matrix.
+	inline void mat3_mul_vec3(const float* m, const float* v, float* out) noexcept
+	{
+		__m128 m0, m1, m2;
+		load_mat3(m, m0, m1, m2);
+		__m128 c = _mm_mul_ps(m0, _mm_set1_ps(v[0]));
+		c = madd(m1, _mm_set1_ps(v[1]), c);
+		c = madd(m2, _mm_set1_ps(v[2]), c);
+		store3(out, c);
+	}
+
+	/// @brief out = lhs * rhs for row-major 3x4 affine matrices (implicit last row 0, 0, 0, 1). All aligned.
+	inline void affine3_mul(const float* lhs, const float* rhs, float* out) noexcept
+	{
+		const __m128 b0 = _mm_load_ps(rhs);
+		const __m128 b1 = _mm_load_ps(rhs + 4);
+		const __m128 b2 = _mm_load_ps(rhs + 8);
+		const __m128 w_mask = _mm_castsi128_ps(_mm_setr_epi32(0, 0, 0, -1));
+		for (int i = 0; i < 3; ++i)
+		{
+			const __m128 a = _mm_load_ps(lhs + 4 * i);
+			__m128 r = _mm_and_ps(a, w_mask);
+			r = madd(swizzle<0, 0, 0, 0>(a), b0, r);
+			r = madd(swizzle<1, 1, 1, 1>(a), b1, r);
+			r = madd(swizzle<2, 2, 2, 2>(a), b2, r);
+			_mm_store_ps(out + 4 * i, r);
+		}
+	}
+
+	/// @brief out = inverse(m) for a row-major 3x4 affine matrix. Both aligned.
+	/// @note The columns of inverse(L) are the cross products of the rows of L over det(L).
+	inline void affine3_inverse(const float* m, float* out) noexcept
+	{
+		const __m128 r0 = _mm_load_ps(m);
+		const __m128 r1 = _mm_load_ps(m + 4);
+		const __m128 r2 = _mm_load_ps(m + 8);
+		const __m128 zero = _mm_setzero_ps();
+		const __m128 a0 = _mm_blend_ps(r0, zero, 0x8);
+		const __m128 a1 = _mm_blend_ps(r1, zero, 0x8);
+		const __m128 a2 = _mm_blend_ps(r2, zero, 0x8);
+		auto cross = [](__m128 a, __m128 b) {
+			__m128 a_yzx = swizzle<1, 2, 0, 3>(a);
+			__m128 b_yzx = swizzle<1, 2, 0, 3>(b);
+			__m128 c = _mm_sub_ps(_mm_mul_ps(a, b_yzx), _mm_mul_ps(a_yzx, b));
+			return swizzle<1, 2, 0, 3>(c);
+		};
+		__m128 c0 = cross(a1, a2);
+		__m128 c1 = cross(a2, a0);
+		__m128 c2 = cross(a0, a1);
+		const __m128 rdet = _mm_div_ps(_mm_set1_ps(1.0f), _mm_dp_ps(a0, c0, 0x7F));
+		// t = (r0.w, r1.w, r2.w), new translation = -inverse(L) * t
+		const __m128 t01 = _mm_unpackhi_ps(r0, r1);
+		__m128 t = _mm_sub_ps(zero, _mm_mul_ps(c0, swizzle<2, 2, 2, 2>(t01)));
+		t = _mm_sub_ps(t, _mm_mul_ps(c1, swizzle<3, 3, 3, 3>(t01)));
+		t = _mm_sub_ps(t, _mm_mul_ps(c2, swizzle<3, 3, 3, 3>(r2)));
+		_MM_TRANSPOSE4_PS(c0, c1, c2, t);
+		_mm_store_ps(out, _mm_mul_ps(c0, rdet));
+		_mm_store_ps(out + 4, _mm_mul_ps(c1, rdet));
+		_mm_store_ps(out + 8, _mm_mul_ps(c2, rdet));
+	}
+
+	/// @brief 4-component dot product. Pointers unaligned.
+	inline float vec4_dot(const float* a, const float* b) noexcept
+	{
+		return _mm_cvtss_f32(_mm_dp_ps(_mm_loadu_ps(a), _mm_loadu_ps(b), 0xF1));
+	}
+
+	/// @brief 4 floats per register (SSE4.1)
+	struct WideLanes4
+	{
+		using type = __m128;
+		static constexpr size_t width = 4;
+
+		static type load(const float* p) noexcept { return _mm_loadu_ps(p); }
+		static void store(float* p, type v) noexcept { _mm_storeu_ps(p, v); }
+		static type set1(float v) noexcept { return _mm_set1_ps(v); }
+		static type add(type a, type b) noexcept { return _mm_add_ps(a, b); }
+		static type sub(type a, type b) noexcept { return _mm_sub_ps(a, b); }
+		static type mul(type a, type b) noexcept { return _mm_mul_ps(a, b); }
+		static type div(type a, type b) noexcept { return _mm_div_ps(a, b); }
+		static type madd(type a, type b, type c) noexcept { return simd::madd(a, b, c); }
+		static type min(type a, type b) noexcept { return _mm_min_ps(a, b); }
+		static type max(type a, type b) noexcept { return _mm_max_ps(a, b); }
+		static type sqrt(type a) noexcept { return _mm_sqrt_ps(a); }
+		/// @brief ~12 bit hardware estimate
+		static type rsqrt_est(type a) noexcept { return _mm_rsqrt_ps(a); }
+		static type round(type a) noexcept { return _mm_round_ps(a, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC); }
+		static type abs(type a) noexcept { return _mm_andnot_ps(_mm_set1_ps(-0.0f), a); }
+		static type select_nonzero(type cond, type a, type b) noexcept
+		{
+			return _mm_blendv_ps(b, a, _mm_cmpneq_ps(cond, _mm_setzero_ps()));
+		}
+		/// @brief x where a > b, otherwise y
+		static type select_gt(type a, type b, type x, type y) noexcept
+		{
+			return _mm_blendv_ps(y, x, _mm_cmpgt_ps(a, b));
+		}
+		static float hsum(type v) noexcept
+		{
+			v = _mm_add_ps(v, _mm_movehl_ps(v, v));
+			return _mm_cvtss_f32(_mm_add_ss(v, _mm_movehdup_ps(v)));
+		}
+		static float hmin(type v) noexcept
+		{
+			v = _mm_min_ps(v, _mm_movehl_ps(v, v));
+			return _mm_cvtss_f32(_mm_min_ss(v, _mm_movehdup_ps(v)));
+		}
+		static float hmax(type v) noexcept
+		{
+			v = _mm_max_ps(v, _mm_movehl_ps(v, v));
+			return _mm_cvtss_f32(_mm_max_ss(v, _mm_movehdup_ps(v)));
+		}
+	};
+#endif // MATH_SIMD_LEVEL >= 1
+
+	/// @brief One float per "register". Used for loop tails and the scalar backend.
+	struct ScalarLanes
+	{
+		using type = float;
+		static constexpr size_t width = 1;
+
+		static type load(const float* p) noexcept { return *p; }
+		static void store(float* p, type v) noexcept { *p = v; }
+		static type set1(float v) noexcept { return v; }
+		static type add(type a, type b) noexcept { return a + b; }
+		static type sub(type a, type b) noexcept { return a - b; }
+		static type mul(type a, type b) noexcept { return a * b; }
+		static type div(type a, type b) noexcept { return a / b; }
+		static type madd(type a, type b, type c) noexcept { return a * b + c; }
+		static type min(type a, type b) noexcept { return (a > b) ? b : a; }
+		static type max(type a, type b) noexcept { return (a > b) ? a : b; }
+		static type sqrt(type a) noexcept { return std::sqrt(a); }
+		static type rsqrt_est(type a) noexcept
+		{
+#if MATH_SIMD_LEVEL >= 1
+			return _mm_cvtss_f32(_mm_rsqrt_ss(_mm_set_ss(a)));
+#else
+			return 1 / std::sqrt(a);
+#endif
+		}
+		static type round(type a) noexcept { return std::nearbyint(a); }
+		static type abs(type a) noexcept { return std::fabs(a); }
+		/// @brief a where cond != 0, otherwise b
+		static type select_nonzero(type cond, type a, type b) noexcept { return cond != 0 ? a : b; }
+		/// @brief x where a > b, otherwise y
+		static type select_gt(type a, type b, type x, type y) noexcept { return a > b ? x : y; }
+		static float hsum(type a) noexcept { return a; }
+		static float hmin(type a) noexcept { return a; }
+		static float hmax(type a) noexcept { return a; }
+	};
+
+#if MATH_SIMD_LEVEL >= 2
+	/// @brief 8 floats per register (AVX2)
+	struct WideLanes
+	{
+		using type = __m256;
+		static constexpr size_t width = 8;
+
+		static type load(const float* p) noexcept { return _mm256_loadu_ps(p); }
+		static void store(float* p, type v) noexcept { _mm256_storeu_ps(p, v); }
+		static type set1(float v) noexcept { return _mm256_set1_ps(v); }
+		static type add(type a, type b) noexcept { return _mm256_add_ps(a, b); }
+		static type sub(type a, type b) noexcept { return _mm256_sub_ps(a, b); }
+		static type mul(type a, type b) noexcept { return _mm256_mul_ps(a, b); }
+		static type div(type a, type b) noexcept { return _mm256_div_ps(a, b); }
+		static type madd(type a, type b, type c) noexcept { return _mm256_fmadd_ps(a, b, c); }
+		static type min(type a, type b) noexcept { return _mm256_min_ps(a, b); }
+		static type max(type a, type b) noexcept { return _mm256_max_ps(a, b); }
+		static type sqrt(type a) noexcept { return _mm256_sqrt_ps(a); }
+		/// @brief ~12 bit hardware estimate
+		static type rsqrt_est(type a) noexcept { return _mm256_rsqrt_ps(a); }
+		static type round(type a) noexcept { return _mm256_round_ps(a, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC); }
+		static type abs(type a) noexcept { return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a); }
+		static type select_nonzero(type cond, type a, type b) noexcept
+		{
+			return _mm256_blendv_ps(b, a, _mm256_cmp_ps(cond, _mm256_setzero_ps(), _CMP_NEQ_UQ));
+		}
+		/// @brief x where a > b, otherwise y
+		static type select_gt(type a, type b, type x, type y) noexcept
+		{
+			return _mm256_blendv_ps(y, x, _mm256_cmp_ps(a, b, _CMP_GT_OQ));
+		}
+		static float hsum(type a) noexcept
+		{
+			return WideLanes4::hsum(_mm_add_ps(_mm256_castps256_ps128(a), _mm256_extractf128_ps(a, 1)));
+		}
+		static float hmin(type a) noexcept
+		{
+			return WideLanes4::hmin(_mm_min_ps(_mm256_castps256_ps128(a), _mm256_extractf128_ps(a, 1)));
+		}
+		static float hmax(type a) noexcept
+		{
+			return WideLanes4::hmax(_mm_max_ps(_mm256_castps256_ps128(a), _mm256_extractf128_ps(a, 1)));
+		}
+	};
+#elif MATH_SIMD_LEVEL >= 1
+	using WideLanes = WideLanes4;
+#else
+	using WideLanes = ScalarLanes;
+#endif
+
+	/// @brief Run op(Lanes{}, i) over [0, n) with the widest lanes, then finish the tail one by one.
+	/// @param op Generic callable taking a lanes tag (WideLanes or ScalarLanes) and the start index
+	template <typename Op>
+	inline void for_each_lanes(size_t n, Op&& op) noexcept
+	{
+		const size_t wide = n - n % WideLanes::width;
+		for (size_t i = 0; i < wide; i += WideLanes::width)
+			op(WideLanes{}, i);
+		for (size_t i = wide; i < n; ++i)
+			op(ScalarLanes{}, i);
+	}
+}
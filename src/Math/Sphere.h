@@ -0,0 +1,69 @@
+#pragma once
+
+#include "AABB.h"
+
+/// @brief Bounding sphere. A negative radius marks an empty sphere.
+class Sphere
+{
+public:
+	constexpr Sphere() noexcept : center(), radius(-1) {}
+
+	constexpr Sphere(const vec3& center, float radius) noexcept : center(center), radius(radius) {}
+
+	constexpr Sphere(const Sphere&) noexcept = default;
+
+	/// @brief Circumscribed sphere of box
+	constexpr explicit Sphere(const AABB& box) noexcept :
+		center(box.center()), radius(box.empty() ? -1.0f : Mathf::sqrt(box.extents().length_squared())) {}
+
+	/// @brief Sphere around the bounds center of points[0, n). Not minimal, but within a factor of sqrt(3).
+	constexpr static Sphere from_points(const vec3* points, size_t n) noexcept
+	{
+		if (n == 0)
+			return Sphere();
+		const vec3 c = AABB::from_points(points, n).center();
+		float r2 = 0;
+		for (size_t i = 0; i < n; ++i)
+			r2 = Mathf::max(r2, (points[i] - c).length_squared());
+		return Sphere(c, Mathf::sqrt(r2));
+	}
+
+	constexpr bool operator==(const Sphere&) const noexcept = default;
+
+	constexpr bool empty() const noexcept { return radius < 0; }
+
+	constexpr bool contains(const vec3& p) const noexcept
+	{
+		return !empty() && (p - center).length_squared() <= radius * radius;
+	}
+
+	constexpr bool intersects(const Sphere& rhs) const noexcept
+	{
+		const float r = radius + rhs.radius;
+		return !empty() && !rhs.empty() && (rhs.center - center).length_squared() <= r * r;
+	}
+
+	constexpr bool intersects(const AABB& box) const noexcept
+	{
+		return !empty() && box.distance_squared(center) <= radius * radius;
+	}
+
+	/// @brief Box around the sphere
+	constexpr AABB bounds() const noexcept
+	{
+		return empty() ? AABB() : AABB::from_center_extents(center, vec3(radius));
+	}
+
+	/// @brief Sphere enclosing the transformed sphere. Non-uniform scale uses the largest axis.
+	constexpr Sphere transformed(const Affine3& m) const noexcept
+	{
+		if (empty())
+			return *this;
+		const mat3 l = m.get_linear();
+		const float s2 = Mathf::max(l.cols[0].length_squared(), l.cols[1].length_squared(), l.cols[2].length_squared());
+		return Sphere(m.transform_point(center), radius * Mathf::sqrt(s2));
+	}
+
+	vec3 center;
+	float radius;
+};
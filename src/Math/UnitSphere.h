@@ -0,0 +1,68 @@
+#pragma once
+
+#include "vec3.h"
+
+#include <array>
+#include <cstddef>
+
+/// @file UnitSphere.h
+/// @brief Latitude/longitude direction tables for procedural spheres.
+///
+/// A sphere of accuracy `ac` has `ac` latitude rings (poles excluded) of `2 * ac + 3`
+/// directions each; the first and last direction of a ring coincide so texture seams work.
+/// Rings run from the north pole (+y) southwards, each ring clockwise seen from above.
+
+/// @brief Segments around each ring of a sphere with the given accuracy, the `latitudes` of
+/// Mesh::NewSphere. A ring stores one more direction than this to close the seam.
+constexpr unsigned UnitSphereLatitudes(unsigned accuracy) noexcept
+{
+	return 2 * accuracy + 2;
+}
+
+/// @brief Number of directions in a table of the given accuracy
+constexpr size_t UnitSphereSize(unsigned accuracy) noexcept
+{
+	return static_cast<size_t>(accuracy) * (UnitSphereLatitudes(accuracy) + 1);
+}
+
+/// @brief Fill out[0, UnitSphereSize(accuracy)) with unit directions, ring major.
+template <MathPrecision P = MathPrecision::Accurate>
+constexpr void BuildUnitSphere(unsigned accuracy, vec3* out) noexcept
+{
+	const unsigned latitudes = UnitSphereLatitudes(accuracy);
+	const float arg = -Mathf::Pi * 2.0f / latitudes;
+	const float phi = Mathf::Pi / (accuracy + 1);
+	for (unsigned i = 0; i < accuracy; ++i)
+	{
+		vec2 vphi = vec2::unit<P>((i + 1) * phi);
+		for (unsigned j = 0; j <= latitudes; ++j)
+		{
+			vec2 theta = vec2::unit<P>(arg * j);
+			out[i * (latitudes + 1) + j] = vec3(vphi.y * theta.x, vphi.x, vphi.y * theta.y);
+		}
+	}
+}
+
+/// @brief Direction table evaluated at compile time.
+template <unsigned Accuracy>
+struct UnitSphere
+{
+	static constexpr std::array<vec3, UnitSphereSize(Accuracy)> directions = []() {
+		std::array<vec3, UnitSphereSize(Accuracy)> ret;
+		BuildUnitSphere(Accuracy, ret.data());
+		return ret;
+	}();
+};
+
+/// @brief Prebuilt table for one of the standard accuracies (8, 16, 32).
+/// @return nullptr for any other accuracy
+inline const vec3* FindUnitSphere(unsigned accuracy) noexcept
+{
+	switch (accuracy)
+	{
+	case 8: return UnitSphere<8>::directions.data();
+	case 16: return UnitSphere<16>::directions.data();
+	case 32: return UnitSphere<32>::directions.data();
+	default: return nullptr;
+	}
+}
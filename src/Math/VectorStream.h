@@ -0,0 +1,361 @@
+#pragma once
+
+#include "vec4.h"
+#include "BatchTransform.h"
+
+#include <cstddef>
+#include <memory>
+#include <new>
+
+/// @file VectorStream.h
+/// @brief Structure-of-arrays vector containers.
+/// Each component lives in its own lane (x[], y[], z[], ...) so bulk operations
+/// vectorize across elements. Lanes of an owning stream are 32-byte aligned.
+
+/// @brief Non-owning view over N planar float lanes.
+/// Can wrap any external SoA memory without copying.
+template <size_t N> requires (N == 3 || N == 4)
+class VecStreamView
+{
+public:
+	using vec_type = std::conditional_t<N == 3, vec3, vec4>;
+
+	constexpr VecStreamView() noexcept : lanes{}, count(0) {}
+
+	constexpr VecStreamView(float* x, float* y, float* z, size_t count) noexcept requires (N == 3) :
+		lanes{ x, y, z }, count(count) {}
+
+	constexpr VecStreamView(float* x, float* y, float* z, float* w, size_t count) noexcept requires (N == 4) :
+		lanes{ x, y, z, w }, count(count) {}
+
+	/// @brief View a block of N * count floats stored lane after lane (x[count], y[count], ...).
+	static constexpr VecStreamView planar(float* base, size_t count) noexcept
+	{
+		VecStreamView view;
+		for (size_t c = 0; c < N; ++c)
+			view.lanes[c] = base + c * count;
+		view.count = count;
+		return view;
+	}
+
+	constexpr size_t size() const noexcept { return count; }
+
+	vec_type get(size_t i) const noexcept
+	{
+		if constexpr (N == 3)
+			return vec3(lanes[0][i], lanes[1][i], lanes[2][i]);
+		else
+			return vec4(lanes[0][i], lanes[1][i], lanes[2][i], lanes[3][i]);
+	}
+
+	void set(size_t i, const vec_type& v) noexcept
+	{
+		lanes[0][i] = v.x;
+		lanes[1][i] = v.y;
+		lanes[2][i] = v.z;
+		if constexpr (N == 4)
+			lanes[3][i] = v.w;
+	}
+
+	/// @brief Deinterleave count AoS vectors into this view. count must not exceed size().
+	void load(const vec_type* src, size_t n) noexcept
+	{
+		size_t i = 0;
+#if MATH_SIMD_LEVEL >= 1
+		if constexpr (N == 3)
+		{
+			for (; i + 4 <= n; i += 4)
+			{
+				__m128 x, y, z;
+				simd::vec3x4_load(&src[i].x, x, y, z);
+				_mm_storeu_ps(lanes[0] + i, x);
+				_mm_storeu_ps(lanes[1] + i, y);
+				_mm_storeu_ps(lanes[2] + i, z);
+			}
+		}
+		else
+		{
+			for (; i + 4 <= n; i += 4)
+			{
+				__m128 x = _mm_loadu_ps(&src[i].x);
+				__m128 y = _mm_loadu_ps(&src[i + 1].x);
+				__m128 z = _mm_loadu_ps(&src[i + 2].x);
+				__m128 w = _mm_loadu_ps(&src[i + 3].x);
+				_MM_TRANSPOSE4_PS(x, y, z, w);
+				_mm_storeu_ps(lanes[0] + i, x);
+				_mm_storeu_ps(lanes[1] + i, y);
+				_mm_storeu_ps(lanes[2] + i, z);
+				_mm_storeu_ps(lanes[3] + i, w);
+			}
+		}
+#endif
+		for (; i < n; ++i)
+			set(i, src[i]);
+	}
+
+	/// @brief Interleave the view back into size() AoS vectors.
+	void store(vec_type* dst) const noexcept
+	{
+		size_t i = 0;
+#if MATH_SIMD_LEVEL >= 1
+		if constexpr (N == 3)
+		{
+			for (; i + 4 <= count; i += 4)
+				simd::vec3x4_store(&dst[i].x,
+					_mm_loadu_ps(lanes[0] + i), _mm_loadu_ps(lanes[1] + i), _mm_loadu_ps(lanes[2] + i));
+		}
+		else
+		{
+			for (; i + 4 <= count; i += 4)
+			{
+				__m128 x = _mm_loadu_ps(lanes[0] + i);
+				__m128 y = _mm_loadu_ps(lanes[1] + i);
+				__m128 z = _mm_loadu_ps(lanes[2] + i);
+				__m128 w = _mm_loadu_ps(lanes[3] + i);
+				_MM_TRANSPOSE4_PS(x, y, z, w);
+				_mm_storeu_ps(&dst[i].x, x);
+				_mm_storeu_ps(&dst[i + 1].x, y);
+				_mm_storeu_ps(&dst[i + 2].x, z);
+				_mm_storeu_ps(&dst[i + 3].x, w);
+			}
+		}
+#endif
+		for (; i < count; ++i)
+			dst[i] = get(i);
+	}
+
+	/// @brief out[i] = dot(this[i], rhs[i])
+	void dot_product(const VecStreamView& rhs, float* out) const noexcept
+	{
+		simd::for_each_lanes(count, [&](auto lanes_tag, size_t i) {
+			using L = decltype(lanes_tag);
+			auto r = L::mul(L::load(lanes[0] + i), L::load(rhs.lanes[0] + i));
+			for (size_t c = 1; c < N; ++c)
+				r = L::madd(L::load(lanes[c] + i), L::load(rhs.lanes[c] + i), r);
+			L::store(out + i, r);
+		});
+	}
+
+	/// @brief out[i] = cross(this[i], rhs[i]). out may alias either operand.
+	void cross_product(const VecStreamView& rhs, const VecStreamView& out) const noexcept requires (N == 3)
+	{
+		simd::for_each_lanes(count, [&](auto lanes_tag, size_t i) {
+			using L = decltype(lanes_tag);
+			auto ax = L::load(lanes[0] + i), ay = L::load(lanes[1] + i), az = L::load(lanes[2] + i);
+			auto bx = L::load(rhs.lanes[0] + i), by = L::load(rhs.lanes[1] + i), bz = L::load(rhs.lanes[2] + i);
+			L::store(out.lanes[0] + i, L::sub(L::mul(ay, bz), L::mul(az, by)));
+			L::store(out.lanes[1] + i, L::sub(L::mul(az, bx), L::mul(ax, bz)));
+			L::store(out.lanes[2] + i, L::sub(L::mul(ax, by), L::mul(ay, bx)));
+		});
+	}
+
+	/// @brief out[i] = this[i] / length(this[i]). Zero vectors stay zero. out may alias this.
+	void normalized(const VecStreamView& out) const noexcept
+	{
+		simd::for_each_lanes(count, [&](auto lanes_tag, size_t i) {
+			using L = decltype(lanes_tag);
+			typename L::type v[N];
+			for (size_t c = 0; c < N; ++c)
+				v[c] = L::load(lanes[c] + i);
+			auto ls = L::mul(v[0], v[0]);
+			for (size_t c = 1; c < N; ++c)
+				ls = L::madd(v[c], v[c], ls);
+			auto rl = L::select_nonzero(ls, L::div(L::set1(1.0f), L::sqrt(ls)), L::set1(1.0f));
+			for (size_t c = 0; c < N; ++c)
+				L::store(out.lanes[c] + i, L::mul(v[c], rl));
+		});
+	}
+
+	void normalize() const noexcept { normalized(*this); }
+
+	/// @brief out[i] = lerp(this[i], rhs[i], t)
+	void lerp(const VecStreamView& rhs, float t, const VecStreamView& out) const noexcept
+	{
+		for (size_t c = 0; c < N; ++c)
+		{
+			const float* a = lanes[c];
+			const float* b = rhs.lanes[c];
+			float* r = out.lanes[c];
+			simd::for_each_lanes(count, [&](auto lanes_tag, size_t i) {
+				using L = decltype(lanes_tag);
+				auto va = L::load(a + i);
+				L::store(r + i, L::madd(L::sub(L::load(b + i), va), L::set1(t), va));
+			});
+		}
+	}
+
+	/// @brief Component-wise out[i] = min(this[i], rhs[i])
+	void min(const VecStreamView& rhs, const VecStreamView& out) const noexcept
+	{
+		for (size_t c = 0; c < N; ++c)
+		{
+			const float* a = lanes[c];
+			const float* b = rhs.lanes[c];
+			float* r = out.lanes[c];
+			simd::for_each_lanes(count, [&](auto lanes_tag, size_t i) {
+				using L = decltype(lanes_tag);
+				L::store(r + i, L::min(L::load(a + i), L::load(b + i)));
+			});
+		}
+	}
+
+	/// @brief Component-wise out[i] = max(this[i], rhs[i])
+	void max(const VecStreamView& rhs, const VecStreamView& out) const noexcept
+	{
+		for (size_t c = 0; c < N; ++c)
+		{
+			const float* a = lanes[c];
+			const float* b = rhs.lanes[c];
+			float* r = out.lanes[c];
+			simd::for_each_lanes(count, [&](auto lanes_tag, size_t i) {
+				using L = decltype(lanes_tag);
+				L::store(r + i, L::max(L::load(a + i), L::load(b + i)));
+			});
+		}
+	}
+
+	/// @brief Sum of all elements
+	vec_type sum() const noexcept
+	{
+		vec_type ret;
+		for (size_t c = 0; c < N; ++c)
+			(&ret.x)[c] = reduce_lane<0>(lanes[c]);
+		return ret;
+	}
+
+	/// @brief Component-wise minimum of all elements. Empty view returns +max float.
+	vec_type min_element() const noexcept
+	{
+		vec_type ret;
+		for (size_t c = 0; c < N; ++c)
+			(&ret.x)[c] = reduce_lane<1>(lanes[c]);
+		return ret;
+	}
+
+	/// @brief Component-wise maximum of all elements. Empty view returns -max float.
+	vec_type max_element() const noexcept
+	{
+		vec_type ret;
+		for (size_t c = 0; c < N; ++c)
+			(&ret.x)[c] = reduce_lane<2>(lanes[c]);
+		return ret;
+	}
+
+	float* lanes[N];
+	size_t count;
+
+private:
+	/// @tparam Op 0 = sum, 1 = min, 2 = max
+	template <int Op>
+	float reduce_lane(const float* p) const noexcept
+	{
+		using W = simd::WideLanes;
+		constexpr float init = (Op == 0) ? 0.0f :
+			(Op == 1) ? std::numeric_limits<float>::max() : -std::numeric_limits<float>::max();
+		auto acc = W::set1(init);
+		size_t i = 0;
+		for (; i + W::width <= count; i += W::width)
+		{
+			if constexpr (Op == 0)
+				acc = W::add(acc, W::load(p + i));
+			else if constexpr (Op == 1)
+				acc = W::min(acc, W::load(p + i));
+			else
+				acc = W::max(acc, W::load(p + i));
+		}
+		float r = (Op == 0) ? W::hsum(acc) : (Op == 1) ? W::hmin(acc) : W::hmax(acc);
+		for (; i < count; ++i)
+		{
+			if constexpr (Op == 0)
+				r += p[i];
+			else if constexpr (Op == 1)
+				r = Mathf::min(r, p[i]);
+			else
+				r = Mathf::max(r, p[i]);
+		}
+		return r;
+	}
+};
+
+/// @brief Owning SoA container of N-component vectors with 32-byte aligned lanes.
+template <size_t N> requires (N == 3 || N == 4)
+class VecStream
+{
+public:
+	using vec_type = typename VecStreamView<N>::vec_type;
+	using view_type = VecStreamView<N>;
+
+	static constexpr size_t alignment = 32;
+
+	explicit VecStream(size_t count = 0) : m_Count(0), m_Stride(0)
+	{
+		resize(count);
+	}
+
+	VecStream(const vec_type* src, size_t count) : VecStream(count)
+	{
+		m_View.load(src, count);
+	}
+
+	VecStream(const VecStream&) = delete;
+
+	VecStream& operator=(const VecStream&) = delete;
+
+	VecStream(VecStream&&) noexcept = default;
+
+	VecStream& operator=(VecStream&&) noexcept = default;
+
+	size_t size() const noexcept { return m_Count; }
+
+	/// @brief Reallocate for count elements. Existing content is not preserved.
+	void resize(size_t count)
+	{
+		// Round every lane up to a multiple of 8 floats so each lane starts 32-byte aligned
+		m_Stride = (count + 7) & ~size_t(7);
+		m_Count = count;
+		m_pData.reset(m_Stride ?
+			static_cast<float*>(::operator new[](m_Stride * N * sizeof(float), std::align_val_t(alignment))) :
+			nullptr);
+		m_View = view_type::planar(m_pData.get(), m_Stride);
+		m_View.count = count;
+	}
+
+	float* lane(size_t c) noexcept { return m_View.lanes[c]; }
+
+	const float* lane(size_t c) const noexcept { return m_View.lanes[c]; }
+
+	view_type view() noexcept { return m_View; }
+
+	vec_type operator[](size_t i) const noexcept { return m_View.get(i); }
+
+	void set(size_t i, const vec_type& v) noexcept { m_View.set(i, v); }
+
+	void load(const vec_type* src) noexcept { m_View.load(src, m_Count); }
+
+	void store(vec_type* dst) const noexcept { m_View.store(dst); }
+
+	vec_type sum() const noexcept { return m_View.sum(); }
+
+	vec_type min_element() const noexcept { return m_View.min_element(); }
+
+	vec_type max_element() const noexcept { return m_View.max_element(); }
+
+private:
+	struct AlignedDelete
+	{
+		void operator()(float* p) const noexcept
+		{
+			::operator delete[](p, std::align_val_t(alignment));
+		}
+	};
+
+	std::unique_ptr<float[], AlignedDelete> m_pData;
+	view_type m_View;
+	size_t m_Count;
+	size_t m_Stride;
+};
+
+using Vec3Stream = VecStream<3>;
+using Vec4Stream = VecStream<4>;
+using Vec3View = VecStreamView<3>;
+using Vec4View = VecStreamView<4>;
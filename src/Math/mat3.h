@@ -28,22 +28,23 @@ public:
 		cols[2] = col2;
 	}
 
+	/// @brief Rotation matrix of a unit quaternion: mat3(q) * p == q.rotate(p), mat3(a * b) == mat3(a) * mat3(b)
 	constexpr explicit mat3(const Quaternion& quat) noexcept
 	{
 		auto [x, y, z, w] = vec4(quat);
 		cols[0] = vec3(
 			1 - 2 * (y * y + z * z),
-			2 * (x * y - z * w),
-			2 * (x + z + y * w)
+			2 * (x * y + z * w),
+			2 * (x * z - y * w)
 		);
 		cols[1] = vec3(
-			2 * (x * y + z * w),
+			2 * (x * y - z * w),
 			1 - 2 * (x * x + z * z),
-			2 * (y * z - x * w)
+			2 * (y * z + x * w)
 		);
 		cols[2] = vec3(
-			2 * (x * z - y * w),
-			2 * (y * z + x * w),
+			2 * (x * z + y * w),
+			2 * (y * z - x * w),
 			1 - 2 * (x * x + y * y)
 		);
 	}
@@ -126,6 +127,14 @@ public:
 
 	constexpr mat3 operator*(const mat3& rhs) const noexcept
 	{
+#if MATH_SIMD_LEVEL >= 1
+		if (!std::is_constant_evaluated())
+		{
+			mat3 ret;
+			simd::mat3_mul(&cols[0].x, &rhs.cols[0].x, &ret.cols[0].x);
+			return ret;
+		}
+#endif
 		return mat3(
 			operator*(rhs.cols[0]),
 			operator*(rhs.cols[1]),
@@ -135,6 +144,14 @@ public:
 
 	constexpr vec3 operator*(const vec3& v) const noexcept
 	{
+#if MATH_SIMD_LEVEL >= 1
+		if (!std::is_constant_evaluated())
+		{
+			vec3 ret;
+			simd::mat3_mul_vec3(&cols[0].x, &v.x, &ret.x);
+			return ret;
+		}
+#endif
 		return vec3(
 			cols[0].x * v.x + cols[1].x * v.y + cols[2].x * v.z,
 			cols[0].y * v.x + cols[1].y * v.y + cols[2].y * v.z,
@@ -4,7 +4,8 @@
 #include "mat3.h"
 
 /// @brief 4x4 matrix
-class mat4
+/// @note Storage is 16-byte aligned so the SIMD backend can use aligned loads.
+class alignas(16) mat4
 {
 public:
 	constexpr mat4() noexcept
@@ -44,9 +45,9 @@ public:
 	constexpr mat4(const vec3& position, const vec3& scales, const Quaternion& rotation) noexcept
 	{
 		mat3 rot = mat3(rotation);
-		cols[0] * vec4(rot.cols[0] * scales, 0);
-		cols[1] * vec4(rot.cols[1] * scales, 0);
-		cols[2] * vec4(rot.cols[2] * scales, 0);
+		cols[0] = vec4(rot.cols[0] * scales, 0);
+		cols[1] = vec4(rot.cols[1] * scales, 0);
+		cols[2] = vec4(rot.cols[2] * scales, 0);
 		cols[3] = vec4(position, 1);
 	}
 
@@ -159,6 +160,14 @@ public:
 
 	constexpr mat4 operator*(const mat4& rhs) const noexcept
 	{
+#if MATH_SIMD_LEVEL >= 1
+		if (!std::is_constant_evaluated())
+		{
+			mat4 ret;
+			simd::mat4_mul(cols[0], rhs.cols[0], ret.cols[0]);
+			return ret;
+		}
+#endif
 		return mat4(
 			operator*(rhs.cols[0]),
 			operator*(rhs.cols[1]),
@@ -169,6 +178,14 @@ public:
 
 	constexpr vec4 operator*(const vec4& v) const noexcept
 	{
+#if MATH_SIMD_LEVEL >= 1
+		if (!std::is_constant_evaluated())
+		{
+			vec4 ret;
+			simd::mat4_mul_vec4(cols[0], v, ret);
+			return ret;
+		}
+#endif
 		return vec4(
 			cols[0].x * v.x + cols[1].x * v.y + cols[2].x * v.z + cols[3].x * v.w,
 			cols[0].y * v.x + cols[1].y * v.y + cols[2].y * v.z + cols[3].y * v.w,
@@ -199,6 +216,14 @@ public:
 
 	constexpr mat4 transposed() const noexcept
 	{
+#if MATH_SIMD_LEVEL >= 1
+		if (!std::is_constant_evaluated())
+		{
+			mat4 ret;
+			simd::mat4_transpose(cols[0], ret.cols[0]);
+			return ret;
+		}
+#endif
 		return mat4(
 			vec4(cols[0].x, cols[1].x, cols[2].x, cols[3].x),
 			vec4(cols[0].y, cols[1].y, cols[2].y, cols[3].y),
@@ -219,6 +244,14 @@ public:
 
 	constexpr mat4 inverse() const noexcept
 	{
+#if MATH_SIMD_LEVEL >= 1
+		if (!std::is_constant_evaluated())
+		{
+			mat4 ret;
+			simd::mat4_inverse(cols[0], ret.cols[0]);
+			return ret;
+		}
+#endif
 		mat2 A = mat2(cols[0].x, cols[0].y, cols[1].x, cols[1].y).inverse();
 		mat2 B = mat2(cols[2].x, cols[2].y, cols[3].x, cols[3].y);
 		mat2 C = mat2(cols[0].z, cols[0].w, cols[1].z, cols[1].w);
@@ -313,9 +346,7 @@ public:
 	static mat4 random() noexcept
 	{
 		mat4 ret;
-		float* addr = &ret.cols[0].x;
-		for (size_t i = 0; i < 16; ++i)
-			*(addr + i) = Mathf::random();
+		Mathf::random_engine().fill(&ret.cols[0].x, 16);
 		return ret;
 	}
 
@@ -21,7 +21,8 @@ public:
 	constexpr static vec2 left() noexcept { return vec2(-1, 0); }
 	constexpr static vec2 down() noexcept { return vec2(0, -1); }
 
-	static vec2 unit(float rad) noexcept { return vec2(Mathf::cos(rad), Mathf::sin(rad)); }
+	template <MathPrecision P = MathPrecision::Accurate>
+	constexpr static vec2 unit(float rad) noexcept { return vec2(Mathf::cos<P>(rad), Mathf::sin<P>(rad)); }
 
 	constexpr bool operator==(const vec2& rhs) const noexcept { return x == rhs.x && y == rhs.y; }
 
@@ -74,20 +75,23 @@ public:
 	constexpr float manhatten() const noexcept { return Mathf::abs(x) + Mathf::abs(y); }
 	constexpr float length_squared() const noexcept { return dot_product(*this); }
 	float length() const noexcept { return Mathf::sqrt(length_squared()); }
-	float rlength() const noexcept { return Mathf::rsqrt(length_squared()); }
+	template <MathPrecision P = MathPrecision::Accurate>
+	float rlength() const noexcept { return Mathf::rsqrt<P>(length_squared()); }
 
+	template <MathPrecision P = MathPrecision::Accurate>
 	vec2 normalized() const noexcept
 	{
 		vec2 ret = *this;
 		if (!eqzero())
-			ret *= rlength();
+			ret *= rlength<P>();
 		return ret;
 	}
 
+	template <MathPrecision P = MathPrecision::Accurate>
 	void normalize() noexcept
 	{
 		if (!eqzero())
-			*this *= rlength();
+			*this *= rlength<P>();
 	}
 
 	float argz() const noexcept { return Mathf::atan2(y, x); }
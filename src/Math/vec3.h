@@ -175,20 +175,23 @@ public:
 
 	constexpr float length_squared() const noexcept { return dot_product(*this); }
 	float length() const noexcept { return Mathf::sqrt(length_squared()); }
-	float rlength() const noexcept { return Mathf::rsqrt(length_squared()); }
+	template <MathPrecision P = MathPrecision::Accurate>
+	float rlength() const noexcept { return Mathf::rsqrt<P>(length_squared()); }
 	
+	template <MathPrecision P = MathPrecision::Accurate>
 	vec3 normalized() const noexcept
 	{
 		vec3 ret = *this;
 		if (!eqzero())
-			ret *= rlength();
+			ret *= rlength<P>();
 		return ret;
 	}
 
+	template <MathPrecision P = MathPrecision::Accurate>
 	void normalize() noexcept
 	{
 		if (!eqzero())
-			*this *= rlength();
+			*this *= rlength<P>();
 	}
 
 	float arg(const vec3& rhs) const noexcept
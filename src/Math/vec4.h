@@ -3,6 +3,7 @@
 #include "Mathf.h"
 
 #include "vec3.h"
+#include "SIMD.h"
 
 #include <tuple>
 
@@ -175,6 +176,10 @@ public:
 
 	constexpr float dot_product(const vec4& rhs) const noexcept
 	{
+#if MATH_SIMD_LEVEL >= 1
+		if (!std::is_constant_evaluated())
+			return simd::vec4_dot(&x, &rhs.x);
+#endif
 		vec4 mul = operator*(rhs);
 		return mul.x + mul.y + mul.z + mul.w;
 	}
@@ -211,9 +216,9 @@ public:
 
 	static vec4 random() noexcept
 	{
-		return vec4(
-			Mathf::random(), Mathf::random(), Mathf::random(), Mathf::random()
-		);
+		vec4 ret;
+		Mathf::random_engine().fill(&ret.x, 4);
+		return ret;
 	}
 
 	template <size_t idx> requires (idx < 4)
@@ -21,6 +21,14 @@ class Image
 public:
 	Image(const AnsiString& filepath);
 
+	/// @brief Zero filled image, e.g. to fill procedurally
+	Image(int width, int height, ImageFormat format = ImageFormat::RGBA8) :
+		m_szData(size_t(width) * height * (static_cast<int>(format) >> 8) * (static_cast<int>(format) & 0xFF) / 8),
+		m_Format(format), m_Width(width), m_Height(height)
+	{
+		m_pData = MakeUnique<uint8_t[]>(m_szData);
+	}
+
 	Image(const Image&) = delete;
 
 	Image& operator=(const Image&) = delete;
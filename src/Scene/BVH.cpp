@@ -0,0 +1,563 @@
+#include "BVH.h"
+#include "Node.h"
+#include "Transform.h"
+#include "TransformSystem.h"
+
+#include "../Math/BatchCulling.h"
+
+#include <algorithm>
+#include <cassert>
+
+namespace
+{
+	/// @brief Centroid bins per axis of the SAH build
+	constexpr int BinCount = 16;
+
+	/// @brief Moved leaves, as a share of all leaves, above which Refit() recomputes the whole tree
+	constexpr size_t RefitAllRatio = 4;
+
+	AABB Union(const AABB& a, const AABB& b) noexcept
+	{
+		return AABB(a).merge(b);
+	}
+
+	float Axis(const vec3& v, int axis) noexcept
+	{
+		return axis == 0 ? v.x : axis == 1 ? v.y : v.z;
+	}
+}
+
+uint32_t BVH::Insert(Node* node, const AABB& localBounds)
+{
+	assert(node != nullptr && !localBounds.empty());
+	const uint32_t leaf = AllocateNode();
+	TreeNode& n = m_Nodes[leaf];
+	n.children[0] = n.children[1] = InvalidProxy;
+	n.height = 0;
+	n.node = node;
+	n.local = localBounds;
+	n.bounds = AABB();
+	UpdateWorldBounds(leaf);
+	InsertLeaf(leaf);
+	++m_ProxyCount;
+
+	SyncEntries();
+	const uint32_t entry = node->GetTransform()->GetIndex();
+	if (entry >= m_EntryProxies.size())
+		m_EntryProxies.resize(entry + 1, InvalidProxy);
+	m_EntryProxies[entry] = leaf;
+	return leaf;
+}
+
+void BVH::Remove(uint32_t proxy)
+{
+	SyncEntries();
+	const uint32_t entry = m_Nodes[proxy].node->GetTransform()->GetIndex();
+	if (entry < m_EntryProxies.size() && m_EntryProxies[entry] == proxy)
+		m_EntryProxies[entry] = InvalidProxy;
+	RemoveLeaf(proxy);
+	FreeNode(proxy);
+	--m_ProxyCount;
+}
+
+void BVH::SetLocalBounds(uint32_t proxy, const AABB& localBounds)
+{
+	assert(!localBounds.empty());
+	m_Nodes[proxy].local = localBounds;
+	if (UpdateWorldBounds(proxy) && m_Nodes[proxy].parent != InvalidProxy)
+		RefitUpwards(m_Nodes[proxy].parent);
+}
+
+uint32_t BVH::GetProxy(const Node* node) const
+{
+	SyncEntries();
+	const uint32_t entry = node->GetTransform()->GetIndex();
+	return entry < m_EntryProxies.size() ? m_EntryProxies[entry] : InvalidProxy;
+}
+
+uint32_t BVH::GetHeight() const noexcept
+{
+	return m_Root != InvalidProxy ? m_Nodes[m_Root].height : 0;
+}
+
+float BVH::GetCost() const noexcept
+{
+	if (m_Root == InvalidProxy || IsLeaf(m_Root))
+		return 0;
+	float area = 0;
+	for (const TreeNode& n : m_Nodes)
+	{
+		if (n.height != FreeHeight && n.children[0] != InvalidProxy)
+			area += n.bounds.surface_area();
+	}
+	return area / m_Nodes[m_Root].bounds.surface_area();
+}
+
+void BVH::Refit()
+{
+	SyncEntries();
+	m_Moved.clear();
+	for (uint32_t entry : TransformSystem::GetSingleton()->GetChangedEntries())
+	{
+		const uint32_t proxy = entry < m_EntryProxies.size() ? m_EntryProxies[entry] : InvalidProxy;
+		if (proxy != InvalidProxy && UpdateWorldBounds(proxy))
+			m_Moved.push_back(proxy);
+	}
+	if (m_Moved.size() * RefitAllRatio > m_ProxyCount)
+	{
+		RefitAll();
+		return;
+	}
+	for (uint32_t proxy : m_Moved)
+	{
+		if (m_Nodes[proxy].parent != InvalidProxy)
+			RefitUpwards(m_Nodes[proxy].parent);
+	}
+}
+
+void BVH::Build()
+{
+	Array<uint32_t> leaves;
+	leaves.reserve(m_ProxyCount);
+	for (uint32_t i = 0; i < m_Nodes.size(); ++i)
+	{
+		if (m_Nodes[i].node != nullptr)
+			leaves.push_back(i);
+		else if (m_Nodes[i].height != FreeHeight)
+			FreeNode(i);
+	}
+	m_Root = InvalidProxy;
+	if (leaves.empty())
+		return;
+	m_Nodes.reserve(leaves.size() * 2);
+	m_Root = BuildRange(leaves.data(), leaves.size());
+	m_Nodes[m_Root].parent = InvalidProxy;
+}
+
+void BVH::Query(const Frustum& frustum, Array<Node*>& out) const
+{
+	if (m_Root == InvalidProxy)
+		return;
+	m_Stack.clear();
+	m_Candidates.clear();
+	if (IsLeaf(m_Root))
+		m_Candidates.push_back(m_Root);
+	else
+		m_Stack.push_back(m_Root);
+	while (!m_Stack.empty())
+	{
+		const uint32_t index = m_Stack.back();
+		m_Stack.pop_back();
+		const Containment containment = frustum.classify(m_Nodes[index].bounds);
+		if (containment == Containment::Outside)
+			continue;
+		if (containment == Containment::Inside)
+		{
+			// Everything below is visible, collect the leaves without testing them
+			const size_t mark = m_Stack.size();
+			m_Stack.push_back(index);
+			while (m_Stack.size() > mark)
+			{
+				const TreeNode& n = m_Nodes[m_Stack.back()];
+				m_Stack.pop_back();
+				if (n.node != nullptr)
+					out.push_back(n.node);
+				else
+					m_Stack.insert(m_Stack.end(), n.children, n.children + 2);
+			}
+			continue;
+		}
+		for (uint32_t child : m_Nodes[index].children)
+			(IsLeaf(child) ? m_Candidates : m_Stack).push_back(child);
+	}
+	FlushCandidates(out, [&](const AABBSoA& boxes, uint32_t* hits, size_t n) {
+		return CullAABBs(frustum, boxes, hits, n);
+	});
+}
+
+void BVH::Query(const Sphere& sphere, Array<Node*>& out) const
+{
+	if (m_Root == InvalidProxy || sphere.empty())
+		return;
+	m_Stack.clear();
+	m_Candidates.clear();
+	if (IsLeaf(m_Root))
+		m_Candidates.push_back(m_Root);
+	else
+		m_Stack.push_back(m_Root);
+	while (!m_Stack.empty())
+	{
+		const uint32_t index = m_Stack.back();
+		m_Stack.pop_back();
+		if (!sphere.intersects(m_Nodes[index].bounds))
+			continue;
+		for (uint32_t child : m_Nodes[index].children)
+			(IsLeaf(child) ? m_Candidates : m_Stack).push_back(child);
+	}
+	FlushCandidates(out, [&](const AABBSoA& boxes, uint32_t* hits, size_t n) {
+		return OverlapAABBs(sphere, boxes, hits, n);
+	});
+}
+
+BVH::RayHit BVH::Raycast(const Ray& ray, float maxDistance) const
+{
+	RayHit hit;
+	hit.distance = maxDistance;
+	float t;
+	if (m_Root == InvalidProxy || !ray.intersects(m_Nodes[m_Root].bounds, t, maxDistance))
+		return hit;
+	m_RayStack.clear();
+	m_RayStack.emplace_back(m_Root, t);
+	while (!m_RayStack.empty())
+	{
+		const auto [index, entry] = m_RayStack.back();
+		m_RayStack.pop_back();
+		// A closer hit may have been found since this node was pushed
+		if (entry > hit.distance)
+			continue;
+		const TreeNode& n = m_Nodes[index];
+		if (n.node != nullptr)
+		{
+			if (ray.intersects(n.tight, t, hit.distance) && (hit.node == nullptr || t < hit.distance))
+			{
+				hit.node = n.node;
+				hit.distance = t;
+			}
+			continue;
+		}
+		// Visit the nearer child first
+		float t0, t1;
+		const bool hit0 = ray.intersects(m_Nodes[n.children[0]].bounds, t0, hit.distance);
+		const bool hit1 = ray.intersects(m_Nodes[n.children[1]].bounds, t1, hit.distance);
+		if (hit0 && hit1 && t0 < t1)
+		{
+			m_RayStack.emplace_back(n.children[1], t1);
+			m_RayStack.emplace_back(n.children[0], t0);
+		}
+		else
+		{
+			if (hit0)
+				m_RayStack.emplace_back(n.children[0], t0);
+			if (hit1)
+				m_RayStack.emplace_back(n.children[1], t1);
+		}
+	}
+	if (hit.node == nullptr)
+		hit.distance = std::numeric_limits<float>::infinity();
+	return hit;
+}
+
+void BVH::Raycast(const Ray* rays, RayHit* hits, size_t count) const
+{
+	for (size_t i = 0; i < count; ++i)
+		hits[i] = Raycast(rays[i]);
+}
+
+uint32_t BVH::AllocateNode()
+{
+	if (m_FreeList == InvalidProxy)
+	{
+		m_Nodes.emplace_back();
+		m_Nodes.back().parent = InvalidProxy;
+		return static_cast<uint32_t>(m_Nodes.size() - 1);
+	}
+	const uint32_t index = m_FreeList;
+	m_FreeList = m_Nodes[index].parent;
+	m_Nodes[index].parent = InvalidProxy;
+	return index;
+}
+
+void BVH::FreeNode(uint32_t index) noexcept
+{
+	TreeNode& n = m_Nodes[index];
+	n.parent = m_FreeList;
+	n.children[0] = n.children[1] = InvalidProxy;
+	n.height = FreeHeight;
+	n.node = nullptr;
+	m_FreeList = index;
+}
+
+void BVH::InsertLeaf(uint32_t leaf)
+{
+	if (m_Root == InvalidProxy)
+	{
+		m_Root = leaf;
+		m_Nodes[leaf].parent = InvalidProxy;
+		return;
+	}
+
+	// Descend while a child is a cheaper sibling than the current node, counting the area
+	// growth of every ancestor the new leaf would enlarge
+	const AABB box = m_Nodes[leaf].bounds;
+	uint32_t index = m_Root;
+	while (!IsLeaf(index))
+	{
+		const TreeNode& n = m_Nodes[index];
+		const float area = n.bounds.surface_area();
+		const float combined = Union(n.bounds, box).surface_area();
+		const float cost = 2 * combined;
+		const float inheritance = 2 * (combined - area);
+		auto descend = [&](uint32_t child) {
+			const AABB& bounds = m_Nodes[child].bounds;
+			const float merged = Union(bounds, box).surface_area();
+			return (IsLeaf(child) ? merged : merged - bounds.surface_area()) + inheritance;
+		};
+		const float cost0 = descend(n.children[0]);
+		const float cost1 = descend(n.children[1]);
+		if (cost < cost0 && cost < cost1)
+			break;
+		index = cost0 < cost1 ? n.children[0] : n.children[1];
+	}
+
+	const uint32_t sibling = index;
+	const uint32_t oldParent = m_Nodes[sibling].parent;
+	const uint32_t parent = AllocateNode();
+	TreeNode& p = m_Nodes[parent];
+	p.parent = oldParent;
+	p.children[0] = sibling;
+	p.children[1] = leaf;
+	p.node = nullptr;
+	m_Nodes[sibling].parent = parent;
+	m_Nodes[leaf].parent = parent;
+	if (oldParent == InvalidProxy)
+		m_Root = parent;
+	else
+	{
+		uint32_t* children = m_Nodes[oldParent].children;
+		children[children[0] == sibling ? 0 : 1] = parent;
+	}
+	RefitUpwards(parent);
+}
+
+void BVH::RemoveLeaf(uint32_t leaf) noexcept
+{
+	if (leaf == m_Root)
+	{
+		m_Root = InvalidProxy;
+		return;
+	}
+	const uint32_t parent = m_Nodes[leaf].parent;
+	const uint32_t grandParent = m_Nodes[parent].parent;
+	const uint32_t* children = m_Nodes[parent].children;
+	const uint32_t sibling = children[0] == leaf ? children[1] : children[0];
+	m_Nodes[sibling].parent = grandParent;
+	FreeNode(parent);
+	if (grandParent == InvalidProxy)
+	{
+		m_Root = sibling;
+		return;
+	}
+	uint32_t* grandChildren = m_Nodes[grandParent].children;
+	grandChildren[grandChildren[0] == parent ? 0 : 1] = sibling;
+	RefitUpwards(grandParent);
+}
+
+void BVH::RefitUpwards(uint32_t index) noexcept
+{
+	while (index != InvalidProxy)
+	{
+		UpdateInner(index);
+		Rotate(index);
+		index = m_Nodes[index].parent;
+	}
+}
+
+void BVH::Rotate(uint32_t index) noexcept
+{
+	const uint32_t b = m_Nodes[index].children[0];
+	const uint32_t c = m_Nodes[index].children[1];
+	// Candidate swaps of a child of index with a child of its sibling, scored by how much the
+	// sibling shrinks. Bounds of index itself do not change.
+	uint32_t bestOwner = InvalidProxy, bestSlot = 0, bestChild = 0;
+	float bestGain = 0;
+	auto consider = [&](uint32_t child, uint32_t sibling, int childSlot) {
+		if (IsLeaf(sibling))
+			return;
+		const TreeNode& s = m_Nodes[sibling];
+		const float area = s.bounds.surface_area();
+		for (uint32_t slot = 0; slot < 2; ++slot)
+		{
+			// child takes the place of s.children[slot], the other grandchild stays
+			const float gain = area - Union(m_Nodes[child].bounds, m_Nodes[s.children[slot ^ 1]].bounds).surface_area();
+			if (gain > bestGain)
+			{
+				bestGain = gain;
+				bestOwner = sibling;
+				bestSlot = slot;
+				bestChild = childSlot;
+			}
+		}
+	};
+	consider(b, c, 0);
+	consider(c, b, 1);
+	if (bestOwner == InvalidProxy)
+		return;
+
+	uint32_t& child = m_Nodes[index].children[bestChild];
+	uint32_t& grandChild = m_Nodes[bestOwner].children[bestSlot];
+	std::swap(child, grandChild);
+	m_Nodes[child].parent = index;
+	m_Nodes[grandChild].parent = bestOwner;
+	UpdateInner(bestOwner);
+	UpdateInner(index);
+}
+
+void BVH::UpdateInner(uint32_t index) noexcept
+{
+	TreeNode& n = m_Nodes[index];
+	const TreeNode& a = m_Nodes[n.children[0]];
+	const TreeNode& b = m_Nodes[n.children[1]];
+	n.bounds = Union(a.bounds, b.bounds);
+	n.height = 1 + std::max(a.height, b.height);
+}
+
+bool BVH::UpdateWorldBounds(uint32_t leaf) noexcept
+{
+	TreeNode& n = m_Nodes[leaf];
+	const Transform* transform = n.node->GetTransform();
+	n.tight = n.local.transformed(Affine3(transform->GetWorldPosition(), transform->GetWorldScale(), transform->GetWorldRotation()));
+	if (n.bounds.contains(n.tight))
+		return false;
+	n.bounds = AABB(n.tight.min - vec3(m_Margin), n.tight.max + vec3(m_Margin));
+	return true;
+}
+
+uint32_t BVH::BuildRange(uint32_t* leaves, size_t count)
+{
+	if (count == 1)
+		return leaves[0];
+
+	AABB centroids;
+	for (size_t i = 0; i < count; ++i)
+		centroids.merge(m_Nodes[leaves[i]].bounds.center());
+	const vec3 size = centroids.size();
+	const int axis = size.x >= size.y && size.x >= size.z ? 0 : size.y >= size.z ? 1 : 2;
+	const float lo = Axis(centroids.min, axis);
+	const float extent = Axis(size, axis);
+	auto center = [&](uint32_t leaf) { return Axis(m_Nodes[leaf].bounds.center(), axis); };
+
+	size_t mid = 0;
+	if (extent > 0)
+	{
+		auto binOf = [&](uint32_t leaf) {
+			return std::min(static_cast<int>((center(leaf) - lo) / extent * BinCount), BinCount - 1);
+		};
+		AABB bounds[BinCount];
+		size_t counts[BinCount] = {};
+		for (size_t i = 0; i < count; ++i)
+		{
+			const int bin = binOf(leaves[i]);
+			bounds[bin].merge(m_Nodes[leaves[i]].bounds);
+			++counts[bin];
+		}
+		// Split after bin k: cost = left area * left count + right area * right count
+		float rightCost[BinCount];
+		AABB right;
+		size_t rightCount = 0;
+		for (int k = BinCount - 1; k > 0; --k)
+		{
+			right.merge(bounds[k]);
+			rightCount += counts[k];
+			rightCost[k - 1] = rightCount != 0 ? right.surface_area() * rightCount : 0;
+		}
+		AABB left;
+		size_t leftCount = 0;
+		float bestCost = std::numeric_limits<float>::infinity();
+		int best = 0;
+		for (int k = 0; k < BinCount - 1; ++k)
+		{
+			left.merge(bounds[k]);
+			leftCount += counts[k];
+			const float cost = (leftCount != 0 ? left.surface_area() * leftCount : 0) + rightCost[k];
+			if (cost < bestCost)
+			{
+				bestCost = cost;
+				best = k;
+			}
+		}
+		mid = std::partition(leaves, leaves + count, [&](uint32_t leaf) { return binOf(leaf) <= best; }) - leaves;
+	}
+	if (mid == 0 || mid == count)
+	{
+		// Coincident centroids: split in the middle to bound the depth
+		mid = count / 2;
+		std::nth_element(leaves, leaves + mid, leaves + count, [&](uint32_t a, uint32_t b) { return center(a) < center(b); });
+	}
+
+	const uint32_t first = BuildRange(leaves, mid);
+	const uint32_t second = BuildRange(leaves + mid, count - mid);
+	const uint32_t index = AllocateNode();
+	TreeNode& n = m_Nodes[index];
+	n.children[0] = first;
+	n.children[1] = second;
+	n.node = nullptr;
+	m_Nodes[first].parent = index;
+	m_Nodes[second].parent = index;
+	UpdateInner(index);
+	return index;
+}
+
+void BVH::SyncEntries() const
+{
+	const TransformSystem* system = TransformSystem::GetSingleton();
+	if (system->GetLayoutGeneration() == m_LayoutGeneration)
+	{
+		// New entries are appended without a layout change
+		if (m_EntryProxies.size() < system->GetCount())
+			m_EntryProxies.resize(system->GetCount(), InvalidProxy);
+		return;
+	}
+	m_LayoutGeneration = system->GetLayoutGeneration();
+	m_EntryProxies.assign(system->GetCount(), InvalidProxy);
+	for (uint32_t i = 0; i < m_Nodes.size(); ++i)
+	{
+		if (m_Nodes[i].node != nullptr)
+			m_EntryProxies[m_Nodes[i].node->GetTransform()->GetIndex()] = i;
+	}
+}
+
+void BVH::RefitAll() noexcept
+{
+	if (m_Root == InvalidProxy)
+		return;
+	// Preorder into m_Candidates, then walk it backwards so children come before parents
+	m_Candidates.clear();
+	m_Stack.assign(1, m_Root);
+	while (!m_Stack.empty())
+	{
+		const uint32_t index = m_Stack.back();
+		m_Stack.pop_back();
+		if (IsLeaf(index))
+			continue;
+		m_Candidates.push_back(index);
+		m_Stack.insert(m_Stack.end(), m_Nodes[index].children, m_Nodes[index].children + 2);
+	}
+	for (size_t i = m_Candidates.size(); i-- > 0;)
+		UpdateInner(m_Candidates[i]);
+}
+
+template <typename Test>
+void BVH::FlushCandidates(Array<Node*>& out, Test&& test) const
+{
+	const size_t n = m_Candidates.size();
+	if (n == 0)
+		return;
+	m_CandidateBounds.resize(n * 6);
+	float* soa = m_CandidateBounds.data();
+	for (size_t k = 0; k < n; ++k)
+	{
+		const AABB& box = m_Nodes[m_Candidates[k]].tight;
+		const vec3 c = box.center(), e = box.extents();
+		soa[k] = c.x;
+		soa[n + k] = c.y;
+		soa[2 * n + k] = c.z;
+		soa[3 * n + k] = e.x;
+		soa[4 * n + k] = e.y;
+		soa[5 * n + k] = e.z;
+	}
+	const AABBSoA boxes = { soa, soa + n, soa + 2 * n, soa + 3 * n, soa + 4 * n, soa + 5 * n };
+	m_Hits.resize(n);
+	const size_t hits = test(boxes, m_Hits.data(), n);
+	for (size_t k = 0; k < hits; ++k)
+		out.push_back(m_Nodes[m_Candidates[m_Hits[k]]].node);
+}
@@ -0,0 +1,152 @@
+#pragma once
+
+#include "../Math/Frustum.h"
+#include "../Math/Ray.h"
+#include "../Math/Sphere.h"
+#include "../Utilities/Array.h"
+
+#include <cstdint>
+#include <limits>
+#include <utility>
+
+class Node;
+
+/// @brief Dynamic bounding volume hierarchy over nodes.
+/// Each proxy is a node with bounds in its local space; world bounds follow the node's Transform
+/// through Refit(). Leaves keep their tight world bounds and a fattened copy that absorbs small
+/// motion without touching the tree. Inserts pick their sibling by surface area cost, refits
+/// rotate nodes on the way up to keep that cost low, and Build() re-creates the whole tree with
+/// binned SAH. Queries test inner nodes one by one and leaves in SIMD batches.
+/// @note Remove a node's proxy before destroying the node.
+class BVH final
+{
+public:
+	static constexpr uint32_t InvalidProxy = UINT32_MAX;
+
+	struct RayHit
+	{
+		Node* node = nullptr;
+		/// @brief Distance at which the ray enters the node's world bounds
+		float distance = std::numeric_limits<float>::infinity();
+	};
+
+	BVH() = default;
+
+	BVH(const BVH&) = delete;
+
+	BVH& operator=(const BVH&) = delete;
+
+	/// @return Proxy id, stable until Remove()
+	uint32_t Insert(Node* node, const AABB& localBounds);
+
+	void Remove(uint32_t proxy);
+
+	void SetLocalBounds(uint32_t proxy, const AABB& localBounds);
+
+	/// @return InvalidProxy if node has no proxy
+	uint32_t GetProxy(const Node* node) const;
+
+	Node* GetNode(uint32_t proxy) const noexcept { return m_Nodes[proxy].node; }
+
+	/// @brief Tight world bounds as of the last Insert(), Refit() or SetLocalBounds()
+	const AABB& GetWorldBounds(uint32_t proxy) const noexcept { return m_Nodes[proxy].tight; }
+
+	size_t GetProxyCount() const noexcept { return m_ProxyCount; }
+
+	/// @brief Longest root to leaf path, 0 for a single leaf
+	uint32_t GetHeight() const noexcept;
+
+	/// @brief Sum of inner node surface areas over the root's, lower is better
+	float GetCost() const noexcept;
+
+	/// @brief Slack added around moved leaves, in world units
+	void SetMargin(float margin) noexcept { m_Margin = margin; }
+
+	/// @brief Follow the transforms changed by the last TransformSystem::Update()
+	void Refit();
+
+	/// @brief Rebuild every inner node with binned SAH, e.g. after loading or large moves
+	void Build();
+
+	/// @brief Append nodes whose world bounds are not outside frustum
+	void Query(const Frustum& frustum, Array<Node*>& out) const;
+
+	/// @brief Append nodes whose world bounds intersect sphere
+	void Query(const Sphere& sphere, Array<Node*>& out) const;
+
+	/// @brief Nearest node whose world bounds the ray enters within maxDistance
+	RayHit Raycast(const Ray& ray, float maxDistance = std::numeric_limits<float>::infinity()) const;
+
+	/// @brief hits[i] = Raycast(rays[i])
+	void Raycast(const Ray* rays, RayHit* hits, size_t count) const;
+
+private:
+	/// @brief Height of nodes on the free list
+	static constexpr uint32_t FreeHeight = UINT32_MAX;
+
+	struct TreeNode
+	{
+		/// @brief Union of the children, or the fattened world bounds of a leaf
+		AABB bounds;
+		/// @brief Next free node while on the free list
+		uint32_t parent;
+		/// @brief InvalidProxy for leaves
+		uint32_t children[2];
+		uint32_t height;
+		/// @brief Leaves only, nullptr for inner and free nodes
+		Node* node;
+		/// @brief Leaves only: bounds in node space and tight world bounds
+		AABB local;
+		AABB tight;
+	};
+
+	bool IsLeaf(uint32_t index) const noexcept { return m_Nodes[index].children[0] == InvalidProxy; }
+
+	uint32_t AllocateNode();
+
+	void FreeNode(uint32_t index) noexcept;
+
+	void InsertLeaf(uint32_t leaf);
+
+	void RemoveLeaf(uint32_t leaf) noexcept;
+
+	/// @brief Recompute bounds and heights from index up to the root, rotating each ancestor
+	void RefitUpwards(uint32_t index) noexcept;
+
+	/// @brief Swap a child with a grandchild below its sibling if that shrinks the sibling
+	void Rotate(uint32_t index) noexcept;
+
+	void UpdateInner(uint32_t index) noexcept;
+
+	/// @brief Recompute the world bounds of a leaf from its node's Transform
+	/// @return Whether the tight bounds left the fat bounds
+	bool UpdateWorldBounds(uint32_t leaf) noexcept;
+
+	uint32_t BuildRange(uint32_t* leaves, size_t count);
+
+	/// @brief Map from TransformSystem entries to proxies, rebuilt when the entries move
+	void SyncEntries() const;
+
+	/// @brief Recompute every inner node bottom-up, cheaper than refitting many paths
+	void RefitAll() noexcept;
+
+	/// @brief Test leaves gathered during a query in one batch
+	template <typename Test>
+	void FlushCandidates(Array<Node*>& out, Test&& test) const;
+
+	Array<TreeNode> m_Nodes;
+	uint32_t m_Root = InvalidProxy;
+	uint32_t m_FreeList = InvalidProxy;
+	size_t m_ProxyCount = 0;
+	float m_Margin = 0.1f;
+	/// @brief Proxy of each TransformSystem entry
+	mutable Array<uint32_t> m_EntryProxies;
+	mutable uint32_t m_LayoutGeneration = UINT32_MAX;
+	Array<uint32_t> m_Moved;
+	/// @brief Query scratch: leaves to test and their tight bounds as structure of arrays
+	mutable Array<uint32_t> m_Stack;
+	mutable Array<std::pair<uint32_t, float>> m_RayStack;
+	mutable Array<uint32_t> m_Candidates;
+	mutable Array<float> m_CandidateBounds;
+	mutable Array<uint32_t> m_Hits;
+};
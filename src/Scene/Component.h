@@ -1,10 +1,14 @@
 #pragma once
 
+#include <cstdint>
+
 class Node;
 
 class Component
 {
 	friend class Node;
+	template <typename T>
+	friend class ComponentPool;
 
 public:
 	Component(const Component&) = delete;
@@ -20,4 +24,6 @@ protected:
 
 private:
 	Node* m_pNode;
+	/// @brief Slot in the ComponentPool of the concrete type
+	uint32_t m_PoolSlot = 0;
 };
\ No newline at end of file
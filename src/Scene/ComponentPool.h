@@ -0,0 +1,153 @@
+#pragma once
+
+#include "Component.h"
+#include "../Utilities/Array.h"
+#include "../Utilities/Pointer.h"
+
+#include <bit>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+
+/// @brief One bit per component type id
+using ComponentMask = uint64_t;
+
+constexpr uint32_t MaxComponentTypes = 64;
+
+/// @brief Type erased interface of ComponentPool
+class ComponentPoolBase
+{
+public:
+	virtual ~ComponentPoolBase() = default;
+
+	/// @brief Destruct a component allocated from this pool and release its slot
+	virtual void Destroy(Component* component) noexcept = 0;
+};
+
+/// @brief Maps component type ids to their pools.
+class ComponentRegistry final
+{
+public:
+	/// @return New type id of pool
+	static uint32_t Register(ComponentPoolBase* pool) noexcept
+	{
+		assert(s_Count < MaxComponentTypes);
+		s_Pools[s_Count] = pool;
+		return s_Count++;
+	}
+
+	static ComponentPoolBase* GetPool(uint32_t id) noexcept
+	{
+		return s_Pools[id];
+	}
+
+private:
+	inline static ComponentPoolBase* s_Pools[MaxComponentTypes] = {};
+	inline static uint32_t s_Count = 0;
+};
+
+/// @brief Paged storage of every component of type T.
+/// Components never move, so pointers stay valid, and pages are dense so ForEach
+/// walks them mostly linearly. Freed slots are reused first.
+/// @note Not synchronized.
+template <typename T>
+class ComponentPool final : public ComponentPoolBase
+{
+public:
+	static constexpr size_t PageSize = 256;
+
+	static ComponentPool* GetSingleton() noexcept
+	{
+		static ComponentPool pool;
+		return &pool;
+	}
+
+	/// @brief Id of T, fixed on first use and the bit of T in a ComponentMask
+	static uint32_t GetTypeId() noexcept
+	{
+		static const uint32_t id = ComponentRegistry::Register(GetSingleton());
+		return id;
+	}
+
+	ComponentPool(const ComponentPool&) = delete;
+
+	ComponentPool& operator=(const ComponentPool&) = delete;
+
+	~ComponentPool() override = default;
+
+	/// @brief Storage for one T, to be constructed with placement new by the caller.
+	/// @param slot Receives the slot, store it in Component::m_PoolSlot
+	void* Allocate(uint32_t& slot)
+	{
+		if (!m_FreeSlots.empty())
+		{
+			slot = m_FreeSlots.back();
+			m_FreeSlots.pop_back();
+		}
+		else
+		{
+			if (m_End == m_Pages.size() * PageSize)
+				m_Pages.push_back(MakeUnique<Page>());
+			slot = m_End++;
+		}
+		Page& page = *m_Pages[slot / PageSize];
+		const size_t i = slot % PageSize;
+		page.live[i / 64] |= uint64_t(1) << (i % 64);
+		++m_Count;
+		return page.storage + i * sizeof(T);
+	}
+
+	void Destroy(Component* component) noexcept override
+	{
+		const uint32_t slot = component->m_PoolSlot;
+		static_cast<T*>(component)->~T();
+		Page& page = *m_Pages[slot / PageSize];
+		const size_t i = slot % PageSize;
+		page.live[i / 64] &= ~(uint64_t(1) << (i % 64));
+		m_FreeSlots.push_back(slot);
+		--m_Count;
+	}
+
+	/// @brief Live component count
+	size_t GetCount() const noexcept { return m_Count; }
+
+	/// @brief fn(T&) for every live component, in slot order
+	template <typename Fn>
+	void ForEach(Fn&& fn) const
+	{
+		for (const auto& page : m_Pages)
+		{
+			for (size_t w = 0; w < PageSize / 64; ++w)
+			{
+				for (uint64_t bits = page->live[w]; bits != 0; bits &= bits - 1)
+				{
+					const size_t i = w * 64 + std::countr_zero(bits);
+					fn(*std::launder(reinterpret_cast<T*>(page->storage + i * sizeof(T))));
+				}
+			}
+		}
+	}
+
+private:
+	ComponentPool() = default;
+
+	struct Page
+	{
+		alignas(T) unsigned char storage[PageSize * sizeof(T)];
+		uint64_t live[PageSize / 64] = {};
+	};
+
+	Array<UniquePtr<Page>> m_Pages;
+	Array<uint32_t> m_FreeSlots;
+	/// @brief Slots below m_End have been handed out at least once
+	uint32_t m_End = 0;
+	size_t m_Count = 0;
+};
+
+/// @brief fn(T&) for every live component of type T, e.g. ForEachComponent<Transform>(...)
+template <typename T, typename Fn>
+void ForEachComponent(Fn&& fn)
+{
+	ComponentPool<T>::GetSingleton()->ForEach(fn);
+}
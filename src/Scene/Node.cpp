@@ -2,45 +2,93 @@
 #include "Component.h"
 #include "Transform.h"
 
+#include "../Utilities/HashMap.h"
+#include "../Utilities/NameTable.h"
+
+#include <cassert>
+
+struct Node::PathCache
+{
+	uint64_t version = 0;
+	StringHashMap<Node*> nodes;
+};
+
+namespace
+{
+	/// @brief Bumped by every change that can invalidate a cached path
+	uint64_t g_HierarchyVersion = 1;
+
+	SlabAllocator<Node>& GetNodeAllocator() noexcept
+	{
+		static SlabAllocator<Node> allocator;
+		return allocator;
+	}
+}
+
 Node::Node(AnsiStringView name) :
-	m_Name(name), m_Parent(nullptr)
+	Node(name, NameTable::GetSingleton()->Intern(name))
 {
-	m_Components.emplace_back(new Transform(this));
+}
+
+Node::Node(AnsiStringView name, uint32_t nameId) :
+	m_Name(name), m_NameId(nameId), m_Parent(nullptr)
+{
+	m_pTransform = AllocateComponent<Transform>();
 }
 
 Node::~Node()
 {
+	ComponentMask mask = m_ComponentMask;
+	for (Component* component : m_Components)
+	{
+		ComponentRegistry::GetPool(std::countr_zero(mask))->Destroy(component);
+		mask &= mask - 1;
+	}
+	ComponentPool<Transform>::GetSingleton()->Destroy(m_pTransform);
+	++g_HierarchyVersion;
+}
+
+void* Node::operator new([[maybe_unused]] size_t size)
+{
+	assert(size == sizeof(Node));
+	return GetNodeAllocator().Allocate();
+}
+
+void Node::operator delete(void* p) noexcept
+{
+	GetNodeAllocator().Free(p);
+}
+
+const SlabAllocator<Node>& Node::GetAllocator() noexcept
+{
+	return GetNodeAllocator();
 }
 
 bool Node::SetName(AnsiStringView name)
 {
+	const uint32_t id = NameTable::GetSingleton()->Intern(name);
 	if (m_Parent)
 	{
-		if (m_Parent->HasChild(name))
+		if (m_Parent->FindChild(id))
 			return false;
+		m_Parent->UnindexChild(this);
 	}
 	m_Name = name;
+	m_NameId = id;
+	if (m_Parent)
+		m_Parent->IndexChild(this);
+	++g_HierarchyVersion;
 	return true;
 }
 
 bool Node::HasChild(AnsiStringView name) const noexcept
 {
-	for (const auto& p : m_Children)
-	{
-		if (p->m_Name == name)
-			return true;
-	}
-	return false;
+	return FindChild(NameTable::GetSingleton()->Find(name)) != nullptr;
 }
 
 bool Node::HasChild(const Node* node) const noexcept
 {
-	for (const auto& p : m_Children)
-	{
-		if (p.get() == node)
-			return true;
-	}
-	return false;
+	return node != nullptr && node->m_Parent == this;
 }
 
 bool Node::IsAncestorOf(const Node* node) const noexcept
@@ -60,7 +108,7 @@ bool Node::IsAncestorOf(const Node* node) const noexcept
 bool Node::TestAppendChild(const Node* node) const noexcept
 {
 	if (node == nullptr || node == this || node->IsAncestorOf(this) ||
-		HasChild(node) || HasChild(node->m_Name))
+		HasChild(node) || FindChild(node->m_NameId))
 		return false;
 	return true;
 }
@@ -71,10 +119,11 @@ bool Node::AppendChild(Node* node)
 	{
 		if (node->m_Parent)
 			node->m_Parent->ReleaseChild(node);
-		else
-			node->GetTransform()->MarkDirty();
 		m_Children.push_back(UniquePtr<Node>(node));
 		node->m_Parent = this;
+		IndexChild(node);
+		node->GetTransform()->SetParent(GetTransform());
+		++g_HierarchyVersion;
 		return true;
 	}
 	return false;
@@ -82,17 +131,22 @@ bool Node::AppendChild(Node* node)
 
 Node* Node::CreateChild(AnsiStringView name)
 {
-	if (HasChild(name))
+	// Interning up front costs one name lookup instead of two
+	const uint32_t id = NameTable::GetSingleton()->Intern(name);
+	if (FindChild(id))
 		return nullptr;
-	Node* node = new Node(name);
+	Node* node = new Node(name, id);
 	m_Children.emplace_back(node);
-	node->GetTransform()->MarkDirty();
+	node->m_Parent = this;
+	IndexChild(node);
+	node->GetTransform()->SetParent(GetTransform());
+	++g_HierarchyVersion;
 	return node;
 }
 
 Node* Node::ReleaseChild(Node* node)
 {
-	if (node == nullptr)
+	if (!HasChild(node))
 		return nullptr;
 	auto it = m_Children.begin();
 	for (; it != m_Children.end(); ++it)
@@ -104,7 +158,10 @@ Node* Node::ReleaseChild(Node* node)
 	{
 		Node* _node = it->release();
 		m_Children.erase(it);
-		_node->GetTransform()->MarkDirty();
+		UnindexChild(_node);
+		_node->m_Parent = nullptr;
+		++g_HierarchyVersion;
+		_node->GetTransform()->SetParent(nullptr);
 		return _node;
 	}
 	return nullptr;
@@ -112,15 +169,121 @@ Node* Node::ReleaseChild(Node* node)
 
 Node* Node::GetChild(AnsiStringView name) const noexcept
 {
-	for (auto it = m_Children.begin(); it != m_Children.end(); ++it)
+	return FindChild(NameTable::GetSingleton()->Find(name));
+}
+
+Node* Node::FindByPath(AnsiStringView path) const
+{
+	if (!m_PathCache)
+		m_PathCache = MakeUnique<PathCache>();
+	if (m_PathCache->version != g_HierarchyVersion)
 	{
-		if (it->get()->m_Name == name)
-			return it->get();
+		m_PathCache->nodes.clear();
+		m_PathCache->version = g_HierarchyVersion;
 	}
-	return nullptr;
+	if (auto it = m_PathCache->nodes.find(path); it != m_PathCache->nodes.end())
+		return it->second;
+
+	Node* node = const_cast<Node*>(this);
+	size_t begin = 0;
+	while (node && begin <= path.size())
+	{
+		size_t end = path.find('/', begin);
+		if (end == AnsiStringView::npos)
+			end = path.size();
+		node = node->GetChild(path.substr(begin, end - begin));
+		begin = end + 1;
+	}
+	m_PathCache->nodes.emplace(path, node);
+	return node;
 }
 
 Transform* Node::GetTransform() const noexcept
 {
-	return static_cast<Transform*>(m_Components[0].get());
+	return m_pTransform;
+}
+
+Node* Node::FindChild(uint32_t nameId) const noexcept
+{
+	if (nameId == NameTable::InvalidId)
+		return nullptr;
+	if (!m_ChildIndex.empty())
+	{
+		const size_t mask = m_ChildIndex.size() - 1;
+		for (size_t i = ChildSlot(nameId); m_ChildIndex[i] != nullptr; i = (i + 1) & mask)
+		{
+			if (m_ChildIndex[i]->m_NameId == nameId)
+				return m_ChildIndex[i];
+		}
+		return nullptr;
+	}
+	for (const auto& p : m_Children)
+	{
+		if (p->m_NameId == nameId)
+			return p.get();
+	}
+	return nullptr;
+}
+
+void Node::IndexChild(Node* child)
+{
+	if (m_ChildIndex.empty())
+	{
+		if (m_Children.size() >= ChildIndexThreshold)
+			RebuildChildIndex();
+		return;
+	}
+	// Keep the load factor at most 1/2
+	if (m_Children.size() * 2 > m_ChildIndex.size())
+	{
+		RebuildChildIndex();
+		return;
+	}
+	InsertChildIndex(child);
+}
+
+void Node::UnindexChild(const Node* child) noexcept
+{
+	if (m_ChildIndex.empty())
+		return;
+	const size_t mask = m_ChildIndex.size() - 1;
+	size_t hole = ChildSlot(child->m_NameId);
+	while (m_ChildIndex[hole] != child)
+	{
+		if (m_ChildIndex[hole] == nullptr)
+			return;
+		hole = (hole + 1) & mask;
+	}
+	// Move later entries of the probe run into the hole unless that would put them before their home slot
+	for (size_t i = (hole + 1) & mask; m_ChildIndex[i] != nullptr; i = (i + 1) & mask)
+	{
+		const size_t home = ChildSlot(m_ChildIndex[i]->m_NameId);
+		if (((i - home) & mask) >= ((i - hole) & mask))
+		{
+			m_ChildIndex[hole] = m_ChildIndex[i];
+			hole = i;
+		}
+	}
+	m_ChildIndex[hole] = nullptr;
+}
+
+size_t Node::ChildSlot(uint32_t nameId) const noexcept
+{
+	return static_cast<size_t>((nameId * 0x9E3779B97F4A7C15ull) >> 32) & (m_ChildIndex.size() - 1);
+}
+
+void Node::RebuildChildIndex()
+{
+	m_ChildIndex.assign(std::bit_ceil(m_Children.size() * 4), nullptr);
+	for (const auto& p : m_Children)
+		InsertChildIndex(p.get());
+}
+
+void Node::InsertChildIndex(Node* child) noexcept
+{
+	const size_t mask = m_ChildIndex.size() - 1;
+	size_t i = ChildSlot(child->m_NameId);
+	while (m_ChildIndex[i] != nullptr)
+		i = (i + 1) & mask;
+	m_ChildIndex[i] = child;
 }
@@ -4,10 +4,9 @@
 #include "../Utilities/String.h"
 #include "../Utilities/Array.h"
 #include "../Utilities/Pointer.h"
+#include "../Utilities/SlabAllocator.h"
+#include "ComponentPool.h"
 
-#include <typeinfo>
-
-class Component;
 class Transform;
 
 template <typename T>
@@ -26,6 +25,13 @@ public:
 
 	~Node();
 
+	/// @brief Heap nodes, e.g. from CreateChild(), come from one SlabAllocator
+	static void* operator new(size_t size);
+
+	static void operator delete(void* p) noexcept;
+
+	static const SlabAllocator<Node>& GetAllocator() noexcept;
+
 	bool SetName(AnsiStringView name);
 
 	const AnsiString& GetName() const noexcept { return m_Name; }
@@ -48,54 +54,130 @@ public:
 
 	Node* GetChild(AnsiStringView name) const noexcept;
 
+	size_t GetChildCount() const noexcept { return m_Children.size(); }
+
+	/// @brief Make room for count children, e.g. before attaching a known number of them
+	void ReserveChildren(size_t count) { m_Children.reserve(count); }
+
+	/// @brief Children in the order they were attached
+	Node* GetChildAt(size_t index) const noexcept { return m_Children[index].get(); }
+
+	/// @brief Descendant at a '/' separated path of child names, e.g. "body/arm/hand".
+	/// Results are cached per node until any node is renamed, attached, detached or destroyed.
+	/// @return nullptr if some segment has no matching child
+	Node* FindByPath(AnsiStringView path) const;
+
 	template <ComponentType T>
 	bool HasComponent() const noexcept
 	{
-		for (const auto& p : m_Components)
-		{
-			if (typeid(*p) == typeid(T))
-				return true;
-		}
-		return false;
+		if constexpr (SameAs<T, Transform>)
+			return true;
+		else
+			return (m_ComponentMask >> ComponentPool<T>::GetTypeId() & 1) != 0;
 	}
 
+	/// @brief Component of type T, created if the node has none
 	template <ComponentType T>
 	T* GetOrCreateComponnet()
 	{
-		if (HasComponent<T>())
-			return nullptr;
-		return m_Components.emplace_back(new T(this)).get();
+		if (T* p = GetComponent<T>())
+			return p;
+		return CreateComponent<T>();
 	}
 
 	template <ComponentType T>
 	T* GetComponent() const noexcept
 	{
-		for (const auto& p : m_Components)
+		if constexpr (SameAs<T, Transform>)
+			return m_pTransform;
+		else
 		{
-			if (typeid(*p) == typeid(T))
-				return static_cast<T*>(p.get());
+			const uint32_t id = ComponentPool<T>::GetTypeId();
+			if ((m_ComponentMask >> id & 1) == 0)
+				return nullptr;
+			return static_cast<T*>(m_Components[ComponentIndex(id)]);
 		}
-		return nullptr;
 	}
 
+	/// @brief Every node keeps its Transform
 	template <ComponentType T>
+	requires (!SameAs<T, Transform>)
 	void RemoveComponent()
 	{
-		for (auto it = m_Components.begin(); it != m_Components.end(); ++it)
-		{
-			if (typeid(*(it->get())) == typeid(T))
-			{
-				m_Components.erase(it);
-				return;
-			}
-		}
+		const uint32_t id = ComponentPool<T>::GetTypeId();
+		if ((m_ComponentMask >> id & 1) == 0)
+			return;
+		const size_t index = ComponentIndex(id);
+		ComponentPool<T>::GetSingleton()->Destroy(m_Components[index]);
+		m_Components.erase(m_Components.begin() + index);
+		m_ComponentMask &= ~(ComponentMask(1) << id);
 	}
 
+	/// @brief Bits of the component types other than Transform
+	ComponentMask GetComponentMask() const noexcept { return m_ComponentMask; }
+
 	Transform* GetTransform() const noexcept;
 
 private:
+	struct PathCache;
+
+	Node(AnsiStringView name, uint32_t nameId);
+
+	/// @brief Position of a type id in m_Components, which is sorted by type id
+	size_t ComponentIndex(uint32_t id) const noexcept
+	{
+		return std::popcount(m_ComponentMask & ((ComponentMask(1) << id) - 1));
+	}
+
+	template <ComponentType T>
+	T* AllocateComponent()
+	{
+		uint32_t slot;
+		T* p = new (ComponentPool<T>::GetSingleton()->Allocate(slot)) T(this);
+		p->m_PoolSlot = slot;
+		return p;
+	}
+
+	template <ComponentType T>
+	T* CreateComponent()
+	{
+		const uint32_t id = ComponentPool<T>::GetTypeId();
+		T* p = AllocateComponent<T>();
+		m_Components.insert(m_Components.begin() + ComponentIndex(id), p);
+		m_ComponentMask |= ComponentMask(1) << id;
+		return p;
+	}
+
+	/// @brief Child count from which children are also indexed by name
+	static constexpr size_t ChildIndexThreshold = 16;
+
+	Node* FindChild(uint32_t nameId) const noexcept;
+
+	/// @brief Add a child just appended to m_Children to the name index
+	void IndexChild(Node* child);
+
+	void UnindexChild(const Node* child) noexcept;
+
+	/// @brief Home slot of a name id in m_ChildIndex
+	size_t ChildSlot(uint32_t nameId) const noexcept;
+
+	/// @brief Size m_ChildIndex for the current children and insert all of them
+	void RebuildChildIndex();
+
+	void InsertChildIndex(Node* child) noexcept;
+
 	AnsiString m_Name;
+	/// @brief m_Name interned in NameTable
+	uint32_t m_NameId;
 	Node* m_Parent;
 	Array<UniquePtr<Node>> m_Children;
-	Array<UniquePtr<Component>> m_Components;
+	/// @brief Components other than the Transform, owned by their pools, one per bit of
+	/// m_ComponentMask in bit order. Empty for most nodes, so it costs no heap allocation.
+	Array<Component*> m_Components;
+	ComponentMask m_ComponentMask = 0;
+	Transform* m_pTransform;
+	/// @brief Open addressing table of children by name id with linear probing, empty below
+	/// ChildIndexThreshold children. Only grows, so churn below one parent does not allocate.
+	Array<Node*> m_ChildIndex;
+	mutable UniquePtr<PathCache> m_PathCache;
 };
\ No newline at end of file
@@ -0,0 +1,286 @@
+#include "SceneFile.h"
+#include "Node.h"
+#include "Transform.h"
+
+#include <bit>
+#include <cstdio>
+#include <cstring>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static_assert(std::endian::native == std::endian::little, "Scene files are little-endian");
+
+using namespace SceneFormat;
+
+namespace
+{
+	constexpr size_t SectionAlignment = 16;
+
+	size_t AlignUp(size_t size) noexcept
+	{
+		return (size + SectionAlignment - 1) & ~(SectionAlignment - 1);
+	}
+
+	/// @brief Map a whole file read-only. The file itself need not stay open.
+	const unsigned char* MapFile(const AnsiString& path, size_t& size) noexcept
+	{
+#ifdef _WIN32
+		HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (file == INVALID_HANDLE_VALUE)
+			return nullptr;
+		LARGE_INTEGER length;
+		const void* data = nullptr;
+		if (GetFileSizeEx(file, &length) && length.QuadPart > 0)
+		{
+			if (HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr))
+			{
+				data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+				CloseHandle(mapping);
+			}
+			size = static_cast<size_t>(length.QuadPart);
+		}
+		CloseHandle(file);
+		return static_cast<const unsigned char*>(data);
+#else
+		const int fd = open(path.c_str(), O_RDONLY);
+		if (fd < 0)
+			return nullptr;
+		struct stat stat_buf;
+		void* data = MAP_FAILED;
+		if (fstat(fd, &stat_buf) == 0 && stat_buf.st_size > 0)
+		{
+			size = static_cast<size_t>(stat_buf.st_size);
+			data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+		}
+		close(fd);
+		return data != MAP_FAILED ? static_cast<const unsigned char*>(data) : nullptr;
+#endif
+	}
+
+	void UnmapFile(const unsigned char* data, size_t size) noexcept
+	{
+#ifdef _WIN32
+		(void)size;
+		UnmapViewOfFile(data);
+#else
+		munmap(const_cast<unsigned char*>(data), size);
+#endif
+	}
+}
+
+SceneFile::SceneFile(const AnsiString& path)
+{
+	m_pData = MapFile(path, m_szData);
+	if (m_pData == nullptr)
+	{
+		printf("Warning: Error mapping scene file \"%s\"!\n", path.c_str());
+		return;
+	}
+	if (!Validate())
+	{
+		printf("Warning: Invalid scene file \"%s\"!\n", path.c_str());
+		UnmapFile(m_pData, m_szData);
+		m_pData = nullptr;
+	}
+}
+
+SceneFile::~SceneFile()
+{
+	if (m_pData)
+		UnmapFile(m_pData, m_szData);
+}
+
+bool SceneFile::Validate() const noexcept
+{
+	if (m_szData < sizeof(Header))
+		return false;
+	const Header& header = GetHeader();
+	if (header.magic != Magic || header.version != Version || header.size != m_szData)
+		return false;
+	for (const Section& section : header.sections)
+	{
+		if (section.offset % SectionAlignment != 0 || section.offset < sizeof(Header) ||
+			section.offset > m_szData || section.size > m_szData - section.offset)
+			return false;
+	}
+	const Section* sections = header.sections;
+	if (sections[Nodes].size % sizeof(NodeRecord) != 0 || sections[Components].size % sizeof(ComponentRecord) != 0 ||
+		sections[References].size % sizeof(ReferenceRecord) != 0 || sections[Transforms].size % sizeof(TransformRecord) != 0)
+		return false;
+
+	const size_t count = GetNodeCount();
+	if (count == 0 || Count<TransformRecord>(Transforms) != count)
+		return false;
+	const uint64_t strings = sections[Strings].size;
+	const auto validString = [strings](StringRef str) {
+		return str.offset <= strings && str.length <= strings - str.offset;
+	};
+	const NodeRecord* nodes = GetNodes();
+	for (size_t i = 0; i < count; ++i)
+	{
+		// Parents come first, so instantiating in record order always finds the parent.
+		// childCount sizes a reservation, so it must not exceed the other records.
+		const bool validParent = i == 0 ? nodes[i].parent == InvalidIndex : nodes[i].parent < i;
+		if (!validParent || nodes[i].childCount >= count || !validString(nodes[i].name))
+			return false;
+	}
+	const ComponentRecord* components = GetComponents();
+	for (size_t i = 0; i < GetComponentCount(); ++i)
+	{
+		const ComponentRecord& c = components[i];
+		if (c.node >= count || !validString(c.type) || c.offset % SectionAlignment != 0 ||
+			c.offset > sections[Blobs].size || c.size > sections[Blobs].size - c.offset)
+			return false;
+	}
+	const ReferenceRecord* references = GetReferences();
+	for (size_t i = 0; i < GetReferenceCount(); ++i)
+	{
+		if (references[i].node >= count || !validString(references[i].asset))
+			return false;
+	}
+	return true;
+}
+
+Node* SceneFile::Instantiate(Node* parent, Array<Node*>* nodes) const
+{
+	if (!IsValid())
+		return nullptr;
+	const size_t count = GetNodeCount();
+	const NodeRecord* records = GetNodes();
+	const TransformRecord* transforms = GetTransforms();
+	Array<Node*> created;
+	Array<Node*>& out = nodes != nullptr ? *nodes : created;
+	out.assign(count, nullptr);
+
+	const AnsiStringView rootName = GetString(records[0].name);
+	out[0] = parent != nullptr ? parent->CreateChild(rootName) : new Node(rootName);
+	if (out[0] == nullptr)
+		return nullptr;
+	for (size_t i = 0; i < count; ++i)
+	{
+		// A node whose name repeats a sibling is skipped with its subtree
+		if (i != 0 && out[records[i].parent] != nullptr)
+			out[i] = out[records[i].parent]->CreateChild(GetString(records[i].name));
+		if (out[i] == nullptr)
+			continue;
+		out[i]->ReserveChildren(records[i].childCount);
+		Transform* transform = out[i]->GetTransform();
+		transform->SetPosition(transforms[i].position);
+		transform->SetScale(transforms[i].scale);
+		transform->SetRotation(transforms[i].rotation);
+	}
+	return out[0];
+}
+
+SceneWriter::SceneWriter(const Node& root)
+{
+	// Depth-first preorder keeps parents before children and each subtree contiguous
+	Array<std::pair<const Node*, uint32_t>> stack = { { &root, InvalidIndex } };
+	while (!stack.empty())
+	{
+		const auto [node, parent] = stack.back();
+		stack.pop_back();
+		const uint32_t index = static_cast<uint32_t>(m_Nodes.size());
+		m_Indices.emplace(node, index);
+		const size_t childCount = node->GetChildCount();
+		m_Nodes.push_back({ AddString(node->GetName()), parent, static_cast<uint32_t>(childCount) });
+		const Transform* transform = node->GetTransform();
+		m_Transforms.push_back({ transform->GetPosition(), transform->GetScale(), transform->GetRotation() });
+		for (size_t i = childCount; i-- > 0;)
+			stack.emplace_back(node->GetChildAt(i), index);
+	}
+}
+
+uint32_t SceneWriter::GetIndex(const Node* node) const noexcept
+{
+	auto it = m_Indices.find(node);
+	return it != m_Indices.end() ? it->second : InvalidIndex;
+}
+
+bool SceneWriter::AddComponentData(const Node* node, AnsiStringView type, const void* data, size_t size)
+{
+	const uint32_t index = GetIndex(node);
+	if (index == InvalidIndex)
+		return false;
+	const size_t offset = AlignUp(m_Blobs.size());
+	m_Blobs.resize(offset + size);
+	if (size != 0)
+		std::memcpy(m_Blobs.data() + offset, data, size);
+	m_Components.push_back({ index, AddString(type), 0, offset, size });
+	return true;
+}
+
+bool SceneWriter::AddReference(const Node* node, ReferenceKind kind, AnsiStringView asset)
+{
+	const uint32_t index = GetIndex(node);
+	if (index == InvalidIndex)
+		return false;
+	m_References.push_back({ index, kind, AddString(asset) });
+	return true;
+}
+
+StringRef SceneWriter::AddString(AnsiStringView str)
+{
+	const StringRef ref = { static_cast<uint32_t>(m_Strings.size()), static_cast<uint32_t>(str.size()) };
+	m_Strings += str;
+	return ref;
+}
+
+Array<unsigned char> SceneWriter::Serialize() const
+{
+	struct Source
+	{
+		const void* data;
+		size_t size;
+	};
+	const Source sources[SectionCount] = {
+		{ m_Nodes.data(), m_Nodes.size() * sizeof(NodeRecord) },
+		{ m_Transforms.data(), m_Transforms.size() * sizeof(TransformRecord) },
+		{ m_Components.data(), m_Components.size() * sizeof(ComponentRecord) },
+		{ m_References.data(), m_References.size() * sizeof(ReferenceRecord) },
+		{ m_Blobs.data(), m_Blobs.size() },
+		{ m_Strings.data(), m_Strings.size() },
+	};
+
+	Header header = {};
+	header.magic = Magic;
+	header.version = Version;
+	size_t size = AlignUp(sizeof(Header));
+	for (uint32_t i = 0; i < SectionCount; ++i)
+	{
+		header.sections[i] = { size, sources[i].size };
+		size = AlignUp(size + sources[i].size);
+	}
+	header.size = size;
+
+	Array<unsigned char> file(size, 0);
+	std::memcpy(file.data(), &header, sizeof(Header));
+	for (uint32_t i = 0; i < SectionCount; ++i)
+	{
+		if (sources[i].size != 0)
+			std::memcpy(file.data() + header.sections[i].offset, sources[i].data, sources[i].size);
+	}
+	return file;
+}
+
+bool SceneWriter::Write(const AnsiString& path) const
+{
+	const Array<unsigned char> file = Serialize();
+	std::FILE* fp = std::fopen(path.c_str(), "wb");
+	if (fp == nullptr)
+	{
+		printf("Warning: Error writing scene file \"%s\"!\n", path.c_str());
+		return false;
+	}
+	const bool ok = std::fwrite(file.data(), 1, file.size(), fp) == file.size();
+	return std::fclose(fp) == 0 && ok;
+}
@@ -0,0 +1,217 @@
+#pragma once
+
+#include "../Math/Quaternion.h"
+#include "../Utilities/Array.h"
+#include "../Utilities/HashMap.h"
+#include "../Utilities/String.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+class Node;
+
+/// @brief On-disk layout of a scene file.
+/// A file is a Header followed by sections at 16 byte aligned offsets. Records refer to each
+/// other by index and to strings or blobs by offset, never by pointer, so a mapped file is
+/// used in place: resolving an offset against the mapping base is the only fix-up.
+/// Multi-byte values are little-endian.
+namespace SceneFormat
+{
+	constexpr uint32_t Magic = 'LScn';
+
+	constexpr uint32_t Version = 1;
+
+	constexpr uint32_t InvalidIndex = UINT32_MAX;
+
+	enum SectionId : uint32_t
+	{
+		/// @brief NodeRecord per node, parents before children, the first record is the root
+		Nodes,
+		/// @brief TransformRecord per node, same order as Nodes
+		Transforms,
+		/// @brief ComponentRecord array
+		Components,
+		/// @brief ReferenceRecord array
+		References,
+		/// @brief Component data, each blob 16 byte aligned
+		Blobs,
+		/// @brief UTF-8 characters of every StringRef, not terminated
+		Strings,
+		SectionCount
+	};
+
+	struct Section
+	{
+		uint64_t offset;
+		uint64_t size;
+	};
+
+	struct Header
+	{
+		uint32_t magic;
+		uint32_t version;
+		/// @brief Size of the whole file
+		uint64_t size;
+		Section sections[SectionCount];
+	};
+
+	struct StringRef
+	{
+		uint32_t offset;
+		uint32_t length;
+	};
+
+	struct NodeRecord
+	{
+		StringRef name;
+		/// @brief Index of the parent record, InvalidIndex for the root
+		uint32_t parent;
+		uint32_t childCount;
+	};
+
+	struct TransformRecord
+	{
+		vec3 position;
+		vec3 scale;
+		Quaternion rotation;
+	};
+
+	/// @brief Opaque data of one component, interpreted by whoever knows its type name
+	struct ComponentRecord
+	{
+		uint32_t node;
+		StringRef type;
+		uint32_t reserved;
+		uint64_t offset;
+		uint64_t size;
+	};
+
+	enum class ReferenceKind : uint32_t
+	{
+		Mesh = 'Mesh',
+		Material = 'Mtrl',
+		Texture = 'Text',
+	};
+
+	/// @brief Named asset used by a node, resolved by the application after loading
+	struct ReferenceRecord
+	{
+		uint32_t node;
+		ReferenceKind kind;
+		StringRef asset;
+	};
+
+	static_assert(std::is_trivially_copyable_v<TransformRecord> && sizeof(TransformRecord) == 40);
+	static_assert(sizeof(Header) == 16 + 16 * SectionCount);
+}
+
+/// @brief Read-only view of a scene file mapped into memory.
+/// Opening validates every offset and index, after which all accessors are plain pointer
+/// arithmetic on the mapping. Nothing is copied until Instantiate().
+class SceneFile final
+{
+public:
+	/// @param path File system path of the scene file
+	explicit SceneFile(const AnsiString& path);
+
+	SceneFile(const SceneFile&) = delete;
+
+	SceneFile& operator=(const SceneFile&) = delete;
+
+	~SceneFile();
+
+	/// @brief Whether the file was mapped and passed validation
+	bool IsValid() const noexcept { return m_pData != nullptr; }
+
+	size_t GetNodeCount() const noexcept { return Count<SceneFormat::NodeRecord>(SceneFormat::Nodes); }
+
+	const SceneFormat::NodeRecord* GetNodes() const noexcept { return Records<SceneFormat::NodeRecord>(SceneFormat::Nodes); }
+
+	const SceneFormat::TransformRecord* GetTransforms() const noexcept { return Records<SceneFormat::TransformRecord>(SceneFormat::Transforms); }
+
+	size_t GetComponentCount() const noexcept { return Count<SceneFormat::ComponentRecord>(SceneFormat::Components); }
+
+	const SceneFormat::ComponentRecord* GetComponents() const noexcept { return Records<SceneFormat::ComponentRecord>(SceneFormat::Components); }
+
+	size_t GetReferenceCount() const noexcept { return Count<SceneFormat::ReferenceRecord>(SceneFormat::References); }
+
+	const SceneFormat::ReferenceRecord* GetReferences() const noexcept { return Records<SceneFormat::ReferenceRecord>(SceneFormat::References); }
+
+	AnsiStringView GetString(SceneFormat::StringRef str) const noexcept
+	{
+		return AnsiStringView(Records<char>(SceneFormat::Strings) + str.offset, str.length);
+	}
+
+	const void* GetBlob(const SceneFormat::ComponentRecord& component) const noexcept
+	{
+		return Records<unsigned char>(SceneFormat::Blobs) + component.offset;
+	}
+
+	/// @brief Build the node tree under parent, or as a new root if parent is nullptr.
+	/// @param nodes If given, receives the created node of each record, e.g. to attach components
+	/// @return Node of the root record, nullptr if the file is invalid or the root name is taken in parent
+	Node* Instantiate(Node* parent, Array<Node*>* nodes = nullptr) const;
+
+private:
+	bool Validate() const noexcept;
+
+	template <typename T>
+	const T* Records(SceneFormat::SectionId id) const noexcept
+	{
+		return reinterpret_cast<const T*>(m_pData + GetHeader().sections[id].offset);
+	}
+
+	template <typename T>
+	size_t Count(SceneFormat::SectionId id) const noexcept
+	{
+		return m_pData != nullptr ? GetHeader().sections[id].size / sizeof(T) : 0;
+	}
+
+	const SceneFormat::Header& GetHeader() const noexcept
+	{
+		return *reinterpret_cast<const SceneFormat::Header*>(m_pData);
+	}
+
+	const unsigned char* m_pData = nullptr;
+	size_t m_szData = 0;
+};
+
+/// @brief Snapshot of a live node tree, written as a scene file.
+/// The hierarchy and local transforms are captured on construction; component data and asset
+/// references are added per node before Write().
+class SceneWriter final
+{
+public:
+	explicit SceneWriter(const Node& root);
+
+	SceneWriter(const SceneWriter&) = delete;
+
+	SceneWriter& operator=(const SceneWriter&) = delete;
+
+	/// @brief Record index of a snapshot node, SceneFormat::InvalidIndex if it is not in the tree
+	uint32_t GetIndex(const Node* node) const noexcept;
+
+	/// @return false if node is not in the snapshot
+	bool AddComponentData(const Node* node, AnsiStringView type, const void* data, size_t size);
+
+	/// @return false if node is not in the snapshot
+	bool AddReference(const Node* node, SceneFormat::ReferenceKind kind, AnsiStringView asset);
+
+	/// @param path File system path, overwritten
+	bool Write(const AnsiString& path) const;
+
+	/// @brief The file contents Write() would produce
+	Array<unsigned char> Serialize() const;
+
+private:
+	SceneFormat::StringRef AddString(AnsiStringView str);
+
+	Array<SceneFormat::NodeRecord> m_Nodes;
+	Array<SceneFormat::TransformRecord> m_Transforms;
+	Array<SceneFormat::ComponentRecord> m_Components;
+	Array<SceneFormat::ReferenceRecord> m_References;
+	Array<unsigned char> m_Blobs;
+	AnsiString m_Strings;
+	HashMap<const Node*, uint32_t> m_Indices;
+};
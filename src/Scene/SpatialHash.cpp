@@ -0,0 +1,406 @@
+#include "SpatialHash.h"
+#include "Node.h"
+#include "Transform.h"
+#include "TransformSystem.h"
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <cmath>
+
+namespace
+{
+	/// @brief Cell coordinates are clamped to [-CellLimit, CellLimit) to pack into 21 bits each
+	constexpr int32_t CellLimit = 1 << 20;
+
+	constexpr size_t MinCellCapacity = 16;
+
+	int32_t CellCoordinate(float v) noexcept
+	{
+		// The comparisons also catch NaN and values beyond int32_t
+		const float f = std::floor(v);
+		return f >= CellLimit ? CellLimit - 1 : f >= -CellLimit ? static_cast<int32_t>(f) : -CellLimit;
+	}
+
+	uint64_t PackCell(int32_t x, int32_t y, int32_t z) noexcept
+	{
+		return static_cast<uint64_t>(x + CellLimit) << 42 | static_cast<uint64_t>(y + CellLimit) << 21 | static_cast<uint64_t>(z + CellLimit);
+	}
+
+	void UnpackCell(uint64_t key, int32_t (&cell)[3]) noexcept
+	{
+		constexpr uint64_t mask = (1 << 21) - 1;
+		cell[0] = static_cast<int32_t>(key >> 42) - CellLimit;
+		cell[1] = static_cast<int32_t>((key >> 21) & mask) - CellLimit;
+		cell[2] = static_cast<int32_t>(key & mask) - CellLimit;
+	}
+}
+
+SpatialHash::SpatialHash(float cellSize) :
+	m_CellSize(cellSize), m_InvCellSize(1 / cellSize)
+{
+	assert(cellSize > 0);
+}
+
+uint32_t SpatialHash::Insert(const Sphere& bounds)
+{
+	assert(!bounds.empty());
+	const uint32_t proxy = AllocateProxy();
+	Proxy& p = m_Proxies[proxy];
+	p.bounds = bounds;
+	p.node = nullptr;
+	p.localRadius = bounds.radius;
+	Link(proxy, GetCellKey(bounds));
+	return proxy;
+}
+
+uint32_t SpatialHash::Insert(Node* node, float localRadius)
+{
+	assert(node != nullptr && localRadius >= 0);
+	const uint32_t proxy = AllocateProxy();
+	Proxy& p = m_Proxies[proxy];
+	p.bounds = Sphere();
+	p.node = node;
+	p.localRadius = localRadius;
+	p.cell = EmptyCell;
+	UpdateNodeBounds(proxy);
+
+	SyncEntries();
+	const uint32_t entry = node->GetTransform()->GetIndex();
+	if (entry >= m_EntryProxies.size())
+		m_EntryProxies.resize(entry + 1, InvalidProxy);
+	m_EntryProxies[entry] = proxy;
+	return proxy;
+}
+
+void SpatialHash::Remove(uint32_t proxy)
+{
+	Proxy& p = m_Proxies[proxy];
+	if (p.node != nullptr)
+	{
+		SyncEntries();
+		const uint32_t entry = p.node->GetTransform()->GetIndex();
+		if (entry < m_EntryProxies.size() && m_EntryProxies[entry] == proxy)
+			m_EntryProxies[entry] = InvalidProxy;
+	}
+	Unlink(proxy);
+	p.bounds = Sphere();
+	p.node = nullptr;
+	p.next = m_FreeList;
+	m_FreeList = proxy;
+	--m_ProxyCount;
+}
+
+void SpatialHash::Move(uint32_t proxy, const vec3& center)
+{
+	SetBounds(proxy, Sphere(center, m_Proxies[proxy].bounds.radius));
+}
+
+void SpatialHash::SetRadius(uint32_t proxy, float radius)
+{
+	assert(radius >= 0);
+	Proxy& p = m_Proxies[proxy];
+	if (p.node != nullptr)
+	{
+		p.localRadius = radius;
+		UpdateNodeBounds(proxy);
+	}
+	else
+		SetBounds(proxy, Sphere(p.bounds.center, radius));
+}
+
+void SpatialHash::Build(const SphereSoA& spheres, size_t count)
+{
+	m_Proxies.resize(count);
+	m_FreeList = InvalidProxy;
+	m_ProxyCount = count;
+	m_LargeHead = InvalidProxy;
+	m_EntryProxies.clear();
+	// Every proxy may end up in its own cell
+	m_CellCount = 0;
+	m_Cells.clear();
+	RehashCells(std::max(MinCellCapacity, std::bit_ceil(count * 2)));
+	for (size_t i = 0; i < count; ++i)
+	{
+		Proxy& p = m_Proxies[i];
+		p.bounds = Sphere(vec3(spheres.x[i], spheres.y[i], spheres.z[i]), spheres.radius[i]);
+		p.node = nullptr;
+		p.localRadius = spheres.radius[i];
+		Link(static_cast<uint32_t>(i), GetCellKey(p.bounds));
+	}
+}
+
+void SpatialHash::Refit()
+{
+	SyncEntries();
+	for (uint32_t entry : TransformSystem::GetSingleton()->GetChangedEntries())
+	{
+		const uint32_t proxy = entry < m_EntryProxies.size() ? m_EntryProxies[entry] : InvalidProxy;
+		if (proxy != InvalidProxy)
+			UpdateNodeBounds(proxy);
+	}
+}
+
+uint32_t SpatialHash::GetProxy(const Node* node) const
+{
+	SyncEntries();
+	const uint32_t entry = node->GetTransform()->GetIndex();
+	return entry < m_EntryProxies.size() ? m_EntryProxies[entry] : InvalidProxy;
+}
+
+void SpatialHash::Query(const Sphere& sphere, Array<uint32_t>& out) const
+{
+	if (sphere.empty())
+		return;
+	Collect(GetCellRange(sphere.bounds()), out, [&](uint32_t, const Sphere& bounds) {
+		return sphere.intersects(bounds);
+	});
+}
+
+void SpatialHash::Query(const AABB& box, Array<uint32_t>& out) const
+{
+	if (box.empty())
+		return;
+	Collect(GetCellRange(box), out, [&](uint32_t, const Sphere& bounds) {
+		return bounds.intersects(box);
+	});
+}
+
+void SpatialHash::QueryNeighbors(uint32_t proxy, float distance, Array<uint32_t>& out) const
+{
+	const Sphere& self = m_Proxies[proxy].bounds;
+	const Sphere sphere(self.center, self.radius + distance);
+	Collect(GetCellRange(sphere.bounds()), out, [&](uint32_t other, const Sphere& bounds) {
+		return other != proxy && sphere.intersects(bounds);
+	});
+}
+
+uint64_t SpatialHash::GetCellKey(const Sphere& bounds) const noexcept
+{
+	if (bounds.radius * 2 > m_CellSize)
+		return LargeCell;
+	const vec3 c = bounds.center * m_InvCellSize;
+	return PackCell(CellCoordinate(c.x), CellCoordinate(c.y), CellCoordinate(c.z));
+}
+
+SpatialHash::CellRange SpatialHash::GetCellRange(const AABB& box) const noexcept
+{
+	// A proxy centered in cell c reaches at most half a cell beyond it
+	const vec3 lo = (box.min - vec3(m_CellSize * 0.5f)) * m_InvCellSize;
+	const vec3 hi = (box.max + vec3(m_CellSize * 0.5f)) * m_InvCellSize;
+	return {
+		{ CellCoordinate(lo.x), CellCoordinate(lo.y), CellCoordinate(lo.z) },
+		{ CellCoordinate(hi.x), CellCoordinate(hi.y), CellCoordinate(hi.z) },
+	};
+}
+
+uint32_t SpatialHash::AllocateProxy()
+{
+	++m_ProxyCount;
+	if (m_FreeList == InvalidProxy)
+	{
+		m_Proxies.emplace_back();
+		return static_cast<uint32_t>(m_Proxies.size() - 1);
+	}
+	const uint32_t proxy = m_FreeList;
+	m_FreeList = m_Proxies[proxy].next;
+	return proxy;
+}
+
+void SpatialHash::Link(uint32_t proxy, uint64_t cell)
+{
+	uint32_t* head = &m_LargeHead;
+	if (cell != LargeCell)
+	{
+		Cell& c = FindOrAddCell(cell);
+		++c.count;
+		head = &c.head;
+	}
+	Proxy& p = m_Proxies[proxy];
+	p.cell = cell;
+	p.prev = InvalidProxy;
+	p.next = *head;
+	if (*head != InvalidProxy)
+		m_Proxies[*head].prev = proxy;
+	*head = proxy;
+}
+
+void SpatialHash::Unlink(uint32_t proxy) noexcept
+{
+	Proxy& p = m_Proxies[proxy];
+	if (p.cell == EmptyCell)
+		return;
+	if (p.next != InvalidProxy)
+		m_Proxies[p.next].prev = p.prev;
+	if (p.cell == LargeCell)
+	{
+		if (p.prev != InvalidProxy)
+			m_Proxies[p.prev].next = p.next;
+		else
+			m_LargeHead = p.next;
+	}
+	else
+	{
+		Cell& c = m_Cells[FindCell(p.cell)];
+		if (p.prev != InvalidProxy)
+			m_Proxies[p.prev].next = p.next;
+		else
+			c.head = p.next;
+		if (--c.count == 0)
+			RemoveCell(p.cell);
+	}
+	p.cell = EmptyCell;
+}
+
+void SpatialHash::SetBounds(uint32_t proxy, const Sphere& bounds)
+{
+	const uint64_t cell = GetCellKey(bounds);
+	if (cell != m_Proxies[proxy].cell)
+	{
+		Unlink(proxy);
+		Link(proxy, cell);
+	}
+	m_Proxies[proxy].bounds = bounds;
+}
+
+void SpatialHash::UpdateNodeBounds(uint32_t proxy)
+{
+	const Transform* transform = m_Proxies[proxy].node->GetTransform();
+	const vec3& scale = transform->GetWorldScale();
+	const float maxScale = std::max({ Mathf::abs(scale.x), Mathf::abs(scale.y), Mathf::abs(scale.z) });
+	SetBounds(proxy, Sphere(transform->GetWorldPosition(), m_Proxies[proxy].localRadius * maxScale));
+}
+
+size_t SpatialHash::CellSlot(uint64_t key) const noexcept
+{
+	return static_cast<size_t>((key * 0x9E3779B97F4A7C15ull) >> 32) & (m_Cells.size() - 1);
+}
+
+size_t SpatialHash::FindCell(uint64_t key) const noexcept
+{
+	if (m_Cells.empty())
+		return SIZE_MAX;
+	const size_t mask = m_Cells.size() - 1;
+	for (size_t i = CellSlot(key); m_Cells[i].key != EmptyCell; i = (i + 1) & mask)
+	{
+		if (m_Cells[i].key == key)
+			return i;
+	}
+	return SIZE_MAX;
+}
+
+SpatialHash::Cell& SpatialHash::FindOrAddCell(uint64_t key)
+{
+	// Keep the load factor at most 1/2
+	if ((m_CellCount + 1) * 2 > m_Cells.size())
+		RehashCells(std::max(MinCellCapacity, std::bit_ceil((m_CellCount + 1) * 4)));
+	const size_t mask = m_Cells.size() - 1;
+	size_t i = CellSlot(key);
+	while (m_Cells[i].key != EmptyCell)
+	{
+		if (m_Cells[i].key == key)
+			return m_Cells[i];
+		i = (i + 1) & mask;
+	}
+	++m_CellCount;
+	m_Cells[i] = { key, InvalidProxy, 0 };
+	return m_Cells[i];
+}
+
+void SpatialHash::RemoveCell(uint64_t key) noexcept
+{
+	size_t hole = FindCell(key);
+	if (hole == SIZE_MAX)
+		return;
+	// Move later entries of the probe run into the hole unless that would put them before their home slot
+	const size_t mask = m_Cells.size() - 1;
+	for (size_t i = (hole + 1) & mask; m_Cells[i].key != EmptyCell; i = (i + 1) & mask)
+	{
+		const size_t home = CellSlot(m_Cells[i].key);
+		if (((i - home) & mask) >= ((i - hole) & mask))
+		{
+			m_Cells[hole] = m_Cells[i];
+			hole = i;
+		}
+	}
+	m_Cells[hole].key = EmptyCell;
+	--m_CellCount;
+}
+
+void SpatialHash::RehashCells(size_t capacity)
+{
+	Array<Cell> cells(capacity, Cell{ EmptyCell, InvalidProxy, 0 });
+	m_Cells.swap(cells);
+	const size_t mask = capacity - 1;
+	for (const Cell& cell : cells)
+	{
+		if (cell.key == EmptyCell)
+			continue;
+		size_t i = CellSlot(cell.key);
+		while (m_Cells[i].key != EmptyCell)
+			i = (i + 1) & mask;
+		m_Cells[i] = cell;
+	}
+}
+
+void SpatialHash::SyncEntries() const
+{
+	const TransformSystem* system = TransformSystem::GetSingleton();
+	if (system->GetLayoutGeneration() == m_LayoutGeneration)
+	{
+		// New entries are appended without a layout change
+		if (m_EntryProxies.size() < system->GetCount())
+			m_EntryProxies.resize(system->GetCount(), InvalidProxy);
+		return;
+	}
+	m_LayoutGeneration = system->GetLayoutGeneration();
+	m_EntryProxies.assign(system->GetCount(), InvalidProxy);
+	for (uint32_t i = 0; i < m_Proxies.size(); ++i)
+	{
+		if (m_Proxies[i].node != nullptr)
+			m_EntryProxies[m_Proxies[i].node->GetTransform()->GetIndex()] = i;
+	}
+}
+
+template <typename Test>
+void SpatialHash::Collect(const CellRange& range, Array<uint32_t>& out, Test&& test) const
+{
+	auto collectList = [&](uint32_t proxy) {
+		for (; proxy != InvalidProxy; proxy = m_Proxies[proxy].next)
+		{
+			if (test(proxy, m_Proxies[proxy].bounds))
+				out.push_back(proxy);
+		}
+	};
+	const double volume = double(range.max[0] - range.min[0] + 1) * double(range.max[1] - range.min[1] + 1) * double(range.max[2] - range.min[2] + 1);
+	if (volume <= static_cast<double>(m_CellCount))
+	{
+		for (int32_t x = range.min[0]; x <= range.max[0]; ++x)
+		{
+			for (int32_t y = range.min[1]; y <= range.max[1]; ++y)
+			{
+				for (int32_t z = range.min[2]; z <= range.max[2]; ++z)
+				{
+					const size_t slot = FindCell(PackCell(x, y, z));
+					if (slot != SIZE_MAX)
+						collectList(m_Cells[slot].head);
+				}
+			}
+		}
+	}
+	else
+	{
+		// Fewer occupied cells than cells in range: scan the table instead of probing each
+		for (const Cell& cell : m_Cells)
+		{
+			if (cell.key == EmptyCell)
+				continue;
+			int32_t c[3];
+			UnpackCell(cell.key, c);
+			if (c[0] >= range.min[0] && c[0] <= range.max[0] && c[1] >= range.min[1] && c[1] <= range.max[1] &&
+				c[2] >= range.min[2] && c[2] <= range.max[2])
+				collectList(cell.head);
+		}
+	}
+	collectList(m_LargeHead);
+}
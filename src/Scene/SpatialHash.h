@@ -0,0 +1,155 @@
+#pragma once
+
+#include "../Math/BatchCulling.h"
+#include "../Utilities/Array.h"
+
+#include <cstdint>
+
+class Node;
+
+/// @brief Loose uniform grid over bounding spheres, stored in a hash table of occupied cells.
+/// Each proxy lives in the one cell containing its center, so moving it is O(1): update the
+/// center, and relink it only when it crossed into another cell. Queries visit every cell
+/// whose bounds, grown by half a cell, touch the query. Proxies larger than half a cell are
+/// kept in one separate list that every query tests.
+/// Suited to many small objects that all move every frame, where a BVH would mostly refit.
+/// Proxies either follow a node's Transform through Refit(), or are placed directly with
+/// Move() or Build(), e.g. for particles that have no node.
+/// @note Remove a node's proxy before destroying the node.
+class SpatialHash final
+{
+public:
+	static constexpr uint32_t InvalidProxy = UINT32_MAX;
+
+	/// @param cellSize Edge length of a cell. Works best at about the size of typical queries, and
+	/// proxies above half of it fall back to the large list.
+	explicit SpatialHash(float cellSize = 4.0f);
+
+	SpatialHash(const SpatialHash&) = delete;
+
+	SpatialHash& operator=(const SpatialHash&) = delete;
+
+	/// @brief Add a proxy placed directly.
+	/// @return Proxy id, stable until Remove() or Build()
+	uint32_t Insert(const Sphere& bounds);
+
+	/// @brief Add a proxy that follows node: centered at its world position, radius scaled by its
+	/// largest world scale
+	uint32_t Insert(Node* node, float localRadius);
+
+	void Remove(uint32_t proxy);
+
+	void Move(uint32_t proxy, const vec3& center);
+
+	void SetRadius(uint32_t proxy, float radius);
+
+	/// @brief Replace every proxy by spheres[0, count), proxy i being sphere i
+	void Build(const SphereSoA& spheres, size_t count);
+
+	/// @brief Follow the node transforms changed by the last TransformSystem::Update()
+	void Refit();
+
+	const Sphere& GetBounds(uint32_t proxy) const noexcept { return m_Proxies[proxy].bounds; }
+
+	/// @return nullptr for proxies placed directly
+	Node* GetNode(uint32_t proxy) const noexcept { return m_Proxies[proxy].node; }
+
+	/// @return InvalidProxy if node has no proxy
+	uint32_t GetProxy(const Node* node) const;
+
+	size_t GetProxyCount() const noexcept { return m_ProxyCount; }
+
+	/// @brief Number of cells holding at least one proxy
+	size_t GetCellCount() const noexcept { return m_CellCount; }
+
+	float GetCellSize() const noexcept { return m_CellSize; }
+
+	/// @brief Append proxies whose bounds intersect sphere
+	void Query(const Sphere& sphere, Array<uint32_t>& out) const;
+
+	/// @brief Append proxies whose bounds intersect box
+	void Query(const AABB& box, Array<uint32_t>& out) const;
+
+	/// @brief Append other proxies whose bounds come within distance of proxy's bounds
+	void QueryNeighbors(uint32_t proxy, float distance, Array<uint32_t>& out) const;
+
+private:
+	/// @brief Cell key of the list of proxies larger than half a cell
+	static constexpr uint64_t LargeCell = UINT64_MAX - 1;
+
+	/// @brief Key of unused hash table slots
+	static constexpr uint64_t EmptyCell = UINT64_MAX;
+
+	struct Proxy
+	{
+		/// @brief Empty while on the free list
+		Sphere bounds;
+		/// @brief Neighbors in the cell list; next free proxy while on the free list
+		uint32_t prev;
+		uint32_t next;
+		uint64_t cell;
+		Node* node;
+		float localRadius;
+	};
+
+	struct Cell
+	{
+		uint64_t key;
+		uint32_t head;
+		uint32_t count;
+	};
+
+	struct CellRange
+	{
+		int32_t min[3];
+		int32_t max[3];
+	};
+
+	uint64_t GetCellKey(const Sphere& bounds) const noexcept;
+
+	/// @brief Cells whose loose bounds may touch box
+	CellRange GetCellRange(const AABB& box) const noexcept;
+
+	uint32_t AllocateProxy();
+
+	void Link(uint32_t proxy, uint64_t cell);
+
+	void Unlink(uint32_t proxy) noexcept;
+
+	/// @brief Set bounds, relinking the proxy if its cell changes
+	void SetBounds(uint32_t proxy, const Sphere& bounds);
+
+	/// @brief Refresh bounds of a node proxy from its Transform
+	void UpdateNodeBounds(uint32_t proxy);
+
+	size_t CellSlot(uint64_t key) const noexcept;
+
+	/// @return Slot of the cell, SIZE_MAX if it is empty
+	size_t FindCell(uint64_t key) const noexcept;
+
+	Cell& FindOrAddCell(uint64_t key);
+
+	void RemoveCell(uint64_t key) noexcept;
+
+	void RehashCells(size_t capacity);
+
+	/// @brief Map from TransformSystem entries to proxies, rebuilt when the entries move
+	void SyncEntries() const;
+
+	/// @brief Test every proxy of the cells in range and the large list with test
+	template <typename Test>
+	void Collect(const CellRange& range, Array<uint32_t>& out, Test&& test) const;
+
+	float m_CellSize;
+	float m_InvCellSize;
+	Array<Proxy> m_Proxies;
+	uint32_t m_FreeList = InvalidProxy;
+	size_t m_ProxyCount = 0;
+	/// @brief Open addressing, linear probing, load factor at most 1/2
+	Array<Cell> m_Cells;
+	size_t m_CellCount = 0;
+	uint32_t m_LargeHead = InvalidProxy;
+	/// @brief Proxy of each TransformSystem entry
+	mutable Array<uint32_t> m_EntryProxies;
+	mutable uint32_t m_LayoutGeneration = UINT32_MAX;
+};
@@ -2,55 +2,72 @@
 #include "Node.h"
 
 #include "..\Math\mat3.h"
+#include "..\Math\BatchTransform.h"
 
 Transform::Transform(Node* node) :
-	Component(node), m_Scale(1, 1, 1), m_WorldScale(1, 1, 1), m_bDirty(false)
+	Component(node), m_Index(TransformSystem::GetSingleton()->Allocate(this))
 {
 }
 
 Transform::~Transform()
 {
+	TransformSystem::GetSingleton()->Free(m_Index);
 }
 
 const vec3& Transform::GetPosition() const noexcept
 {
-	return m_Position;
+	return TransformSystem::GetSingleton()->m_Positions[m_Index];
 }
 
 const vec3& Transform::GetWorldPosition() const noexcept
 {
-	if (m_bDirty)
-		UpdateWorldTransform();
-	return m_WorldPosition;
+	TransformSystem* system = TransformSystem::GetSingleton();
+	system->Resolve(m_Index);
+	return system->m_WorldPositions[m_Index];
 }
 
 const vec3& Transform::GetScale() const noexcept
 {
-	return m_Scale;
+	return TransformSystem::GetSingleton()->m_Scales[m_Index];
 }
 
 const vec3& Transform::GetWorldScale() const noexcept
 {
-	if (m_bDirty)
-		UpdateWorldTransform();
-	return m_WorldScale;
+	TransformSystem* system = TransformSystem::GetSingleton();
+	system->Resolve(m_Index);
+	return system->m_WorldScales[m_Index];
 }
 
 const Quaternion& Transform::GetRotation() const noexcept
 {
-	return m_Rotation;
+	return TransformSystem::GetSingleton()->m_Rotations[m_Index];
 }
 
 const Quaternion& Transform::GetWorldRotation() const noexcept
 {
-	if (m_bDirty)
-		UpdateWorldTransform();
-	return m_WorldRotation;
+	TransformSystem* system = TransformSystem::GetSingleton();
+	system->Resolve(m_Index);
+	return system->m_WorldRotations[m_Index];
+}
+
+uint32_t Transform::GetWorldGeneration() const noexcept
+{
+	return TransformSystem::GetSingleton()->m_WorldGenerations[m_Index];
+}
+
+const Affine3& Transform::GetWorldMatrix() const noexcept
+{
+	return TransformSystem::GetSingleton()->GetWorldMatrix(m_Index);
+}
+
+const Affine3& Transform::GetWorldToLocalMatrix() const noexcept
+{
+	return TransformSystem::GetSingleton()->GetWorldToLocalMatrix(m_Index);
 }
 
 void Transform::SetPosition(const vec3& position) noexcept
 {
-	m_Position = position;
+	TransformSystem::GetSingleton()->m_Positions[m_Index] = position;
 	MarkDirty();
 }
 
@@ -64,7 +81,7 @@ void Transform::SetWorldPosition(const vec3& position) noexcept
 
 void Transform::SetScale(const vec3& scales) noexcept
 {
-	m_Scale = scales;
+	TransformSystem::GetSingleton()->m_Scales[m_Index] = scales;
 	MarkDirty();
 }
 
@@ -78,7 +95,7 @@ void Transform::SetWorldScale(const vec3& scales) noexcept
 
 void Transform::SetRotation(const Quaternion& rotation) noexcept
 {
-	m_Rotation = rotation;
+	TransformSystem::GetSingleton()->m_Rotations[m_Index] = rotation;
 	MarkDirty();
 }
 
@@ -102,7 +119,7 @@ void Transform::Translate(const vec3& translation, TransformSpace space) noexcep
 	{
 		_trans = LocalToParent(translation);
 	}
-	m_Position += _trans;
+	TransformSystem::GetSingleton()->m_Positions[m_Index] += _trans;
 	MarkDirty();
 }
 
@@ -114,7 +131,7 @@ void Transform::Scale(const vec3& scales, TransformSpace space) noexcept
 		if (Node* parent = GetNode()->GetParent(); parent)
 			_scales = scales / parent->GetTransform()->GetWorldScale();
 	}
-	m_Scale *= _scales;
+	TransformSystem::GetSingleton()->m_Scales[m_Index] *= _scales;
 	MarkDirty();
 }
 
@@ -128,61 +145,44 @@ void Transform::Rotate(const Quaternion& rotation, TransformSpace space) noexcep
 	}
 	else if (space == TransformSpace::Self)
 	{
-		rot = m_Rotation * rotation;
+		rot = GetRotation() * rotation;
 	}
-	m_Rotation = rot * m_Rotation;
+	Quaternion& local = TransformSystem::GetSingleton()->m_Rotations[m_Index];
+	local = rot * local;
 	MarkDirty();
 }
 
 vec3 Transform::LocalToParent(const vec3& v) const noexcept
 {
-	return m_Position + m_Scale * (mat3(m_Rotation) * v);
+	return GetPosition() + GetScale() * GetRotation().rotate(v);
 }
 
 vec3 Transform::ParentToLocal(const vec3& v) const noexcept
 {
-	return mat3(m_Rotation.inverse()) * ((v - m_Position) / m_Scale);
+	return GetRotation().inverse().rotate((v - GetPosition()) / GetScale());
 }
 
 vec3 Transform::LocalToWorld(const vec3& v) const noexcept
 {
-	if (m_bDirty)
-		UpdateWorldTransform();
-	return m_WorldPosition + m_WorldScale * (mat3(m_WorldRotation) * v);
+	return GetWorldMatrix().transform_point(v);
 }
 
 vec3 Transform::WorldToLocal(const vec3& v) const noexcept
 {
-	if (m_bDirty)
-		UpdateWorldTransform();
-	return mat3(m_WorldRotation.inverse()) * ((v - m_WorldPosition) / m_WorldScale);
+	return GetWorldToLocalMatrix().transform_point(v);
 }
 
-void Transform::MarkDirty() const noexcept
+void Transform::LocalToWorld(const vec3* in, vec3* out, size_t count) const noexcept
 {
-	if (m_bDirty)
-		return;
-	m_bDirty = true;
-	for (const auto& p : GetNode()->m_Children)
-		p->GetTransform()->MarkDirty();
+	TransformPoints(GetWorldMatrix(), in, out, count);
 }
 
-void Transform::UpdateWorldTransform() const noexcept
+void Transform::SetParent(const Transform* parent) noexcept
 {
-	Node* parent = GetNode()->GetParent();
-	if (parent)
-	{
-		Transform* pt = parent->GetTransform();
-		pt->UpdateWorldTransform();
-		m_WorldPosition = pt->m_WorldPosition + pt->LocalToWorld(m_Position);
-		m_WorldScale = pt->m_WorldScale * m_Scale;
-		m_WorldRotation = pt->m_WorldRotation * m_Rotation;
-	}
-	else
-	{
-		m_WorldPosition = m_Position;
-		m_WorldScale = m_Scale;
-		m_WorldRotation = m_Rotation;
-	}
-	m_bDirty = false;
-}
\ No newline at end of file
+	TransformSystem::GetSingleton()->SetParent(m_Index, parent ? parent->m_Index : TransformSystem::InvalidIndex);
+}
+
+void Transform::MarkDirty() const noexcept
+{
+	TransformSystem::GetSingleton()->MarkDirty(m_Index);
+}
@@ -1,7 +1,7 @@
 #pragma once
 
 #include "Component.h"
-#include "../Math/Quaternion.h"
+#include "TransformSystem.h"
 
 enum class TransformSpace
 {
@@ -10,9 +10,12 @@ enum class TransformSpace
 	Self
 };
 
+/// @brief Position, scale and rotation of a Node relative to its parent.
+/// The data lives in TransformSystem; a Transform is a view of one entry there.
 class Transform final : public Component
 {
 	friend class Node;
+	friend class TransformSystem;
 
 public:
 	~Transform() override;
@@ -29,6 +32,20 @@ public:
 
 	const Quaternion& GetWorldRotation() const noexcept;
 
+	/// @brief TransformSystem generation in which the world transform last changed.
+	/// Compare with a stored value to skip work, e.g. re-uploading an unchanged model matrix.
+	uint32_t GetWorldGeneration() const noexcept;
+
+	/// @brief Local to world matrix, cached until the world transform changes.
+	/// @note The reference is valid until the next Transform is created or TransformSystem::Update() runs.
+	const Affine3& GetWorldMatrix() const noexcept;
+
+	/// @brief Inverse of GetWorldMatrix(), cached the same way
+	const Affine3& GetWorldToLocalMatrix() const noexcept;
+
+	/// @brief Entry in TransformSystem. Changes whenever TransformSystem::GetLayoutGeneration() does.
+	uint32_t GetIndex() const noexcept { return m_Index; }
+
 	void SetPosition(const vec3& position) noexcept;
 
 	void SetWorldPosition(const vec3& position) noexcept;
@@ -55,18 +72,19 @@ public:
 
 	vec3 WorldToLocal(const vec3& v) const noexcept;
 
+	/// @brief Batch version of LocalToWorld
+	/// @param in Local space points
+	/// @param out World space points, may be the same array as in
+	/// @param count Points count
+	void LocalToWorld(const vec3* in, vec3* out, size_t count) const noexcept;
+
 private:
 	Transform(Node* node);
 
-	void MarkDirty() const noexcept;
+	void SetParent(const Transform* parent) noexcept;
 
-	void UpdateWorldTransform() const noexcept;
+	void MarkDirty() const noexcept;
 
-	vec3 m_Position;
-	vec3 m_Scale;
-	Quaternion m_Rotation;
-	mutable vec3 m_WorldPosition;
-	mutable vec3 m_WorldScale;
-	mutable Quaternion m_WorldRotation;
-	mutable bool m_bDirty;
+	/// @brief Entry in TransformSystem, updated when the system reorders
+	uint32_t m_Index;
 };
\ No newline at end of file
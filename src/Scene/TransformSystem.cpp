@@ -0,0 +1,355 @@
+#include "TransformSystem.h"
+#include "Transform.h"
+#include "../Utilities/ThreadPool.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <type_traits>
+
+namespace
+{
+	/// @brief Smallest subtree worth a task of its own
+	constexpr uint32_t MinTaskSize = 512;
+
+	/// @brief Tasks per thread to even out uneven subtrees
+	constexpr size_t TasksPerThread = 4;
+}
+
+TransformSystem* TransformSystem::GetSingleton() noexcept
+{
+	static TransformSystem system;
+	return &system;
+}
+
+void TransformSystem::Update(ThreadPool* pool)
+{
+	m_Journal.clear();
+	// Restore depth-first order once the hierarchy stops changing, or right away if it is required
+	if (m_bOrderDirty || m_FreeCount * 2 > m_Owners.size() || (!m_bDepthFirst && !m_bStructureChanged))
+		Reorder();
+	m_bStructureChanged = false;
+	++m_Generation;
+	if (m_DirtyList.empty())
+		return;
+
+	std::sort(m_DirtyList.begin(), m_DirtyList.end());
+	if (m_bDepthFirst && pool != nullptr && pool->GetThreadCount() > 1)
+		UpdateParallel(*pool);
+	else if (m_bDepthFirst)
+	{
+		// Each dirty subtree is a contiguous range, skip dirty entries inside a range already done
+		uint32_t end = 0;
+		for (uint32_t index : m_DirtyList)
+		{
+			if (index < end)
+				continue;
+			end = index + m_SubtreeSizes[index];
+			for (uint32_t i = index; i < end; ++i)
+				Refresh(i);
+		}
+	}
+	else
+	{
+		const size_t count = m_Owners.size();
+		for (size_t i = m_DirtyList.front(); i < count; ++i)
+		{
+			const uint32_t parent = m_Parents[i];
+			if (parent != InvalidIndex)
+				m_Dirty[i] |= m_Dirty[parent];
+			if (m_Dirty[i])
+				Refresh(static_cast<uint32_t>(i));
+		}
+	}
+
+	for (uint32_t index : m_DirtyList)
+		m_Dirty[index] = 0;
+	for (uint32_t index : m_Journal)
+		m_Dirty[index] = 0;
+	m_DirtyList.clear();
+}
+
+uint32_t TransformSystem::Allocate(Transform* owner)
+{
+	// A new root at the end keeps the depth-first order
+	const uint32_t index = static_cast<uint32_t>(m_Owners.size());
+	m_Owners.push_back(owner);
+	m_Parents.push_back(InvalidIndex);
+	m_Positions.emplace_back();
+	m_Scales.emplace_back(1, 1, 1);
+	m_Rotations.emplace_back();
+	m_WorldPositions.emplace_back();
+	m_WorldScales.emplace_back(1, 1, 1);
+	m_WorldRotations.emplace_back();
+	m_WorldGenerations.push_back(m_Generation);
+	m_WorldMatrices.emplace_back();
+	m_WorldToLocalMatrices.emplace_back();
+	m_MatrixFlags.push_back(WorldMatrixValid | WorldToLocalMatrixValid);
+	m_SubtreeSizes.push_back(1);
+	m_Dirty.push_back(0);
+	return index;
+}
+
+void TransformSystem::Free(uint32_t index) noexcept
+{
+	// The entry stays in place until the next Reorder(), subtree ranges remain valid
+	m_Owners[index] = nullptr;
+	m_Parents[index] = InvalidIndex;
+	++m_FreeCount;
+}
+
+void TransformSystem::SetParent(uint32_t index, uint32_t parent) noexcept
+{
+	m_Parents[index] = parent;
+	// Appending a new child keeps parents first, moving a subtree under a later entry does not
+	if (parent != InvalidIndex && parent > index)
+		m_bOrderDirty = true;
+	m_bDepthFirst = false;
+	m_bStructureChanged = true;
+	MarkDirty(index);
+}
+
+void TransformSystem::MarkDirty(uint32_t index) noexcept
+{
+	if (m_Dirty[index])
+		return;
+	m_Dirty[index] = 1;
+	m_DirtyList.push_back(index);
+}
+
+bool TransformSystem::Resolve(uint32_t index) noexcept
+{
+	if (m_DirtyList.empty())
+		return false;
+	const uint32_t parent = m_Parents[index];
+	const bool bParentChanged = parent != InvalidIndex && Resolve(parent);
+	if (bParentChanged || m_Dirty[index])
+	{
+		Combine(index);
+		return true;
+	}
+	return false;
+}
+
+void TransformSystem::Combine(uint32_t index) noexcept
+{
+	const uint32_t parent = m_Parents[index];
+	if (parent != InvalidIndex)
+	{
+		const vec3& ws = m_WorldScales[parent];
+		const Quaternion& wr = m_WorldRotations[parent];
+		m_WorldPositions[index] = m_WorldPositions[parent] + ws * wr.rotate(m_Positions[index]);
+		m_WorldScales[index] = ws * m_Scales[index];
+		m_WorldRotations[index] = wr * m_Rotations[index];
+	}
+	else
+	{
+		m_WorldPositions[index] = m_Positions[index];
+		m_WorldScales[index] = m_Scales[index];
+		m_WorldRotations[index] = m_Rotations[index];
+	}
+	m_MatrixFlags[index] = 0;
+}
+
+const Affine3& TransformSystem::GetWorldMatrix(uint32_t index) noexcept
+{
+	Resolve(index);
+	if (!(m_MatrixFlags[index] & WorldMatrixValid))
+	{
+		m_WorldMatrices[index] = Affine3(m_WorldPositions[index], m_WorldScales[index], m_WorldRotations[index]);
+		m_MatrixFlags[index] |= WorldMatrixValid;
+	}
+	return m_WorldMatrices[index];
+}
+
+const Affine3& TransformSystem::GetWorldToLocalMatrix(uint32_t index) noexcept
+{
+	const Affine3& world = GetWorldMatrix(index);
+	if (!(m_MatrixFlags[index] & WorldToLocalMatrixValid))
+	{
+		m_WorldToLocalMatrices[index] = world.inverse();
+		m_MatrixFlags[index] |= WorldToLocalMatrixValid;
+	}
+	return m_WorldToLocalMatrices[index];
+}
+
+void TransformSystem::ExportWorldMatrices(std::span<mat4> out, size_t first) noexcept
+{
+	assert(first + out.size() <= m_Owners.size());
+	for (size_t i = 0; i < out.size(); ++i)
+		out[i] = static_cast<mat4>(GetWorldMatrix(static_cast<uint32_t>(first + i)));
+}
+
+void TransformSystem::ExportWorldMatrices(std::span<const uint32_t> entries, std::span<mat4> out) noexcept
+{
+	assert(out.size() >= entries.size());
+	for (size_t i = 0; i < entries.size(); ++i)
+		out[i] = static_cast<mat4>(GetWorldMatrix(entries[i]));
+}
+
+void TransformSystem::Refresh(uint32_t index)
+{
+	Combine(index);
+	if (m_Owners[index] != nullptr)
+	{
+		m_WorldGenerations[index] = m_Generation;
+		m_Journal.push_back(index);
+	}
+}
+
+void TransformSystem::UpdateParallel(ThreadPool& pool)
+{
+	m_Ranges.clear();
+	size_t total = 0;
+	uint32_t end = 0;
+	for (uint32_t index : m_DirtyList)
+	{
+		if (index < end)
+			continue;
+		end = index + m_SubtreeSizes[index];
+		m_Ranges.push_back(index);
+		total += m_SubtreeSizes[index];
+	}
+
+	// Split subtrees above the task size: the root is updated here and its children become
+	// candidates in turn, so every task starts below an up to date parent
+	const size_t taskSize = std::max<size_t>(MinTaskSize, total / (pool.GetThreadCount() * TasksPerThread));
+	m_Tasks.assign(m_Ranges.begin(), m_Ranges.end());
+	for (size_t k = 0; k < m_Tasks.size(); ++k)
+	{
+		const uint32_t root = m_Tasks[k];
+		if (m_SubtreeSizes[root] <= taskSize)
+			continue;
+		Combine(root);
+		if (m_Owners[root] != nullptr)
+			m_WorldGenerations[root] = m_Generation;
+		m_Tasks[k] = InvalidIndex;
+		for (uint32_t child = root + 1; child < root + m_SubtreeSizes[root]; child += m_SubtreeSizes[child])
+			m_Tasks.push_back(child);
+	}
+	std::erase(m_Tasks, InvalidIndex);
+	// Largest first, so a big task does not start last
+	std::sort(m_Tasks.begin(), m_Tasks.end(), [this](uint32_t a, uint32_t b) {
+		return m_SubtreeSizes[a] > m_SubtreeSizes[b];
+	});
+
+	pool.ParallelFor(m_Tasks.size(), [this](size_t k) {
+		const uint32_t root = m_Tasks[k];
+		for (uint32_t i = root; i < root + m_SubtreeSizes[root]; ++i)
+		{
+			Combine(i);
+			if (m_Owners[i] != nullptr)
+				m_WorldGenerations[i] = m_Generation;
+		}
+	});
+
+	// Journal in index order like the serial update
+	for (uint32_t root : m_Ranges)
+	{
+		for (uint32_t i = root; i < root + m_SubtreeSizes[root]; ++i)
+		{
+			if (m_Owners[i] != nullptr)
+				m_Journal.push_back(i);
+		}
+	}
+}
+
+void TransformSystem::Reorder()
+{
+	const size_t count = m_Owners.size();
+	// Children lists as index ranges: first child and next sibling, siblings in current order
+	Array<uint32_t>& first = m_ReorderFirst;
+	Array<uint32_t>& next = m_ReorderNext;
+	Array<uint32_t>& stack = m_ReorderStack;
+	first.assign(count, InvalidIndex);
+	next.assign(count, InvalidIndex);
+	stack.clear();
+	for (size_t i = count; i-- > 0;)
+	{
+		if (m_Owners[i] == nullptr)
+			continue;
+		if (m_Parents[i] == InvalidIndex)
+			stack.push_back(static_cast<uint32_t>(i));
+		else
+		{
+			next[i] = first[m_Parents[i]];
+			first[m_Parents[i]] = static_cast<uint32_t>(i);
+		}
+	}
+
+	Array<uint32_t>& order = m_ReorderOrder;
+	order.clear();
+	while (!stack.empty())
+	{
+		uint32_t i = stack.back();
+		stack.pop_back();
+		order.push_back(i);
+		// Push children in reverse so the first child is visited first
+		const size_t mark = stack.size();
+		for (uint32_t c = first[i]; c != InvalidIndex; c = next[c])
+			stack.push_back(c);
+		std::reverse(stack.begin() + mark, stack.end());
+	}
+
+	// Old index to new index, then remap parents
+	Array<uint32_t>& remap = first;
+	std::fill(remap.begin(), remap.end(), InvalidIndex);
+	for (size_t k = 0; k < order.size(); ++k)
+		remap[order[k]] = static_cast<uint32_t>(k);
+	Gather(m_Owners, order, m_GatherScratch);
+	Gather(m_Parents, order, m_GatherScratch);
+	for (uint32_t& parent : m_Parents)
+	{
+		if (parent != InvalidIndex)
+			parent = remap[parent];
+	}
+	Gather(m_Positions, order, m_GatherScratch);
+	Gather(m_Scales, order, m_GatherScratch);
+	Gather(m_Rotations, order, m_GatherScratch);
+	Gather(m_WorldPositions, order, m_GatherScratch);
+	Gather(m_WorldScales, order, m_GatherScratch);
+	Gather(m_WorldRotations, order, m_GatherScratch);
+	Gather(m_WorldGenerations, order, m_GatherScratch);
+	Gather(m_WorldMatrices, order, m_GatherScratch);
+	Gather(m_WorldToLocalMatrices, order, m_GatherScratch);
+	Gather(m_MatrixFlags, order, m_GatherScratch);
+	Gather(m_Dirty, order, m_GatherScratch);
+	for (size_t k = 0; k < m_Owners.size(); ++k)
+		m_Owners[k]->m_Index = static_cast<uint32_t>(k);
+
+	// Pending changes of live entries follow them to their new index
+	size_t dirty = 0;
+	for (uint32_t index : m_DirtyList)
+	{
+		if (remap[index] != InvalidIndex)
+			m_DirtyList[dirty++] = remap[index];
+	}
+	m_DirtyList.resize(dirty);
+
+	// Children follow their parent, so accumulating backwards sees every child before its parent
+	m_SubtreeSizes.assign(m_Owners.size(), 1);
+	for (size_t k = m_Owners.size(); k-- > 0;)
+	{
+		if (m_Parents[k] != InvalidIndex)
+			m_SubtreeSizes[m_Parents[k]] += m_SubtreeSizes[k];
+	}
+
+	m_FreeCount = 0;
+	m_bOrderDirty = false;
+	m_bDepthFirst = true;
+	++m_LayoutGeneration;
+}
+
+template <typename T>
+void TransformSystem::Gather(Array<T>& data, const Array<uint32_t>& order, Array<unsigned char>& scratch)
+{
+	// Through a byte copy instead of a new array, so data keeps its capacity and steady
+	// create/destroy churn does not reallocate. The bytes hold no T objects, so every element
+	// is copied back with memcpy rather than read through a T pointer.
+	static_assert(std::is_trivially_copyable_v<T>);
+	scratch.resize(data.size() * sizeof(T));
+	std::memcpy(scratch.data(), data.data(), scratch.size());
+	data.resize(order.size());
+	for (size_t k = 0; k < order.size(); ++k)
+		std::memcpy(&data[k], scratch.data() + order[k] * sizeof(T), sizeof(T));
+}
@@ -0,0 +1,157 @@
+#pragma once
+
+#include "../Math/Affine3.h"
+#include "../Math/Quaternion.h"
+#include "../Utilities/Array.h"
+
+#include <cstdint>
+#include <span>
+
+class Transform;
+class ThreadPool;
+
+/// @brief Storage of every Transform.
+/// Local and world TRS live in flat arrays, ordered so that a parent always precedes its children.
+/// Setters append the changed entry to a dirty list, Update() then recomputes the affected world
+/// transforms and records them in a change journal. Between updates world getters resolve the
+/// ancestor chain of a single entry.
+///
+/// While the hierarchy is stable the entries are in depth-first order, every subtree is one
+/// contiguous range and Update() only visits changed subtrees. A frame that adds or moves nodes
+/// falls back to one linear pass; the depth-first order is restored on the next stable frame.
+class TransformSystem final
+{
+	friend class Transform;
+
+public:
+	static constexpr uint32_t InvalidIndex = UINT32_MAX;
+
+	static TransformSystem* GetSingleton() noexcept;
+
+	TransformSystem(const TransformSystem&) = delete;
+
+	TransformSystem& operator=(const TransformSystem&) = delete;
+
+	/// @brief Recompute world transforms of every changed entry and its descendants,
+	/// replace the change journal and advance the generation.
+	/// @param pool If given, independent changed subtrees are updated on its threads. Subtrees larger
+	/// than a task are split below their root, level by level. Results, journal and generations are
+	/// identical to the serial update. Frames that changed the hierarchy run serially.
+	void Update(ThreadPool* pool = nullptr);
+
+	/// @brief Number of Update() calls so far
+	uint32_t GetGeneration() const noexcept { return m_Generation; }
+
+	/// @brief Advanced whenever Update() moves entries to other indices.
+	/// Consumers caching entry indices must rebuild them when it changes.
+	uint32_t GetLayoutGeneration() const noexcept { return m_LayoutGeneration; }
+
+	/// @brief Entries whose world transform the last Update() changed, in increasing order.
+	/// Destroyed entries are left out.
+	const Array<uint32_t>& GetChangedEntries() const noexcept { return m_Journal; }
+
+	/// @brief Entry count. Includes destroyed transforms (GetTransform() returns nullptr)
+	/// until Update() compacts them away.
+	size_t GetCount() const noexcept { return m_Owners.size(); }
+
+	/// @return nullptr for a destroyed entry
+	Transform* GetTransform(size_t index) const noexcept { return m_Owners[index]; }
+
+	/// @brief Parent index of each entry, always smaller than the entry index after Update()
+	const uint32_t* GetParents() const noexcept { return m_Parents.data(); }
+
+	const vec3* GetWorldPositions() const noexcept { return m_WorldPositions.data(); }
+
+	const vec3* GetWorldScales() const noexcept { return m_WorldScales.data(); }
+
+	const Quaternion* GetWorldRotations() const noexcept { return m_WorldRotations.data(); }
+
+	/// @brief Generation of the Update() that last changed each world transform
+	const uint32_t* GetWorldGenerations() const noexcept { return m_WorldGenerations.data(); }
+
+	/// @brief Local to world matrix of an entry, cached until its world transform changes.
+	/// @note The reference is valid until the next Transform is created or Update() runs.
+	const Affine3& GetWorldMatrix(uint32_t index) noexcept;
+
+	/// @brief Inverse of GetWorldMatrix(), cached the same way
+	const Affine3& GetWorldToLocalMatrix(uint32_t index) noexcept;
+
+	/// @brief Write the world matrices of entries [first, first + out.size()), e.g. straight into a
+	/// mapped uniform or instance buffer
+	void ExportWorldMatrices(std::span<mat4> out, size_t first = 0) noexcept;
+
+	/// @brief out[i] = world matrix of entries[i]
+	void ExportWorldMatrices(std::span<const uint32_t> entries, std::span<mat4> out) noexcept;
+
+private:
+	/// @brief Bits of m_MatrixFlags
+	static constexpr uint8_t WorldMatrixValid = 1;
+	static constexpr uint8_t WorldToLocalMatrixValid = 2;
+
+	TransformSystem() = default;
+
+	uint32_t Allocate(Transform* owner);
+
+	void Free(uint32_t index) noexcept;
+
+	void SetParent(uint32_t index, uint32_t parent) noexcept;
+
+	void MarkDirty(uint32_t index) noexcept;
+
+	/// @brief Bring the world transform of one entry up to date without clearing any flags.
+	/// @return Whether the world transform was recomputed
+	bool Resolve(uint32_t index) noexcept;
+
+	/// @brief Recompute the world transform of one entry from its parent. Drops its cached matrices.
+	void Combine(uint32_t index) noexcept;
+
+	/// @brief Combine and journal one entry
+	void Refresh(uint32_t index);
+
+	/// @brief Depth-first update of the sorted dirty list on the threads of pool
+	void UpdateParallel(ThreadPool& pool);
+
+	/// @brief Sort entries depth-first, drop destroyed ones and measure subtree sizes.
+	void Reorder();
+
+	template <typename T>
+	static void Gather(Array<T>& data, const Array<uint32_t>& order, Array<unsigned char>& scratch);
+
+	Array<Transform*> m_Owners;
+	Array<uint32_t> m_Parents;
+	Array<vec3> m_Positions;
+	Array<vec3> m_Scales;
+	Array<Quaternion> m_Rotations;
+	Array<vec3> m_WorldPositions;
+	Array<vec3> m_WorldScales;
+	Array<Quaternion> m_WorldRotations;
+	Array<uint32_t> m_WorldGenerations;
+	/// @brief Caches of GetWorldMatrix() and GetWorldToLocalMatrix(), valid per m_MatrixFlags
+	Array<Affine3> m_WorldMatrices;
+	Array<Affine3> m_WorldToLocalMatrices;
+	Array<uint8_t> m_MatrixFlags;
+	/// @brief Entry count of each subtree, valid while m_bDepthFirst
+	Array<uint32_t> m_SubtreeSizes;
+	/// @brief Set for entries in m_DirtyList, and for their descendants during a linear pass
+	Array<uint8_t> m_Dirty;
+	/// @brief Entries with local changes since the last Update()
+	Array<uint32_t> m_DirtyList;
+	Array<uint32_t> m_Journal;
+	/// @brief Scratch of UpdateParallel(): roots of the changed subtrees and of the tasks
+	Array<uint32_t> m_Ranges;
+	Array<uint32_t> m_Tasks;
+	/// @brief Scratch of Reorder(), kept so that its buffers are reused
+	Array<uint32_t> m_ReorderFirst;
+	Array<uint32_t> m_ReorderNext;
+	Array<uint32_t> m_ReorderStack;
+	Array<uint32_t> m_ReorderOrder;
+	Array<unsigned char> m_GatherScratch;
+	size_t m_FreeCount = 0;
+	uint32_t m_Generation = 0;
+	uint32_t m_LayoutGeneration = 0;
+	/// @brief Some parent comes after its child
+	bool m_bOrderDirty = false;
+	bool m_bDepthFirst = true;
+	/// @brief Nodes were added or moved since the last Update()
+	bool m_bStructureChanged = false;
+};
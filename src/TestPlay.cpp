@@ -6,12 +6,15 @@
 #include "Graphics/LightObject.h"
 #include "Graphics/Mesh.h"
 #include "Graphics/Material.h"
+#include "Graphics/RenderQueue.h"
 #include "Graphics/Texture.h"
 
 #include "Resources/Image.h"
 
 #include "Math/mat4.h"
 
+#include <cassert>
+
 TestPlay::TestPlay()
 {
 }
@@ -94,6 +97,8 @@ int TestPlay::Initialize()
 	Sphere02->BindGPUResources();
 	Sphere02->transform.cols[3] = vec4(1.0f, 1.3f, 1.5f);
 
+	Queue = MakeUnique<RenderQueue>();
+
 	return 0;
 }
 
@@ -119,13 +124,14 @@ void TestPlay::Draw()
 	Phong->SetLightParams(1, Light01.get());
 	Phong->SetLightParams(2, Light02.get());
 
-	Phong->SetMaterialParams(Material01.get());
-	Sphere01->Draw();
-
-	Phong->SetMaterialParams(Material02.get());
-	Cube01->Draw();
-	Sphere02->Draw();
+	// The queue orders the draws by pipeline, texture and material, and sets each only once
+	Queue->Begin(*TestCamera);
+	Queue->Submit(Sphere01.get());
+	Queue->Submit(Cube01.get());
+	Queue->Submit(Sphere02.get());
+	Queue->Submit(Ground.get());
+	Queue->Execute();
 
-	Phong->SetMaterialParams(Material03.get());
-	Ground->Draw();
+	// Uniforms go through handles resolved at link time
+	assert(Phong->GetParamAllocationCount() == 0);
 }
\ No newline at end of file
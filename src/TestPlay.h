@@ -9,6 +9,7 @@ class SunLightObject;
 class OmniLightObject;
 class Mesh;
 class Material;
+class RenderQueue;
 
 class TestPlay : public GamePlay
 {
@@ -39,5 +40,6 @@ private:
 	SharedPtr<Material> Material01;
 	SharedPtr<Material> Material02;
 	SharedPtr<Material> Material03;
+	UniquePtr<RenderQueue> Queue;
 };
 
@@ -0,0 +1,699 @@
+// Graphics module tests. Each case installs a fresh NullRenderDevice and checks the commands the
+// renderer recorded on it, so the objects a case creates must be destroyed before it returns.
+
+#include "../Graphics/CameraObject.h"
+#include "../Graphics/Graphics.h"
+#include "../Graphics/LightObject.h"
+#include "../Graphics/Material.h"
+#include "../Graphics/Mesh.h"
+#include "../Graphics/NullRenderDevice.h"
+#include "../Graphics/PhongPipeline.h"
+#include "../Graphics/RenderQueue.h"
+#include "../Graphics/Texture.h"
+#include "../Math/Random.h"
+#include "../Math/mat4.h"
+#include "../Resources/Image.h"
+#include "Test.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+	using Command = NullRenderDevice::Command;
+
+	/// @brief A recorded command and its packed arguments
+	struct Recorded
+	{
+		Command command;
+		const uint8_t* args;
+
+		/// @brief Argument that starts offset bytes after the opcode
+		template <typename T>
+		T Arg(size_t offset) const
+		{
+			T value;
+			memcpy(&value, args + offset, sizeof(T));
+			return value;
+		}
+	};
+
+	/// @brief Bytes NullRenderDevice records after the opcode of command
+	size_t ArgumentSize(Command command)
+	{
+		switch (command)
+		{
+		case Command::SetViewport:
+			return 2 * sizeof(int);
+		case Command::Clear:
+			return sizeof(Color);
+		case Command::CreateProgram:
+		case Command::DeleteProgram:
+		case Command::UseProgram:
+		case Command::DeleteBuffer:
+		case Command::CreateVertexArray:
+		case Command::DeleteVertexArray:
+		case Command::BindVertexArray:
+		case Command::SetIndexBuffer:
+			return 4;
+		case Command::BindUniformBlock:
+		case Command::SetUniformInt:
+		case Command::SetUniformFloat:
+		case Command::BindUniformBuffer:
+		case Command::BindTexture:
+			return 8;
+		case Command::SetUniformVec3:
+			return 4 + sizeof(vec3);
+		case Command::SetUniformVec4:
+		case Command::SetVertexAttribDefault:
+			return 4 + sizeof(vec4);
+		case Command::SetUniformMat4:
+			return 4 + sizeof(mat4);
+		case Command::CreateBuffer:
+			return 4 + 8;
+		case Command::UpdateBuffer:
+			return 4 + 8 + 8;
+		case Command::SetVertexAttribute:
+			return 4 + 4 + 1 + 1 + 8;
+		case Command::SetInstanceAttribute:
+			return 4 + 4 + 1 + 4 + 8;
+		case Command::CreateTexture2D:
+			return 4 + 4 + 4;
+		case Command::Draw:
+		case Command::DrawIndexed:
+			return sizeof(PrimitiveType) + 4;
+		case Command::DrawInstanced:
+		case Command::DrawIndexedInstanced:
+			return sizeof(PrimitiveType) + 4 + 4;
+		default:
+			return 0;
+		}
+	}
+
+	/// @brief Split the command buffer of device into its commands
+	Array<Recorded> Decode(const NullRenderDevice& device)
+	{
+		Array<Recorded> commands;
+		const Array<uint8_t>& bytes = device.GetCommands();
+		size_t at = 0;
+		while (at < bytes.size())
+		{
+			const Command command = static_cast<Command>(bytes[at]);
+			CHECK(command < Command::Count);
+			if (command >= Command::Count)
+				break;
+			commands.push_back({ command, bytes.data() + at + 1 });
+			at += 1 + ArgumentSize(command);
+		}
+		CHECK(at == bytes.size());
+		CHECK(commands.size() == device.GetCommandCount());
+		return commands;
+	}
+
+	/// @brief Install a NullRenderDevice with nothing registered
+	NullRenderDevice* InstallDevice()
+	{
+		auto device = MakeUnique<NullRenderDevice>();
+		NullRenderDevice* raw = device.get();
+		Graphics::GetSingleton()->SetDevice(std::move(device));
+		return raw;
+	}
+
+	/// @brief Register the uniforms and blocks PhongPipeline declares, as a GL driver would report them
+	void AddPhongUniforms(NullRenderDevice* device)
+	{
+		device->AddUniform("MVP.Model", UniformType::Mat4);
+		device->AddUniform("Config.UseHalfLambert", UniformType::Bool);
+		device->AddUniform("Config.UseBlinnPhong", UniformType::Bool);
+		device->AddUniform("Material.Diffuse", UniformType::Vec4);
+		device->AddUniform("Material.DiffuseMap", UniformType::Sampler);
+		device->AddUniform("Material.UseDiffuseMap", UniformType::Bool);
+		device->AddUniform("Material.Specular", UniformType::Float);
+		device->AddUniform("Material.Glossiness", UniformType::Float);
+		device->AddUniformBlock("FrameBlock", sizeof(FrameUniforms));
+		device->AddUniformBlock("LightBlock", sizeof(LightUniforms));
+	}
+
+	SharedPtr<Texture> MakeTexture()
+	{
+		return MakeShared<Texture>(MakeShared<Image>(2, 2));
+	}
+
+	/// @brief Number of different values in values
+	size_t CountDistinct(Array<uint64_t> values)
+	{
+		std::sort(values.begin(), values.end());
+		return static_cast<size_t>(std::unique(values.begin(), values.end()) - values.begin());
+	}
+}
+
+TEST_CASE(null_device_reuses_deleted_names)
+{
+	NullRenderDevice* device = InstallDevice();
+	const uint32_t a = device->CreateBuffer(16, nullptr, BufferUsage::Static);
+	const uint32_t b = device->CreateBuffer(32, nullptr, BufferUsage::Dynamic);
+	const uint32_t vertexArray = device->CreateVertexArray();
+	CHECK(a != 0 && b != 0 && vertexArray != 0);
+	CHECK(a != b && b != vertexArray && a != vertexArray);
+
+	// The most recently deleted name comes back first, whatever kind of object it named
+	device->DeleteBuffer(a);
+	device->DeleteVertexArray(vertexArray);
+	device->DeleteBuffer(0);
+	CHECK(device->CreateBuffer(64, nullptr, BufferUsage::Static) == vertexArray);
+	CHECK(device->CreateVertexArray() == a);
+	const uint32_t program = device->CreateProgram("", "");
+	CHECK(program != 0 && program != a && program != b && program != vertexArray);
+	device->DeleteProgram(program);
+	CHECK(device->CreateVertexArray() == program);
+
+	const Array<Recorded> commands = Decode(*device);
+	CHECK(commands.size() == 11);
+	if (commands.size() != 11)
+		return;
+	CHECK(commands[0].command == Command::CreateBuffer);
+	CHECK(commands[0].Arg<uint32_t>(0) == a && commands[0].Arg<uint64_t>(4) == 16);
+	CHECK(commands[1].command == Command::CreateBuffer);
+	CHECK(commands[1].Arg<uint32_t>(0) == b && commands[1].Arg<uint64_t>(4) == 32);
+	CHECK(commands[2].command == Command::CreateVertexArray && commands[2].Arg<uint32_t>(0) == vertexArray);
+	CHECK(commands[3].command == Command::DeleteBuffer && commands[3].Arg<uint32_t>(0) == a);
+	CHECK(commands[4].command == Command::DeleteVertexArray && commands[4].Arg<uint32_t>(0) == vertexArray);
+	CHECK(commands[5].command == Command::DeleteBuffer && commands[5].Arg<uint32_t>(0) == 0);
+	CHECK(commands[6].command == Command::CreateBuffer);
+	CHECK(commands[6].Arg<uint32_t>(0) == vertexArray && commands[6].Arg<uint64_t>(4) == 64);
+	CHECK(commands[7].command == Command::CreateVertexArray && commands[7].Arg<uint32_t>(0) == a);
+	CHECK(commands[8].command == Command::CreateProgram && commands[8].Arg<uint32_t>(0) == program);
+	CHECK(commands[9].command == Command::DeleteProgram && commands[9].Arg<uint32_t>(0) == program);
+	CHECK(commands[10].command == Command::CreateVertexArray && commands[10].Arg<uint32_t>(0) == program);
+	CHECK(device->GetCommandCount(Command::CreateBuffer) == 3);
+	CHECK(device->GetCommandCount(Command::CreateVertexArray) == 3);
+
+	device->ClearCommands();
+	CHECK(device->GetCommands().empty() && device->GetCommandCount() == 0);
+	CHECK(device->GetCommandCount(Command::CreateBuffer) == 0);
+}
+
+TEST_CASE(null_device_reports_registered_uniforms)
+{
+	NullRenderDevice* device = InstallDevice();
+	device->AddUniform("Tint", UniformType::Vec4);
+	device->AddUniform("Bones[0]", UniformType::Mat4, 3);
+	device->AddUniform("Enabled", UniformType::Bool);
+	device->AddUniformBlock("FrameBlock", 208);
+
+	const uint32_t program = device->CreateProgram("in vec3 Position; in mat4 InstanceModel;", "");
+	const uint32_t other = device->CreateProgram("in vec3 Normal;", "");
+
+	// Every program reports every uniform, locations following the sizes of the previous ones
+	for (uint32_t p : { program, other })
+	{
+		Array<UniformInfo> uniforms;
+		device->GetActiveUniforms(p, uniforms);
+		CHECK(uniforms.size() == 3);
+		if (uniforms.size() != 3)
+			continue;
+		CHECK(uniforms[0].name == "Tint" && uniforms[0].location == 0);
+		CHECK(uniforms[0].type == UniformType::Vec4 && uniforms[0].size == 1);
+		CHECK(uniforms[1].name == "Bones[0]" && uniforms[1].location == 1);
+		CHECK(uniforms[1].type == UniformType::Mat4 && uniforms[1].size == 3);
+		CHECK(uniforms[2].name == "Enabled" && uniforms[2].location == 4);
+		CHECK(uniforms[2].type == UniformType::Bool && uniforms[2].size == 1);
+	}
+
+	// Attributes are found by the part of their name after the last '.', in the vertex shader
+	const int32_t position = device->GetAttribLocation(program, "VSV.Position");
+	const int32_t instanceModel = device->GetAttribLocation(program, "InstanceModel");
+	CHECK(position >= 0 && instanceModel >= 0);
+	CHECK(position % 4 == 0 && instanceModel % 4 == 0 && position != instanceModel);
+	CHECK(device->GetAttribLocation(program, "VSV.Position") == position);
+	CHECK(device->GetAttribLocation(program, "VSV.Normal") < 0);
+	CHECK(device->GetAttribLocation(other, "VSV.Normal") >= 0);
+	CHECK(device->GetAttribLocation(other, "VSV.Position") < 0);
+	CHECK(device->GetAttribLocation(program + other + 1, "VSV.Position") < 0);
+
+	// Blocks report their size and record the binding, unknown blocks record nothing
+	device->ClearCommands();
+	CHECK(device->BindUniformBlock(program, "FrameBlock", 3) == 208);
+	CHECK(device->BindUniformBlock(program, "LightBlock", 4) == -1);
+	const Array<Recorded> commands = Decode(*device);
+	CHECK(commands.size() == 1);
+	if (commands.size() == 1)
+	{
+		CHECK(commands[0].command == Command::BindUniformBlock);
+		CHECK(commands[0].Arg<uint32_t>(0) == program && commands[0].Arg<uint32_t>(4) == 3);
+	}
+}
+
+TEST_CASE(render_queue_sorts_by_state)
+{
+	NullRenderDevice* device = InstallDevice();
+	AddPhongUniforms(device);
+	const SharedPtr<Pipeline> pipelines[] = { MakeShared<PhongPipeline>(), MakeShared<PhongPipeline>() };
+	const SharedPtr<Texture> textures[] = { MakeTexture(), MakeTexture() };
+	Array<SharedPtr<Material>> materials;
+	for (size_t i = 0; i < 5; ++i)
+		materials.push_back(MakeShared<Material>());
+	materials[1]->diffuse = textures[0];
+	materials[2]->diffuse = textures[0];
+	materials[3]->diffuse = textures[1];
+	materials[4]->diffuse = textures[1];
+
+	// Meshes sharing pipelines, textures and materials in every combination the key orders by
+	constexpr size_t MeshCount = 8;
+	Array<UniquePtr<Mesh>> meshes;
+	for (size_t i = 0; i < MeshCount; ++i)
+	{
+		meshes.emplace_back(Mesh::NewCube(pipelines[i % 2], 1.0f, VertexAttributes(), materials[(i * 3) % 5]));
+		meshes.back()->BindGPUResources();
+	}
+
+	CameraObject camera;
+	camera.lookAt = mat4(vec3(0, 0, 50), vec3(0), vec3::up());
+	camera.nearClip = 1.0f;
+	camera.farClip = 100.0f;
+
+	// Every mesh many times at random depths, in random order. The x translation is the
+	// submission index, to find the draws in the command stream.
+	constexpr size_t DrawCount = 400;
+	Random random(20240801);
+	Array<uint32_t> order(DrawCount);
+	for (size_t i = 0; i < DrawCount; ++i)
+		order[i] = static_cast<uint32_t>(i % MeshCount);
+	for (size_t i = DrawCount - 1; i > 0; --i)
+		std::swap(order[i], order[random.next_u32() % (i + 1)]);
+	Array<Mesh*> draws;
+	Array<mat4> models;
+	for (size_t i = 0; i < DrawCount; ++i)
+	{
+		draws.push_back(meshes[order[i]].get());
+		mat4 model;
+		// Some in front of the near plane and past the far one, where depth saturates
+		model.cols[3] = vec4(static_cast<float>(i), random.range(-10, 10), random.range(-60, 55), 1);
+		models.push_back(model);
+	}
+
+	RenderQueue queue;
+	Array<uint64_t> previousKeys;
+	for (int frame = 0; frame < 2; ++frame)
+	{
+		queue.Begin(camera);
+		for (size_t i = 0; i < DrawCount; ++i)
+			queue.Submit(draws[i], models[i]);
+		device->ClearCommands();
+		queue.Execute();
+
+		// Fields of the key, from the most significant down: pipeline 8 | texture 12 | material 12 |
+		// vertex array 16 | depth 16
+		const Array<uint64_t>& keys = queue.GetKeys();
+		CHECK(keys.size() == DrawCount);
+		if (keys.size() != DrawCount)
+			return;
+		Array<uint64_t> materialIds(materials.size(), 0);
+		size_t depthMismatches = 0;
+		for (size_t i = 0; i < DrawCount; ++i)
+		{
+			const Mesh* mesh = draws[i];
+			const uint64_t key = keys[i];
+			CHECK((key >> 56) == (mesh->GetPipeline()->GetProgramID() & 0xFF));
+			const SharedPtr<Material>& material = mesh->GetMaterial();
+			const uint32_t texture = material->diffuse.UseMap() ? material->diffuse.GetTexture()->GetTextureID() : 0;
+			CHECK(((key >> 44) & 0xFFF) == texture);
+			const size_t m = std::find(materials.begin(), materials.end(), material) - materials.begin();
+			const uint64_t materialId = (key >> 32) & 0xFFF;
+			CHECK(materialId != 0);
+			if (materialIds[m] == 0)
+				materialIds[m] = materialId;
+			CHECK(materialIds[m] == materialId);
+			CHECK(((key >> 16) & 0xFFFF) == mesh->GetVertexArrayID());
+			const float depth = 50 - models[i].cols[3].z;
+			const float t = Mathf::clamp((depth - camera.nearClip) / (camera.farClip - camera.nearClip), 0.0f, 1.0f);
+			const int64_t expectedDepth = static_cast<int64_t>(t * 65535.0f);
+			const int64_t depthBits = static_cast<int64_t>(key & 0xFFFF);
+			depthMismatches += depthBits < expectedDepth - 1 || depthBits > expectedDepth + 1;
+		}
+		CHECK(depthMismatches == 0);
+		CHECK(CountDistinct(materialIds) == materials.size());
+		// Material ids are kept across frames, so the keys are too
+		if (frame > 0)
+			CHECK(keys == previousKeys);
+		previousKeys = keys;
+
+		// Draws come back by ascending key, equal keys in submission order
+		const auto model = std::find_if(pipelines[0]->GetUniforms().begin(), pipelines[0]->GetUniforms().end(),
+			[](const UniformInfo& uniform) { return uniform.name == "MVP.Model"; });
+		const int32_t modelLocation = model->location;
+		Array<uint32_t> executed;
+		size_t unmatchedDraws = 0;
+		int64_t lastModel = -1;
+		for (const Recorded& command : Decode(*device))
+		{
+			if (command.command == Command::SetUniformMat4 && command.Arg<int32_t>(0) == modelLocation)
+				lastModel = static_cast<int64_t>(command.Arg<mat4>(4).cols[3].x);
+			else if (command.command == Command::DrawIndexed)
+			{
+				unmatchedDraws += lastModel < 0;
+				if (lastModel >= 0)
+					executed.push_back(static_cast<uint32_t>(lastModel));
+				lastModel = -1;
+			}
+		}
+		CHECK(unmatchedDraws == 0);
+		CHECK(executed.size() == DrawCount);
+		size_t misordered = 0;
+		for (size_t i = 1; i < executed.size(); ++i)
+		{
+			const uint64_t a = keys[executed[i - 1]], b = keys[executed[i]];
+			misordered += a > b || (a == b && executed[i - 1] > executed[i]);
+		}
+		CHECK(misordered == 0);
+		Array<uint32_t> sorted = executed;
+		std::sort(sorted.begin(), sorted.end());
+		CHECK(std::adjacent_find(sorted.begin(), sorted.end()) == sorted.end());
+
+		// State is set once per distinct value, not once per draw. Textures are bound again
+		// after each pipeline change, the vertex array is unbound at the end.
+		Array<uint64_t> programs, boundTextures, pipelineMaterials;
+		for (const Mesh* mesh : draws)
+		{
+			const uint64_t program = mesh->GetPipeline()->GetProgramID();
+			const Material* material = mesh->GetMaterial().get();
+			programs.push_back(program);
+			if (material->diffuse.UseMap())
+				boundTextures.push_back((program << 32) | material->diffuse.GetTexture()->GetTextureID());
+			pipelineMaterials.push_back((program << 32) | (std::find(materials.begin(), materials.end(),
+				mesh->GetMaterial()) - materials.begin()));
+		}
+		CHECK(device->GetCommandCount(Command::UseProgram) == CountDistinct(programs));
+		CHECK(device->GetCommandCount(Command::BindTexture) == CountDistinct(boundTextures));
+		CHECK(device->GetCommandCount(Command::BindVertexArray) == MeshCount + 1);
+		CHECK(device->GetCommandCount(Command::DrawIndexed) == DrawCount);
+		const RenderQueueStats& stats = queue.GetStats();
+		CHECK(stats.draws == DrawCount);
+		CHECK(stats.pipelineChanges == CountDistinct(programs));
+		CHECK(stats.materialChanges == CountDistinct(pipelineMaterials));
+		CHECK(stats.vertexArrayChanges == MeshCount);
+	}
+}
+
+TEST_CASE(instanced_draw_reattaches_grown_buffer)
+{
+	NullRenderDevice* device = InstallDevice();
+	AddPhongUniforms(device);
+	const SharedPtr<Pipeline> pipeline = MakeShared<PhongPipeline>(true);
+	const int32_t location = pipeline->GetInstanceModelLocation();
+	CHECK(location >= 0);
+	UniquePtr<Mesh> mesh(Mesh::NewCube(pipeline, 1.0f, VertexAttributes()));
+	mesh->BindGPUResources();
+	const uint32_t vertexArray = mesh->GetVertexArrayID();
+
+	Array<mat4> models(32);
+	for (size_t i = 0; i < models.size(); ++i)
+		models[i].cols[3] = vec4(static_cast<float>(i), 0, 0, 1);
+
+	// Instance counts and the capacity each leaves, a power of two. Growing deletes the buffer
+	// before creating the next one, so the device hands out the same name again.
+	constexpr size_t Counts[] = { 3, 4, 2, 9, 16, 17, 1 };
+	constexpr size_t Capacities[] = { 4, 4, 4, 16, 16, 32, 32 };
+	uint32_t buffer = 0;
+	size_t capacity = 0;
+	for (size_t step = 0; step < std::size(Counts); ++step)
+	{
+		const size_t count = Counts[step];
+		const bool grows = Capacities[step] != capacity;
+		device->ClearCommands();
+		mesh->DrawInstanced({ models.data(), count });
+		const Array<Recorded> commands = Decode(*device);
+
+		// Bind, [DeleteBuffer, CreateBuffer], UpdateBuffer, [4 x SetInstanceAttribute], draw, unbind
+		const size_t expected = (grows ? 5 : 0) + (grows && buffer ? 1 : 0) + 4;
+		CHECK(commands.size() == expected);
+		if (commands.size() != expected)
+			return;
+		size_t at = 0;
+		CHECK(commands[at].command == Command::BindVertexArray && commands[at].Arg<uint32_t>(0) == vertexArray);
+		++at;
+		if (grows)
+		{
+			if (buffer)
+			{
+				CHECK(commands[at].command == Command::DeleteBuffer && commands[at].Arg<uint32_t>(0) == buffer);
+				++at;
+			}
+			CHECK(commands[at].command == Command::CreateBuffer);
+			CHECK(commands[at].Arg<uint64_t>(4) == Capacities[step] * sizeof(mat4));
+			const uint32_t created = commands[at].Arg<uint32_t>(0);
+			CHECK(created != 0 && (buffer == 0 || created == buffer));
+			buffer = created;
+			capacity = Capacities[step];
+			++at;
+		}
+		CHECK(commands[at].command == Command::UpdateBuffer && commands[at].Arg<uint32_t>(0) == buffer);
+		CHECK(commands[at].Arg<uint64_t>(4) == 0 && commands[at].Arg<uint64_t>(12) == count * sizeof(mat4));
+		++at;
+		// A new buffer is attached again, one attribute per column of the matrix at consecutive
+		// locations, while the mesh's vertex array is bound
+		for (int32_t column = 0; grows && column < 4; ++column, ++at)
+		{
+			const Recorded& attribute = commands[at];
+			CHECK(attribute.command == Command::SetInstanceAttribute);
+			CHECK(attribute.Arg<int32_t>(0) == location + column);
+			CHECK(attribute.Arg<uint32_t>(4) == buffer);
+			CHECK(attribute.Arg<uint8_t>(8) == 4);
+			CHECK(attribute.Arg<uint32_t>(9) == sizeof(mat4));
+			CHECK(attribute.Arg<uint64_t>(13) == column * sizeof(vec4));
+		}
+		CHECK(commands[at].command == Command::DrawIndexedInstanced);
+		CHECK(commands[at].Arg<PrimitiveType>(0) == PrimitiveType::TriangleList);
+		// A cube is 12 triangles
+		CHECK(commands[at].Arg<uint32_t>(sizeof(PrimitiveType)) == 36);
+		CHECK(commands[at].Arg<uint32_t>(sizeof(PrimitiveType) + 4) == count);
+		++at;
+		CHECK(commands[at].command == Command::BindVertexArray && commands[at].Arg<uint32_t>(0) == 0);
+	}
+	CHECK(device->GetCommandCount(Command::Draw) == 0 && device->GetCommandCount(Command::DrawIndexed) == 0);
+}
+
+TEST_CASE(pipeline_param_handles)
+{
+	NullRenderDevice* device = InstallDevice();
+	device->AddUniform("Tint", UniformType::Vec4);
+	device->AddUniform("Bones[0]", UniformType::Mat4, 3);
+	device->AddUniform("Enabled", UniformType::Bool);
+	device->AddUniform("Albedo", UniformType::Sampler);
+	Pipeline pipeline("in vec3 Position;", "");
+	CHECK(pipeline.Valid());
+
+	auto find = [&](AnsiStringView name) -> const UniformInfo* {
+		for (const UniformInfo& uniform : pipeline.GetUniforms())
+			if (uniform.name == name)
+				return &uniform;
+		return nullptr;
+	};
+
+	// The array is listed whole and once per element, at consecutive locations
+	const UniformInfo* bones = find("Bones");
+	CHECK(bones != nullptr && bones->location == 1 && bones->size == 3 && bones->type == UniformType::Mat4);
+	for (int32_t k = 0; k < 3; ++k)
+	{
+		const UniformInfo* bone = find("Bones[" + std::to_string(k) + "]");
+		CHECK(bone != nullptr && bone->location == 1 + k && bone->size == 1 && bone->type == UniformType::Mat4);
+	}
+	CHECK(find("Bones[3]") == nullptr);
+	CHECK(pipeline.GetUniforms().size() == 7);
+
+	mat4 m;
+	m.cols[3] = vec4(1, 2, 3, 1);
+	auto lastMat4 = [&](int32_t location) {
+		const Array<Recorded> commands = Decode(*device);
+		return commands.size() == 1 && commands[0].command == Command::SetUniformMat4 &&
+			commands[0].Arg<int32_t>(0) == location && commands[0].Arg<mat4>(4) == m;
+	};
+	for (int32_t k = 0; k < 3; ++k)
+	{
+		const AnsiString name = "Bones[" + std::to_string(k) + "]";
+		const ParamHandle<mat4> bone = pipeline.GetParamHandle<mat4>(name);
+		CHECK(bone.Valid());
+		device->ClearCommands();
+		pipeline.SetShaderParam(bone, m);
+		CHECK(lastMat4(1 + k));
+		device->ClearCommands();
+		pipeline.SetShaderParam(name, m);
+		CHECK(lastMat4(1 + k));
+	}
+
+	// Handles of missing uniforms, and default ones, set nothing
+	device->ClearCommands();
+	const ParamHandle<mat4> missing = pipeline.GetParamHandle<mat4>("Bones[3]");
+	CHECK(!missing.Valid() && !ParamHandle<float>().Valid());
+	pipeline.SetShaderParam(missing, m);
+	pipeline.SetShaderParam(ParamHandle<float>(), 1.0f);
+	pipeline.SetShaderParam("Missing", 1.0f);
+	pipeline.SetShaderParam("Bones[3]", m);
+	CHECK(device->GetCommandCount() == 0);
+
+	// A value of another type is rejected, by handle and by name, rather than set
+	const ParamHandle<float> tintAsFloat = pipeline.GetParamHandle<float>("Tint");
+	const ParamHandle<vec3> tintAsVec3 = pipeline.GetParamHandle<vec3>("Tint");
+	const ParamHandle<bool> albedoAsBool = pipeline.GetParamHandle<bool>("Albedo");
+	const ParamHandle<mat4> enabledAsMat4 = pipeline.GetParamHandle<mat4>("Enabled");
+	CHECK(!tintAsFloat.Valid() && !tintAsVec3.Valid() && !albedoAsBool.Valid() && !enabledAsMat4.Valid());
+	pipeline.SetShaderParam(tintAsFloat, 1.0f);
+	pipeline.SetShaderParam(tintAsVec3, vec3(1));
+	pipeline.SetShaderParam(albedoAsBool, true);
+	pipeline.SetShaderParam(enabledAsMat4, m);
+	pipeline.SetShaderParam("Tint", 1.0f);
+	pipeline.SetShaderParam("Tint", m);
+	pipeline.SetShaderParam("Albedo", true);
+	pipeline.SetShaderParam("Enabled", 1.0f);
+	pipeline.SetShaderParam("Bones", vec4(1));
+	CHECK(device->GetCommandCount() == 0);
+
+	// Bools and samplers are set as ints, bools also from C++ bools
+	const ParamHandle<bool> enabled = pipeline.GetParamHandle<bool>("Enabled");
+	const ParamHandle<int> enabledAsInt = pipeline.GetParamHandle<int>("Enabled");
+	const ParamHandle<int> albedo = pipeline.GetParamHandle<int>("Albedo");
+	const ParamHandle<vec4> tint = pipeline.GetParamHandle<vec4>("Tint");
+	CHECK(enabled.Valid() && enabledAsInt.Valid() && albedo.Valid() && tint.Valid());
+	pipeline.SetShaderParam(enabled, true);
+	pipeline.SetShaderParam(enabledAsInt, 0);
+	pipeline.SetShaderParam(albedo, 2);
+	pipeline.SetShaderParam(tint, vec4(0.5f));
+	pipeline.SetShaderParam("Tint", vec4(0.25f));
+	const Array<Recorded> commands = Decode(*device);
+	CHECK(commands.size() == 5);
+	if (commands.size() == 5)
+	{
+		CHECK(commands[0].command == Command::SetUniformInt);
+		CHECK(commands[0].Arg<int32_t>(0) == 4 && commands[0].Arg<int>(4) == 1);
+		CHECK(commands[1].command == Command::SetUniformInt);
+		CHECK(commands[1].Arg<int32_t>(0) == 4 && commands[1].Arg<int>(4) == 0);
+		CHECK(commands[2].command == Command::SetUniformInt);
+		CHECK(commands[2].Arg<int32_t>(0) == 5 && commands[2].Arg<int>(4) == 2);
+		CHECK(commands[3].command == Command::SetUniformVec4);
+		CHECK(commands[3].Arg<int32_t>(0) == 0 && commands[3].Arg<vec4>(4) == vec4(0.5f));
+		CHECK(commands[4].command == Command::SetUniformVec4);
+		CHECK(commands[4].Arg<int32_t>(0) == 0 && commands[4].Arg<vec4>(4) == vec4(0.25f));
+	}
+	CHECK(pipeline.GetNameLookupCount() == 3 + 2 + 5 + 1);
+}
+
+TEST_CASE(uniform_blocks_upload_once_per_frame)
+{
+	NullRenderDevice* device = InstallDevice();
+	AddPhongUniforms(device);
+	const SharedPtr<Pipeline> pipeline = MakeShared<PhongPipeline>();
+	const uint32_t program = pipeline->GetProgramID();
+
+	// Each block is attached to its binding, then gets a buffer of its size bound there
+	struct Block
+	{
+		uint32_t binding;
+		size_t size;
+		uint32_t buffer = 0;
+	};
+	Block blocks[] = {
+		{ static_cast<uint32_t>(UniformBlockBinding::Frame), sizeof(FrameUniforms) },
+		{ static_cast<uint32_t>(UniformBlockBinding::Lights), sizeof(LightUniforms) },
+	};
+	{
+		const Array<Recorded> commands = Decode(*device);
+		size_t at = std::find_if(commands.begin(), commands.end(),
+			[](const Recorded& c) { return c.command == Command::BindUniformBlock; }) - commands.begin();
+		CHECK(at + 3 * std::size(blocks) <= commands.size());
+		if (at + 3 * std::size(blocks) > commands.size())
+			return;
+		for (Block& block : blocks)
+		{
+			CHECK(commands[at].command == Command::BindUniformBlock);
+			CHECK(commands[at].Arg<uint32_t>(0) == program && commands[at].Arg<uint32_t>(4) == block.binding);
+			CHECK(commands[at + 1].command == Command::CreateBuffer);
+			CHECK(commands[at + 1].Arg<uint64_t>(4) == block.size);
+			block.buffer = commands[at + 1].Arg<uint32_t>(0);
+			CHECK(commands[at + 2].command == Command::BindUniformBuffer);
+			CHECK(commands[at + 2].Arg<uint32_t>(0) == block.binding && commands[at + 2].Arg<uint32_t>(4) == block.buffer);
+			at += 3;
+		}
+		CHECK(blocks[0].buffer != 0 && blocks[1].buffer != 0 && blocks[0].buffer != blocks[1].buffer);
+	}
+
+	UniquePtr<Mesh> cube(Mesh::NewCube(pipeline, 1.0f, VertexAttributes()));
+	UniquePtr<Mesh> sphere(Mesh::NewSphere(pipeline, 1.0f, 8));
+	cube->BindGPUResources();
+	sphere->BindGPUResources();
+	CameraObject camera;
+	SunLightObject sun;
+	OmniLightObject omni;
+
+	// Uploads of one frame as (buffer, size), checking they all come before the first draw
+	auto frame = [&](auto&& setParams) {
+		device->ClearCommands();
+		Graphics::GetSingleton()->UsePipeline(pipeline);
+		setParams();
+		cube->Draw();
+		sphere->Draw();
+		cube->Draw();
+		Array<std::pair<uint32_t, uint64_t>> uploads;
+		bool beforeDraws = true;
+		size_t draws = 0, binds = 0;
+		for (const Recorded& command : Decode(*device))
+		{
+			if (command.command == Command::UpdateBuffer)
+			{
+				CHECK(command.Arg<uint64_t>(4) == 0);
+				uploads.push_back({ command.Arg<uint32_t>(0), command.Arg<uint64_t>(12) });
+				beforeDraws = beforeDraws && draws == 0;
+			}
+			else if (command.command == Command::DrawIndexed)
+				++draws;
+			// Putting the pipeline in use binds every buffer to the binding its block was attached to
+			else if (command.command == Command::BindUniformBuffer)
+			{
+				CHECK(binds < std::size(blocks));
+				if (binds < std::size(blocks))
+				{
+					CHECK(command.Arg<uint32_t>(0) == blocks[binds].binding);
+					CHECK(command.Arg<uint32_t>(4) == blocks[binds].buffer);
+				}
+				++binds;
+			}
+		}
+		CHECK(draws == 3 && binds == std::size(blocks));
+		CHECK(beforeDraws);
+		return uploads;
+	};
+	const size_t lightsHeader = offsetof(LightUniforms, omniLights);
+
+	// Everything set: both blocks once, the light block up to the highest enabled omni light
+	const size_t uploadsBefore = pipeline->GetUniformBlockUploadCount();
+	auto uploads = frame([&] {
+		pipeline->SetCameraParams(&camera);
+		pipeline->SetLightParams(&sun);
+		pipeline->SetLightParams(0, &omni);
+		pipeline->SetLightParams(2, &omni);
+		pipeline->SetCameraParams(&camera);
+	});
+	CHECK(uploads.size() == 2);
+	if (uploads.size() == 2)
+	{
+		CHECK(uploads[0].first == blocks[0].buffer && uploads[0].second == sizeof(FrameUniforms));
+		CHECK(uploads[1].first == blocks[1].buffer && uploads[1].second == lightsHeader + 3 * sizeof(OmniLightUniforms));
+	}
+	CHECK(pipeline->GetUniformBlockUploadCount() == uploadsBefore + 2);
+
+	// Only the camera
+	uploads = frame([&] { pipeline->SetCameraParams(&camera); });
+	CHECK(uploads.size() == 1);
+	if (uploads.size() == 1)
+		CHECK(uploads[0].first == blocks[0].buffer && uploads[0].second == sizeof(FrameUniforms));
+
+	// Turning off the highest omni light shortens the upload
+	uploads = frame([&] { pipeline->SetLightParams(2, nullptr); });
+	CHECK(uploads.size() == 1);
+	if (uploads.size() == 1)
+		CHECK(uploads[0].first == blocks[1].buffer && uploads[0].second == lightsHeader + sizeof(OmniLightUniforms));
+
+	// Nothing changed, nothing uploaded
+	uploads = frame([] {});
+	CHECK(uploads.empty());
+	CHECK(pipeline->GetUniformBlockUploadCount() == uploadsBefore + 4);
+}
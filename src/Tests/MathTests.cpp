@@ -0,0 +1,877 @@
+// Math module tests. The SIMD kernels are checked against the scalar code at the tolerances
+// documented in SIMD.h.
+
+#include "../Math/BatchCulling.h"
+#include "../Math/BatchQuaternion.h"
+#include "../Math/BatchTransform.h"
+#include "../Math/Random.h"
+#include "../Math/Rigid.h"
+#include "../Math/UnitSphere.h"
+#include "../Math/VectorStream.h"
+#include "../Math/mat4.h"
+#include "Test.h"
+
+#include <array>
+#include <cfloat>
+#include <cstdint>
+
+namespace
+{
+	/// @brief Deterministic values in [-1, 1), usable in constant expressions
+	struct ConstRandom
+	{
+		uint32_t state;
+
+		constexpr float next() noexcept
+		{
+			state = state * 1664525u + 1013904223u;
+			return static_cast<float>(state >> 8) / 8388608.0f - 1.0f;
+		}
+	};
+
+	constexpr size_t KernelCaseCount = 64;
+
+	struct KernelInputs
+	{
+		mat4 a4, b4;
+		vec4 v4, w4;
+		mat3 a3, b3;
+		vec3 v3;
+	};
+
+	struct KernelResults
+	{
+		mat4 mul4, transposed4, inverse4;
+		vec4 mul_vec4;
+		float dot4 = 0;
+		mat3 mul3;
+		vec3 mul_vec3;
+	};
+
+	constexpr std::array<KernelInputs, KernelCaseCount> MakeKernelInputs()
+	{
+		ConstRandom random{ 20240601 };
+		auto v3 = [&] {
+			const float x = random.next(), y = random.next(), z = random.next();
+			return vec3(x, y, z);
+		};
+		auto v4 = [&] {
+			const vec3 xyz = v3();
+			return vec4(xyz, random.next());
+		};
+		std::array<KernelInputs, KernelCaseCount> inputs;
+		for (KernelInputs& in : inputs)
+		{
+			// Diagonally dominant, so every inverse is well conditioned
+			in.a4 = mat4(v4(), v4(), v4(), v4()) + mat4::eye(5);
+			in.b4 = mat4(v4(), v4(), v4(), v4());
+			in.v4 = v4();
+			in.w4 = v4();
+			in.a3 = mat3(v3(), v3(), v3());
+			in.b3 = mat3(v3(), v3(), v3());
+			in.v3 = v3();
+		}
+		return inputs;
+	}
+
+	/// @brief Constant evaluation skips the SIMD kernels, so these are the results of the scalar code
+	constexpr std::array<KernelResults, KernelCaseCount> RunScalarKernels(const std::array<KernelInputs, KernelCaseCount>& inputs)
+	{
+		std::array<KernelResults, KernelCaseCount> results;
+		for (size_t i = 0; i < KernelCaseCount; ++i)
+		{
+			const KernelInputs& in = inputs[i];
+			KernelResults& out = results[i];
+			out.mul4 = in.a4 * in.b4;
+			out.transposed4 = in.a4.transposed();
+			out.inverse4 = in.a4.inverse();
+			out.mul_vec4 = in.a4 * in.v4;
+			out.dot4 = in.v4.dot_product(in.w4);
+			out.mul3 = in.a3 * in.b3;
+			out.mul_vec3 = in.a3 * in.v3;
+		}
+		return results;
+	}
+
+	constexpr std::array<KernelInputs, KernelCaseCount> KernelInputSet = MakeKernelInputs();
+	constexpr std::array<KernelResults, KernelCaseCount> ScalarResults = RunScalarKernels(KernelInputSet);
+
+	struct TrigSample
+	{
+		float x, sin, cos;
+	};
+
+	constexpr size_t TrigSampleCount = 256;
+
+	/// @brief Mathf::sin/cos evaluated at compile time, x in [-8pi, 8pi)
+	constexpr std::array<TrigSample, TrigSampleCount> ConstTrigSamples = []() {
+		ConstRandom random{ 20240901 };
+		std::array<TrigSample, TrigSampleCount> samples;
+		for (TrigSample& sample : samples)
+		{
+			sample.x = random.next() * 8 * Mathf::Pi;
+			sample.sin = Mathf::sin(sample.x);
+			sample.cos = Mathf::cos(sample.x);
+		}
+		// Exact float multiples of pi/2 land next to roots
+		samples[0].x = 0;
+		samples[1].x = Mathf::Pi / 2;
+		samples[2].x = Mathf::Pi;
+		samples[3].x = -3 * Mathf::Pi / 2;
+		for (size_t i = 0; i < 4; ++i)
+		{
+			samples[i].sin = Mathf::sin(samples[i].x);
+			samples[i].cos = Mathf::cos(samples[i].x);
+		}
+		return samples;
+	}();
+
+	/// @brief One float ulp of value, the compile time functions round a double result once
+	float Ulp(float value)
+	{
+		return std::nextafter(std::fabs(value), std::numeric_limits<float>::infinity()) - std::fabs(value);
+	}
+
+	/// @brief sum_k |a[k][i] * b[j][k]| of each product element, for column-major size x size
+	/// matrices multiplied by columns of b
+	void AbsProducts(const float* a, const float* b, size_t size, size_t columns, float* out)
+	{
+		for (size_t j = 0; j < columns; ++j)
+			for (size_t i = 0; i < size; ++i)
+			{
+				float sum = 0;
+				for (size_t k = 0; k < size; ++k)
+					sum += std::fabs(a[size * k + i] * b[size * j + k]);
+				out[size * j + i] = sum;
+			}
+	}
+
+	/// @brief Each actual[i] within tolerance * scale[i] of expected[i]
+	void CheckProducts(const float* actual, const float* expected, const float* scale, size_t n, float tolerance,
+		const char* what)
+	{
+		for (size_t i = 0; i < n; ++i)
+			if (!test::CheckNear(actual[i], expected[i], tolerance * scale[i], __FILE__, __LINE__, what))
+				return;
+	}
+
+#if MATH_SIMD_LEVEL == 1
+	constexpr float ProductTolerance = 0;
+#else
+	// FMA, in the AVX2 kernels or contracted by the compiler in scalar code, rounds differently
+	constexpr float ProductTolerance = 4 * FLT_EPSILON;
+#endif
+	constexpr float DotTolerance = 4 * FLT_EPSILON;
+	constexpr float InverseTolerance = 1e-6f;
+
+	/// @brief Not a multiple of any lane width, so every stream operation runs its scalar tail
+	constexpr size_t StreamSize = 29;
+
+	/// @brief Components in [-1, 1), with a zero vector at index 5
+	template <typename V>
+	Array<V> MakeVectors(uint64_t seed)
+	{
+		Random random(seed);
+		Array<V> vectors(StreamSize);
+		for (V& v : vectors)
+			random.fill(&v.x, sizeof(V) / sizeof(float), -1.0f, 1.0f);
+		vectors[5] = V();
+		return vectors;
+	}
+
+	template <typename V>
+	void CheckVectorNear(const V& actual, const V& expected, float tolerance)
+	{
+		for (size_t c = 0; c < sizeof(V) / sizeof(float); ++c)
+			CHECK_NEAR((&actual.x)[c], (&expected.x)[c], tolerance);
+	}
+
+	/// @brief Largest error of a Fast tier result against double precision libm, as in the FastMath.h table
+	struct FastError
+	{
+		double abs = 0;
+		/// Only where |libm result| > 0.5, near roots the absolute bound is the meaningful one
+		double ulp = 0;
+
+		void add(float fast, double reference) noexcept
+		{
+			const double error = std::fabs(fast - reference);
+			abs = std::fmax(abs, error);
+			if (std::fabs(reference) > 0.5)
+				ulp = std::fmax(ulp, error / std::ldexp(1.0, std::ilogb(static_cast<float>(reference)) - 23));
+		}
+	};
+
+	/// @brief n evenly spaced samples of [low, high]
+	Array<float> Sweep(double low, double high, size_t n)
+	{
+		Array<float> samples(n);
+		for (size_t i = 0; i < n; ++i)
+			samples[i] = static_cast<float>(low + (high - low) * static_cast<double>(i) / static_cast<double>(n - 1));
+		return samples;
+	}
+
+	/// @brief Error of the scalar and batch Fast tier of a one argument function over in
+	template <typename Scalar, typename Batch, typename Reference>
+	FastError MeasureFast(const Array<float>& in, Scalar scalar, Batch batch, Reference reference)
+	{
+		Array<float> out(in.size());
+		batch(in.data(), out.data(), in.size());
+		FastError error;
+		for (size_t i = 0; i < in.size(); ++i)
+		{
+			const double expected = reference(static_cast<double>(in[i]));
+			error.add(out[i], expected);
+			error.add(scalar(in[i]), expected);
+		}
+		return error;
+	}
+
+	constexpr size_t FastSweepSize = 1 << 18;
+}
+
+TEST_CASE(simd_mat4_mul)
+{
+	for (size_t i = 0; i < KernelCaseCount; ++i)
+	{
+		const KernelInputs& in = KernelInputSet[i];
+		const mat4 actual = in.a4 * in.b4;
+		mat4 scale;
+		AbsProducts(in.a4.cols[0], in.b4.cols[0], 4, 4, scale.cols[0]);
+		CheckProducts(actual.cols[0], ScalarResults[i].mul4.cols[0], scale.cols[0], 16, ProductTolerance, "mat4 * mat4");
+	}
+}
+
+TEST_CASE(simd_mat4_mul_vec4)
+{
+	for (size_t i = 0; i < KernelCaseCount; ++i)
+	{
+		const KernelInputs& in = KernelInputSet[i];
+		const vec4 actual = in.a4 * in.v4;
+		vec4 scale;
+		AbsProducts(in.a4.cols[0], in.v4, 4, 1, scale);
+		CheckProducts(actual, ScalarResults[i].mul_vec4, scale, 4, ProductTolerance, "mat4 * vec4");
+	}
+}
+
+TEST_CASE(simd_mat4_transpose)
+{
+	for (size_t i = 0; i < KernelCaseCount; ++i)
+		CHECK(KernelInputSet[i].a4.transposed() == ScalarResults[i].transposed4);
+}
+
+TEST_CASE(simd_mat4_inverse)
+{
+	for (size_t i = 0; i < KernelCaseCount; ++i)
+	{
+		const mat4 actual = KernelInputSet[i].a4.inverse();
+		const float* expected = ScalarResults[i].inverse4.cols[0];
+		float largest = 0;
+		for (size_t k = 0; k < 16; ++k)
+			largest = std::fmax(largest, std::fabs(expected[k]));
+		for (size_t k = 0; k < 16; ++k)
+			CHECK_NEAR(actual.cols[0][k], expected[k], InverseTolerance * largest);
+	}
+}
+
+TEST_CASE(simd_vec4_dot)
+{
+	for (size_t i = 0; i < KernelCaseCount; ++i)
+	{
+		const KernelInputs& in = KernelInputSet[i];
+		const float scale = std::fabs(in.v4.x * in.w4.x) + std::fabs(in.v4.y * in.w4.y)
+			+ std::fabs(in.v4.z * in.w4.z) + std::fabs(in.v4.w * in.w4.w);
+		CHECK_NEAR(in.v4.dot_product(in.w4), ScalarResults[i].dot4, DotTolerance * scale);
+	}
+}
+
+TEST_CASE(simd_mat3_mul)
+{
+	for (size_t i = 0; i < KernelCaseCount; ++i)
+	{
+		const KernelInputs& in = KernelInputSet[i];
+		const mat3 actual = in.a3 * in.b3;
+		mat3 scale;
+		AbsProducts(&in.a3.cols[0].x, &in.b3.cols[0].x, 3, 3, &scale.cols[0].x);
+		CheckProducts(&actual.cols[0].x, &ScalarResults[i].mul3.cols[0].x, &scale.cols[0].x, 9, ProductTolerance,
+			"mat3 * mat3");
+	}
+}
+
+TEST_CASE(simd_mat3_mul_vec3)
+{
+	for (size_t i = 0; i < KernelCaseCount; ++i)
+	{
+		const KernelInputs& in = KernelInputSet[i];
+		const vec3 actual = in.a3 * in.v3;
+		vec3 scale;
+		AbsProducts(&in.a3.cols[0].x, &in.v3.x, 3, 1, &scale.x);
+		CheckProducts(&actual.x, &ScalarResults[i].mul_vec3.x, &scale.x, 3, ProductTolerance, "mat3 * vec3");
+	}
+}
+
+TEST_CASE(stream_load_store)
+{
+	const Array<vec3> v3 = MakeVectors<vec3>(1);
+	const Array<vec4> v4 = MakeVectors<vec4>(2);
+	Vec3Stream s3(v3.data(), StreamSize);
+	Vec4Stream s4(v4.data(), StreamSize);
+	for (size_t i = 0; i < StreamSize; ++i)
+	{
+		CHECK(s3.lane(0)[i] == v3[i].x && s3.lane(1)[i] == v3[i].y && s3.lane(2)[i] == v3[i].z);
+		CHECK(s4[i] == v4[i]);
+	}
+	for (size_t c = 0; c < 4; ++c)
+		CHECK(reinterpret_cast<uintptr_t>(s4.lane(c)) % Vec4Stream::alignment == 0);
+
+	Array<vec3> v3_out(StreamSize);
+	Array<vec4> v4_out(StreamSize);
+	s3.store(v3_out.data());
+	s4.store(v4_out.data());
+	CHECK(v3_out == v3);
+	CHECK(v4_out == v4);
+}
+
+TEST_CASE(stream_planar_view)
+{
+	const Array<vec3> v3 = MakeVectors<vec3>(3);
+	Array<float> planar(3 * StreamSize);
+	Vec3View view = Vec3View::planar(planar.data(), StreamSize);
+	view.load(v3.data(), StreamSize);
+	for (size_t i = 0; i < StreamSize; ++i)
+		CHECK(planar[i] == v3[i].x && planar[StreamSize + i] == v3[i].y && planar[2 * StreamSize + i] == v3[i].z);
+	view.set(7, vec3(1, 2, 3));
+	CHECK(view.get(7) == vec3(1, 2, 3));
+	CHECK(planar[2 * StreamSize + 7] == 3);
+}
+
+TEST_CASE(stream_vec3_ops)
+{
+	const Array<vec3> a = MakeVectors<vec3>(4);
+	const Array<vec3> b = MakeVectors<vec3>(5);
+	Vec3Stream sa(a.data(), StreamSize), sb(b.data(), StreamSize), out(StreamSize);
+	Array<float> dots(StreamSize);
+
+	sa.view().dot_product(sb.view(), dots.data());
+	for (size_t i = 0; i < StreamSize; ++i)
+		CHECK_NEAR(dots[i], a[i].dot_product(b[i]), 1e-6f);
+
+	sa.view().cross_product(sb.view(), out.view());
+	for (size_t i = 0; i < StreamSize; ++i)
+		CheckVectorNear(out[i], a[i].cross_product(b[i]), 1e-6f);
+
+	sa.view().normalized(out.view());
+	for (size_t i = 0; i < StreamSize; ++i)
+		CheckVectorNear(out[i], a[i].normalized(), 1e-6f);
+	CHECK(out[5] == vec3());
+
+	// In place, aliasing the first operand
+	sa.view().cross_product(sb.view(), sa.view());
+	for (size_t i = 0; i < StreamSize; ++i)
+		CheckVectorNear(sa[i], a[i].cross_product(b[i]), 1e-6f);
+}
+
+TEST_CASE(stream_vec4_ops)
+{
+	const Array<vec4> a = MakeVectors<vec4>(6);
+	const Array<vec4> b = MakeVectors<vec4>(7);
+	Vec4Stream sa(a.data(), StreamSize), sb(b.data(), StreamSize), out(StreamSize);
+
+	sa.view().normalized(out.view());
+	for (size_t i = 0; i < StreamSize; ++i)
+		CheckVectorNear(out[i], a[i].normalized(), 1e-6f);
+
+	sa.view().lerp(sb.view(), 0.25f, out.view());
+	for (size_t i = 0; i < StreamSize; ++i)
+		CheckVectorNear(out[i], a[i] + (b[i] - a[i]) * 0.25f, 1e-6f);
+
+	sa.view().min(sb.view(), out.view());
+	for (size_t i = 0; i < StreamSize; ++i)
+		CHECK(out[i] == vec4(Mathf::min(a[i].x, b[i].x), Mathf::min(a[i].y, b[i].y),
+			Mathf::min(a[i].z, b[i].z), Mathf::min(a[i].w, b[i].w)));
+
+	sa.view().max(sb.view(), out.view());
+	for (size_t i = 0; i < StreamSize; ++i)
+		CHECK(out[i] == vec4(Mathf::max(a[i].x, b[i].x), Mathf::max(a[i].y, b[i].y),
+			Mathf::max(a[i].z, b[i].z), Mathf::max(a[i].w, b[i].w)));
+
+	vec4 sum(0, 0, 0, 0), low(FLT_MAX), high(-FLT_MAX);
+	for (const vec4& v : a)
+	{
+		sum += v;
+		low = vec4(Mathf::min(low.x, v.x), Mathf::min(low.y, v.y), Mathf::min(low.z, v.z), Mathf::min(low.w, v.w));
+		high = vec4(Mathf::max(high.x, v.x), Mathf::max(high.y, v.y), Mathf::max(high.z, v.z), Mathf::max(high.w, v.w));
+	}
+	CheckVectorNear(sa.sum(), sum, 1e-5f);
+	CHECK(sa.min_element() == low);
+	CHECK(sa.max_element() == high);
+}
+
+TEST_CASE(fast_rsqrt_edges)
+{
+	constexpr float inf = std::numeric_limits<float>::infinity();
+	const float in[] = { 0.0f, -0.0f, inf, 1.0f, 4.0f, 0.01f, 1e20f, 1e-20f, 0.0f };
+	constexpr size_t n = sizeof(in) / sizeof(in[0]);
+	float batch[n];
+	Mathf::rsqrt<MathPrecision::Fast>(in, batch, n);
+	for (size_t i = 0; i < n; ++i)
+	{
+		const float accurate = Mathf::rsqrt(in[i]);
+		const float fast = Mathf::rsqrt<MathPrecision::Fast>(in[i]);
+		if (std::isinf(accurate) || accurate == 0)
+		{
+			CHECK(fast == accurate);
+			CHECK(batch[i] == accurate);
+		}
+		else
+		{
+			CHECK_NEAR(fast, accurate, 4 * FLT_EPSILON * accurate);
+			CHECK_NEAR(batch[i], accurate, 4 * FLT_EPSILON * accurate);
+		}
+	}
+}
+
+TEST_CASE(fast_math_error_bounds)
+{
+	constexpr double pi = 3.14159265358979323846;
+	constexpr auto Fast = MathPrecision::Fast;
+
+	Array<float> angles = Sweep(-100 * pi, 100 * pi, FastSweepSize);
+	// Worst known cos input, next to -5pi/2
+	angles.push_back(-7.8539958f);
+	const FastError sin = MeasureFast(angles, [](float x) { return Mathf::sin<Fast>(x); },
+		[](const float* in, float* out, size_t n) { Mathf::sin<Fast>(in, out, n); }, [](double x) { return std::sin(x); });
+	CHECK(sin.abs <= 2.2e-7);
+	CHECK(sin.ulp <= 4);
+	const FastError cos = MeasureFast(angles, [](float x) { return Mathf::cos<Fast>(x); },
+		[](const float* in, float* out, size_t n) { Mathf::cos<Fast>(in, out, n); }, [](double x) { return std::cos(x); });
+	CHECK(cos.abs <= 2.8e-7);
+	CHECK(cos.ulp <= 5);
+
+	const FastError acos = MeasureFast(Sweep(-1, 1, FastSweepSize), [](float x) { return Mathf::acos<Fast>(x); },
+		[](const float* in, float* out, size_t n) { Mathf::acos<Fast>(in, out, n); }, [](double x) { return std::acos(x); });
+	CHECK(acos.abs <= 4.4e-7);
+	CHECK(acos.ulp <= 3);
+
+	Array<float> squares(FastSweepSize);
+	for (size_t i = 0; i < FastSweepSize; ++i)
+		squares[i] = static_cast<float>(std::exp2(-100.0 + 200.0 * static_cast<double>(i) / (FastSweepSize - 1)));
+	const FastError rsqrt = MeasureFast(squares, [](float x) { return Mathf::rsqrt<Fast>(x); },
+		[](const float* in, float* out, size_t n) { Mathf::rsqrt<Fast>(in, out, n); }, [](double x) { return 1 / std::sqrt(x); });
+#if MATH_SIMD_LEVEL == 0
+	CHECK(rsqrt.ulp <= 2);
+#else
+	CHECK(rsqrt.ulp <= 4);
+#endif
+
+	// Every direction, at radii from 2^-120 to 2^119
+	Array<float> y(FastSweepSize), x(FastSweepSize), atan2(FastSweepSize);
+	for (size_t i = 0; i < FastSweepSize; ++i)
+	{
+		const double angle = -pi + 2 * pi * static_cast<double>(i) / (FastSweepSize - 1);
+		const double radius = std::ldexp(1.0, static_cast<int>(i % 240) - 120);
+		y[i] = static_cast<float>(radius * std::sin(angle));
+		x[i] = static_cast<float>(radius * std::cos(angle));
+	}
+	Mathf::atan2<Fast>(y.data(), x.data(), atan2.data(), FastSweepSize);
+	FastError atan2_error;
+	for (size_t i = 0; i < FastSweepSize; ++i)
+	{
+		// The sign of zero is ignored, see FastMath.h
+		if (y[i] == 0)
+			continue;
+		const double expected = std::atan2(static_cast<double>(y[i]), static_cast<double>(x[i]));
+		atan2_error.add(atan2[i], expected);
+		atan2_error.add(Mathf::atan2<Fast>(y[i], x[i]), expected);
+	}
+	CHECK(atan2_error.abs <= 3.1e-7);
+	CHECK(Mathf::atan2<Fast>(0.0f, 0.0f) == 0);
+}
+
+TEST_CASE(random_reference_sequence)
+{
+	// splitmix64 seeding and xoshiro256++ as published by Blackman and Vigna
+	Random random(2024);
+	CHECK(random.next_u64() == 0x8641253F8FED82D1ull);
+	CHECK(random.next_u64() == 0x4B7EEEC62AF66AF9ull);
+	CHECK(random.next_u64() == 0x3E595FE9CF746B2Aull);
+	CHECK(random.next_u64() == 0x6BF1AA430346476Cull);
+
+	Random third = Random::stream(2024, 2);
+	CHECK(third.next_u64() == 0x8579FE1A3DD4CBD7ull);
+	CHECK(third.next_u64() == 0x89594E1AE457B324ull);
+}
+
+TEST_CASE(random_stream_matches_split)
+{
+	Random parent(77);
+	for (uint32_t i = 0; i < 4; ++i)
+	{
+		Random split = parent.split();
+		Random stream = Random::stream(77, i);
+		for (int k = 0; k < 8; ++k)
+			CHECK(split.next_u64() == stream.next_u64());
+	}
+}
+
+TEST_CASE(random_fill_reference)
+{
+	// Exact on every backend: 24 bit integers times 2^-24
+	constexpr uint32_t expected[] = { 14698767, 1971074, 798909, 12372443, 6006898, 7704573, 8936670, 2536568,
+		2513207, 15816790, 10958457, 13428841, 10325250, 7296064, 7874701, 8690255 };
+	constexpr size_t n = sizeof(expected) / sizeof(expected[0]);
+	float values[n];
+	Random random(2024);
+	random.fill(values, n);
+	for (size_t i = 0; i < n; ++i)
+		CHECK(values[i] == static_cast<float>(expected[i]) / 16777216.0f);
+
+	// A partial step writes the prefix of the same values
+	float prefix[n] = {};
+	Random(2024).fill(prefix, 13);
+	for (size_t i = 0; i < 13; ++i)
+		CHECK(prefix[i] == values[i]);
+	CHECK(prefix[13] == 0);
+}
+
+TEST_CASE(constexpr_trig_matches_libm)
+{
+	for (const TrigSample& sample : ConstTrigSamples)
+	{
+		const float sin = static_cast<float>(std::sin(static_cast<double>(sample.x)));
+		const float cos = static_cast<float>(std::cos(static_cast<double>(sample.x)));
+		CHECK_NEAR(sample.sin, sin, Ulp(sin));
+		CHECK_NEAR(sample.cos, cos, Ulp(cos));
+		CHECK_NEAR(sample.sin, Mathf::sin(sample.x), Ulp(sin));
+		CHECK_NEAR(sample.cos, Mathf::cos(sample.x), Ulp(cos));
+	}
+}
+
+namespace
+{
+	/// @brief The compile time tables against BuildUnitSphere at run time, which calls the C runtime
+	template <unsigned Accuracy>
+	void CheckUnitSphereTable()
+	{
+		Array<vec3> runtime(UnitSphereSize(Accuracy));
+		BuildUnitSphere(Accuracy, runtime.data());
+		CHECK(FindUnitSphere(Accuracy) == UnitSphere<Accuracy>::directions.data());
+		// Products of two values within 1 ulp each
+		for (size_t i = 0; i < runtime.size(); ++i)
+			CheckVectorNear(UnitSphere<Accuracy>::directions[i], runtime[i], 2 * FLT_EPSILON);
+	}
+}
+
+TEST_CASE(unit_sphere_tables_match_runtime)
+{
+	CheckUnitSphereTable<8>();
+	CheckUnitSphereTable<16>();
+	CheckUnitSphereTable<32>();
+}
+
+TEST_CASE(batch_transform_tails)
+{
+	const mat4 m(vec3(1, -2, 3), vec3(1.5f, 0.5f, 2), Quaternion(vec3(0.3f, 0.5f, 0.7f).normalized(), 0.9f));
+	const mat3 normal_matrix = NormalMatrix(m);
+	// Every remainder of the 8- and 4-wide loops, and empty batches
+	for (size_t n = 0; n <= 19; ++n)
+	{
+		Array<vec3> in = MakeVectors<vec3>(8 + n);
+		in.resize(n);
+		Array<vec3> points(n), directions(n), normals(n);
+		TransformPoints(m, in.data(), points.data(), n);
+		TransformDirections(m, in.data(), directions.data(), n);
+		TransformNormals(normal_matrix, in.data(), normals.data(), n);
+		for (size_t i = 0; i < n; ++i)
+		{
+			CheckVectorNear(points[i], vec3(m * vec4(in[i], 1)), 1e-5f);
+			CheckVectorNear(directions[i], vec3(m * vec4(in[i], 0)), 1e-5f);
+			CheckVectorNear(normals[i], (normal_matrix * in[i]).normalized(), 1e-5f);
+		}
+
+		// In place
+		TransformPoints(m, in.data(), in.data(), n);
+		CHECK(in == points);
+	}
+}
+
+namespace
+{
+	void CheckMatrixNear(const mat4& actual, const mat4& expected, float tolerance)
+	{
+		for (size_t c = 0; c < 4; ++c)
+			CheckVectorNear(actual.cols[c], expected.cols[c], tolerance);
+	}
+
+	/// @brief Rotation about a random axis, never the identity
+	Quaternion RandomRotation(Random& random)
+	{
+		vec3 axis;
+		random.fill(&axis.x, 3, -1.0f, 1.0f);
+		return Quaternion((axis + vec3(0, 0, 2)).normalized(), random.range(0.1f, 3.0f));
+	}
+}
+
+TEST_CASE(affine3_matches_mat4)
+{
+	Random random(11);
+	for (size_t i = 0; i < 64; ++i)
+	{
+		vec3 position, scales;
+		random.fill(&position.x, 3, -1.0f, 1.0f);
+		random.fill(&scales.x, 3, 0.5f, 2.5f);
+		const Quaternion rotation = RandomRotation(random);
+		const Affine3 a(position, scales, rotation);
+		const mat4 ma(position, scales, rotation);
+		CheckMatrixNear(mat4(a), ma, 1e-6f);
+		CheckMatrixNear(mat4(Affine3(ma)), ma, 1e-6f);
+
+		const Affine3 b(vec3(random.range(-1, 1), 0.5f, 2), vec3(random.range(0.5f, 2.5f)), RandomRotation(random));
+		const mat4 mb(b);
+		CheckMatrixNear(mat4(a * b), ma * mb, 1e-5f);
+		CheckMatrixNear(mat4(a.inverse()), ma.inverse(), 1e-5f);
+		CheckMatrixNear(mat4(a * a.inverse()), mat4::identity(), 1e-5f);
+
+		vec3 p;
+		random.fill(&p.x, 3, -1.0f, 1.0f);
+		CheckVectorNear(a.transform_point(p), vec3(ma * vec4(p, 1)), 1e-5f);
+		CheckVectorNear(a.transform_direction(p), vec3(ma * vec4(p, 0)), 1e-5f);
+		CheckVectorNear((a * b).transform_point(p), a.transform_point(b.transform_point(p)), 1e-5f);
+	}
+}
+
+TEST_CASE(rigid_matches_mat4)
+{
+	Random random(12);
+	for (size_t i = 0; i < 64; ++i)
+	{
+		vec3 ta, tb, p;
+		random.fill(&ta.x, 3, -1.0f, 1.0f);
+		random.fill(&tb.x, 3, -1.0f, 1.0f);
+		random.fill(&p.x, 3, -1.0f, 1.0f);
+		const Rigid a(RandomRotation(random), ta);
+		const Rigid b(RandomRotation(random), tb);
+		const mat4 ma(a), mb(b);
+		CheckMatrixNear(ma, mat4(ta, vec3(1), a.rotation), 1e-6f);
+		CheckMatrixNear(mat4(Affine3(a)), ma, 1e-6f);
+
+		CheckMatrixNear(mat4(a * b), ma * mb, 1e-5f);
+		CheckMatrixNear(mat4(a.inverse()), ma.inverse(), 1e-5f);
+		CheckMatrixNear(mat4(a * a.inverse()), mat4::identity(), 1e-5f);
+
+		CheckVectorNear(a.transform_point(p), vec3(ma * vec4(p, 1)), 1e-5f);
+		CheckVectorNear(a.transform_direction(p), vec3(ma * vec4(p, 0)), 1e-5f);
+		CheckVectorNear(a.inverse().transform_point(a.transform_point(p)), p, 1e-5f);
+	}
+}
+
+namespace
+{
+	void CheckMatrixNear(const mat3& actual, const mat3& expected, float tolerance)
+	{
+		for (size_t c = 0; c < 3; ++c)
+			CheckVectorNear(actual.cols[c], expected.cols[c], tolerance);
+	}
+
+	/// @brief Rotation and the other quaternion of the same rotation, -q, from the angle plus a turn
+	std::pair<Quaternion, Quaternion> RandomRotationPair(Random& random)
+	{
+		vec3 axis;
+		random.fill(&axis.x, 3, -1.0f, 1.0f);
+		axis = (axis + vec3(0, 0, 2)).normalized();
+		const float angle = random.range(-3.0f, 3.0f);
+		return { Quaternion(axis, angle), Quaternion(axis, angle + 2 * Mathf::Pi) };
+	}
+}
+
+TEST_CASE(quaternion_matches_mat3)
+{
+	// Active right-handed rotations: a quarter turn about z takes x to y
+	const Quaternion quarter(vec3(0, 0, 1), Mathf::Pi / 2);
+	CheckVectorNear(quarter.rotate(vec3(1, 0, 0)), vec3(0, 1, 0), 1e-6f);
+	CheckVectorNear(mat3(quarter) * vec3(1, 0, 0), vec3(0, 1, 0), 1e-6f);
+	CheckVectorNear(mat3(quarter) * vec3(0, 1, 0), vec3(-1, 0, 0), 1e-6f);
+
+	Random random(14);
+	for (size_t i = 0; i < 64; ++i)
+	{
+		const Quaternion a = RandomRotation(random), b = RandomRotation(random);
+		vec3 p;
+		random.fill(&p.x, 3, -1.0f, 1.0f);
+		CheckMatrixNear(mat3(a * b), mat3(a) * mat3(b), 1e-5f);
+		CheckVectorNear(mat3(a) * p, a.rotate(p), 1e-5f);
+		CheckVectorNear((a * b).rotate(p), a.rotate(b.rotate(p)), 1e-5f);
+		CheckVectorNear(vec3(mat4(a) * vec4(p, 1)), a.rotate(p), 1e-5f);
+		CheckMatrixNear(mat3(a) * mat3(a.inverse()), mat3::identity(), 1e-5f);
+		CheckVectorNear(vec4(a * a.inverse()), vec4(Quaternion()), 1e-6f);
+	}
+}
+
+TEST_CASE(quaternion_interpolation_short_arc)
+{
+	Random random(15);
+	for (size_t i = 0; i < 64; ++i)
+	{
+		const Quaternion q = RandomRotation(random);
+		const auto [r, flipped] = RandomRotationPair(random);
+		CHECK_NEAR(r.dot_product(flipped), -1.0f, 1e-5f);
+		const float d = Mathf::abs(q.dot_product(r));
+		const float theta = Mathf::acos(d);
+		for (float t : { 0.0f, 0.25f, 0.5f, 0.75f, 1.0f })
+		{
+			// Either quaternion of the target gives the same result, on the arc that starts at q
+			const Quaternion s = Quaternion::slerp(q, r, t);
+			CheckVectorNear(vec4(Quaternion::slerp(q, flipped, t)), vec4(s), 1e-5f);
+			CHECK_NEAR(vec4(s).length(), 1.0f, 1e-5f);
+			CHECK(s.dot_product(q) >= d - 1e-5f);
+			// At a constant rate along it
+			CHECK_NEAR(Mathf::acos(Mathf::min(s.dot_product(q), 1.0f)), t * theta, 2e-3f);
+			CheckVectorNear(vec4(Quaternion::slerp<MathPrecision::Fast>(q, flipped, t)), vec4(s), 2e-5f);
+
+			const Quaternion n = Quaternion::nlerp(q, r, t);
+			CheckVectorNear(vec4(Quaternion::nlerp(q, flipped, t)), vec4(n), 1e-5f);
+			CHECK(n.dot_product(q) >= d - 1e-5f);
+		}
+		CheckVectorNear(vec4(Quaternion::slerp(q, r, 0)), vec4(q), 1e-5f);
+		CHECK_NEAR(Mathf::abs(Quaternion::slerp(q, flipped, 1).dot_product(r)), 1.0f, 1e-5f);
+
+		// Nearly parallel inputs take the nlerp path
+		const Quaternion near = q * Quaternion(vec3(0, 1, 0), 1e-3f);
+		CHECK(Mathf::abs(q.dot_product(near)) > Quaternion::SlerpNlerpThreshold);
+		CheckVectorNear(vec4(Quaternion::slerp(q, near, 0.5f)), vec4(Quaternion::nlerp(q, near, 0.5f)), 1e-6f);
+	}
+}
+
+TEST_CASE(batch_quaternion_tails)
+{
+	Random random(16);
+	// Every remainder of the 8- and 4-wide loops, and empty batches
+	for (size_t n = 0; n <= 19; ++n)
+	{
+		// Half of the targets on the other hemisphere, some nearly parallel to take the nlerp path
+		Array<Quaternion> a(n), b(n);
+		Array<float> t(n);
+		const Quaternion small(vec3(1, 0, 0), 1e-3f);
+		for (size_t i = 0; i < n; ++i)
+		{
+			const auto [q, qFlipped] = RandomRotationPair(random);
+			const auto [r, rFlipped] = RandomRotationPair(random);
+			const Quaternion target = i % 3 == 2 ? q * small : r;
+			const Quaternion other = i % 3 == 2 ? qFlipped * small : rFlipped;
+			a[i] = q;
+			b[i] = (q.dot_product(target) < 0) == (i % 2 == 1) ? target : other;
+			t[i] = random.range(0.0f, 1.0f);
+		}
+		const float uniform = 0.3f;
+
+		// One past the end, which must not be written
+		const Quaternion sentinel(vec3(1, 0, 0), 1.0f);
+		Array<Quaternion> out(n + 1, sentinel);
+		NlerpQuaternions(a.data(), b.data(), t.data(), out.data(), n);
+		for (size_t i = 0; i < n; ++i)
+			CheckVectorNear(vec4(out[i]), vec4(Quaternion::nlerp(a[i], b[i], t[i])), 1e-6f);
+		NlerpQuaternions(a.data(), b.data(), uniform, out.data(), n);
+		for (size_t i = 0; i < n; ++i)
+			CheckVectorNear(vec4(out[i]), vec4(Quaternion::nlerp(a[i], b[i], uniform)), 1e-6f);
+		SlerpQuaternions(a.data(), b.data(), uniform, out.data(), n);
+		for (size_t i = 0; i < n; ++i)
+			CheckVectorNear(vec4(out[i]), vec4(Quaternion::slerp<MathPrecision::Fast>(a[i], b[i], uniform)), 2e-6f);
+		SlerpQuaternions(a.data(), b.data(), t.data(), out.data(), n);
+		for (size_t i = 0; i < n; ++i)
+			CheckVectorNear(vec4(out[i]), vec4(Quaternion::slerp<MathPrecision::Fast>(a[i], b[i], t[i])), 2e-6f);
+		CHECK(out[n] == sentinel);
+
+		Array<mat3> m3(n + 1, mat3::zero());
+		Array<mat4> m4(n + 1, mat4::zero());
+		QuaternionsToMat3(out.data(), m3.data(), n);
+		QuaternionsToMat4(out.data(), m4.data(), n);
+		for (size_t i = 0; i < n; ++i)
+		{
+			CheckMatrixNear(m3[i], mat3(out[i]), 4 * FLT_EPSILON);
+			CheckMatrixNear(m4[i], mat4(out[i]), 4 * FLT_EPSILON);
+		}
+		CHECK(m3[n].cols[0] == vec3() && m3[n].cols[1] == vec3() && m3[n].cols[2] == vec3() && m4[n] == mat4::zero());
+
+		// In place
+		SlerpQuaternions(a.data(), b.data(), t.data(), a.data(), n);
+		CHECK(Array<Quaternion>(out.begin(), out.begin() + n) == a);
+	}
+}
+
+namespace
+{
+	/// @brief Distance of the closest bound surface to any frustum plane. Where it is tiny, the
+	/// SIMD and scalar classifications may round to different sides.
+	float PlaneMargin(const Frustum& frustum, const vec3& c, const vec3& e, bool box)
+	{
+		float margin = std::numeric_limits<float>::max();
+		for (int k = 0; k < Frustum::PlaneCount; ++k)
+		{
+			const vec4& p = frustum.planes[k];
+			const float d = frustum.distance(Frustum::Plane(k), c);
+			const float r = box ? std::fabs(p.x) * e.x + std::fabs(p.y) * e.y + std::fabs(p.z) * e.z : e.x;
+			margin = Mathf::min(margin, Mathf::min(std::fabs(d + r), std::fabs(d - r)));
+		}
+		return margin;
+	}
+}
+
+TEST_CASE(batch_culling_matches_frustum)
+{
+	// Same camera as MathBench
+	const mat4 projection(vec4(0.974f, 0, 0, 0), vec4(0, 1.732f, 0, 0), vec4(0, 0, -1.020f, -1), vec4(0, 0, -2.020f, 0));
+	const Frustum frustum(projection * mat4(vec3(0, 0, 20), vec3(), vec3::up()));
+	// Not a multiple of the lane width, so the scalar tail runs too
+	constexpr size_t n = 1027;
+	Random random(13);
+	Array<float> x(n), y(n), z(n), ex(n), ey(n), ez(n);
+	random.fill(x.data(), n, -20.0f, 20.0f);
+	random.fill(y.data(), n, -20.0f, 20.0f);
+	random.fill(z.data(), n, -20.0f, 20.0f);
+	random.fill(ex.data(), n, 0.0f, 3.0f);
+	random.fill(ey.data(), n, 0.0f, 3.0f);
+	random.fill(ez.data(), n, 0.0f, 3.0f);
+	const SphereSoA spheres = { x.data(), y.data(), z.data(), ex.data() };
+	const AABBSoA boxes = { x.data(), y.data(), z.data(), ex.data(), ey.data(), ez.data() };
+
+	Array<Containment> sphere_codes(n), box_codes(n);
+	Array<uint32_t> visible(n);
+	ClassifySpheres(frustum, spheres, sphere_codes.data(), n);
+	ClassifyAABBs(frustum, boxes, box_codes.data(), n);
+	size_t outside = 0, inside = 0;
+	for (size_t i = 0; i < n; ++i)
+	{
+		const vec3 c(x[i], y[i], z[i]), e(ex[i], ey[i], ez[i]);
+		const Containment sphere = frustum.classify(Sphere(c, ex[i]));
+		const Containment box = frustum.classify(AABB::from_center_extents(c, e));
+		CHECK(sphere_codes[i] == sphere || PlaneMargin(frustum, c, vec3(ex[i]), false) < 1e-4f);
+		CHECK(box_codes[i] == box || PlaneMargin(frustum, c, e, true) < 1e-4f);
+		outside += box == Containment::Outside;
+		inside += box == Containment::Inside;
+	}
+	// The bounds exercise all three results
+	CHECK(outside > 0 && inside > 0 && outside + inside < n);
+
+	// Culling keeps exactly the bounds the batch classification does not reject, in order
+	const size_t sphere_count = CullSpheres(frustum, spheres, visible.data(), n);
+	Array<uint32_t> expected;
+	for (size_t i = 0; i < n; ++i)
+		if (sphere_codes[i] != Containment::Outside)
+			expected.push_back(static_cast<uint32_t>(i));
+	CHECK(Array<uint32_t>(visible.begin(), visible.begin() + sphere_count) == expected);
+
+	const size_t box_count = CullAABBs(frustum, boxes, visible.data(), n);
+	expected.clear();
+	for (size_t i = 0; i < n; ++i)
+		if (box_codes[i] != Containment::Outside)
+			expected.push_back(static_cast<uint32_t>(i));
+	CHECK(Array<uint32_t>(visible.begin(), visible.begin() + box_count) == expected);
+
+	const Sphere probe(vec3(2, -1, 3), 6);
+	const size_t hit_count = OverlapAABBs(probe, boxes, visible.data(), n);
+	expected.clear();
+	for (size_t i = 0; i < n; ++i)
+		if (probe.intersects(AABB::from_center_extents(vec3(x[i], y[i], z[i]), vec3(ex[i], ey[i], ez[i]))))
+			expected.push_back(static_cast<uint32_t>(i));
+	CHECK(Array<uint32_t>(visible.begin(), visible.begin() + hit_count) == expected);
+}
@@ -0,0 +1,1169 @@
+// Scene module tests. Every case destroys the nodes it creates, the TransformSystem singleton
+// is shared by all of them.
+
+#include "../Math/BatchCulling.h"
+#include "../Math/Random.h"
+#include "../Scene/BVH.h"
+#include "../Scene/Node.h"
+#include "../Scene/SceneFile.h"
+#include "../Scene/SpatialHash.h"
+#include "../Scene/Transform.h"
+#include "../Scene/TransformSystem.h"
+#include "../Utilities/HashMap.h"
+#include "../Utilities/SlabAllocator.h"
+#include "../Utilities/ThreadPool.h"
+#include "Test.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+namespace
+{
+	/// @brief Component types of different sizes that count their live instances
+	template <size_t Size>
+	class Probe final : public Component
+	{
+		friend class ::Node;
+
+	public:
+		~Probe() override { --s_Live; }
+
+		inline static size_t s_Live = 0;
+		uint32_t tag = 0;
+		unsigned char payload[Size] = {};
+
+	private:
+		Probe(Node* node) :
+			Component(node)
+		{
+			++s_Live;
+		}
+	};
+
+	using SmallProbe = Probe<4>;
+	using MediumProbe = Probe<40>;
+	using LargeProbe = Probe<400>;
+
+	/// @brief Expected components of one node in the component pool test
+	struct ProbeState
+	{
+		Node* node;
+		uint32_t tags[3];
+	};
+
+	template <typename T>
+	void CheckProbe(const Node* node, uint32_t tag)
+	{
+		T* p = node->GetComponent<T>();
+		CHECK(node->HasComponent<T>() == (tag != 0));
+		CHECK((p != nullptr) == (tag != 0));
+		if (p != nullptr)
+		{
+			CHECK(p->tag == tag);
+			CHECK(p->GetNode() == node);
+		}
+	}
+
+	/// @brief ForEachComponent<T> visits exactly the live components of type T, each once
+	template <typename T>
+	void CheckPool(const Array<ProbeState>& states, size_t k)
+	{
+		Array<const T*> expected, visited;
+		for (const ProbeState& state : states)
+		{
+			if (state.tags[k] != 0)
+				expected.push_back(state.node->GetComponent<T>());
+		}
+		ForEachComponent<T>([&](T& p) { visited.push_back(&p); });
+		std::sort(expected.begin(), expected.end());
+		std::sort(visited.begin(), visited.end());
+		CHECK(visited == expected);
+		CHECK(ComponentPool<T>::GetSingleton()->GetCount() == expected.size());
+		CHECK(T::s_Live == expected.size());
+	}
+
+	/// @brief Random hierarchy of count nodes below root, each node a child of an earlier one
+	Array<Node*> MakeTree(Node* root, size_t count, uint64_t seed)
+	{
+		Random random(seed);
+		Array<Node*> nodes = { root };
+		for (size_t i = 1; i < count; ++i)
+		{
+			Node* parent = nodes[random.next_u32() % nodes.size()];
+			Node* node = parent->CreateChild("node_" + std::to_string(i));
+			Transform* t = node->GetTransform();
+			t->SetPosition(vec3(random.range(-1, 1), random.range(-1, 1), random.range(-1, 1)));
+			t->SetScale(vec3(random.range(0.5f, 1.5f)));
+			t->SetRotation(Quaternion(vec3(random.range(-1, 1), 1, random.range(-1, 1)).normalized(), random.range(-3, 3)));
+			nodes.push_back(node);
+		}
+		return nodes;
+	}
+
+	/// @brief World transform of node composed from the local transforms up its ancestor chain
+	void ComposeWorld(const Node* node, vec3& position, vec3& scale, Quaternion& rotation)
+	{
+		const Transform* t = node->GetTransform();
+		if (node->GetParent() == nullptr)
+		{
+			position = t->GetPosition();
+			scale = t->GetScale();
+			rotation = t->GetRotation();
+			return;
+		}
+		vec3 ws;
+		Quaternion wr;
+		ComposeWorld(node->GetParent(), position, ws, wr);
+		position += ws * wr.rotate(t->GetPosition());
+		scale = ws * t->GetScale();
+		rotation = wr * t->GetRotation();
+	}
+
+	/// @brief Every world transform matches its ancestor chain
+	void CheckWorldTransforms(const Array<Node*>& nodes)
+	{
+		for (const Node* node : nodes)
+		{
+			vec3 position, scale;
+			Quaternion rotation;
+			ComposeWorld(node, position, scale, rotation);
+			const Transform* t = node->GetTransform();
+			CHECK((t->GetWorldPosition() - position).length() < 1e-4f);
+			CHECK((t->GetWorldScale() - scale).length() < 1e-4f);
+			CHECK(Mathf::abs(t->GetWorldRotation().dot_product(rotation)) > 1 - 1e-5f);
+		}
+	}
+
+	/// @brief Product of the local mat4s up the ancestor chain. Equals the world matrix whenever
+	/// no rotated ancestor sits above a non-uniform scale, where the TRS chain cannot hold shear.
+	mat4 ComposeWorldMatrix(const Node* node)
+	{
+		const Transform* t = node->GetTransform();
+		const mat4 local(t->GetPosition(), t->GetScale(), t->GetRotation());
+		return node->GetParent() == nullptr ? local : ComposeWorldMatrix(node->GetParent()) * local;
+	}
+
+	void CheckMatrixNear(const mat4& actual, const mat4& expected, float tolerance)
+	{
+		for (int c = 0; c < 4; ++c)
+			for (int r = 0; r < 4; ++r)
+				CHECK_NEAR(actual.cols[c][r], expected.cols[c][r], tolerance);
+	}
+
+	/// @brief GetWorldMatrix(), GetWorldToLocalMatrix() and both ExportWorldMatrices() overloads
+	/// against ComposeWorldMatrix()
+	void CheckWorldMatrices(const Array<Node*>& nodes)
+	{
+		TransformSystem* system = TransformSystem::GetSingleton();
+		Array<mat4> all(system->GetCount());
+		system->ExportWorldMatrices(std::span<mat4>(all.data(), all.size()));
+		Array<uint32_t> entries;
+		for (const Node* node : nodes)
+			entries.push_back(node->GetTransform()->GetIndex());
+		Array<mat4> selected(entries.size());
+		system->ExportWorldMatrices(std::span<const uint32_t>(entries.data(), entries.size()),
+			std::span<mat4>(selected.data(), selected.size()));
+
+		for (size_t i = 0; i < nodes.size(); ++i)
+		{
+			const Transform* t = nodes[i]->GetTransform();
+			const mat4 expected = ComposeWorldMatrix(nodes[i]);
+			CheckMatrixNear(static_cast<mat4>(t->GetWorldMatrix()), expected, 1e-4f);
+			CheckMatrixNear(static_cast<mat4>(t->GetWorldToLocalMatrix()), expected.inverse(), 1e-4f);
+			CheckMatrixNear(all[entries[i]], expected, 1e-4f);
+			CheckMatrixNear(selected[i], expected, 1e-4f);
+		}
+	}
+
+	/// @brief Entries of node and its descendants
+	void CollectSubtree(const Node* node, Array<uint32_t>& entries)
+	{
+		entries.push_back(node->GetTransform()->GetIndex());
+		for (size_t i = 0; i < node->GetChildCount(); ++i)
+			CollectSubtree(node->GetChildAt(i), entries);
+	}
+
+	/// @brief The journal holds exactly the entries of the given subtrees, in increasing order,
+	/// and only those carry the current generation
+	void CheckJournal(const Array<Node*>& nodes, const Array<const Node*>& changed)
+	{
+		const TransformSystem* system = TransformSystem::GetSingleton();
+		Array<uint32_t> expected;
+		for (const Node* node : changed)
+			CollectSubtree(node, expected);
+		std::sort(expected.begin(), expected.end());
+		expected.erase(std::unique(expected.begin(), expected.end()), expected.end());
+		CHECK(system->GetChangedEntries() == expected);
+
+		for (const Node* node : nodes)
+		{
+			const uint32_t index = node->GetTransform()->GetIndex();
+			const bool inJournal = std::binary_search(expected.begin(), expected.end(), index);
+			CHECK((system->GetWorldGenerations()[index] == system->GetGeneration()) == inJournal);
+			CHECK(node->GetTransform()->GetWorldGeneration() == system->GetWorldGenerations()[index]);
+		}
+	}
+
+	/// @brief Every child is found by its name, HasChild() agrees, and absent names find nothing
+	void CheckChildNames(const Node* parent, const StringHashMap<Node*>& children)
+	{
+		CHECK(parent->GetChildCount() == children.size());
+		for (const auto& [name, child] : children)
+		{
+			CHECK(parent->GetChild(name) == child);
+			CHECK(parent->HasChild(name));
+			CHECK(child->GetParent() == parent);
+		}
+		CHECK(parent->GetChild("absent") == nullptr);
+		CHECK(!parent->HasChild("absent"));
+	}
+
+	/// @brief Random creates, duplicate creates, renames, moves and releases below parent, checked
+	/// against a map of the expected children after each step
+	void ChurnChildren(Node* parent, size_t count, int steps, uint64_t seed)
+	{
+		Random random(seed);
+		StringHashMap<Node*> children;
+		Node other("other");
+		for (size_t i = 0; i < count; ++i)
+		{
+			const AnsiString name = "child_" + std::to_string(i);
+			children.emplace(name, parent->CreateChild(name));
+		}
+		CheckChildNames(parent, children);
+
+		for (int step = 0; step < steps; ++step)
+		{
+			const AnsiString name = "child_" + std::to_string(random.next_u32() % (count * 2));
+			auto it = children.find(name);
+			Node* sibling = parent->GetChildAt(random.next_u32() % parent->GetChildCount());
+			switch (random.next_u32() % 4)
+			{
+			case 0:
+				// Creating a child under a taken name fails
+				if (Node* child = parent->CreateChild(name))
+				{
+					CHECK(it == children.end());
+					children.emplace(name, child);
+				}
+				else
+					CHECK(it != children.end());
+				break;
+			case 1:
+				// Renaming to a taken name fails and keeps the old name
+				if (sibling->SetName(name))
+				{
+					CHECK(it == children.end());
+					std::erase_if(children, [sibling](const auto& p) { return p.second == sibling; });
+					children.emplace(name, sibling);
+				}
+				else
+					CHECK(it != children.end());
+				break;
+			case 2:
+				// Move a child away and back, it returns under its current name
+				CHECK(other.AppendChild(sibling));
+				CHECK(!parent->HasChild(sibling->GetName()));
+				CHECK(parent->AppendChild(sibling));
+				break;
+			default:
+				if (parent->GetChildCount() > 1)
+				{
+					std::erase_if(children, [sibling](const auto& p) { return p.second == sibling; });
+					delete parent->ReleaseChild(sibling);
+				}
+				break;
+			}
+			CheckChildNames(parent, children);
+		}
+	}
+
+	/// @brief Move the root and some random nodes of a tree from MakeTree
+	void Perturb(const Array<Node*>& nodes, uint64_t seed)
+	{
+		Random random(seed);
+		nodes[0]->GetTransform()->Rotate(Quaternion(vec3::up(), 0.5f));
+		for (size_t i = 0; i < 64; ++i)
+			nodes[random.next_u32() % nodes.size()]->GetTransform()->Translate(vec3(random.range(-1, 1), 0, 0));
+	}
+
+	/// @brief Positions in nodes of the journaled entries, in journal order
+	Array<size_t> JournaledNodes(const Array<Node*>& nodes)
+	{
+		HashMap<const Node*, size_t> positions;
+		for (size_t i = 0; i < nodes.size(); ++i)
+			positions.emplace(nodes[i], i);
+		const TransformSystem* system = TransformSystem::GetSingleton();
+		Array<size_t> journaled;
+		for (uint32_t index : system->GetChangedEntries())
+		{
+			auto it = positions.find(system->GetTransform(index)->GetNode());
+			if (it != positions.end())
+				journaled.push_back(it->second);
+		}
+		return journaled;
+	}
+
+	/// @brief Same names, child order and local transforms in both trees
+	void CheckSameTree(const Node* a, const Node* b)
+	{
+		CHECK(a->GetName() == b->GetName());
+		CHECK(a->GetTransform()->GetPosition() == b->GetTransform()->GetPosition());
+		CHECK(a->GetTransform()->GetScale() == b->GetTransform()->GetScale());
+		CHECK(std::memcmp(&a->GetTransform()->GetRotation(), &b->GetTransform()->GetRotation(), sizeof(Quaternion)) == 0);
+		CHECK(a->GetChildCount() == b->GetChildCount());
+		for (size_t i = 0; i < std::min(a->GetChildCount(), b->GetChildCount()); ++i)
+			CheckSameTree(a->GetChildAt(i), b->GetChildAt(i));
+	}
+
+	/// @brief Write bytes to path and open them as a scene file
+	bool OpensAsScene(const char* path, const Array<unsigned char>& bytes)
+	{
+		std::FILE* fp = std::fopen(path, "wb");
+		if (fp == nullptr)
+			return false;
+		std::fwrite(bytes.data(), 1, bytes.size(), fp);
+		std::fclose(fp);
+		return SceneFile(path).IsValid();
+	}
+
+	/// @brief Scattered nodes in a 60 unit cube with random local transforms
+	Array<Node*> ScatterNodes(Node* root, size_t count, Random& random)
+	{
+		Array<Node*> nodes;
+		for (size_t i = 0; i < count; ++i)
+		{
+			Node* node = root->CreateChild("node_" + std::to_string(i));
+			Transform* t = node->GetTransform();
+			t->SetPosition(vec3(random.range(-30, 30), random.range(-30, 30), random.range(-30, 30)));
+			t->SetScale(vec3(random.range(0.5f, 2)));
+			t->SetRotation(Quaternion(vec3(random.range(-1, 1), 1, random.range(-1, 1)).normalized(), random.range(-3, 3)));
+			nodes.push_back(node);
+		}
+		return nodes;
+	}
+
+	/// @brief Frustum of a camera at a random point looking at another one
+	Frustum RandomFrustum(Random& random, vec3& eye, vec3& target)
+	{
+		const mat4 projection(vec4(0.974f, 0, 0, 0), vec4(0, 1.732f, 0, 0), vec4(0, 0, -1.020f, -1), vec4(0, 0, -2.020f, 0));
+		eye = vec3(random.range(-40, 40), random.range(-40, 40), random.range(-40, 40));
+		target = vec3(random.range(-30, 30), random.range(-30, 30), random.range(-30, 30));
+		return Frustum(projection * mat4(eye, target, vec3::up()));
+	}
+
+	/// @brief World bounds of a set of nodes as structure of arrays, for the batch kernels
+	struct BoundsSoA
+	{
+		Array<const Node*> nodes;
+		Array<AABB> bounds;
+		Array<float> x, y, z, ex, ey, ez;
+
+		void Add(const Node* node, const AABB& box)
+		{
+			const vec3 c = box.center(), e = box.extents();
+			nodes.push_back(node);
+			bounds.push_back(box);
+			x.push_back(c.x);
+			y.push_back(c.y);
+			z.push_back(c.z);
+			ex.push_back(e.x);
+			ey.push_back(e.y);
+			ez.push_back(e.z);
+		}
+
+		AABBSoA View() const { return { x.data(), y.data(), z.data(), ex.data(), ey.data(), ez.data() }; }
+
+		/// @brief Sorted nodes at the first count indices
+		Array<const Node*> Select(const Array<uint32_t>& indices, size_t count) const
+		{
+			Array<const Node*> out;
+			for (size_t i = 0; i < count; ++i)
+				out.push_back(nodes[indices[i]]);
+			std::sort(out.begin(), out.end());
+			return out;
+		}
+	};
+
+	Array<const Node*> Sorted(const Array<Node*>& nodes)
+	{
+		Array<const Node*> out(nodes.begin(), nodes.end());
+		std::sort(out.begin(), out.end());
+		return out;
+	}
+
+	/// @brief Frustum, sphere and ray queries of bvh agree with testing every proxy, using the
+	/// same batch kernels for the leaves
+	void CheckBVHQueries(const BVH& bvh, const Array<Node*>& nodes, Random& random)
+	{
+		BoundsSoA all;
+		for (const Node* node : nodes)
+		{
+			const uint32_t proxy = bvh.GetProxy(node);
+			CHECK(proxy != BVH::InvalidProxy && bvh.GetNode(proxy) == node);
+			all.Add(node, bvh.GetWorldBounds(proxy));
+		}
+		CHECK(bvh.GetProxyCount() == nodes.size());
+
+		Array<uint32_t> hits(nodes.size());
+		Array<Node*> found;
+		size_t nonEmpty = 0, rayHits = 0;
+		for (int q = 0; q < 64; ++q)
+		{
+			vec3 eye, target;
+			const Frustum frustum = RandomFrustum(random, eye, target);
+			found.clear();
+			bvh.Query(frustum, found);
+			CHECK(Sorted(found) == all.Select(hits, CullAABBs(frustum, all.View(), hits.data(), nodes.size())));
+			nonEmpty += !found.empty();
+
+			const Sphere sphere(target, random.range(0, 15));
+			found.clear();
+			bvh.Query(sphere, found);
+			CHECK(Sorted(found) == all.Select(hits, OverlapAABBs(sphere, all.View(), hits.data(), nodes.size())));
+
+			const Ray ray(eye, (target - eye).normalized());
+			const BVH::RayHit hit = bvh.Raycast(ray);
+			BVH::RayHit nearest;
+			for (size_t i = 0; i < nodes.size(); ++i)
+			{
+				float t;
+				if (ray.intersects(all.bounds[i], t, nearest.distance) && (nearest.node == nullptr || t < nearest.distance))
+				{
+					nearest.node = nodes[i];
+					nearest.distance = t;
+				}
+			}
+			// Rays from inside several boxes tie at distance 0, any of them is right
+			CHECK((hit.node == nullptr) == (nearest.node == nullptr));
+			CHECK(hit.distance == nearest.distance);
+			float t;
+			CHECK(hit.node == nullptr ||
+				(ray.intersects(bvh.GetWorldBounds(bvh.GetProxy(hit.node)), t) && t == hit.distance));
+			rayHits += hit.node != nullptr;
+			BVH::RayHit batched;
+			bvh.Raycast(&ray, &batched, 1);
+			CHECK(batched.node == hit.node && batched.distance == hit.distance);
+		}
+		// The queries are not all trivial
+		CHECK(nonEmpty > 16 && rayHits > 16);
+	}
+
+	/// @brief Expected bounds of every live proxy of a SpatialHash
+	using ProxyBounds = HashMap<uint32_t, Sphere>;
+
+	Array<uint32_t> Sorted(Array<uint32_t> proxies)
+	{
+		std::sort(proxies.begin(), proxies.end());
+		return proxies;
+	}
+
+	/// @brief Bounds, sphere, box and neighbor queries of hash agree with testing every proxy
+	void CheckSpatialHash(const SpatialHash& hash, const ProxyBounds& proxies, Random& random)
+	{
+		CHECK(hash.GetProxyCount() == proxies.size());
+		size_t wrongBounds = 0;
+		for (const auto& [proxy, bounds] : proxies)
+		{
+			const Sphere& actual = hash.GetBounds(proxy);
+			wrongBounds += actual.center != bounds.center || actual.radius != bounds.radius;
+		}
+		CHECK(wrongBounds == 0);
+
+		Array<uint32_t> found, expected;
+		size_t nonEmpty = 0;
+		for (int q = 0; q < 64; ++q)
+		{
+			const vec3 c(random.range(-40, 40), random.range(-40, 40), random.range(-40, 40));
+			// Some queries cover more cells than are occupied, which scans the table instead
+			const Sphere sphere(c, q % 16 == 0 ? 60.0f : random.range(0, 6));
+			found.clear();
+			expected.clear();
+			hash.Query(sphere, found);
+			for (const auto& [proxy, bounds] : proxies)
+				if (sphere.intersects(bounds))
+					expected.push_back(proxy);
+			CHECK(Sorted(found) == Sorted(expected));
+			nonEmpty += !found.empty();
+
+			const AABB box(c, c + vec3(random.range(0, 8), random.range(0, 8), random.range(0, 8)));
+			found.clear();
+			expected.clear();
+			hash.Query(box, found);
+			for (const auto& [proxy, bounds] : proxies)
+				if (bounds.intersects(box))
+					expected.push_back(proxy);
+			CHECK(Sorted(found) == Sorted(expected));
+
+			auto it = proxies.begin();
+			std::advance(it, random.next_u32() % proxies.size());
+			const float distance = random.range(0, 4);
+			const Sphere grown(it->second.center, it->second.radius + distance);
+			found.clear();
+			expected.clear();
+			hash.QueryNeighbors(it->first, distance, found);
+			for (const auto& [proxy, bounds] : proxies)
+				if (proxy != it->first && grown.intersects(bounds))
+					expected.push_back(proxy);
+			CHECK(Sorted(found) == Sorted(expected));
+		}
+		CHECK(nonEmpty > 16);
+	}
+
+	/// @brief Parents precede their children in the flat arrays
+	void CheckParentFirst()
+	{
+		const TransformSystem* system = TransformSystem::GetSingleton();
+		for (size_t i = 0; i < system->GetCount(); ++i)
+		{
+			const uint32_t parent = system->GetParents()[i];
+			CHECK(parent == TransformSystem::InvalidIndex || parent < i);
+		}
+	}
+}
+
+TEST_CASE(transform_system_hierarchy)
+{
+	TransformSystem* system = TransformSystem::GetSingleton();
+	Node root("root");
+	Array<Node*> nodes = MakeTree(&root, 500, 1);
+	root.GetTransform()->SetPosition(vec3(1, 2, 3));
+	system->Update();
+	CheckParentFirst();
+	CheckWorldTransforms(nodes);
+
+	// Move subtrees below later nodes, so parents come after children until the next Update()
+	Random random(2);
+	for (int i = 0; i < 50; ++i)
+	{
+		Node* node = nodes[1 + random.next_u32() % (nodes.size() - 1)];
+		Node* parent = nodes[random.next_u32() % nodes.size()];
+		parent->AppendChild(node);
+	}
+	// Destroy some leaves
+	for (size_t i = nodes.size() - 1; i > 0; --i)
+	{
+		if (nodes[i]->GetChildCount() == 0 && random.next_u32() % 4 == 0)
+		{
+			delete nodes[i]->GetParent()->ReleaseChild(nodes[i]);
+			nodes.erase(nodes.begin() + i);
+		}
+	}
+	// World getters resolve the ancestor chain before Update()
+	CheckWorldTransforms(nodes);
+	system->Update();
+	CheckParentFirst();
+	CheckWorldTransforms(nodes);
+	for (const Node* node : nodes)
+		CHECK(system->GetTransform(node->GetTransform()->GetIndex()) == node->GetTransform());
+
+	// A stable frame restores the depth-first order
+	nodes[0]->GetTransform()->Rotate(Quaternion(vec3::up(), 0.5f));
+	system->Update();
+	CheckParentFirst();
+	CheckWorldTransforms(nodes);
+}
+
+TEST_CASE(transform_system_journal)
+{
+	TransformSystem* system = TransformSystem::GetSingleton();
+	Node root("root");
+	Array<Node*> nodes = MakeTree(&root, 300, 3);
+	system->Update();
+	system->Update();
+
+	// Nothing changed
+	uint32_t generation = system->GetGeneration();
+	system->Update();
+	CHECK(system->GetGeneration() == generation + 1);
+	CheckJournal(nodes, {});
+
+	// Two unrelated subtrees and one nested in the first
+	Node* a = nodes[7];
+	Node* b = nullptr;
+	for (size_t i = nodes.size() - 1; b == nullptr; --i)
+	{
+		if (!a->IsAncestorOf(nodes[i]) && !nodes[i]->IsAncestorOf(a))
+			b = nodes[i];
+	}
+	a->GetTransform()->SetPosition(vec3(0, 5, 0));
+	b->GetTransform()->Rotate(Quaternion(vec3::right(), 0.25f));
+	if (a->GetChildCount() > 0)
+		a->GetChildAt(0)->GetTransform()->SetScale(vec3(2));
+	system->Update();
+	CheckJournal(nodes, { a, b });
+	CheckWorldTransforms(nodes);
+
+	// The next frame only reports what changed again
+	b->GetTransform()->SetPosition(vec3(1, 0, 0));
+	system->Update();
+	CheckJournal(nodes, { b });
+
+	// Destroyed entries are left out, even if they were changed in the same frame
+	Node* leaf = nullptr;
+	for (size_t i = nodes.size() - 1; leaf == nullptr; --i)
+	{
+		if (nodes[i]->GetChildCount() == 0 && nodes[i]->GetParent() != &root)
+			leaf = nodes[i];
+	}
+	Node* parent = leaf->GetParent();
+	leaf->GetTransform()->SetPosition(vec3(3, 0, 0));
+	parent->GetTransform()->SetPosition(vec3(0, 0, 3));
+	std::erase(nodes, leaf);
+	delete parent->ReleaseChild(leaf);
+	system->Update();
+	CheckJournal(nodes, { parent });
+	for (uint32_t index : system->GetChangedEntries())
+		CHECK(system->GetTransform(index) != nullptr);
+}
+
+TEST_CASE(transform_system_world_matrices)
+{
+	TransformSystem* system = TransformSystem::GetSingleton();
+	// Non-uniform scales only where no ancestor is rotated, see ComposeWorldMatrix()
+	Node root("root");
+	Transform* rt = root.GetTransform();
+	rt->SetPosition(vec3(1, -2, 3));
+	rt->SetScale(vec3(2, 0.5f, 1.25f));
+	rt->SetRotation(Quaternion(vec3(1, 2, 3).normalized(), 0.7f));
+	Node* a = root.CreateChild("a");
+	a->GetTransform()->SetPosition(vec3(0.5f, 1, -1));
+	a->GetTransform()->SetScale(vec3(1.5f));
+	a->GetTransform()->SetRotation(Quaternion(vec3(-2, 1, 0.5f).normalized(), -1.1f));
+	Node* b = a->CreateChild("b");
+	b->GetTransform()->SetPosition(vec3(-1, 0.25f, 2));
+	b->GetTransform()->SetScale(vec3(0.75f));
+	b->GetTransform()->SetRotation(Quaternion(vec3(0, 1, 1).normalized(), 2));
+
+	Node plain("plain");
+	plain.GetTransform()->SetPosition(vec3(-3, 0, 1));
+	plain.GetTransform()->SetScale(vec3(1, 3, 0.5f));
+	Node* c = plain.CreateChild("c");
+	c->GetTransform()->SetPosition(vec3(1, 1, 1));
+	c->GetTransform()->SetScale(vec3(0.5f, 2, 1));
+	c->GetTransform()->SetRotation(Quaternion(vec3(1, 0, 1).normalized(), 0.4f));
+	Node* d = c->CreateChild("d");
+	d->GetTransform()->SetPosition(vec3(0, -2, 0.5f));
+	d->GetTransform()->SetScale(vec3(2));
+	d->GetTransform()->SetRotation(Quaternion(vec3(0, 0, 1), -0.8f));
+
+	const Array<Node*> nodes = { &root, a, b, &plain, c, d };
+	system->Update();
+	CheckWorldMatrices(nodes);
+
+	// Parent edits drop the cached matrices of the subtree, before and after Update()
+	rt->SetScale(vec3(0.5f, 1.5f, 3));
+	rt->Rotate(Quaternion(vec3(0, 1, 0), 0.3f));
+	plain.GetTransform()->SetPosition(vec3(4, 4, -4));
+	c->GetTransform()->SetScale(vec3(3, 1, 0.25f));
+	CheckWorldMatrices(nodes);
+	system->Update();
+	CheckJournal(nodes, { &root, &plain });
+	CheckWorldMatrices(nodes);
+}
+
+TEST_CASE(node_child_names)
+{
+	// Linear search below the 16 children of Node::ChildIndexThreshold, hashed index above it
+	Node small("small");
+	ChurnChildren(&small, 8, 400, 4);
+	Node large("large");
+	ChurnChildren(&large, 300, 4000, 5);
+}
+
+TEST_CASE(node_find_by_path)
+{
+	Node root("root");
+	Node* a = root.CreateChild("a");
+	Node* b = a->CreateChild("b");
+	Node* c = b->CreateChild("c");
+	for (int i = 0; i < 2; ++i)
+	{
+		// The second pass hits the cache
+		CHECK(root.FindByPath("a/b/c") == c);
+		CHECK(root.FindByPath("a/b") == b);
+		CHECK(root.FindByPath("a/x") == nullptr);
+		CHECK(a->FindByPath("b/c") == c);
+	}
+
+	// Renames
+	CHECK(b->SetName("d"));
+	CHECK(root.FindByPath("a/b/c") == nullptr);
+	CHECK(root.FindByPath("a/d/c") == c);
+	CHECK(b->SetName("b"));
+	CHECK(root.FindByPath("a/b/c") == c);
+
+	// Release and attach elsewhere
+	Node* released = a->ReleaseChild(b);
+	CHECK(released == b);
+	CHECK(root.FindByPath("a/b/c") == nullptr);
+	CHECK(root.FindByPath("a/b") == nullptr);
+	CHECK(root.AppendChild(b));
+	CHECK(root.FindByPath("b/c") == c);
+
+	// A new node at a previously missing path
+	Node* x = a->CreateChild("x");
+	CHECK(root.FindByPath("a/x") == x);
+
+	// Destroyed nodes drop out
+	delete b->ReleaseChild(c);
+	CHECK(root.FindByPath("b/c") == nullptr);
+	CHECK(root.FindByPath("b") == b);
+}
+
+TEST_CASE(component_pools)
+{
+	Random random(6);
+	Node root("root");
+	Array<ProbeState> states;
+	for (int i = 0; i < 600; ++i)
+		states.push_back({ root.CreateChild("node_" + std::to_string(i)), { 0, 0, 0 } });
+
+	uint32_t nextTag = 1;
+	for (int step = 0; step < 5000; ++step)
+	{
+		ProbeState& state = states[random.next_u32() % states.size()];
+		const size_t k = random.next_u32() % 3;
+		const bool create = random.next_u32() % 3 != 0;
+		auto apply = [&]<typename T>() {
+			if (create)
+			{
+				T* p = state.node->GetOrCreateComponnet<T>();
+				if (state.tags[k] == 0)
+					p->tag = state.tags[k] = nextTag++;
+			}
+			else
+			{
+				state.node->RemoveComponent<T>();
+				state.tags[k] = 0;
+			}
+		};
+		if (k == 0)
+			apply.operator()<SmallProbe>();
+		else if (k == 1)
+			apply.operator()<MediumProbe>();
+		else
+			apply.operator()<LargeProbe>();
+
+		CheckProbe<SmallProbe>(state.node, state.tags[0]);
+		CheckProbe<MediumProbe>(state.node, state.tags[1]);
+		CheckProbe<LargeProbe>(state.node, state.tags[2]);
+		CHECK(state.node->HasComponent<Transform>());
+	}
+
+	// Components stay in place while others come and go
+	for (const ProbeState& state : states)
+	{
+		CheckProbe<SmallProbe>(state.node, state.tags[0]);
+		CheckProbe<MediumProbe>(state.node, state.tags[1]);
+		CheckProbe<LargeProbe>(state.node, state.tags[2]);
+		CHECK(std::popcount(state.node->GetComponentMask()) ==
+			(state.tags[0] != 0) + (state.tags[1] != 0) + (state.tags[2] != 0));
+	}
+	CheckPool<SmallProbe>(states, 0);
+	CheckPool<MediumProbe>(states, 1);
+	CheckPool<LargeProbe>(states, 2);
+
+	// Destroying a node destroys its components
+	for (size_t i = 0; i < states.size(); i += 2)
+	{
+		delete root.ReleaseChild(states[i].node);
+		states[i].node = nullptr;
+	}
+	std::erase_if(states, [](const ProbeState& state) { return state.node == nullptr; });
+	CheckPool<SmallProbe>(states, 0);
+	CheckPool<MediumProbe>(states, 1);
+	CheckPool<LargeProbe>(states, 2);
+}
+
+TEST_CASE(transform_system_parallel_matches_serial)
+{
+	// Two identical trees, one updated serially and one on a pool, must agree bitwise.
+	// Large enough that subtrees are split into tasks below their roots.
+	TransformSystem* system = TransformSystem::GetSingleton();
+	ThreadPool pool(4);
+	Node serialRoot("serial"), parallelRoot("parallel");
+	const Array<Node*> serial = MakeTree(&serialRoot, 50000, 7);
+	const Array<Node*> parallel = MakeTree(&parallelRoot, 50000, 7);
+	system->Update();
+	system->Update();
+
+	for (uint64_t frame = 0; frame < 4; ++frame)
+	{
+		Perturb(serial, frame);
+		system->Update();
+		const uint32_t serialGeneration = system->GetGeneration();
+		const Array<size_t> serialJournal = JournaledNodes(serial);
+		CHECK(!serialJournal.empty());
+
+		Perturb(parallel, frame);
+		system->Update(&pool);
+		const uint32_t parallelGeneration = system->GetGeneration();
+		CHECK(JournaledNodes(parallel) == serialJournal);
+		CHECK(JournaledNodes(serial).empty());
+
+		size_t transformMismatches = 0, generationMismatches = 0;
+		for (size_t i = 0; i < serial.size(); ++i)
+		{
+			const Transform* a = serial[i]->GetTransform();
+			const Transform* b = parallel[i]->GetTransform();
+			if (std::memcmp(&a->GetWorldPosition(), &b->GetWorldPosition(), sizeof(vec3)) != 0
+				|| std::memcmp(&a->GetWorldScale(), &b->GetWorldScale(), sizeof(vec3)) != 0
+				|| std::memcmp(&a->GetWorldRotation(), &b->GetWorldRotation(), sizeof(Quaternion)) != 0)
+				++transformMismatches;
+			if ((a->GetWorldGeneration() == serialGeneration) != (b->GetWorldGeneration() == parallelGeneration))
+				++generationMismatches;
+		}
+		CHECK(transformMismatches == 0);
+		CHECK(generationMismatches == 0);
+	}
+}
+
+TEST_CASE(slab_allocator_reuse)
+{
+	struct Item
+	{
+		double value;
+		char name[20];
+	};
+	SlabAllocator<Item, 8> allocator;
+	Array<void*> blocks;
+	for (int i = 0; i < 20; ++i)
+		blocks.push_back(allocator.Allocate());
+	CHECK(allocator.GetLiveCount() == 20);
+	CHECK(allocator.GetPageCount() == 3);
+	for (void* p : blocks)
+		CHECK(reinterpret_cast<uintptr_t>(p) % alignof(Item) == 0);
+	Array<void*> sorted = blocks;
+	std::sort(sorted.begin(), sorted.end());
+	CHECK(std::adjacent_find(sorted.begin(), sorted.end()) == sorted.end());
+
+	// Freed blocks are reused before any new page
+	allocator.Free(nullptr);
+	for (size_t i = 0; i < blocks.size(); i += 2)
+		allocator.Free(blocks[i]);
+	CHECK(allocator.GetLiveCount() == 10);
+	Array<void*> reused;
+	for (int i = 0; i < 10; ++i)
+		reused.push_back(allocator.Allocate());
+	CHECK(allocator.GetPageCount() == 3);
+	std::sort(reused.begin(), reused.end());
+	Array<void*> freed;
+	for (size_t i = 0; i < blocks.size(); i += 2)
+		freed.push_back(blocks[i]);
+	std::sort(freed.begin(), freed.end());
+	CHECK(reused == freed);
+	// The last page has 4 untouched blocks
+	for (int i = 0; i < 4; ++i)
+		allocator.Allocate();
+	CHECK(allocator.GetPageCount() == 3);
+	allocator.Allocate();
+	CHECK(allocator.GetPageCount() == 4);
+	CHECK(allocator.GetLiveCount() == 25);
+}
+
+TEST_CASE(node_respawn)
+{
+	// Destroying and recreating children reuses node blocks, component slots and transform entries
+	const SlabAllocator<Node>& allocator = Node::GetAllocator();
+	TransformSystem* system = TransformSystem::GetSingleton();
+	const size_t liveNodes = allocator.GetLiveCount();
+	const size_t liveTransforms = ComponentPool<Transform>::GetSingleton()->GetCount();
+	{
+		Node parent("parent");
+		Array<Node*> children;
+		for (int i = 0; i < 1000; ++i)
+			children.push_back(parent.CreateChild("child_" + std::to_string(i)));
+		CHECK(allocator.GetLiveCount() == liveNodes + 1000);
+		CHECK(ComponentPool<Transform>::GetSingleton()->GetCount() == liveTransforms + 1001);
+
+		size_t pages = 0, entries = 0;
+		for (int round = 0; round < 8; ++round)
+		{
+			for (size_t i = 0; i < children.size(); ++i)
+			{
+				delete parent.ReleaseChild(children[i]);
+				children[i] = parent.CreateChild("child_" + std::to_string(i));
+				children[i]->GetTransform()->SetPosition(vec3(float(i), float(round), 0));
+			}
+			system->Update();
+			if (round == 3)
+			{
+				pages = allocator.GetPageCount();
+				entries = system->GetCount();
+			}
+			else if (round > 3)
+			{
+				CHECK(allocator.GetPageCount() == pages);
+				CHECK(system->GetCount() <= entries);
+			}
+		}
+		CHECK(allocator.GetLiveCount() == liveNodes + 1000);
+		for (size_t i = 0; i < children.size(); ++i)
+		{
+			CHECK(parent.GetChild("child_" + std::to_string(i)) == children[i]);
+			CHECK(children[i]->GetTransform()->GetWorldPosition() == vec3(float(i), 7, 0));
+		}
+	}
+	CHECK(allocator.GetLiveCount() == liveNodes);
+	CHECK(ComponentPool<Transform>::GetSingleton()->GetCount() == liveTransforms);
+}
+
+TEST_CASE(scene_file_round_trip)
+{
+	const char* path = "SceneTests.scene";
+	Node root("root");
+	const Array<Node*> nodes = MakeTree(&root, 300, 8);
+	SceneWriter writer(root);
+	const uint64_t blob[3] = { 1, 2, 3 };
+	CHECK(writer.AddComponentData(nodes[5], "Blob", blob, sizeof(blob)));
+	CHECK(writer.AddComponentData(nodes[9], "Empty", nullptr, 0));
+	CHECK(writer.AddReference(nodes[7], SceneFormat::ReferenceKind::Mesh, "meshes/cube.obj"));
+	Node stranger("stranger");
+	CHECK(!writer.AddReference(&stranger, SceneFormat::ReferenceKind::Mesh, "x"));
+	CHECK(writer.Write(path));
+
+	{
+		const SceneFile file(path);
+		CHECK(file.IsValid());
+		CHECK(file.GetNodeCount() == nodes.size());
+		CHECK(file.GetComponentCount() == 2);
+		CHECK(file.GetReferenceCount() == 1);
+		if (file.GetComponentCount() == 2 && file.GetReferenceCount() == 1)
+		{
+			const SceneFormat::ComponentRecord& c = file.GetComponents()[0];
+			CHECK(c.node == writer.GetIndex(nodes[5]));
+			CHECK(file.GetString(c.type) == "Blob");
+			CHECK(c.size == sizeof(blob) && std::memcmp(file.GetBlob(c), blob, sizeof(blob)) == 0);
+			CHECK(file.GetComponents()[1].size == 0);
+			const SceneFormat::ReferenceRecord& r = file.GetReferences()[0];
+			CHECK(r.node == writer.GetIndex(nodes[7]));
+			CHECK(r.kind == SceneFormat::ReferenceKind::Mesh);
+			CHECK(file.GetString(r.asset) == "meshes/cube.obj");
+		}
+
+		// As a new root and below a parent, whose name lookup then finds it
+		Array<Node*> created;
+		UniquePtr<Node> loaded(file.Instantiate(nullptr, &created));
+		CHECK(loaded != nullptr && created.size() == nodes.size());
+		if (loaded)
+			CheckSameTree(&root, loaded.get());
+		Node parent("parent");
+		CHECK(file.Instantiate(&parent) == parent.GetChild("root"));
+		CHECK(file.Instantiate(&parent) == nullptr);
+	}
+	std::remove(path);
+}
+
+TEST_CASE(scene_file_rejects_corruption)
+{
+	const char* path = "SceneTests.scene";
+	Node root("root");
+	MakeTree(&root, 20, 9);
+	SceneWriter writer(root);
+	writer.AddComponentData(&root, "Blob", "data", 4);
+	writer.AddReference(&root, SceneFormat::ReferenceKind::Texture, "wall.png");
+	const Array<unsigned char> good = writer.Serialize();
+	CHECK(OpensAsScene(path, good));
+
+	SceneFormat::Header header;
+	std::memcpy(&header, good.data(), sizeof(header));
+	// Modify a copy of the file, fn(bytes, header) may edit either; the header is written back
+	const auto corrupt = [&](auto fn) {
+		Array<unsigned char> bytes = good;
+		SceneFormat::Header h = header;
+		fn(bytes, h);
+		std::memcpy(bytes.data(), &h, sizeof(h));
+		return OpensAsScene(path, bytes);
+	};
+	const auto node = [&](Array<unsigned char>& bytes, size_t i) {
+		return reinterpret_cast<SceneFormat::NodeRecord*>(bytes.data() + header.sections[SceneFormat::Nodes].offset) + i;
+	};
+	const auto component = [&](Array<unsigned char>& bytes) {
+		return reinterpret_cast<SceneFormat::ComponentRecord*>(bytes.data() + header.sections[SceneFormat::Components].offset);
+	};
+	const auto reference = [&](Array<unsigned char>& bytes) {
+		return reinterpret_cast<SceneFormat::ReferenceRecord*>(bytes.data() + header.sections[SceneFormat::References].offset);
+	};
+	using Bytes = Array<unsigned char>;
+	using Header = SceneFormat::Header;
+
+	CHECK(!OpensAsScene(path, Bytes(good.begin(), good.begin() + sizeof(Header) - 1)));
+	CHECK(!OpensAsScene(path, Bytes(good.begin(), good.end() - 16)));
+	CHECK(!corrupt([](Bytes&, Header& h) { h.magic = 0; }));
+	CHECK(!corrupt([](Bytes&, Header& h) { ++h.version; }));
+	CHECK(!corrupt([](Bytes&, Header& h) { h.sections[SceneFormat::Strings].offset += 8; }));
+	CHECK(!corrupt([](Bytes&, Header& h) { h.sections[SceneFormat::Blobs].size = h.size; }));
+	CHECK(!corrupt([](Bytes&, Header& h) { h.sections[SceneFormat::Transforms].size -= sizeof(SceneFormat::TransformRecord); }));
+	CHECK(!corrupt([](Bytes&, Header& h) { h.sections[SceneFormat::Nodes].size = 0; }));
+	CHECK(!corrupt([&](Bytes& b, Header&) { node(b, 0)->parent = 0; }));
+	CHECK(!corrupt([&](Bytes& b, Header&) { node(b, 5)->parent = 5; }));
+	CHECK(!corrupt([&](Bytes& b, Header&) { node(b, 5)->name.length = UINT32_MAX; }));
+	CHECK(!corrupt([&](Bytes& b, Header&) { node(b, 3)->childCount = 20; }));
+	CHECK(!corrupt([&](Bytes& b, Header&) { node(b, 3)->childCount = UINT32_MAX; }));
+	CHECK(!corrupt([&](Bytes& b, Header&) { component(b)->node = 20; }));
+	CHECK(!corrupt([&](Bytes& b, Header&) { component(b)->offset = 8; }));
+	CHECK(!corrupt([&](Bytes& b, Header&) { component(b)->size = 1 << 20; }));
+	CHECK(!corrupt([&](Bytes& b, Header&) { reference(b)->asset.offset = UINT32_MAX; }));
+	// A child count short of the real one only costs a reallocation
+	CHECK(corrupt([&](Bytes& b, Header&) { node(b, 0)->childCount = 0; }));
+	std::remove(path);
+}
+
+TEST_CASE(bvh_queries_match_brute_force)
+{
+	TransformSystem* system = TransformSystem::GetSingleton();
+	Random random(10);
+	Node root("root");
+	Array<Node*> nodes = ScatterNodes(&root, 3000, random);
+	system->Update();
+	BVH bvh;
+	HashMap<const Node*, AABB> localBounds;
+	for (Node* node : nodes)
+	{
+		const vec3 extents(random.range(0.1f, 2), random.range(0.1f, 2), random.range(0.1f, 2));
+		bvh.Insert(node, AABB(-extents, extents));
+		localBounds[node] = AABB(-extents, extents);
+	}
+	CheckBVHQueries(bvh, nodes, random);
+
+	// Removals, new bounds and motion, followed by a refit
+	for (size_t i = 0; i < 500; ++i)
+	{
+		const size_t k = random.next_u32() % nodes.size();
+		bvh.Remove(bvh.GetProxy(nodes[k]));
+		nodes.erase(nodes.begin() + k);
+	}
+	for (size_t i = 0; i < 200; ++i)
+	{
+		const Node* node = nodes[random.next_u32() % nodes.size()];
+		localBounds[node] = AABB(vec3(-3), vec3(random.range(0.1f, 3)));
+		bvh.SetLocalBounds(bvh.GetProxy(node), localBounds[node]);
+	}
+	for (size_t i = 0; i < 1000; ++i)
+		nodes[random.next_u32() % nodes.size()]->GetTransform()->Translate(vec3(random.range(-5, 5), random.range(-5, 5), 0));
+	root.GetTransform()->Rotate(Quaternion(vec3::up(), 0.1f));
+	system->Update();
+	bvh.Refit();
+	// Tight bounds follow the transforms
+	size_t stale = 0;
+	for (const Node* node : nodes)
+	{
+		const Transform* t = node->GetTransform();
+		const AABB expected = localBounds[node].transformed(Affine3(t->GetWorldPosition(), t->GetWorldScale(), t->GetWorldRotation()));
+		const AABB& bounds = bvh.GetWorldBounds(bvh.GetProxy(node));
+		stale += bounds.min != expected.min || bounds.max != expected.max;
+	}
+	CHECK(stale == 0);
+	CheckBVHQueries(bvh, nodes, random);
+
+	// The same proxies after a full rebuild
+	bvh.Build();
+	CheckBVHQueries(bvh, nodes, random);
+	for (Node* node : nodes)
+		bvh.Remove(bvh.GetProxy(node));
+	CHECK(bvh.GetProxyCount() == 0);
+}
+
+TEST_CASE(spatial_hash_queries_match_brute_force)
+{
+	TransformSystem* system = TransformSystem::GetSingleton();
+	Random random(11);
+	SpatialHash hash(2.0f);
+	ProxyBounds proxies;
+	// Mostly proxies below half a cell, some in the large list
+	const auto randomRadius = [&] { return random.next_u32() % 8 == 0 ? random.range(1, 5) : random.range(0, 1); };
+	for (int i = 0; i < 2000; ++i)
+	{
+		const Sphere bounds(vec3(random.range(-30, 30), random.range(-30, 30), random.range(-30, 30)), randomRadius());
+		proxies[hash.Insert(bounds)] = bounds;
+	}
+	Node root("root");
+	Array<Node*> nodes = ScatterNodes(&root, 500, random);
+	system->Update();
+	HashMap<const Node*, float> localRadii;
+	for (Node* node : nodes)
+	{
+		localRadii[node] = random.range(0.1f, 1);
+		hash.Insert(node, localRadii[node]);
+	}
+	// Node proxies are centered at the node with the radius scaled by the largest world scale
+	const auto nodeBounds = [&](const Node* node) {
+		const Transform* t = node->GetTransform();
+		const vec3& s = t->GetWorldScale();
+		return Sphere(t->GetWorldPosition(), localRadii[node] * std::max({ s.x, s.y, s.z }));
+	};
+	for (const Node* node : nodes)
+	{
+		const uint32_t proxy = hash.GetProxy(node);
+		CHECK(proxy != SpatialHash::InvalidProxy && hash.GetNode(proxy) == node);
+		proxies[proxy] = nodeBounds(node);
+	}
+	CheckSpatialHash(hash, proxies, random);
+
+	// Removals, moves within and across cells, and radius changes into and out of the large list
+	Array<uint32_t> direct;
+	for (const auto& [proxy, bounds] : proxies)
+		if (hash.GetNode(proxy) == nullptr)
+			direct.push_back(proxy);
+	std::sort(direct.begin(), direct.end());
+	for (int i = 0; i < 300; ++i)
+	{
+		const size_t k = random.next_u32() % direct.size();
+		hash.Remove(direct[k]);
+		proxies.erase(direct[k]);
+		direct.erase(direct.begin() + k);
+	}
+	for (int i = 0; i < 800; ++i)
+	{
+		const uint32_t proxy = direct[random.next_u32() % direct.size()];
+		Sphere& bounds = proxies[proxy];
+		if (i % 2 == 0)
+			bounds.center += vec3(random.range(-0.3f, 0.3f), random.range(-0.3f, 0.3f), random.range(-0.3f, 0.3f));
+		else
+			bounds.center = vec3(random.range(-30, 30), random.range(-30, 30), random.range(-30, 30));
+		hash.Move(proxy, bounds.center);
+		if (i % 4 == 1)
+		{
+			bounds.radius = randomRadius();
+			hash.SetRadius(proxy, bounds.radius);
+		}
+	}
+	// Freed proxies are reused
+	for (int i = 0; i < 100; ++i)
+	{
+		const Sphere bounds(vec3(random.range(-30, 30), random.range(-30, 30), random.range(-30, 30)), randomRadius());
+		const uint32_t proxy = hash.Insert(bounds);
+		CHECK(proxies.find(proxy) == proxies.end());
+		proxies[proxy] = bounds;
+	}
+	// Node proxies follow their transforms
+	for (int i = 0; i < 200; ++i)
+	{
+		Transform* t = nodes[random.next_u32() % nodes.size()]->GetTransform();
+		t->Translate(vec3(random.range(-5, 5), random.range(-5, 5), 0));
+		t->SetScale(vec3(random.range(0.5f, 3), 1, 1));
+	}
+	root.GetTransform()->SetPosition(vec3(0.5f, 0, 0));
+	system->Update();
+	hash.Refit();
+	for (const Node* node : nodes)
+		proxies[hash.GetProxy(node)] = nodeBounds(node);
+	CheckSpatialHash(hash, proxies, random);
+	for (const Node* node : nodes)
+		hash.Remove(hash.GetProxy(node));
+
+	// Replacing every proxy at once
+	Array<float> x(1500), y(1500), z(1500), radius(1500);
+	random.fill(x.data(), x.size(), -30.0f, 30.0f);
+	random.fill(y.data(), y.size(), -30.0f, 30.0f);
+	random.fill(z.data(), z.size(), -30.0f, 30.0f);
+	for (float& r : radius)
+		r = randomRadius();
+	hash.Build({ x.data(), y.data(), z.data(), radius.data() }, x.size());
+	proxies.clear();
+	for (uint32_t i = 0; i < x.size(); ++i)
+		proxies[i] = Sphere(vec3(x[i], y[i], z[i]), radius[i]);
+	CheckSpatialHash(hash, proxies, random);
+}
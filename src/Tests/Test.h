@@ -0,0 +1,65 @@
+#pragma once
+
+// Checks shared by the test executables. Cases register themselves at static initialization,
+// Tests.cpp runs them.
+
+#include "../Utilities/Array.h"
+
+#include <cmath>
+#include <cstdio>
+
+namespace test
+{
+	using Body = void (*)();
+
+	struct Case
+	{
+		const char* name;
+		Body body;
+	};
+
+	/// @brief Every registered case, in the order of their definitions within each file
+	inline Array<Case>& Cases()
+	{
+		static Array<Case> cases;
+		return cases;
+	}
+
+	/// @brief Failed checks since program start
+	inline size_t g_Failures = 0;
+
+	struct Registrar
+	{
+		Registrar(const char* name, Body body) { Cases().push_back({ name, body }); }
+	};
+
+	inline void Fail(const char* file, int line, const char* expr)
+	{
+		printf("  %s:%d: check failed: %s\n", file, line, expr);
+		++g_Failures;
+	}
+
+	/// @brief |actual - expected| <= tolerance, false for NaN
+	inline bool CheckNear(float actual, float expected, float tolerance, const char* file, int line, const char* expr)
+	{
+		if (std::fabs(actual - expected) <= tolerance)
+			return true;
+		printf("  %s:%d: check failed: %s\n    got %.9g, expected %.9g (tolerance %.3g)\n",
+			file, line, expr, actual, expected, tolerance);
+		++g_Failures;
+		return false;
+	}
+}
+
+/// @brief Define and register a test case. name is an identifier, unique in the executable.
+#define TEST_CASE(name) \
+	static void name(); \
+	static const test::Registrar name##_registrar(#name, name); \
+	static void name()
+
+/// @brief Report expr if it is false and carry on with the case
+#define CHECK(expr) ((expr) ? (void)0 : test::Fail(__FILE__, __LINE__, #expr))
+
+/// @brief Report |actual - expected| > tolerance and carry on with the case
+#define CHECK_NEAR(actual, expected, tolerance) \
+	test::CheckNear((actual), (expected), (tolerance), __FILE__, __LINE__, #actual " ~ " #expected)
@@ -0,0 +1,33 @@
+// Unit tests for the engine modules that need no window or GL loader.
+//
+// Usage: Tests [filter]
+//   filter  Only run cases whose name contains this string
+//
+// Prints one line per case and the failed checks under it, then exits with 1 if any check failed.
+// TestsScalar runs the same cases against the scalar Math backend.
+
+#include "../Math/SIMD.h"
+#include "Test.h"
+
+#include <cstring>
+
+int main(int argc, char** argv)
+{
+	const char* filter = argc > 1 ? argv[1] : nullptr;
+	printf("backend: %s\n", simd::backend_name());
+
+	size_t run = 0, failed = 0;
+	for (const test::Case& c : test::Cases())
+	{
+		if (filter != nullptr && strstr(c.name, filter) == nullptr)
+			continue;
+		const size_t before = test::g_Failures;
+		c.body();
+		const bool passed = test::g_Failures == before;
+		printf("%s %s\n", passed ? "pass" : "FAIL", c.name);
+		++run;
+		failed += passed ? 0 : 1;
+	}
+	printf("%zu cases, %zu failed\n", run, failed);
+	return failed == 0 ? 0 : 1;
+}
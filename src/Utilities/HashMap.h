@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Traits.h"
+#include "String.h"
 
 #include <unordered_map>
 
@@ -10,4 +11,18 @@ concept Hashable = requires (const T & t) {
 };
 
 template <Hashable K, typename V>
-using HashMap = std::unordered_map<K, V>;
\ No newline at end of file
+using HashMap = std::unordered_map<K, V>;
+
+/// @brief Transparent string hash, lets StringHashMap be searched by AnsiStringView without a temporary string
+struct StringHash
+{
+	using is_transparent = void;
+
+	size_t operator()(AnsiStringView str) const noexcept
+	{
+		return std::hash<AnsiStringView>{}(str);
+	}
+};
+
+template <typename V>
+using StringHashMap = std::unordered_map<AnsiString, V, StringHash, std::equal_to<>>;
@@ -0,0 +1,84 @@
+#include "HeapStats.h"
+
+#ifdef HEAP_STATS
+
+#include <cstdlib>
+#include <new>
+
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+
+namespace
+{
+	/// @brief Per thread, so a reading is not disturbed by allocations on other threads
+	thread_local size_t t_HeapAllocations = 0;
+
+	void* Allocate(size_t size, size_t alignment)
+	{
+		++t_HeapAllocations;
+		size = size != 0 ? size : 1;
+#ifdef _WIN32
+		void* p = _aligned_malloc(size, alignment);
+#else
+		void* p = alignment <= alignof(std::max_align_t) ? std::malloc(size) : std::aligned_alloc(alignment, (size + alignment - 1) & ~(alignment - 1));
+#endif
+		// Like running out of memory anywhere else in this code base, fatal
+		if (p == nullptr)
+			std::abort();
+		return p;
+	}
+
+	void Deallocate(void* p) noexcept
+	{
+#ifdef _WIN32
+		_aligned_free(p);
+#else
+		std::free(p);
+#endif
+	}
+}
+
+size_t GetHeapAllocationCount() noexcept
+{
+	return t_HeapAllocations;
+}
+
+void* operator new(size_t size)
+{
+	return Allocate(size, alignof(std::max_align_t));
+}
+
+void* operator new(size_t size, std::align_val_t alignment)
+{
+	return Allocate(size, static_cast<size_t>(alignment));
+}
+
+void operator delete(void* p) noexcept
+{
+	Deallocate(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+	Deallocate(p);
+}
+
+void operator delete(void* p, std::align_val_t) noexcept
+{
+	Deallocate(p);
+}
+
+void operator delete(void* p, size_t, std::align_val_t) noexcept
+{
+	Deallocate(p);
+}
+
+#else
+
+size_t GetHeapAllocationCount() noexcept
+{
+	return 0;
+}
+
+#endif
@@ -0,0 +1,9 @@
+#pragma once
+
+#include <cstddef>
+
+/// @brief Number of allocations through the global operator new on the calling thread since it started.
+/// Counted by the replacement operators in HeapStats.cpp, which are only compiled with HEAP_STATS
+/// defined, e.g. for benchmarks and debug builds; always 0 otherwise.
+/// Compare two readings around a block to check that it does not allocate.
+size_t GetHeapAllocationCount() noexcept;
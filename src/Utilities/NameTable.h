@@ -0,0 +1,53 @@
+#pragma once
+
+#include "Array.h"
+#include "HashMap.h"
+
+#include <cstdint>
+
+/// @brief Interned strings: every distinct name maps to one small integer id for the process lifetime.
+/// @note Not synchronized. Names are never released.
+class NameTable final
+{
+public:
+	static constexpr uint32_t InvalidId = UINT32_MAX;
+
+	static NameTable* GetSingleton() noexcept
+	{
+		static NameTable table;
+		return &table;
+	}
+
+	NameTable(const NameTable&) = delete;
+
+	NameTable& operator=(const NameTable&) = delete;
+
+	/// @brief Id of name, added to the table if needed
+	uint32_t Intern(AnsiStringView name)
+	{
+		if (auto it = m_Ids.find(name); it != m_Ids.end())
+			return it->second;
+		const uint32_t id = static_cast<uint32_t>(m_Names.size());
+		auto it = m_Ids.emplace(AnsiString(name), id).first;
+		m_Names.push_back(&it->first);
+		return id;
+	}
+
+	/// @return InvalidId if name was never interned
+	uint32_t Find(AnsiStringView name) const noexcept
+	{
+		auto it = m_Ids.find(name);
+		return it != m_Ids.end() ? it->second : InvalidId;
+	}
+
+	const AnsiString& GetName(uint32_t id) const noexcept
+	{
+		return *m_Names[id];
+	}
+
+private:
+	NameTable() = default;
+
+	StringHashMap<uint32_t> m_Ids;
+	Array<const AnsiString*> m_Names;
+};
@@ -0,0 +1,72 @@
+#pragma once
+
+#include "Array.h"
+#include "Pointer.h"
+
+#include <cstddef>
+
+/// @brief Fixed size blocks for objects of type T, carved from pages of BlockCount blocks.
+/// Freed blocks go to a free list and are reused before a new page is taken, so a steady
+/// create/destroy pattern stops touching the general heap once the pages are warm.
+/// Pages are only returned when the allocator is destroyed.
+/// @note Not synchronized.
+template <typename T, size_t BlockCount = 256>
+class SlabAllocator final
+{
+public:
+	SlabAllocator() = default;
+
+	SlabAllocator(const SlabAllocator&) = delete;
+
+	SlabAllocator& operator=(const SlabAllocator&) = delete;
+
+	/// @brief Uninitialized storage for one T
+	void* Allocate()
+	{
+		if (m_FreeList == nullptr)
+			AddPage();
+		Block* block = m_FreeList;
+		m_FreeList = block->next;
+		++m_LiveCount;
+		return block;
+	}
+
+	void Free(void* p) noexcept
+	{
+		if (p == nullptr)
+			return;
+		Block* block = static_cast<Block*>(p);
+		block->next = m_FreeList;
+		m_FreeList = block;
+		--m_LiveCount;
+	}
+
+	/// @brief Blocks handed out and not freed
+	size_t GetLiveCount() const noexcept { return m_LiveCount; }
+
+	/// @brief Pages taken from the general heap so far, one allocation each
+	size_t GetPageCount() const noexcept { return m_Pages.size(); }
+
+private:
+	union Block
+	{
+		Block* next;
+		alignas(T) unsigned char storage[sizeof(T)];
+	};
+
+	void AddPage()
+	{
+		m_Pages.push_back(MakeUnique<Block[]>(BlockCount));
+		Block* page = m_Pages.back().get();
+		// Thread the new blocks in address order
+		for (size_t i = BlockCount; i-- > 0;)
+		{
+			page[i].next = m_FreeList;
+			m_FreeList = &page[i];
+		}
+	}
+
+	Array<UniquePtr<Block[]>> m_Pages;
+	Block* m_FreeList = nullptr;
+	size_t m_LiveCount = 0;
+};
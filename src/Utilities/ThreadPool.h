@@ -0,0 +1,113 @@
+#pragma once
+
+#include "Array.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+/// @brief Fixed set of worker threads running index-parallel loops.
+/// The calling thread takes part in every loop, so a pool of one thread has no workers
+/// and runs loops inline.
+/// @note ParallelFor must not be called concurrently or from inside a loop body.
+class ThreadPool final
+{
+public:
+	/// @param threadCount Threads taking part in a loop, including the caller. 0 means one per hardware thread.
+	explicit ThreadPool(size_t threadCount = 0)
+	{
+		if (threadCount == 0)
+			threadCount = std::max(1u, std::thread::hardware_concurrency());
+		for (size_t i = 1; i < threadCount; ++i)
+			m_Workers.emplace_back([this] { WorkerLoop(); });
+	}
+
+	ThreadPool(const ThreadPool&) = delete;
+
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	~ThreadPool()
+	{
+		{
+			std::lock_guard lock(m_Mutex);
+			m_bStop = true;
+		}
+		m_Wake.notify_all();
+		for (std::thread& worker : m_Workers)
+			worker.join();
+	}
+
+	size_t GetThreadCount() const noexcept { return m_Workers.size() + 1; }
+
+	/// @brief fn(i) for every i in [0, count), in no particular order. Returns once all calls returned.
+	void ParallelFor(size_t count, const std::function<void(size_t)>& fn)
+	{
+		if (count == 0)
+			return;
+		if (m_Workers.empty() || count == 1)
+		{
+			for (size_t i = 0; i < count; ++i)
+				fn(i);
+			return;
+		}
+		{
+			std::lock_guard lock(m_Mutex);
+			m_Job = &fn;
+			m_JobSize = count;
+			m_Next.store(0, std::memory_order_relaxed);
+			m_Busy = m_Workers.size();
+			++m_JobId;
+		}
+		m_Wake.notify_all();
+		RunJob(fn, count);
+		std::unique_lock lock(m_Mutex);
+		m_Done.wait(lock, [this] { return m_Busy == 0; });
+		m_Job = nullptr;
+	}
+
+private:
+	void RunJob(const std::function<void(size_t)>& fn, size_t count)
+	{
+		for (size_t i = m_Next.fetch_add(1, std::memory_order_relaxed); i < count; i = m_Next.fetch_add(1, std::memory_order_relaxed))
+			fn(i);
+	}
+
+	void WorkerLoop()
+	{
+		size_t seen = 0;
+		for (;;)
+		{
+			const std::function<void(size_t)>* job;
+			size_t count;
+			{
+				std::unique_lock lock(m_Mutex);
+				m_Wake.wait(lock, [&] { return m_bStop || m_JobId != seen; });
+				if (m_bStop)
+					return;
+				seen = m_JobId;
+				job = m_Job;
+				count = m_JobSize;
+			}
+			RunJob(*job, count);
+			std::lock_guard lock(m_Mutex);
+			if (--m_Busy == 0)
+				m_Done.notify_one();
+		}
+	}
+
+	Array<std::thread> m_Workers;
+	std::mutex m_Mutex;
+	std::condition_variable m_Wake;
+	std::condition_variable m_Done;
+	const std::function<void(size_t)>* m_Job = nullptr;
+	size_t m_JobSize = 0;
+	/// @brief Workers that have not finished the current job
+	size_t m_Busy = 0;
+	size_t m_JobId = 0;
+	std::atomic<size_t> m_Next{0};
+	bool m_bStop = false;
+};